@@ -0,0 +1,348 @@
+#include "acquisitionthread.h"
+#include <QDebug>
+#include <chrono>
+#include <thread>
+#include "telemetryreader.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <emmintrin.h>
+#define CPU_RELAX() _mm_pause()
+#elif defined(__aarch64__) || defined(__arm__)
+#define CPU_RELAX() __asm__ __volatile__("yield")
+#else
+#define CPU_RELAX() do {} while (0)
+#endif
+
+#if defined(Q_OS_LINUX)
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+static const qint64 NS_PER_SECOND = 1000000000;
+static const qint64 JITTER_REPORT_INTERVAL_NS = 10 * NS_PER_SECOND;
+
+// Long sleeps (e.g. the standby period) are split so stop() does not have
+// to wait for a whole period
+static const qint64 MAX_SLEEP_SLICE_NS = NS_PER_SECOND / 10;
+
+// Packet driven mode: the physics page is expected every 3 ms (333 Hz).
+// Around the expected arrival the packet id is polled in a busy loop, outside
+// of that window it is polled with short sleeps.
+static const qint64 INITIAL_PACKET_INTERVAL_NS = NS_PER_SECOND / 333;
+static const qint64 MIN_SPIN_WINDOW_NS = 50000;
+static const qint64 MAX_SPIN_WINDOW_NS = 1000000;
+static const qint64 PACKET_POLL_SLEEP_NS = 200000;
+
+// Process a frame even without a new packet after this time, so status
+// changes (e.g. pause) are still noticed
+static const qint64 PACKET_TIMEOUT_NS = NS_PER_SECOND / 10;
+
+// How often opening the telemetry pages is retried while the game has not
+// created them yet
+static const qint64 SOURCE_RETRY_INTERVAL_NS = NS_PER_SECOND / 2;
+
+
+AcquisitionThread::AcquisitionThread(TelemetryReader* reader, QObject *parent)
+    : QThread(parent)
+    , m_reader(reader)
+    , m_periodNs(NS_PER_SECOND)
+    , m_packetDriven(false)
+{
+
+}
+
+AcquisitionThread::~AcquisitionThread()
+{
+    stop();
+}
+
+void AcquisitionThread::setPeriod(qint64 periodNs)
+{
+    if (periodNs > 0)
+    {
+        m_periodNs.store(periodNs);
+    }
+}
+
+qint64 AcquisitionThread::getPeriod() const
+{
+    return m_periodNs.load();
+}
+
+void AcquisitionThread::setPacketDriven(bool packetDriven)
+{
+    m_packetDriven.store(packetDriven);
+}
+
+bool AcquisitionThread::isPacketDriven() const
+{
+    return m_packetDriven.load();
+}
+
+void AcquisitionThread::setCpuAffinity(qint32 cpu)
+{
+    m_cpu = cpu;
+}
+
+void AcquisitionThread::setRealtimePriority(bool realtimePriority)
+{
+    m_realtimePriority = realtimePriority;
+}
+
+void AcquisitionThread::stop()
+{
+    if (isRunning())
+    {
+        requestInterruption();
+        wait();
+    }
+}
+
+qint64 AcquisitionThread::now()
+{
+#if defined(Q_OS_LINUX)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (static_cast<qint64>(ts.tv_sec) * NS_PER_SECOND) + ts.tv_nsec;
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+void AcquisitionThread::run()
+{
+    qDebug() << "AcquisitionThread::run()";
+    applySchedulingPolicy();
+
+    m_jitter.reset();
+    m_overruns = 0;
+    m_lastReportNs = now();
+
+    m_packetIntervalNs = INITIAL_PACKET_INTERVAL_NS;
+    m_packetDeviationNs = MIN_SPIN_WINDOW_NS;
+    m_lastPacketNs = now();
+    m_lastPacketId = m_reader->currentPacketId();
+
+    qint64 deadline = now();
+    while (!isInterruptionRequested())
+    {
+        if (!m_reader->isSourceOpen())
+        {
+            waitForSource();
+            deadline = now();
+        }
+        else if (m_packetDriven.load())
+        {
+            waitForPacket();
+            deadline = now();
+        }
+        else
+        {
+            deadline = runPolledTick(deadline);
+        }
+
+        qint64 finished = now();
+        if ((finished - m_lastReportNs) >= JITTER_REPORT_INTERVAL_NS)
+        {
+            reportJitter(finished);
+        }
+    }
+
+    qDebug() << "AcquisitionThread stopped";
+}
+
+qint64 AcquisitionThread::runPolledTick(qint64 deadline)
+{
+    sleepUntil(deadline);
+    if (isInterruptionRequested())
+    {
+        return deadline;
+    }
+
+    qint64 wakeUp = now();
+    m_jitter.addSample(wakeUp - deadline);
+
+    m_reader->readData(deadline);
+    m_lastPacketId = m_reader->currentPacketId();
+
+    deadline += m_periodNs.load();
+
+    // Skip ticks that were missed instead of running them back to back
+    qint64 finished = now();
+    if (finished > deadline)
+    {
+        ++m_overruns;
+        deadline = finished;
+    }
+
+    return deadline;
+}
+
+void AcquisitionThread::waitForPacket()
+{
+    qint64 start = now();
+    qint64 spinWindow = qBound(MIN_SPIN_WINDOW_NS, 4 * m_packetDeviationNs, MAX_SPIN_WINDOW_NS);
+    qint64 expected = m_lastPacketNs + m_packetIntervalNs;
+
+    // Sleep until shortly before the next packet is expected
+    if ((expected - spinWindow) > start)
+    {
+        sleepUntil(expected - spinWindow);
+    }
+
+    qint64 lastCheck = now();
+    qint64 current = lastCheck;
+    qint32 packetId = m_lastPacketId;
+    bool received = false;
+    while (!isInterruptionRequested())
+    {
+        packetId = m_reader->currentPacketId();
+        current = now();
+        if (packetId != m_lastPacketId)
+        {
+            received = true;
+            break;
+        }
+
+        if ((current - start) >= PACKET_TIMEOUT_NS)
+        {
+            break;
+        }
+
+        lastCheck = current;
+        if (current < (expected + spinWindow))
+        {
+            CPU_RELAX();
+        }
+        else
+        {
+            sleepUntil(current + PACKET_POLL_SLEEP_NS);
+        }
+    }
+
+    if (isInterruptionRequested())
+    {
+        return;
+    }
+
+    if (received)
+    {
+        // The packet arrived somewhere between the last two checks
+        m_jitter.addSample(current - lastCheck);
+
+        // Track the packet interval and its deviation to size the spin window
+        qint64 interval = current - m_lastPacketNs;
+        if (interval < PACKET_TIMEOUT_NS)
+        {
+            qint64 deviation = qAbs(interval - m_packetIntervalNs);
+            m_packetIntervalNs += (interval - m_packetIntervalNs) / 8;
+            m_packetDeviationNs += (deviation - m_packetDeviationNs) / 8;
+        }
+
+        m_lastPacketNs = current;
+        m_lastPacketId = packetId;
+    }
+    else
+    {
+        ++m_overruns;
+    }
+
+    m_reader->readData(current);
+}
+
+void AcquisitionThread::waitForSource()
+{
+    // There is no packet id to poll before the pages are mapped
+    sleepUntil(now() + SOURCE_RETRY_INTERVAL_NS);
+    if (isInterruptionRequested())
+    {
+        return;
+    }
+
+    m_reader->readData(now());
+    m_lastPacketId = m_reader->currentPacketId();
+    m_lastPacketNs = now();
+}
+
+void AcquisitionThread::applySchedulingPolicy()
+{
+#if defined(Q_OS_LINUX)
+    if (m_cpu >= 0)
+    {
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        CPU_SET(m_cpu, &cpuSet);
+        int result = pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+        if (result != 0)
+        {
+            qWarning() << "Cannot pin acquisition thread to CPU" << m_cpu << ":" << strerror(result);
+        }
+    }
+
+    if (m_realtimePriority)
+    {
+        struct sched_param param;
+        param.sched_priority = sched_get_priority_min(SCHED_FIFO) + 1;
+        int result = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (result != 0)
+        {
+            qWarning() << "Cannot switch acquisition thread to SCHED_FIFO:" << strerror(result);
+        }
+    }
+#else
+    if (m_realtimePriority)
+    {
+        setPriority(QThread::TimeCriticalPriority);
+    }
+
+    if (m_cpu >= 0)
+    {
+        qWarning() << "CPU affinity is not supported on this platform";
+    }
+#endif
+}
+
+void AcquisitionThread::sleepUntil(qint64 deadlineNs)
+{
+    qint64 current = now();
+    while ((current < deadlineNs) && !isInterruptionRequested())
+    {
+        qint64 wakeUp = qMin(deadlineNs, current + MAX_SLEEP_SLICE_NS);
+
+#if defined(Q_OS_LINUX)
+        struct timespec ts;
+        ts.tv_sec = static_cast<time_t>(wakeUp / NS_PER_SECOND);
+        ts.tv_nsec = static_cast<long>(wakeUp % NS_PER_SECOND);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR)
+        {
+            // Interrupted by a signal, sleep again until the deadline
+        }
+#else
+        std::this_thread::sleep_until(std::chrono::steady_clock::time_point(std::chrono::nanoseconds(wakeUp)));
+#endif
+
+        current = now();
+    }
+}
+
+void AcquisitionThread::reportJitter(qint64 nowNs)
+{
+    if (m_packetDriven.load())
+    {
+        qDebug().noquote() << "Packet detection delay:" << m_jitter.summary() << "timeouts=" << m_overruns
+                           << "interval=" << (m_packetIntervalNs / 1000) << "us";
+    }
+    else
+    {
+        qDebug().noquote() << "Acquisition jitter:" << m_jitter.summary() << "overruns=" << m_overruns;
+    }
+
+    m_reader->reportFrameStatistics();
+
+    m_jitter.reset();
+    m_overruns = 0;
+    m_lastReportNs = nowNs;
+}
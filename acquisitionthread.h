@@ -0,0 +1,64 @@
+#ifndef ACQUISITIONTHREAD_DC7445E7EBA04C2EA42A9BC145C9127D
+#define ACQUISITIONTHREAD_DC7445E7EBA04C2EA42A9BC145C9127D
+
+#include <QThread>
+#include <atomic>
+#include "latencystatistics.h"
+
+class TelemetryReader;
+
+// Drives TelemetryReader::readData() from its own thread.
+// In polled mode every tick is scheduled on an absolute deadline, so the
+// period does not drift with the time spent in readData() and a late wake-up
+// is not carried over to the following ticks.
+// In packet driven mode the physics packetId is watched instead and every new
+// physics step is processed once, as soon as it is detected.
+class AcquisitionThread : public QThread
+{
+    Q_OBJECT
+public:
+    explicit AcquisitionThread(TelemetryReader* reader, QObject* parent = nullptr);
+    ~AcquisitionThread() override;
+
+    void setPeriod(qint64 periodNs);
+    qint64 getPeriod() const;
+
+    void setPacketDriven(bool packetDriven);
+    bool isPacketDriven() const;
+
+    // -1 lets the scheduler choose the CPU
+    void setCpuAffinity(qint32 cpu);
+    void setRealtimePriority(bool realtimePriority);
+
+    void stop();
+
+    // Monotonic clock all acquisition timestamps are based on
+    static qint64 now();
+
+private:
+    void run() override;
+    qint64 runPolledTick(qint64 deadline);
+    void waitForPacket();
+    void waitForSource();
+    void applySchedulingPolicy();
+    void sleepUntil(qint64 deadlineNs);
+    void reportJitter(qint64 nowNs);
+
+    TelemetryReader* const m_reader;
+    std::atomic<qint64> m_periodNs;
+    std::atomic<bool> m_packetDriven;
+    qint32 m_cpu = -1;
+    bool m_realtimePriority = false;
+
+    // Owned by the acquisition thread while it is running
+    LatencyStatistics m_jitter;
+    quint64 m_overruns = 0;
+    qint64 m_lastReportNs = 0;
+
+    qint32 m_lastPacketId = 0;
+    qint64 m_lastPacketNs = 0;
+    qint64 m_packetIntervalNs = 0;
+    qint64 m_packetDeviationNs = 0;
+};
+
+#endif // ACQUISITIONTHREAD_DC7445E7EBA04C2EA42A9BC145C9127D
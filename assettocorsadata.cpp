@@ -0,0 +1,250 @@
+
+/* 
+ * File:   AssettoCorsaData.cpp
+ * Author: Simon Plum
+ * 
+ * Created on 9. April 2018, 10:46
+ */
+
+#include "assettocorsadata.h"
+#include <atomic>
+#include <cstring>
+
+namespace
+{
+// The game is not synchronized with us, so the packet id is read through a
+// volatile access to force a fresh load from the shared page every time.
+int loadPacketId(const int* packetId)
+{
+    return *static_cast<const volatile int*>(packetId);
+}
+
+// The page is copied once between two loads of the packet id and copied
+// again only if the game changed the packet id meanwhile. A write that
+// leaves the packet id unchanged is not detected, which the game does not
+// do while it counts the packets.
+template <typename Page, typename FillFunction>
+bool readConsistent(const Page* page, Page &copy, FillFunction fill, quint64 &retries, int &packetId)
+{
+    bool consistent = false;
+    for (int attempt = 0; !consistent && (attempt <= MAX_SNAPSHOT_RETRIES); ++attempt)
+    {
+        if (attempt > 0)
+        {
+            ++retries;
+        }
+
+        int before = loadPacketId(&page->packetId);
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        std::memcpy(&copy, page, sizeof(Page));
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        int after = loadPacketId(&page->packetId);
+
+        packetId = after;
+        consistent = (before == after);
+    }
+
+    copy.packetId = packetId;
+    fill(copy);
+    return consistent;
+}
+}
+
+AssettoCorsaData::AssettoCorsaData(TelemetryBackend* backend)
+    : m_backend(backend)
+    , m_pfp(nullptr)
+    , m_pfg(nullptr)
+    , m_pfs(nullptr)
+    , m_snapshotRetries(0)
+    , m_snapshotFailures(0)
+{
+    if (m_backend == nullptr)
+    {
+        m_backend = TelemetryBackend::create();
+    }
+
+    update();
+}
+
+AssettoCorsaData::~AssettoCorsaData()
+{
+    delete m_backend;
+}
+
+bool AssettoCorsaData::isOpen() const
+{
+    return m_backend->isOpen();
+}
+
+void AssettoCorsaData::update()
+{
+    if (!m_backend->isOpen())
+    {
+        (void)m_backend->reopen();
+    }
+
+    //Get AC-Data buffers
+    m_pfp = m_backend->physics();
+    m_pfg = m_backend->graphics();
+    m_pfs = m_backend->staticData();
+}
+
+bool AssettoCorsaData::readFrame(TelemetryFrame &frame, SPageFilePhysics* physicsPage, SPageFileGraphic* graphicsPage)
+{
+    if (!isOpen())
+    {
+        return false;
+    }
+
+    bool physicsConsistent = readPhysics(frame, physicsPage);
+    bool graphicsConsistent = readGraphics(frame, graphicsPage);
+
+    if (!physicsConsistent)
+    {
+        ++m_snapshotFailures;
+    }
+
+    if (!graphicsConsistent)
+    {
+        ++m_snapshotFailures;
+    }
+
+    return (physicsConsistent && graphicsConsistent);
+}
+
+bool AssettoCorsaData::readPhysics(TelemetryFrame &frame, SPageFilePhysics* physicsPage)
+{
+    auto fill = [&frame](const SPageFilePhysics &pfp)
+    {
+        frame.gas = pfp.gas;
+        frame.brake = pfp.brake;
+        frame.speedKmh = pfp.speedKmh;
+        frame.abs = pfp.abs;
+        frame.tc = pfp.tc;
+
+        // All per-wheel fields in one pass
+        WheelFrame &wheels = frame.wheels;
+        for (qint32 i = 0; i < WHEEL_COUNT; ++i)
+        {
+            wheels.slip[i] = pfp.wheelSlip[i];
+            wheels.load[i] = pfp.wheelLoad[i];
+            wheels.angularSpeed[i] = pfp.wheelAngularSpeed[i];
+            wheels.suspensionTravel[i] = pfp.suspensionTravel[i];
+        }
+    };
+
+    SPageFilePhysics copy;
+    return readConsistent(m_pfp, (physicsPage != nullptr) ? *physicsPage : copy, fill, m_snapshotRetries, frame.physicsPacketId);
+}
+
+bool AssettoCorsaData::readGraphics(TelemetryFrame &frame, SPageFileGraphic* graphicsPage)
+{
+    auto fill = [&frame](const SPageFileGraphic &pfg)
+    {
+        frame.status = pfg.status;
+        frame.flag = pfg.flag;
+        frame.completedLaps = pfg.completedLaps;
+    };
+
+    SPageFileGraphic copy;
+    return readConsistent(m_pfg, (graphicsPage != nullptr) ? *graphicsPage : copy, fill, m_snapshotRetries, frame.graphicsPacketId);
+}
+
+void AssettoCorsaData::copyStaticPage(SPageFileStatic* dest)
+{
+    std::memcpy(dest, m_pfs, sizeof(SPageFileStatic));
+}
+
+int AssettoCorsaData::getPacketId() const
+{
+    if (m_pfp == nullptr)
+    {
+        return 0;
+    }
+
+    return loadPacketId(&m_pfp->packetId);
+}
+
+quint64 AssettoCorsaData::getSnapshotRetries() const
+{
+    return m_snapshotRetries;
+}
+
+quint64 AssettoCorsaData::getSnapshotFailures() const
+{
+    return m_snapshotFailures;
+}
+
+AC_STATUS AssettoCorsaData::getStatus()
+{
+    return m_pfg->status;
+}
+
+float AssettoCorsaData::getAccG0()
+{
+    return m_pfp->accG[0];
+}
+
+float AssettoCorsaData::getAccG1()
+{
+    return m_pfp->accG[1];
+}
+
+float AssettoCorsaData::getAccG2()
+{
+    return m_pfp->accG[2];
+}
+
+float AssettoCorsaData::getSpeedKmh()
+{
+    return m_pfp->speedKmh;
+}
+
+void AssettoCorsaData::getTyreRadius(WheelValueFloat &tyreRadius) const
+{
+    for (qint32 i = 0; i < WHEEL_COUNT; ++i)
+    {
+        tyreRadius[i] = m_pfs->tyreRadius[i];
+    }
+}
+
+void AssettoCorsaData::getSuspensionMaxTravel(WheelValueFloat &suspensionMaxTravel) const
+{
+    for (qint32 i = 0; i < WHEEL_COUNT; ++i)
+    {
+        suspensionMaxTravel[i] = m_pfs->suspensionMaxTravel[i];
+    }
+}
+
+QString AssettoCorsaData::getCarModel() const
+{
+    const qint32 maxLength = sizeof(m_pfs->carModel) / sizeof(m_pfs->carModel[0]);
+    qint32 length = 0;
+    while ((length < maxLength) && (m_pfs->carModel[length] != 0))
+    {
+        ++length;
+    }
+
+#ifdef _WIN32
+    return QString::fromWCharArray(m_pfs->carModel, length);
+#else
+    return QString::fromUtf16(m_pfs->carModel, length);
+#endif
+}
+
+float AssettoCorsaData::getRideHeight(int index)
+{
+    if ((index == 0) || (index == 1))
+    {
+        return m_pfp->rideHeight[index];
+    }
+    
+    return 0.0;
+}
+
+AC_FLAG_TYPE AssettoCorsaData::getFlagStatus()
+{
+    return m_pfg->flag;
+}
@@ -0,0 +1,82 @@
+#ifndef ASSETTOCORSADATA_BAFC17206BF9423AA9B6615821D526C3
+#define ASSETTOCORSADATA_BAFC17206BF9423AA9B6615821D526C3
+
+#include <QtGlobal>
+#include <QString>
+#include "sharedfileout.h"
+#include "telemetrybackend.h"
+#include "telemetryframe.h"
+
+// Number of times a page is copied again when the game wrote to it while it
+// was being copied
+static const int MAX_SNAPSHOT_RETRIES = 4;
+
+class AssettoCorsaData
+{
+public:
+    // Takes ownership of the backend, creates the platform's shared memory
+    // backend if none is given
+    explicit AssettoCorsaData(TelemetryBackend* backend = nullptr);
+    ~AssettoCorsaData();
+    AssettoCorsaData(const AssettoCorsaData&) = delete;
+    AssettoCorsaData& operator=(const AssettoCorsaData&) = delete;
+
+    bool isOpen() const;
+    
+    // Fetches the page pointers, retries opening the backend while it is
+    // not open. The pages must not be read before isOpen() is true.
+    void update();
+
+    // Copies the fields of the current physics step into the frame.
+    // Each page is copied once, with its packetId read before and after.
+    // The read is repeated if the packetId changed, which catches a write
+    // during the read only if the writer changed the packetId with it.
+    // Returns false if no consistent
+    // copy could be made within MAX_SNAPSHOT_RETRIES retries, the frame
+    // then holds the last attempt.
+    // If page buffers are given, the complete pages are copied into them
+    // within the same validated read and the frame is filled from the copy.
+    bool readFrame(TelemetryFrame &frame, SPageFilePhysics* physicsPage = nullptr, SPageFileGraphic* graphicsPage = nullptr);
+
+    // The static page has no packet id and is copied as is
+    void copyStaticPage(SPageFileStatic* dest);
+
+    // Current physics packet id, read directly from the shared page.
+    // 0 while the page is not mapped.
+    int getPacketId() const;
+
+    quint64 getSnapshotRetries() const;
+    quint64 getSnapshotFailures() const;
+    
+    AC_STATUS getStatus();
+    float getAccG0();
+    float getAccG1();
+    float getAccG2();
+    
+    float getSpeedKmh();
+
+    // Per-wheel values of the static page, all four wheels at once
+    void getTyreRadius(WheelValueFloat &tyreRadius) const;
+    void getSuspensionMaxTravel(WheelValueFloat &suspensionMaxTravel) const;
+    QString getCarModel() const;
+    
+    float getRideHeight(int index);
+
+    AC_FLAG_TYPE getFlagStatus();
+    
+private:
+    bool readPhysics(TelemetryFrame &frame, SPageFilePhysics* physicsPage);
+    bool readGraphics(TelemetryFrame &frame, SPageFileGraphic* graphicsPage);
+
+    TelemetryBackend* m_backend;
+
+    const SPageFilePhysics* m_pfp;
+    const SPageFileGraphic* m_pfg;
+    const SPageFileStatic* m_pfs;
+
+    quint64 m_snapshotRetries;
+    quint64 m_snapshotFailures;
+};
+
+#endif // ASSETTOCORSADATA_BAFC17206BF9423AA9B6615821D526C3
+
@@ -0,0 +1,121 @@
+#include "bandwidthplanner.h"
+#include <algorithm>
+#include "serialthread.h"
+
+// Part of the link that is planned, the rest covers gaps between bytes
+static const double LINK_HEADROOM = 0.8;
+// Below this a channel is too slow to be of use
+static const double MIN_CHANNEL_RATE = 5.0;
+
+
+void BandwidthPlanner::setTickRate(double ticksPerSecond)
+{
+    m_tickRate = ticksPerSecond;
+}
+
+void BandwidthPlanner::setBaudRate(const QString &port, qint32 baudRate)
+{
+    m_baudRates.insert(port, baudRate);
+}
+
+void BandwidthPlanner::addChannel(const QString &port, qint32 id, qint32 bytes, qint32 priority)
+{
+    PlannedChannel channel;
+    channel.port = port;
+    channel.id = id;
+    channel.bytes = bytes;
+    channel.priority = priority;
+    m_channels.append(channel);
+}
+
+void BandwidthPlanner::clearChannels()
+{
+    m_channels.clear();
+}
+
+double BandwidthPlanner::linkBytesPerSecond(qint32 baudRate)
+{
+    return static_cast<double>(baudRate) / 10.0;
+}
+
+bool BandwidthPlanner::plan()
+{
+    m_warnings.clear();
+    bool fits = true;
+
+    QList<QString> ports;
+    for (const PlannedChannel &channel : m_channels)
+    {
+        if (!ports.contains(channel.port))
+        {
+            ports.append(channel.port);
+        }
+    }
+
+    for (const QString &port : ports)
+    {
+        qint32 baudRate = m_baudRates.value(port, SerialThread::DEFAULT_BAUD_RATE);
+        double budget = linkBytesPerSecond(baudRate) * LINK_HEADROOM;
+
+        // Highest priority first
+        QList<PlannedChannel*> portChannels;
+        double demand = 0.0;
+        for (PlannedChannel &channel : m_channels)
+        {
+            if (channel.port == port)
+            {
+                portChannels.append(&channel);
+                demand += channel.bytes * m_tickRate;
+            }
+        }
+        std::stable_sort(portChannels.begin(), portChannels.end(), [](const PlannedChannel* left, const PlannedChannel* right)
+        {
+            return left->priority > right->priority;
+        });
+
+        // Every channel keeps its minimum rate, the rest goes by priority
+        double remaining = budget;
+        for (const PlannedChannel* channel : portChannels)
+        {
+            remaining -= channel->bytes * qMin(MIN_CHANNEL_RATE, m_tickRate);
+        }
+
+        QString slowed;
+        for (PlannedChannel* channel : portChannels)
+        {
+            double minimum = qMin(MIN_CHANNEL_RATE, m_tickRate);
+            double extra = qBound(0.0, remaining / channel->bytes, m_tickRate - minimum);
+            remaining -= extra * channel->bytes;
+            channel->rate = minimum + extra;
+            channel->minIntervalNs = (channel->rate < m_tickRate) ? static_cast<qint64>(1e9 / channel->rate) : 0;
+            if (channel->minIntervalNs > 0)
+            {
+                slowed += QString(" id %1 to %2/s").arg(channel->id).arg(channel->rate, 0, 'f', 0);
+            }
+        }
+
+        if (demand > budget)
+        {
+            m_warnings.append(QString("%1: %2 bytes/s needed at %3 ticks/s, %4 baud carry %5 bytes/s, slowed down%6")
+                              .arg(port).arg(demand, 0, 'f', 0).arg(m_tickRate, 0, 'f', 0).arg(baudRate)
+                              .arg(budget, 0, 'f', 0).arg(slowed));
+        }
+
+        if (remaining < 0.0)
+        {
+            fits = false;
+        }
+    }
+
+    return fits;
+}
+
+QList<PlannedChannel> BandwidthPlanner::channels() const
+{
+    return m_channels;
+}
+
+QList<QString> BandwidthPlanner::warnings() const
+{
+    return m_warnings;
+}
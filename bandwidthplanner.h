@@ -0,0 +1,52 @@
+#ifndef BANDWIDTHPLANNER_8BFD35D62E0549F7ACCA060461FFBF84
+#define BANDWIDTHPLANNER_8BFD35D62E0549F7ACCA060461FFBF84
+
+#include <QList>
+#include <QMap>
+#include <QString>
+
+// One kind of message sent to a port
+struct PlannedChannel
+{
+    QString port;
+    // Message id, see ID
+    qint32 id = 0;
+    qint32 bytes = 0;
+    // Channels with a higher priority keep their rate longer
+    qint32 priority = 0;
+
+    // Result of plan(): messages per second and the minimum time between two
+    // messages, 0 if the channel can be sent at every tick
+    double rate = 0.0;
+    qint64 minIntervalNs = 0;
+};
+
+// Checks that the messages of each port fit through its link when every
+// channel changes at every tick, and slows down the channels with the
+// lowest priority first if they do not.
+class BandwidthPlanner
+{
+public:
+    void setTickRate(double ticksPerSecond);
+    void setBaudRate(const QString &port, qint32 baudRate);
+    void addChannel(const QString &port, qint32 id, qint32 bytes, qint32 priority);
+    void clearChannels();
+
+    // Returns false if a port cannot carry even the minimum rate of its
+    // channels, warnings describe every port that needed slowing down
+    bool plan();
+
+    QList<PlannedChannel> channels() const;
+    QList<QString> warnings() const;
+
+    // Bytes per second a serial link carries, 10 bits per byte with 8N1
+    static double linkBytesPerSecond(qint32 baudRate);
+
+private:
+    double m_tickRate = 0.0;
+    QMap<QString, qint32> m_baudRates;
+    QList<PlannedChannel> m_channels;
+    QList<QString> m_warnings;
+};
+
+#endif // BANDWIDTHPLANNER_8BFD35D62E0549F7ACCA060461FFBF84
@@ -0,0 +1,126 @@
+#ifndef BITSTREAM_56A8B2708A7A4847892883E1C059B796
+#define BITSTREAM_56A8B2708A7A4847892883E1C059B796
+
+#include <QtGlobal>
+
+// Writes bits MSB first into a caller provided buffer.
+// At most 32 bits are written per call.
+class BitWriter
+{
+public:
+    BitWriter(uchar* data, qint64 capacity)
+        : m_data(data)
+        , m_capacity(capacity)
+    {
+
+    }
+
+    void write(quint32 value, qint32 count)
+    {
+        quint64 mask = (count == 32) ? 0xffffffffULL : ((1ULL << count) - 1);
+        m_buffer = (m_buffer << count) | (static_cast<quint64>(value) & mask);
+        m_bits += count;
+        while (m_bits >= 8)
+        {
+            m_bits -= 8;
+            if (m_size < m_capacity)
+            {
+                m_data[m_size] = static_cast<uchar>(m_buffer >> m_bits);
+            }
+            else
+            {
+                m_overflow = true;
+            }
+
+            ++m_size;
+        }
+    }
+
+    void write64(quint64 value)
+    {
+        write(static_cast<quint32>(value >> 32), 32);
+        write(static_cast<quint32>(value), 32);
+    }
+
+    // Pads the last byte with zeros, returns the number of bytes written
+    qint64 finish()
+    {
+        if (m_bits > 0)
+        {
+            write(0, 8 - m_bits);
+        }
+
+        return m_size;
+    }
+
+    bool overflow() const
+    {
+        return m_overflow;
+    }
+
+private:
+    uchar* m_data;
+    qint64 m_capacity;
+    qint64 m_size = 0;
+    quint64 m_buffer = 0;
+    qint32 m_bits = 0;
+    bool m_overflow = false;
+};
+
+// Reads bits written by BitWriter. Reading past the end returns zeros and
+// sets the overflow flag.
+class BitReader
+{
+public:
+    BitReader(const uchar* data, qint64 size)
+        : m_data(data)
+        , m_size(size)
+    {
+
+    }
+
+    quint32 read(qint32 count)
+    {
+        while (m_bits < count)
+        {
+            quint64 byte = 0;
+            if (m_position < m_size)
+            {
+                byte = m_data[m_position];
+            }
+            else
+            {
+                m_overflow = true;
+            }
+
+            ++m_position;
+            m_buffer = (m_buffer << 8) | byte;
+            m_bits += 8;
+        }
+
+        m_bits -= count;
+        quint64 mask = (count == 32) ? 0xffffffffULL : ((1ULL << count) - 1);
+        return static_cast<quint32>((m_buffer >> m_bits) & mask);
+    }
+
+    quint64 read64()
+    {
+        quint64 high = read(32);
+        return (high << 32) | read(32);
+    }
+
+    bool overflow() const
+    {
+        return m_overflow;
+    }
+
+private:
+    const uchar* m_data;
+    qint64 m_size;
+    qint64 m_position = 0;
+    quint64 m_buffer = 0;
+    qint32 m_bits = 0;
+    bool m_overflow = false;
+};
+
+#endif // BITSTREAM_56A8B2708A7A4847892883E1C059B796
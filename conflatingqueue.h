@@ -0,0 +1,57 @@
+#ifndef CONFLATINGQUEUE_BC5CD9122352424B8446B8E03BEA9CEF
+#define CONFLATINGQUEUE_BC5CD9122352424B8446B8E03BEA9CEF
+
+#include <QMutex>
+#include <QMutexLocker>
+
+// Queue of length one between a fast producer and a slow consumer.
+// A new value replaces a value that was not taken yet, so the consumer
+// always sees the latest value and never works through a backlog.
+template <typename T>
+class ConflatingQueue
+{
+public:
+    // Returns true if the queue was empty, i.e. the consumer has to be
+    // notified. While a value is pending no further notification is needed.
+    bool push(const T &value)
+    {
+        const QMutexLocker locker(&m_mutex);
+        m_value = value;
+        bool wasEmpty = !m_pending;
+        m_pending = true;
+        if (!wasEmpty)
+        {
+            ++m_conflated;
+        }
+
+        return wasEmpty;
+    }
+
+    bool take(T &value)
+    {
+        const QMutexLocker locker(&m_mutex);
+        if (!m_pending)
+        {
+            return false;
+        }
+
+        value = m_value;
+        m_pending = false;
+        return true;
+    }
+
+    // Number of values that were replaced before the consumer took them
+    quint64 conflated() const
+    {
+        const QMutexLocker locker(&m_mutex);
+        return m_conflated;
+    }
+
+private:
+    mutable QMutex m_mutex;
+    T m_value;
+    bool m_pending = false;
+    quint64 m_conflated = 0;
+};
+
+#endif // CONFLATINGQUEUE_BC5CD9122352424B8446B8E03BEA9CEF
@@ -0,0 +1,75 @@
+# Sources shared by the application and the command line tools
+
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+    $$PWD/serialthread.cpp \
+    $$PWD/devicewatcher.cpp \
+    $$PWD/bandwidthplanner.cpp \
+    $$PWD/protocolv2.cpp \
+    $$PWD/roundtriptracker.cpp \
+    $$PWD/telemetryreader.cpp \
+    $$PWD/slipkernel.cpp \
+    $$PWD/filterchain.cpp \
+    $$PWD/effects.cpp \
+    $$PWD/slidingspectrum.cpp \
+    $$PWD/quantilesketch.cpp \
+    $$PWD/slipcalibration.cpp \
+    $$PWD/outputpredictor.cpp \
+    $$PWD/assettocorsadata.cpp \
+    $$PWD/telemetrybackend.cpp \
+    $$PWD/acquisitionthread.cpp \
+    $$PWD/latencystatistics.cpp \
+    $$PWD/telemetryrecorder.cpp \
+    $$PWD/telemetryrecording.cpp \
+    $$PWD/framecodec.cpp \
+    $$PWD/replaybackend.cpp \
+    $$PWD/telemetryreplay.cpp \
+    $$PWD/settings.cpp \
+    $$PWD/sender.cpp
+
+HEADERS += \
+    $$PWD/serialthread.h \
+    $$PWD/devicewatcher.h \
+    $$PWD/bandwidthplanner.h \
+    $$PWD/protocolv2.h \
+    $$PWD/roundtriptracker.h \
+    $$PWD/telemetryreader.h \
+    $$PWD/slipkernel.h \
+    $$PWD/filterchain.h \
+    $$PWD/effectengine.h \
+    $$PWD/effects.h \
+    $$PWD/slidingspectrum.h \
+    $$PWD/quantilesketch.h \
+    $$PWD/slipcalibration.h \
+    $$PWD/outputpredictor.h \
+    $$PWD/assettocorsadata.h \
+    $$PWD/telemetrybackend.h \
+    $$PWD/telemetryframe.h \
+    $$PWD/acquisitionthread.h \
+    $$PWD/latencystatistics.h \
+    $$PWD/conflatingqueue.h \
+    $$PWD/spscring.h \
+    $$PWD/latestvaluemailbox.h \
+    $$PWD/recordingformat.h \
+    $$PWD/telemetryrecorder.h \
+    $$PWD/telemetryrecording.h \
+    $$PWD/bitstream.h \
+    $$PWD/framecodec.h \
+    $$PWD/replaybackend.h \
+    $$PWD/telemetryreplay.h \
+    $$PWD/sharedfileout.h \
+    $$PWD/settings.h \
+    $$PWD/sender.h \
+    $$PWD/globals.h
+
+win32 {
+    SOURCES += $$PWD/winsharedmemorybackend.cpp
+    HEADERS += $$PWD/winsharedmemorybackend.h
+}
+
+unix {
+    SOURCES += $$PWD/posixsharedmemorybackend.cpp
+    HEADERS += $$PWD/posixsharedmemorybackend.h
+    !macx: LIBS += -lrt
+}
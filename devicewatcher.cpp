@@ -0,0 +1,189 @@
+#include "devicewatcher.h"
+#include <QDebug>
+#include <QSerialPortInfo>
+#include <cstring>
+
+#if defined(Q_OS_LINUX)
+#include <linux/netlink.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+// How often the thread checks whether it should stop
+static const qint32 STOP_CHECK_INTERVAL_MS = 200;
+
+
+static QStringList availablePortNames()
+{
+    QStringList names;
+    for (const QSerialPortInfo &info : QSerialPortInfo::availablePorts())
+    {
+        names.append(info.portName());
+    }
+
+    return names;
+}
+
+DeviceWatcher::DeviceWatcher(QObject *parent)
+    : QThread(parent)
+{
+}
+
+DeviceWatcher::~DeviceWatcher()
+{
+    stop();
+}
+
+void DeviceWatcher::stop()
+{
+    requestInterruption();
+    wait();
+}
+
+void DeviceWatcher::run()
+{
+    qDebug() << "DeviceWatcher::run()";
+    m_ports = availablePortNames();
+
+    if (watchUevents())
+    {
+        return;
+    }
+
+    qDebug() << "Polling the serial ports every" << POLL_INTERVAL_MS << "ms";
+    qint32 waitedMs = 0;
+    while (!isInterruptionRequested())
+    {
+        msleep(STOP_CHECK_INTERVAL_MS);
+        waitedMs += STOP_CHECK_INTERVAL_MS;
+        if (waitedMs >= POLL_INTERVAL_MS)
+        {
+            waitedMs = 0;
+            pollPorts();
+        }
+    }
+}
+
+bool DeviceWatcher::watchUevents()
+{
+#if defined(Q_OS_LINUX)
+    // The kernel announces every device it adds or removes to group 1,
+    // no privileges needed
+    int socket = ::socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+    if (socket < 0)
+    {
+        return false;
+    }
+
+    sockaddr_nl address = {};
+    address.nl_family = AF_NETLINK;
+    address.nl_groups = 1;
+    if (bind(socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+    {
+        (void)close(socket);
+        return false;
+    }
+
+    qDebug() << "Watching the kernel for serial ports";
+    char buffer[8192];
+    pollfd descriptor = {socket, POLLIN, 0};
+    while (!isInterruptionRequested())
+    {
+        if (poll(&descriptor, 1, STOP_CHECK_INTERVAL_MS) <= 0)
+        {
+            continue;
+        }
+
+        ssize_t size = recv(socket, buffer, sizeof(buffer) - 1, MSG_DONTWAIT);
+        if (size <= 0)
+        {
+            continue;
+        }
+        buffer[size] = '\0';
+
+        // "add@/devices/...", then NUL separated KEY=value pairs
+        QString action;
+        QString subsystem;
+        QString deviceName;
+        for (ssize_t i = 0; i < size; i += static_cast<ssize_t>(strlen(buffer + i)) + 1)
+        {
+            QString field = QString::fromLocal8Bit(buffer + i);
+            if (field.startsWith("ACTION="))
+            {
+                action = field.mid(7);
+            }
+            else if (field.startsWith("SUBSYSTEM="))
+            {
+                subsystem = field.mid(10);
+            }
+            else if (field.startsWith("DEVNAME="))
+            {
+                deviceName = field.mid(8);
+            }
+        }
+
+        if ((subsystem != "tty") || deviceName.isEmpty())
+        {
+            continue;
+        }
+
+        if (deviceName.startsWith("/dev/"))
+        {
+            deviceName = deviceName.mid(5);
+        }
+
+        if (action == "add")
+        {
+            setPresent(deviceName, true);
+        }
+        else if (action == "remove")
+        {
+            setPresent(deviceName, false);
+        }
+    }
+
+    (void)close(socket);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void DeviceWatcher::pollPorts()
+{
+    QStringList ports = availablePortNames();
+    for (const QString &port : ports)
+    {
+        setPresent(port, true);
+    }
+
+    for (const QString &port : QStringList(m_ports))
+    {
+        if (!ports.contains(port))
+        {
+            setPresent(port, false);
+        }
+    }
+}
+
+void DeviceWatcher::setPresent(const QString &portName, bool present)
+{
+    if (present == m_ports.contains(portName))
+    {
+        return;
+    }
+
+    if (present)
+    {
+        qDebug() << "Serial port" << portName << "appeared";
+        m_ports.append(portName);
+        Q_EMIT portAdded(portName);
+    }
+    else
+    {
+        qDebug() << "Serial port" << portName << "disappeared";
+        (void)m_ports.removeAll(portName);
+        Q_EMIT portRemoved(portName);
+    }
+}
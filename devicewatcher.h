@@ -0,0 +1,37 @@
+#ifndef DEVICEWATCHER_26972927F93F49D6BB567EB4EB067315
+#define DEVICEWATCHER_26972927F93F49D6BB567EB4EB067315
+
+#include <QStringList>
+#include <QThread>
+
+// Reports serial ports that appear or disappear, with the names
+// QSerialPortInfo::portName() uses. On Linux it listens to the kernel's
+// uevents, elsewhere it compares the port list every POLL_INTERVAL_MS.
+// It has its own thread, so enumerating ports never delays the telemetry
+// or the serial writes.
+class DeviceWatcher : public QThread
+{
+    Q_OBJECT
+public:
+    static const qint32 POLL_INTERVAL_MS = 1000;
+
+    explicit DeviceWatcher(QObject* parent = nullptr);
+    ~DeviceWatcher() override;
+
+    void stop();
+
+Q_SIGNALS:
+    void portAdded(const QString &portName);
+    void portRemoved(const QString &portName);
+
+private:
+    void run() override;
+    bool watchUevents();
+    void pollPorts();
+    void setPresent(const QString &portName, bool present);
+
+    // Only used by the watcher thread
+    QStringList m_ports;
+};
+
+#endif // DEVICEWATCHER_26972927F93F49D6BB567EB4EB067315
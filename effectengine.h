@@ -0,0 +1,171 @@
+#ifndef EFFECTENGINE_18666DE6E8EE45B7A45E0478560BA9B1
+#define EFFECTENGINE_18666DE6E8EE45B7A45E0478560BA9B1
+
+#include <QtGlobal>
+#include <atomic>
+#include "telemetryframe.h"
+#include "slipkernel.h"
+
+class SlipCalibration;
+
+// Values the effects produce, each one is sent to a device
+enum EffectChannel
+{
+    GasChannel,
+    BrakeChannel,
+    FrontLeftChannel,
+    FrontRightChannel,
+    RearLeftChannel,
+    RearRightChannel,
+    WindFanChannel,
+    LedFlagChannel,
+    EFFECT_CHANNEL_COUNT
+};
+
+// Outputs of the effects as bits: one per channel, followed by the results
+// effects share with the effects after them
+static const quint32 GAS_OUTPUT = 1u << GasChannel;
+static const quint32 BRAKE_OUTPUT = 1u << BrakeChannel;
+static const quint32 PEDAL_OUTPUTS = GAS_OUTPUT | BRAKE_OUTPUT;
+static const quint32 WHEEL_OUTPUTS = (1u << FrontLeftChannel) | (1u << FrontRightChannel)
+                                     | (1u << RearLeftChannel) | (1u << RearRightChannel);
+static const quint32 WIND_FAN_OUTPUT = 1u << WindFanChannel;
+static const quint32 LED_FLAG_OUTPUT = 1u << LedFlagChannel;
+static const quint32 SLIP_CLASSIFICATION = 1u << EFFECT_CHANNEL_COUNT;
+
+// Channel of a wheel in per wheel mode
+inline EffectChannel wheelChannel(qint32 wheel)
+{
+    return static_cast<EffectChannel>(FrontLeftChannel + wheel);
+}
+
+// Everything the effects work on during one tick
+struct EffectContext
+{
+    // Input
+    const TelemetryFrame* frame = nullptr;
+    WheelValueFloat tyreRadius;
+    WheelValueFloat suspensionMaxTravel;
+    // Ticks per second
+    float sampleRate = 0.0f;
+    qint32 speed = 0;
+    float brakeIndex = 0.0f;
+    float gasIndex = 0.0f;
+    qint32 bumpingIndex = 0;
+    float absFrequency = 0.0f;
+    qint32 absIntensity = 0;
+    float tcFrequency = 0.0f;
+    qint32 tcIntensity = 0;
+    qint32 roadTextureIntensity = 0;
+    float roadTextureMinFrequency = 0.0f;
+    float roadTextureMaxFrequency = 0.0f;
+    // Learns and scales the slip of the current car, not used if null
+    SlipCalibration* slipCalibration = nullptr;
+
+    // Shared between effects
+    SlipKernelResult slip;
+    bool bumping = false;
+
+    // Output, cleared before every tick
+    qint32 channels[EFFECT_CHANNEL_COUNT] = {};
+
+    // Several effects can drive one channel, the strongest one wins
+    void mix(EffectChannel channel, qint32 value)
+    {
+        channels[channel] = qMax(channels[channel], value);
+    }
+};
+
+namespace EffectEngineDetail
+{
+// One node per registered effect. Index is the position of the effect,
+// Provided are the outputs of all effects before it.
+template <quint32 Index, quint32 Provided, typename... Effects>
+class EffectList
+{
+public:
+    quint32 enable(quint32 needed, quint32 &enabledEffects) const
+    {
+        (void)enabledEffects;
+        return needed;
+    }
+
+    void evaluate(EffectContext &context, quint32 enabledEffects)
+    {
+        (void)context;
+        (void)enabledEffects;
+    }
+};
+
+template <quint32 Index, quint32 Provided, typename Effect, typename... Rest>
+class EffectList<Index, Provided, Effect, Rest...>
+{
+    static_assert((Effect::REQUIRES & ~Provided) == 0, "An effect has to be registered after the effects it depends on");
+    static_assert(Index < 32, "Too many effects");
+
+public:
+    // Walks the effects backwards, an effect is needed if one of its
+    // outputs is needed by an active device or by a later effect
+    quint32 enable(quint32 needed, quint32 &enabledEffects) const
+    {
+        needed = m_rest.enable(needed, enabledEffects);
+        if ((Effect::PROVIDES & needed) != 0)
+        {
+            enabledEffects |= (1u << Index);
+            needed |= Effect::REQUIRES;
+        }
+
+        return needed;
+    }
+
+    void evaluate(EffectContext &context, quint32 enabledEffects)
+    {
+        if ((enabledEffects & (1u << Index)) != 0)
+        {
+            m_effect.evaluate(context);
+        }
+
+        m_rest.evaluate(context, enabledEffects);
+    }
+
+private:
+    Effect m_effect;
+    EffectList<Index + 1, Provided | Effect::PROVIDES, Rest...> m_rest;
+};
+}
+
+// Runs the effects in the order they are given, which has to respect their
+// dependencies. Every effect is called directly, there is no virtual call
+// per tick. An effect is a class with
+//     static const quint32 PROVIDES;   outputs it writes
+//     static const quint32 REQUIRES;   outputs of earlier effects it reads
+//     void evaluate(EffectContext &context);
+template <typename... Effects>
+class EffectEngine
+{
+public:
+    // Only the effects needed for these outputs are evaluated, can be
+    // called from any thread
+    void setActiveOutputs(quint32 outputs)
+    {
+        quint32 enabledEffects = 0;
+        (void)m_effects.enable(outputs, enabledEffects);
+        m_enabledEffects.store(enabledEffects, std::memory_order_relaxed);
+    }
+
+    void evaluate(EffectContext &context)
+    {
+        for (qint32 i = 0; i < EFFECT_CHANNEL_COUNT; ++i)
+        {
+            context.channels[i] = 0;
+        }
+
+        m_effects.evaluate(context, m_enabledEffects.load(std::memory_order_relaxed));
+    }
+
+private:
+    EffectEngineDetail::EffectList<0, 0, Effects...> m_effects;
+    std::atomic<quint32> m_enabledEffects {0};
+};
+
+#endif // EFFECTENGINE_18666DE6E8EE45B7A45E0478560BA9B1
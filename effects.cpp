@@ -0,0 +1,215 @@
+#include "effects.h"
+#include "slipcalibration.h"
+
+// Band RMS of the suspension travel that gives the full intensity, as part
+// of the maximum travel of the wheel
+static const float ROAD_TEXTURE_FULL_SCALE = 0.02f;
+// Used if the game does not report a maximum travel
+static const float DEFAULT_SUSPENSION_MAX_TRAVEL_M = 0.1f;
+// Pedal position below which ABS and traction control have nothing to do
+static const float AID_PEDAL_THRESHOLD = 0.05f;
+// Wheel slip at which the slip kernel counts a wheel as slipping
+static const float AID_SLIP_THRESHOLD = 1.0f;
+static const qint64 AID_HOLD_NS = 100000000;
+
+
+void WheelSlipEffect::evaluate(EffectContext &context)
+{
+    float speed = static_cast<float>(context.speed);
+    classifyWheelSlip(context.frame->wheels, context.tyreRadius, speed * context.brakeIndex, speed * context.gasIndex, context.slip);
+    context.bumping = (context.slip.bumpingMask != 0);
+
+    SlipCalibration* calibration = context.slipCalibration;
+    bool calibrated = false;
+    if (calibration != nullptr)
+    {
+        calibration->add(*context.frame, context.slip, context.speed);
+        calibrated = calibration->isCalibrated();
+    }
+
+    if (!calibrated)
+    {
+        context.mix(GasChannel, context.slip.maxGasValue);
+        context.mix(BrakeChannel, context.slip.maxBrakeValue);
+    }
+
+    for (qint32 i = 0; i < WHEEL_COUNT; ++i)
+    {
+        if (context.slip.status[i] == NotSlipping)
+        {
+            continue;
+        }
+
+        if (!calibrated)
+        {
+            context.mix(wheelChannel(i), context.slip.slip[i]);
+            continue;
+        }
+
+        qint32 value = calibration->scale(i, *context.frame, context.slip, context.speed);
+        context.mix(wheelChannel(i), value);
+        context.mix((context.slip.status[i] == SlippingFromBraking) ? BrakeChannel : GasChannel, value);
+    }
+}
+
+void BumpingEffect::evaluate(EffectContext &context)
+{
+    if (!context.bumping)
+    {
+        return;
+    }
+
+    context.mix(GasChannel, context.bumpingIndex);
+    context.mix(BrakeChannel, context.bumpingIndex);
+    for (qint32 i = 0; i < WHEEL_COUNT; ++i)
+    {
+        context.mix(wheelChannel(i), context.bumpingIndex);
+    }
+}
+
+void RoadTextureEffect::evaluate(EffectContext &context)
+{
+    if (context.roadTextureIntensity <= 0)
+    {
+        return;
+    }
+
+    if ((context.sampleRate != m_sampleRate)
+            || (context.roadTextureMinFrequency != m_minFrequency)
+            || (context.roadTextureMaxFrequency != m_maxFrequency))
+    {
+        m_sampleRate = context.sampleRate;
+        m_minFrequency = context.roadTextureMinFrequency;
+        m_maxFrequency = context.roadTextureMaxFrequency;
+        (void)m_spectrum.configure(m_sampleRate, m_minFrequency, m_maxFrequency);
+    }
+
+    // Nothing to detect if the ticks are too slow for the band
+    if (m_spectrum.binCount() == 0)
+    {
+        return;
+    }
+
+    m_spectrum.addSample(context.frame->wheels.suspensionTravel);
+    WheelValueFloat rms;
+    m_spectrum.bandRms(rms);
+
+    qint32 maxLevel = 0;
+    for (qint32 i = 0; i < WHEEL_COUNT; ++i)
+    {
+        float maxTravel = context.suspensionMaxTravel[i];
+        if (maxTravel <= 0.0f)
+        {
+            maxTravel = DEFAULT_SUSPENSION_MAX_TRAVEL_M;
+        }
+
+        float level = qMin(1.0f, rms[i] / (ROAD_TEXTURE_FULL_SCALE * maxTravel));
+        qint32 value = static_cast<qint32>(level * static_cast<float>(context.roadTextureIntensity));
+        context.mix(wheelChannel(i), value);
+        maxLevel = qMax(maxLevel, value);
+    }
+
+    context.mix(GasChannel, maxLevel);
+    context.mix(BrakeChannel, maxLevel);
+}
+
+qint32 PulsePattern::level(qint64 timestampNs, bool active, float frequency, qint32 intensity)
+{
+    if (!active || (frequency <= 0.0f))
+    {
+        m_active = false;
+        return 0;
+    }
+
+    if (!m_active)
+    {
+        m_active = true;
+        m_startNs = timestampNs;
+    }
+
+    qint64 periodNs = static_cast<qint64>(1e9f / frequency);
+    qint64 phaseNs = (timestampNs - m_startNs) % periodNs;
+    return ((phaseNs * 2) < periodNs) ? intensity : 0;
+}
+
+bool AidActivity::update(qint64 timestampNs, float aid, float pedal, const WheelValueFloat &slip)
+{
+    // Switching the aid on is not a sign of it working
+    bool changed = (m_lastAid > 0.0f) && (aid != m_lastAid);
+    m_lastAid = aid;
+
+    if ((aid <= 0.0f) || (pedal < AID_PEDAL_THRESHOLD))
+    {
+        m_active = false;
+        return false;
+    }
+
+    bool slipping = false;
+    for (qint32 i = 0; i < WHEEL_COUNT; ++i)
+    {
+        slipping = slipping || (slip[i] >= AID_SLIP_THRESHOLD);
+    }
+
+    if (slipping || changed)
+    {
+        m_active = true;
+        m_lastActiveNs = timestampNs;
+    }
+    else if (m_active && ((timestampNs - m_lastActiveNs) > AID_HOLD_NS))
+    {
+        m_active = false;
+    }
+
+    return m_active;
+}
+
+void AbsEffect::evaluate(EffectContext &context)
+{
+    const TelemetryFrame* frame = context.frame;
+    bool active = m_activity.update(frame->timestampNs, frame->abs, frame->brake, frame->wheels.slip);
+    context.mix(BrakeChannel, m_pattern.level(frame->timestampNs, active, context.absFrequency, context.absIntensity));
+}
+
+void TractionControlEffect::evaluate(EffectContext &context)
+{
+    const TelemetryFrame* frame = context.frame;
+    bool active = m_activity.update(frame->timestampNs, frame->tc, frame->gas, frame->wheels.slip);
+    context.mix(GasChannel, m_pattern.level(frame->timestampNs, active, context.tcFrequency, context.tcIntensity));
+}
+
+void WindFanEffect::evaluate(EffectContext &context)
+{
+    //TODO add adjustable parameter for speed sensitivity
+    context.mix(WindFanChannel, (context.speed / 3) * 2);
+}
+
+void LedFlagEffect::evaluate(EffectContext &context)
+{
+    qint32 flagValue = 0;
+    switch (context.frame->flag)
+    {
+    case AC_BLUE_FLAG:
+        flagValue = 1;
+        break;
+    case AC_YELLOW_FLAG:
+        flagValue = 2;
+        break;
+    case AC_BLACK_FLAG:
+        flagValue = 3;
+        break;
+    case AC_WHITE_FLAG:
+        flagValue = 4;
+        break;
+    case AC_CHECKERED_FLAG:
+        flagValue = 5;
+        break;
+    case AC_PENALTY_FLAG:
+        flagValue = 6;
+        break;
+    case AC_NO_FLAG:
+    default:
+        break;
+    }
+
+    context.mix(LedFlagChannel, flagValue);
+}
@@ -0,0 +1,121 @@
+#ifndef EFFECTS_21A10ED9AA9B41CB928A3C9E2571E793
+#define EFFECTS_21A10ED9AA9B41CB928A3C9E2571E793
+
+#include "effectengine.h"
+#include "slidingspectrum.h"
+
+// Slip of the wheels, as maximum per pedal and per wheel. Scaled to the
+// range of the car once the slip calibration has learnt it.
+class WheelSlipEffect
+{
+public:
+    static const quint32 PROVIDES = PEDAL_OUTPUTS | WHEEL_OUTPUTS | SLIP_CLASSIFICATION;
+    static const quint32 REQUIRES = 0;
+
+    void evaluate(EffectContext &context);
+};
+
+// Lets everything vibrate a bit while a wheel has no load
+class BumpingEffect
+{
+public:
+    static const quint32 PROVIDES = PEDAL_OUTPUTS | WHEEL_OUTPUTS;
+    static const quint32 REQUIRES = SLIP_CLASSIFICATION;
+
+    void evaluate(EffectContext &context);
+};
+
+// Kerbs and rumble strips, from the high frequency part of the suspension
+// travel of every wheel
+class RoadTextureEffect
+{
+public:
+    static const quint32 PROVIDES = PEDAL_OUTPUTS | WHEEL_OUTPUTS;
+    static const quint32 REQUIRES = 0;
+
+    void evaluate(EffectContext &context);
+
+private:
+    SlidingSpectrum m_spectrum;
+    float m_sampleRate = 0.0f;
+    float m_minFrequency = 0.0f;
+    float m_maxFrequency = 0.0f;
+};
+
+// Square wave timed by the acquisition clock, so the frequency does not
+// depend on how often it is sampled. Starts with a pulse when activated.
+class PulsePattern
+{
+public:
+    qint32 level(qint64 timestampNs, bool active, float frequency, qint32 intensity);
+
+private:
+    bool m_active = false;
+    qint64 m_startNs = 0;
+};
+
+// The game only reports the setting of ABS and traction control, not when
+// they work. An aid counts as working while it is switched on, its pedal is
+// pressed and a wheel slips or the game changes the aid value. Held for a
+// moment after the last sign, so the pulses are not cut off between frames.
+class AidActivity
+{
+public:
+    bool update(qint64 timestampNs, float aid, float pedal, const WheelValueFloat &slip);
+
+private:
+    float m_lastAid = 0.0f;
+    qint64 m_lastActiveNs = 0;
+    bool m_active = false;
+};
+
+// Pulses the brake while ABS is working
+class AbsEffect
+{
+public:
+    static const quint32 PROVIDES = BRAKE_OUTPUT;
+    static const quint32 REQUIRES = 0;
+
+    void evaluate(EffectContext &context);
+
+private:
+    AidActivity m_activity;
+    PulsePattern m_pattern;
+};
+
+// Pulses the gas while traction control is working
+class TractionControlEffect
+{
+public:
+    static const quint32 PROVIDES = GAS_OUTPUT;
+    static const quint32 REQUIRES = 0;
+
+    void evaluate(EffectContext &context);
+
+private:
+    AidActivity m_activity;
+    PulsePattern m_pattern;
+};
+
+class WindFanEffect
+{
+public:
+    static const quint32 PROVIDES = WIND_FAN_OUTPUT;
+    static const quint32 REQUIRES = 0;
+
+    void evaluate(EffectContext &context);
+};
+
+class LedFlagEffect
+{
+public:
+    static const quint32 PROVIDES = LED_FLAG_OUTPUT;
+    static const quint32 REQUIRES = 0;
+
+    void evaluate(EffectContext &context);
+};
+
+// All effects, in the order they run. Add new effects here.
+typedef EffectEngine<WheelSlipEffect, BumpingEffect, RoadTextureEffect, AbsEffect, TractionControlEffect, WindFanEffect, LedFlagEffect> RegisteredEffects;
+
+#endif // EFFECTS_21A10ED9AA9B41CB928A3C9E2571E793
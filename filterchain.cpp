@@ -0,0 +1,202 @@
+#include "filterchain.h"
+#include <QStringList>
+#include <QtMath>
+#include <cmath>
+
+// Below this the state is flushed to 0, so a decaying output does not end
+// up in denormals
+static const float FLUSH_THRESHOLD = 1e-6f;
+
+
+bool FilterChain::configure(const QString &description, float sampleRate)
+{
+    m_stageCount = 0;
+    m_description = QString();
+
+    if (sampleRate <= 0.0f)
+    {
+        return false;
+    }
+
+    QStringList stages = description.split(',');
+    for (const QString &stage : stages)
+    {
+        if (stage.trimmed().isEmpty())
+        {
+            continue;
+        }
+
+        if ((m_stageCount == MAX_STAGES) || !addStage(stage.trimmed(), sampleRate))
+        {
+            m_stageCount = 0;
+            return false;
+        }
+    }
+
+    m_description = description.trimmed();
+    return true;
+}
+
+bool FilterChain::addStage(const QString &stage, float sampleRate)
+{
+    QStringList parts = stage.split(':');
+    if (parts.size() != 2)
+    {
+        return false;
+    }
+
+    bool ok = false;
+    float parameter = parts[1].trimmed().toFloat(&ok);
+    if (!ok || (parameter < 0.0f))
+    {
+        return false;
+    }
+
+    Stage result;
+    result.parameter = parameter;
+
+    QString type = parts[0].trimmed().toLower();
+    if (type == "ema")
+    {
+        // Time constant in ms to the weight of a new value
+        result.type = SmoothingStage;
+        float samples = (parameter / 1000.0f) * sampleRate;
+        result.b0 = (samples > 0.0f) ? (1.0f - std::exp(-1.0f / samples)) : 1.0f;
+    }
+    else if (type == "lowpass")
+    {
+        if (parameter <= 0.0f)
+        {
+            return false;
+        }
+
+        // Bilinear transform of a Butterworth low pass, the cutoff has to
+        // stay below the Nyquist frequency
+        result.type = LowPassStage;
+        float cutoff = qMin(parameter, sampleRate * 0.45f);
+        float omega = 2.0f * static_cast<float>(M_PI) * cutoff / sampleRate;
+        float alpha = std::sin(omega) / (2.0f * static_cast<float>(M_SQRT1_2));
+        float cosine = std::cos(omega);
+        float a0 = 1.0f + alpha;
+        result.b0 = ((1.0f - cosine) / 2.0f) / a0;
+        result.b1 = (1.0f - cosine) / a0;
+        result.b2 = result.b0;
+        result.a1 = (-2.0f * cosine) / a0;
+        result.a2 = (1.0f - alpha) / a0;
+    }
+    else if (type == "deadband")
+    {
+        result.type = DeadbandStage;
+    }
+    else if (type == "slew")
+    {
+        if (parameter <= 0.0f)
+        {
+            return false;
+        }
+
+        // Units per second to units per value
+        result.type = SlewRateStage;
+        result.b0 = parameter / sampleRate;
+    }
+    else
+    {
+        return false;
+    }
+
+    m_stages[m_stageCount++] = result;
+    return true;
+}
+
+void FilterChain::reset()
+{
+    for (qint32 i = 0; i < m_stageCount; ++i)
+    {
+        m_stages[i].z1 = 0.0f;
+        m_stages[i].z2 = 0.0f;
+        m_stages[i].last = 0.0f;
+        m_stages[i].primed = false;
+    }
+}
+
+qint32 FilterChain::process(qint32 value)
+{
+    if (m_stageCount == 0)
+    {
+        return value;
+    }
+
+    float filtered = static_cast<float>(value);
+    for (qint32 i = 0; i < m_stageCount; ++i)
+    {
+        filtered = processStage(m_stages[i], filtered);
+    }
+
+    return qRound(filtered);
+}
+
+float FilterChain::processStage(Stage &stage, float value)
+{
+    // Start from the first value instead of ramping up from 0
+    if (!stage.primed)
+    {
+        stage.primed = true;
+        stage.last = value;
+        stage.z1 = value * (1.0f - stage.b0);
+        stage.z2 = value * (stage.b2 - stage.a2);
+        return value;
+    }
+
+    switch (stage.type)
+    {
+    case SmoothingStage:
+        stage.last += stage.b0 * (value - stage.last);
+        if (std::fabs(stage.last) < FLUSH_THRESHOLD)
+        {
+            stage.last = 0.0f;
+        }
+        break;
+
+    case LowPassStage:
+    {
+        // Transposed direct form II
+        float output = (stage.b0 * value) + stage.z1;
+        stage.z1 = (stage.b1 * value) - (stage.a1 * output) + stage.z2;
+        stage.z2 = (stage.b2 * value) - (stage.a2 * output);
+        if (std::fabs(stage.z1) < FLUSH_THRESHOLD)
+        {
+            stage.z1 = 0.0f;
+        }
+        if (std::fabs(stage.z2) < FLUSH_THRESHOLD)
+        {
+            stage.z2 = 0.0f;
+        }
+        stage.last = output;
+        break;
+    }
+
+    case DeadbandStage:
+        // Small changes are ignored, but the effect is always allowed to stop
+        if ((std::fabs(value) < 0.5f) || (std::fabs(value - stage.last) > stage.parameter))
+        {
+            stage.last = value;
+        }
+        break;
+
+    case SlewRateStage:
+        stage.last += qBound(-stage.b0, value - stage.last, stage.b0);
+        break;
+    }
+
+    return stage.last;
+}
+
+bool FilterChain::isEmpty() const
+{
+    return (m_stageCount == 0);
+}
+
+QString FilterChain::description() const
+{
+    return m_description;
+}
@@ -0,0 +1,62 @@
+#ifndef FILTERCHAIN_7F7E6777E8FE4FB39B86BE44F4CD0445
+#define FILTERCHAIN_7F7E6777E8FE4FB39B86BE44F4CD0445
+
+#include <QtGlobal>
+#include <QString>
+
+enum FilterStageType
+{
+    SmoothingStage,     // "ema:<time constant in ms>"
+    LowPassStage,       // "lowpass:<cutoff in Hz>", second order Butterworth
+    DeadbandStage,      // "deadband:<width>", hysteresis around the last output
+    SlewRateStage       // "slew:<units per second>"
+};
+
+// Filters one effect output before it is sent. The stages are given as a
+// comma separated list like "ema:20,deadband:1" and run in that order.
+// Configure it outside of the acquisition loop, processing a value never
+// allocates.
+class FilterChain
+{
+public:
+    static const qint32 MAX_STAGES = 4;
+
+    // Returns false and keeps no stages if the description is invalid.
+    // The sample rate is the number of values processed per second.
+    bool configure(const QString &description, float sampleRate);
+    void reset();
+
+    qint32 process(qint32 value);
+
+    bool isEmpty() const;
+    QString description() const;
+
+private:
+    struct Stage
+    {
+        FilterStageType type = SmoothingStage;
+        float parameter = 0.0f;
+
+        // Coefficients, only the low pass uses all of them
+        float b0 = 0.0f;
+        float b1 = 0.0f;
+        float b2 = 0.0f;
+        float a1 = 0.0f;
+        float a2 = 0.0f;
+
+        // State
+        float z1 = 0.0f;
+        float z2 = 0.0f;
+        float last = 0.0f;
+        bool primed = false;
+    };
+
+    bool addStage(const QString &stage, float sampleRate);
+    static float processStage(Stage &stage, float value);
+
+    Stage m_stages[MAX_STAGES];
+    qint32 m_stageCount = 0;
+    QString m_description;
+};
+
+#endif // FILTERCHAIN_7F7E6777E8FE4FB39B86BE44F4CD0445
@@ -0,0 +1,372 @@
+#include "framecodec.h"
+#include <cstring>
+#include "bitstream.h"
+
+namespace
+{
+bool fitsSigned(qint64 value, qint32 bits)
+{
+    qint64 limit = 1LL << (bits - 1);
+    return (value >= -limit) && (value < limit);
+}
+
+qint64 signExtend(quint64 value, qint32 bits)
+{
+    quint64 sign = 1ULL << (bits - 1);
+    return static_cast<qint64>((value ^ sign) - sign);
+}
+
+// XOR encoding of one column, the words are stride apart
+void encodeWords(BitWriter &writer, const quint32* words, qint32 stride, qint32 count)
+{
+    quint32 previous = words[0];
+    writer.write(previous, 32);
+
+    qint32 previousLeading = -1;
+    qint32 previousTrailing = 0;
+    for (qint32 i = 1; i < count; ++i)
+    {
+        quint32 value = words[i * stride];
+        quint32 delta = value ^ previous;
+        previous = value;
+
+        if (delta == 0)
+        {
+            writer.write(0, 1);
+            continue;
+        }
+
+        qint32 leading = static_cast<qint32>(qCountLeadingZeroBits(delta));
+        qint32 trailing = static_cast<qint32>(qCountTrailingZeroBits(delta));
+        if ((previousLeading >= 0) && (leading >= previousLeading) && (trailing >= previousTrailing))
+        {
+            // Fits into the window of the previous value
+            writer.write(0x2, 2);
+            writer.write(delta >> previousTrailing, 32 - previousLeading - previousTrailing);
+        }
+        else
+        {
+            qint32 length = 32 - leading - trailing;
+            writer.write(0x3, 2);
+            writer.write(static_cast<quint32>(leading), 5);
+            writer.write(static_cast<quint32>(length - 1), 5);
+            writer.write(delta >> trailing, length);
+            previousLeading = leading;
+            previousTrailing = trailing;
+        }
+    }
+}
+
+void decodeWords(BitReader &reader, quint32* words, qint32 stride, qint32 count)
+{
+    quint32 previous = reader.read(32);
+    words[0] = previous;
+
+    qint32 previousLeading = 0;
+    qint32 previousTrailing = 0;
+    for (qint32 i = 1; i < count; ++i)
+    {
+        if (reader.read(1) != 0)
+        {
+            if (reader.read(1) != 0)
+            {
+                previousLeading = static_cast<qint32>(reader.read(5));
+                previousTrailing = 32 - previousLeading - (static_cast<qint32>(reader.read(5)) + 1);
+                if (previousTrailing < 0)
+                {
+                    // Damaged block, the caller sees it by the values
+                    previousTrailing = 0;
+                }
+            }
+
+            qint32 length = 32 - previousLeading - previousTrailing;
+            if (length > 0)
+            {
+                previous ^= (reader.read(length) << previousTrailing);
+            }
+        }
+
+        words[i * stride] = previous;
+    }
+}
+
+// Delta-of-delta encoding. The buckets are wider than in Gorilla because
+// the timestamps are in nanoseconds and jitter by tens of microseconds.
+void encodeSeries(BitWriter &writer, const qint64* values, qint32 count)
+{
+    writer.write64(static_cast<quint64>(values[0]));
+
+    qint64 previousDelta = 0;
+    for (qint32 i = 1; i < count; ++i)
+    {
+        qint64 delta = values[i] - values[i - 1];
+        qint64 deltaOfDelta = delta - previousDelta;
+        previousDelta = delta;
+
+        if (deltaOfDelta == 0)
+        {
+            writer.write(0, 1);
+        }
+        else if (fitsSigned(deltaOfDelta, 14))
+        {
+            writer.write(0x2, 2);
+            writer.write(static_cast<quint32>(deltaOfDelta), 14);
+        }
+        else if (fitsSigned(deltaOfDelta, 20))
+        {
+            writer.write(0x6, 3);
+            writer.write(static_cast<quint32>(deltaOfDelta), 20);
+        }
+        else if (fitsSigned(deltaOfDelta, 32))
+        {
+            writer.write(0xe, 4);
+            writer.write(static_cast<quint32>(deltaOfDelta), 32);
+        }
+        else
+        {
+            writer.write(0xf, 4);
+            writer.write64(static_cast<quint64>(deltaOfDelta));
+        }
+    }
+}
+
+void decodeSeries(BitReader &reader, qint64* values, qint32 count)
+{
+    values[0] = static_cast<qint64>(reader.read64());
+
+    qint64 previousDelta = 0;
+    for (qint32 i = 1; i < count; ++i)
+    {
+        qint64 deltaOfDelta = 0;
+        if (reader.read(1) != 0)
+        {
+            if (reader.read(1) == 0)
+            {
+                deltaOfDelta = signExtend(reader.read(14), 14);
+            }
+            else if (reader.read(1) == 0)
+            {
+                deltaOfDelta = signExtend(reader.read(20), 20);
+            }
+            else if (reader.read(1) == 0)
+            {
+                deltaOfDelta = signExtend(reader.read(32), 32);
+            }
+            else
+            {
+                deltaOfDelta = static_cast<qint64>(reader.read64());
+            }
+        }
+
+        previousDelta += deltaOfDelta;
+        values[i] = values[i - 1] + previousDelta;
+    }
+}
+}
+
+FrameBlockEncoder::FrameBlockEncoder()
+{
+    m_physicsWords.resize(MAX_BLOCK_PHYSICS_PAGES * PHYSICS_WORDS);
+    m_physicsTimes.resize(MAX_BLOCK_PHYSICS_PAGES);
+    m_graphicsWords.resize(MAX_BLOCK_GRAPHICS_PAGES * GRAPHICS_WORDS);
+    m_graphicsTimes.resize(MAX_BLOCK_GRAPHICS_PAGES);
+    m_graphicsPositions.resize(MAX_BLOCK_GRAPHICS_PAGES);
+    m_output.resize(static_cast<qint32>(MAX_COMPRESSED_BLOCK_SIZE));
+}
+
+bool FrameBlockEncoder::add(RecordType type, qint64 timestampNs, const void* payload)
+{
+    switch (type)
+    {
+    case PhysicsRecord:
+        if (m_physicsCount >= MAX_BLOCK_PHYSICS_PAGES)
+        {
+            return false;
+        }
+
+        std::memcpy(m_physicsWords.data() + (m_physicsCount * PHYSICS_WORDS), payload, sizeof(SPageFilePhysics));
+        m_physicsTimes[m_physicsCount] = timestampNs;
+        ++m_physicsCount;
+        break;
+
+    case GraphicsRecord:
+        if (m_graphicsCount >= MAX_BLOCK_GRAPHICS_PAGES)
+        {
+            return false;
+        }
+
+        std::memcpy(m_graphicsWords.data() + (m_graphicsCount * GRAPHICS_WORDS), payload, sizeof(SPageFileGraphic));
+        m_graphicsTimes[m_graphicsCount] = timestampNs;
+        m_graphicsPositions[m_graphicsCount] = m_physicsCount;
+        ++m_graphicsCount;
+        break;
+
+    default:
+        return false;
+    }
+
+    m_lastTimestamp = timestampNs;
+    return true;
+}
+
+bool FrameBlockEncoder::isEmpty() const
+{
+    return ((m_physicsCount == 0) && (m_graphicsCount == 0));
+}
+
+qint64 FrameBlockEncoder::lastTimestamp() const
+{
+    return m_lastTimestamp;
+}
+
+qint64 FrameBlockEncoder::rawSize() const
+{
+    return (static_cast<qint64>(m_physicsCount) * sizeof(SPageFilePhysics))
+            + (static_cast<qint64>(m_graphicsCount) * sizeof(SPageFileGraphic));
+}
+
+quint32 FrameBlockEncoder::finish()
+{
+    CompressedBlockHeader header;
+    header.physicsCount = static_cast<quint16>(m_physicsCount);
+    header.graphicsCount = static_cast<quint16>(m_graphicsCount);
+    header.reserved = 0;
+    std::memcpy(m_output.data(), &header, sizeof(header));
+
+    BitWriter writer(m_output.data() + sizeof(header), m_output.size() - static_cast<qint32>(sizeof(header)));
+    if (m_physicsCount > 0)
+    {
+        encodeSeries(writer, m_physicsTimes.constData(), m_physicsCount);
+        for (qint32 column = 0; column < PHYSICS_WORDS; ++column)
+        {
+            encodeWords(writer, m_physicsWords.constData() + column, PHYSICS_WORDS, m_physicsCount);
+        }
+    }
+
+    if (m_graphicsCount > 0)
+    {
+        encodeSeries(writer, m_graphicsPositions.constData(), m_graphicsCount);
+        encodeSeries(writer, m_graphicsTimes.constData(), m_graphicsCount);
+        for (qint32 column = 0; column < GRAPHICS_WORDS; ++column)
+        {
+            encodeWords(writer, m_graphicsWords.constData() + column, GRAPHICS_WORDS, m_graphicsCount);
+        }
+    }
+
+    qint64 size = static_cast<qint64>(sizeof(header)) + writer.finish();
+    Q_ASSERT(!writer.overflow());
+
+    m_physicsCount = 0;
+    m_graphicsCount = 0;
+    return static_cast<quint32>(size);
+}
+
+const uchar* FrameBlockEncoder::data() const
+{
+    return m_output.constData();
+}
+
+FrameBlockDecoder::FrameBlockDecoder()
+{
+    m_physicsWords.resize(MAX_BLOCK_PHYSICS_PAGES * PHYSICS_WORDS);
+    m_physicsTimes.resize(MAX_BLOCK_PHYSICS_PAGES);
+    m_graphicsWords.resize(MAX_BLOCK_GRAPHICS_PAGES * GRAPHICS_WORDS);
+    m_graphicsTimes.resize(MAX_BLOCK_GRAPHICS_PAGES);
+    m_graphicsPositions.resize(MAX_BLOCK_GRAPHICS_PAGES);
+    m_order.resize(MAX_BLOCK_PHYSICS_PAGES + MAX_BLOCK_GRAPHICS_PAGES);
+}
+
+bool FrameBlockDecoder::decode(const uchar* data, quint32 size)
+{
+    m_count = 0;
+    if (size < sizeof(CompressedBlockHeader))
+    {
+        return false;
+    }
+
+    CompressedBlockHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    qint32 physicsCount = header.physicsCount;
+    qint32 graphicsCount = header.graphicsCount;
+    if ((physicsCount > MAX_BLOCK_PHYSICS_PAGES) || (graphicsCount > MAX_BLOCK_GRAPHICS_PAGES))
+    {
+        return false;
+    }
+
+    BitReader reader(data + sizeof(header), size - sizeof(header));
+    if (physicsCount > 0)
+    {
+        decodeSeries(reader, m_physicsTimes.data(), physicsCount);
+        for (qint32 column = 0; column < PHYSICS_WORDS; ++column)
+        {
+            decodeWords(reader, m_physicsWords.data() + column, PHYSICS_WORDS, physicsCount);
+        }
+    }
+
+    if (graphicsCount > 0)
+    {
+        decodeSeries(reader, m_graphicsPositions.data(), graphicsCount);
+        decodeSeries(reader, m_graphicsTimes.data(), graphicsCount);
+        for (qint32 column = 0; column < GRAPHICS_WORDS; ++column)
+        {
+            decodeWords(reader, m_graphicsWords.data() + column, GRAPHICS_WORDS, graphicsCount);
+        }
+    }
+
+    if (reader.overflow())
+    {
+        return false;
+    }
+
+    // Graphics pages go before the physics page at their position
+    qint32 graphics = 0;
+    for (qint32 physics = 0; physics <= physicsCount; ++physics)
+    {
+        while ((graphics < graphicsCount) && (m_graphicsPositions[graphics] <= physics))
+        {
+            m_order[m_count++] = ~graphics;
+            ++graphics;
+        }
+
+        if (physics < physicsCount)
+        {
+            m_order[m_count++] = physics;
+        }
+    }
+
+    while (graphics < graphicsCount)
+    {
+        m_order[m_count++] = ~graphics;
+        ++graphics;
+    }
+
+    return true;
+}
+
+qint32 FrameBlockDecoder::count() const
+{
+    return m_count;
+}
+
+RecordView FrameBlockDecoder::page(qint32 index) const
+{
+    RecordView record;
+    qint32 order = m_order[index];
+    if (order >= 0)
+    {
+        record.type = PhysicsRecord;
+        record.timestampNs = m_physicsTimes[order];
+        record.payload = reinterpret_cast<const uchar*>(m_physicsWords.constData() + (order * PHYSICS_WORDS));
+        record.size = sizeof(SPageFilePhysics);
+    }
+    else
+    {
+        qint32 graphics = ~order;
+        record.type = GraphicsRecord;
+        record.timestampNs = m_graphicsTimes[graphics];
+        record.payload = reinterpret_cast<const uchar*>(m_graphicsWords.constData() + (graphics * GRAPHICS_WORDS));
+        record.size = sizeof(SPageFileGraphic);
+    }
+
+    return record;
+}
@@ -0,0 +1,102 @@
+#ifndef FRAMECODEC_44AAD732A0AA455992079BE411927F7F
+#define FRAMECODEC_44AAD732A0AA455992079BE411927F7F
+
+#include <QVector>
+#include "recordingformat.h"
+
+// Pages are compressed as columns of 32 bit words: word n of every page in
+// a block forms one column. Each column is stored like a Gorilla time
+// series, as the XOR with the previous value, with the leading and
+// trailing zero bits left out. Timestamps are stored as delta-of-delta.
+// Most words of the physics page change little or not at all from one
+// step to the next, so most XORs cost one or two bits.
+//
+// Block layout:
+//   CompressedBlockHeader
+//   bits: physics timestamps, physics columns,
+//         graphics positions, graphics timestamps, graphics columns
+//
+// The position of a graphics page is the number of physics pages before
+// it in the block, which restores the order the pages were recorded in.
+
+static_assert((sizeof(SPageFilePhysics) % 4) == 0, "Physics page is not made of 32 bit words");
+static_assert((sizeof(SPageFileGraphic) % 4) == 0, "Graphics page is not made of 32 bit words");
+
+static const qint32 PHYSICS_WORDS = sizeof(SPageFilePhysics) / 4;
+static const qint32 GRAPHICS_WORDS = sizeof(SPageFileGraphic) / 4;
+
+static const qint32 MAX_BLOCK_PHYSICS_PAGES = 512;
+static const qint32 MAX_BLOCK_GRAPHICS_PAGES = 512;
+
+struct CompressedBlockHeader
+{
+    quint16 physicsCount;
+    quint16 graphicsCount;
+    quint32 reserved;
+};
+
+// Worst case: 44 bits per word, 68 bits per timestamp and position
+static const qint64 MAX_COMPRESSED_BLOCK_SIZE = sizeof(CompressedBlockHeader)
+        + (((static_cast<qint64>(MAX_BLOCK_PHYSICS_PAGES) * ((PHYSICS_WORDS * 44) + 68))
+            + (static_cast<qint64>(MAX_BLOCK_GRAPHICS_PAGES) * ((GRAPHICS_WORDS * 44) + 136)) + 7) / 8);
+
+// Collects pages and compresses them into one block.
+// All buffers are allocated once by the constructor.
+class FrameBlockEncoder
+{
+public:
+    FrameBlockEncoder();
+
+    // Returns false if the block has no room for the page, it has to be
+    // finished before the page can be added
+    bool add(RecordType type, qint64 timestampNs, const void* payload);
+
+    bool isEmpty() const;
+    qint64 lastTimestamp() const;
+
+    // Size of the pages added since the block was started
+    qint64 rawSize() const;
+
+    // Compresses the block into data() and starts a new one.
+    // Returns the size of the compressed block.
+    quint32 finish();
+    const uchar* data() const;
+
+private:
+    QVector<quint32> m_physicsWords;
+    QVector<qint64> m_physicsTimes;
+    QVector<quint32> m_graphicsWords;
+    QVector<qint64> m_graphicsTimes;
+    QVector<qint64> m_graphicsPositions;
+    qint32 m_physicsCount = 0;
+    qint32 m_graphicsCount = 0;
+    qint64 m_lastTimestamp = 0;
+    QVector<uchar> m_output;
+};
+
+// Decodes a block into pages that stay valid until the next block is
+// decoded. All buffers are allocated once by the constructor.
+class FrameBlockDecoder
+{
+public:
+    FrameBlockDecoder();
+
+    bool decode(const uchar* data, quint32 size);
+
+    // Pages in the order they were recorded in
+    qint32 count() const;
+    RecordView page(qint32 index) const;
+
+private:
+    QVector<quint32> m_physicsWords;
+    QVector<qint64> m_physicsTimes;
+    QVector<quint32> m_graphicsWords;
+    QVector<qint64> m_graphicsTimes;
+    QVector<qint64> m_graphicsPositions;
+
+    // Physics page index, or the bitwise complement of a graphics page index
+    QVector<qint32> m_order;
+    qint32 m_count = 0;
+};
+
+#endif // FRAMECODEC_44AAD732A0AA455992079BE411927F7F
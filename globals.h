@@ -1,54 +1,74 @@
-#ifndef GLOBALS_91B700E529094B50A400A45F5F951EAE
-#define GLOBALS_91B700E529094B50A400A45F5F951EAE
-
-static const quint8 BYTE_SIZE = 0x08;
-static const quint8 START_BIT = 0x80;
-
-enum ID
-{
-    WheelSlip = 0x00,
-    LEDFlag = 0x01,
-    WindFan = 0x02
-};
-
-struct WheelValueInt
-{
-    qint32 frontLeft;
-    qint32 frontRight;
-    qint32 rearLeft;
-    qint32 rearRight;
-
-    WheelValueInt()
-    {
-        frontLeft = 0;
-        frontRight = 0;
-        rearLeft = 0;
-        rearRight = 0;
-    }
-};
-
-struct WheelValueFloat
-{
-    float frontLeft;
-    float frontRight;
-    float rearLeft;
-    float rearRight;
-
-    WheelValueFloat()
-    {
-        frontLeft = 0.0f;
-        frontRight = 0.0f;
-        rearLeft = 0.0f;
-        rearRight = 0.0f;
-    }
-};
-
-enum WheelSlipStatus
-{
-    NotSlipping,
-    SlippingFromBraking,
-    SlippingFromGas
-};
-
-
-#endif // GLOBALS_91B700E529094B50A400A45F5F951EAE
+#ifndef GLOBALS_91B700E529094B50A400A45F5F951EAE
+#define GLOBALS_91B700E529094B50A400A45F5F951EAE
+
+static const quint8 BYTE_SIZE = 0x08;
+static const quint8 START_BIT = 0x80;
+
+// Assetto Corsa updates the physics page at 333 Hz
+static const qint32 MAX_UPS = 333;
+
+enum ID
+{
+    WheelSlip = 0x00,
+    LEDFlag = 0x01,
+    WindFan = 0x02,
+    WheelSlipPerWheel = 0x03,
+    // Baud rate request of the host and the answer of the device
+    LinkConfig = 0x04,
+    // Channel of a device's v2 answer to a frame: the sequence number of the
+    // frame and the device clock, see ProtocolV2::encodeTiming()
+    LinkTiming = 0x05
+};
+
+// Order of the wheels in all per-wheel values, same as in the game's pages
+enum Wheel
+{
+    FrontLeft,
+    FrontRight,
+    RearLeft,
+    RearRight
+};
+
+static const qint32 WHEEL_COUNT = 4;
+
+// One value per wheel, indexed by Wheel. Aligned, so the four values of a
+// field can be processed as one vector.
+struct alignas(16) WheelValueInt
+{
+    qint32 value[WHEEL_COUNT] = {0, 0, 0, 0};
+
+    qint32& operator[](qint32 wheel)
+    {
+        return value[wheel];
+    }
+
+    qint32 operator[](qint32 wheel) const
+    {
+        return value[wheel];
+    }
+};
+
+struct alignas(16) WheelValueFloat
+{
+    float value[WHEEL_COUNT] = {0.0f, 0.0f, 0.0f, 0.0f};
+
+    float& operator[](qint32 wheel)
+    {
+        return value[wheel];
+    }
+
+    float operator[](qint32 wheel) const
+    {
+        return value[wheel];
+    }
+};
+
+enum WheelSlipStatus
+{
+    NotSlipping,
+    SlippingFromBraking,
+    SlippingFromGas
+};
+
+
+#endif // GLOBALS_91B700E529094B50A400A45F5F951EAE
@@ -0,0 +1,147 @@
+#include "latencystatistics.h"
+#include <QtAlgorithms>
+#include <QtMath>
+#include <cstring>
+
+
+LatencyStatistics::LatencyStatistics()
+{
+    reset();
+}
+
+void LatencyStatistics::addSample(qint64 ns)
+{
+    if (ns < 0)
+    {
+        ns = 0;
+    }
+
+    ++m_buckets[bucketIndex(static_cast<quint64>(ns))];
+
+    if ((m_count == 0) || (ns < m_min))
+    {
+        m_min = ns;
+    }
+
+    if ((m_count == 0) || (ns > m_max))
+    {
+        m_max = ns;
+    }
+
+    ++m_count;
+    m_sum += static_cast<double>(ns);
+    m_sumOfSquares += static_cast<double>(ns) * static_cast<double>(ns);
+}
+
+void LatencyStatistics::reset()
+{
+    std::memset(m_buckets, 0, sizeof(m_buckets));
+    m_count = 0;
+    m_min = 0;
+    m_max = 0;
+    m_sum = 0.0;
+    m_sumOfSquares = 0.0;
+}
+
+quint64 LatencyStatistics::count() const
+{
+    return m_count;
+}
+
+qint64 LatencyStatistics::min() const
+{
+    return m_min;
+}
+
+qint64 LatencyStatistics::max() const
+{
+    return m_max;
+}
+
+double LatencyStatistics::mean() const
+{
+    if (m_count == 0)
+    {
+        return 0.0;
+    }
+
+    return (m_sum / static_cast<double>(m_count));
+}
+
+double LatencyStatistics::standardDeviation() const
+{
+    if (m_count < 2)
+    {
+        return 0.0;
+    }
+
+    double average = mean();
+    double variance = (m_sumOfSquares / static_cast<double>(m_count)) - (average * average);
+    return ((variance > 0.0) ? qSqrt(variance) : 0.0);
+}
+
+qint64 LatencyStatistics::percentile(double percent) const
+{
+    if (m_count == 0)
+    {
+        return 0;
+    }
+
+    quint64 rank = static_cast<quint64>(qCeil((qBound(0.0, percent, 100.0) / 100.0) * static_cast<double>(m_count)));
+    if (rank == 0)
+    {
+        rank = 1;
+    }
+
+    quint64 seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; ++i)
+    {
+        seen += m_buckets[i];
+        if (seen >= rank)
+        {
+            return qMin(static_cast<qint64>(bucketUpperBound(i)), m_max);
+        }
+    }
+
+    return m_max;
+}
+
+QString LatencyStatistics::summary() const
+{
+    return QString("n=%1 mean=%2us sd=%3us p50=%4us p95=%5us p99=%6us max=%7us")
+            .arg(m_count)
+            .arg(mean() / 1000.0, 0, 'f', 1)
+            .arg(standardDeviation() / 1000.0, 0, 'f', 1)
+            .arg(static_cast<double>(percentile(50.0)) / 1000.0, 0, 'f', 1)
+            .arg(static_cast<double>(percentile(95.0)) / 1000.0, 0, 'f', 1)
+            .arg(static_cast<double>(percentile(99.0)) / 1000.0, 0, 'f', 1)
+            .arg(static_cast<double>(m_max) / 1000.0, 0, 'f', 1);
+}
+
+int LatencyStatistics::bucketIndex(quint64 value)
+{
+    // Values below SUB_BUCKETS get an exact bucket each, above that every
+    // power of two is split into SUB_BUCKETS linear buckets
+    if (value < static_cast<quint64>(SUB_BUCKETS))
+    {
+        return static_cast<int>(value);
+    }
+
+    int msb = 63 - static_cast<int>(qCountLeadingZeroBits(value));
+    int shift = msb - SUB_BUCKET_BITS;
+    int subBucket = static_cast<int>((value >> shift) & (SUB_BUCKETS - 1));
+    return ((msb - SUB_BUCKET_BITS + 1) * SUB_BUCKETS) + subBucket;
+}
+
+quint64 LatencyStatistics::bucketUpperBound(int index)
+{
+    if (index < SUB_BUCKETS)
+    {
+        return static_cast<quint64>(index);
+    }
+
+    int msb = (index / SUB_BUCKETS) + SUB_BUCKET_BITS - 1;
+    int shift = msb - SUB_BUCKET_BITS;
+    quint64 lower = static_cast<quint64>(SUB_BUCKETS + (index % SUB_BUCKETS)) << shift;
+    return (lower + (Q_UINT64_C(1) << shift) - 1);
+}
@@ -0,0 +1,45 @@
+#ifndef LATENCYSTATISTICS_5D89CD28ECB04B02A22FEBDA3AFE3C82
+#define LATENCYSTATISTICS_5D89CD28ECB04B02A22FEBDA3AFE3C82
+
+#include <QtGlobal>
+#include <QString>
+
+// Fixed size latency histogram with about 12 % bucket precision.
+// Adding a sample never allocates, so it can be used on the acquisition
+// and serial threads.
+class LatencyStatistics
+{
+public:
+    LatencyStatistics();
+
+    void addSample(qint64 ns);
+    void reset();
+
+    quint64 count() const;
+    qint64 min() const;
+    qint64 max() const;
+    double mean() const;
+    double standardDeviation() const;
+
+    // Returns the upper bound of the bucket holding the given percentile (0..100)
+    qint64 percentile(double percent) const;
+
+    QString summary() const;
+
+private:
+    static const int SUB_BUCKET_BITS = 3;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const int BUCKET_COUNT = 64 * SUB_BUCKETS;
+
+    static int bucketIndex(quint64 value);
+    static quint64 bucketUpperBound(int index);
+
+    quint64 m_buckets[BUCKET_COUNT];
+    quint64 m_count;
+    qint64 m_min;
+    qint64 m_max;
+    double m_sum;
+    double m_sumOfSquares;
+};
+
+#endif // LATENCYSTATISTICS_5D89CD28ECB04B02A22FEBDA3AFE3C82
@@ -0,0 +1,82 @@
+#ifndef LATESTVALUEMAILBOX_AF17B949F8E5420F9CFD0FE768B131A6
+#define LATESTVALUEMAILBOX_AF17B949F8E5420F9CFD0FE768B131A6
+
+#include <QtGlobal>
+#include <atomic>
+
+// Lock-free triple buffer for exactly one producer and one consumer thread.
+// The producer writes into its own slot and swaps it with the middle slot,
+// the consumer swaps the middle slot with its own, so neither side ever
+// waits and the consumer always reads the newest value. Nothing is
+// allocated after construction.
+template <typename T>
+class LatestValueMailbox
+{
+public:
+    LatestValueMailbox()
+        : m_middle(1)
+        , m_overwritten(0)
+    {
+
+    }
+
+    // Producer: returns true if the mailbox was empty, i.e. the consumer may
+    // have to be woken up. Otherwise an unread value was overwritten.
+    bool push(const T &value)
+    {
+        m_slots[m_back] = value;
+        quint32 previous = m_middle.exchange(m_back | NEW_VALUE, std::memory_order_acq_rel);
+        m_back = previous & SLOT_MASK;
+        if ((previous & NEW_VALUE) != 0)
+        {
+            m_overwritten.store(m_overwritten.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        return true;
+    }
+
+    // Consumer: takes the newest value, returns false if there is none
+    // since the last take
+    bool take(T &value)
+    {
+        if ((m_middle.load(std::memory_order_relaxed) & NEW_VALUE) == 0)
+        {
+            return false;
+        }
+
+        quint32 previous = m_middle.exchange(m_front, std::memory_order_acq_rel);
+        m_front = previous & SLOT_MASK;
+        value = m_slots[m_front];
+        return true;
+    }
+
+    // Consumer: forgets an unread value
+    void clear()
+    {
+        T value;
+        (void)take(value);
+    }
+
+    // Values the consumer never saw because a newer one replaced them
+    quint64 overwritten() const
+    {
+        return m_overwritten.load(std::memory_order_relaxed);
+    }
+
+private:
+    static const quint32 SLOT_MASK = 0x3;
+    static const quint32 NEW_VALUE = 0x4;
+
+    T m_slots[3];
+    // Slot owned by the producer and by the consumer
+    quint32 m_back = 0;
+    char m_backPadding[64 - sizeof(quint32)];
+    quint32 m_front = 2;
+    char m_frontPadding[64 - sizeof(quint32)];
+    // Slot in between, with NEW_VALUE set until the consumer takes it
+    std::atomic<quint32> m_middle;
+    std::atomic<quint64> m_overwritten;
+};
+
+#endif // LATESTVALUEMAILBOX_AF17B949F8E5420F9CFD0FE768B131A6
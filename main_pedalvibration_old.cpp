@@ -4,8 +4,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <fstream>
-#include "SharedFileOut.h"
-#include "AssettoCorsaData.h"
+#include "sharedfileout.h"
+#include "assettocorsadata.h"
 
 using namespace std;
 
@@ -0,0 +1,173 @@
+#include "outputpredictor.h"
+#include <cmath>
+
+// Gains of the alpha-beta filters at the physics rate of the game. A lower
+// alpha smooths more, a lower beta makes the rate react slower.
+static const float PREDICTION_ALPHA = 0.5f;
+static const float PREDICTION_BETA = 0.1f;
+// A longer gap between physics steps restarts the filters, e.g. after a pause
+static const float MAX_STEP_S = 0.1f;
+
+
+QString PredictionStatistics::summary() const
+{
+    return QString("angular speed %1 rad/s (held %2), slip %3 (held %4), speed %5 km/h (held %6), %7 samples")
+            .arg(angularSpeedError, 0, 'f', 3)
+            .arg(heldAngularSpeedError, 0, 'f', 3)
+            .arg(slipError, 0, 'f', 3)
+            .arg(heldSlipError, 0, 'f', 3)
+            .arg(speedError, 0, 'f', 3)
+            .arg(heldSpeedError, 0, 'f', 3)
+            .arg(samples);
+}
+
+OutputPredictor::OutputPredictor()
+    : m_leadNs(0)
+    , m_started(false)
+    , m_lastPacketId(0)
+    , m_lastUpdateNs(0)
+    , m_pendingFirst(0)
+    , m_pendingCount(0)
+    , m_samples(0)
+    , m_errorSums()
+    , m_heldErrorSums()
+{
+}
+
+void OutputPredictor::setLead(qint64 leadNs)
+{
+    m_leadNs = qMax<qint64>(0, leadNs);
+    reset();
+}
+
+qint64 OutputPredictor::lead() const
+{
+    return m_leadNs;
+}
+
+void OutputPredictor::reset()
+{
+    m_started = false;
+    m_pendingFirst = 0;
+    m_pendingCount = 0;
+}
+
+void OutputPredictor::readValues(const TelemetryFrame &frame, float* values)
+{
+    for (qint32 i = 0; i < WHEEL_COUNT; ++i)
+    {
+        values[i] = frame.wheels.angularSpeed[i];
+        values[WHEEL_COUNT + i] = frame.wheels.slip[i];
+    }
+    values[SPEED_VALUE] = frame.speedKmh;
+}
+
+void OutputPredictor::measure(const TelemetryFrame &frame, const float* values)
+{
+    // Predictions are compared with the first physics step at or after their target
+    while ((m_pendingCount > 0) && (m_pending[m_pendingFirst].targetNs <= frame.timestampNs))
+    {
+        const Prediction &prediction = m_pending[m_pendingFirst];
+        for (qint32 i = 0; i < VALUE_COUNT; ++i)
+        {
+            m_errorSums[i] += std::fabs(prediction.predicted[i] - values[i]);
+            m_heldErrorSums[i] += std::fabs(prediction.held[i] - values[i]);
+        }
+        ++m_samples;
+
+        m_pendingFirst = (m_pendingFirst + 1) % PENDING_SIZE;
+        --m_pendingCount;
+    }
+}
+
+void OutputPredictor::update(const float* values, float dt)
+{
+    for (qint32 i = 0; i < VALUE_COUNT; ++i)
+    {
+        AlphaBeta &filter = m_filters[i];
+        float expected = filter.value + (filter.rate * dt);
+        float residual = values[i] - expected;
+        filter.value = expected + (PREDICTION_ALPHA * residual);
+        filter.rate += (PREDICTION_BETA / dt) * residual;
+    }
+}
+
+void OutputPredictor::predict(const TelemetryFrame &frame, TelemetryFrame &predicted)
+{
+    float values[VALUE_COUNT];
+    readValues(frame, values);
+
+    bool newStep = !m_started || (frame.physicsPacketId != m_lastPacketId);
+    if (newStep)
+    {
+        measure(frame, values);
+
+        float dt = static_cast<float>(frame.timestampNs - m_lastUpdateNs) / 1e9f;
+        if (m_started && (dt > 0.0f) && (dt <= MAX_STEP_S))
+        {
+            update(values, dt);
+        }
+        else
+        {
+            for (qint32 i = 0; i < VALUE_COUNT; ++i)
+            {
+                m_filters[i].value = values[i];
+                m_filters[i].rate = 0.0f;
+            }
+            m_started = true;
+        }
+
+        m_lastPacketId = frame.physicsPacketId;
+        m_lastUpdateNs = frame.timestampNs;
+    }
+
+    // Ticks between physics steps look further ahead from the last step
+    float ahead = static_cast<float>((frame.timestampNs - m_lastUpdateNs) + m_leadNs) / 1e9f;
+    float output[VALUE_COUNT];
+    for (qint32 i = 0; i < VALUE_COUNT; ++i)
+    {
+        output[i] = m_filters[i].value + (m_filters[i].rate * ahead);
+    }
+
+    predicted = frame;
+    for (qint32 i = 0; i < WHEEL_COUNT; ++i)
+    {
+        predicted.wheels.angularSpeed[i] = output[i];
+        predicted.wheels.slip[i] = qMax(0.0f, output[WHEEL_COUNT + i]);
+    }
+    predicted.speedKmh = qMax(0.0f, output[SPEED_VALUE]);
+
+    if (newStep && (m_pendingCount < PENDING_SIZE))
+    {
+        Prediction &prediction = m_pending[(m_pendingFirst + m_pendingCount) % PENDING_SIZE];
+        prediction.targetNs = frame.timestampNs + m_leadNs;
+        for (qint32 i = 0; i < VALUE_COUNT; ++i)
+        {
+            prediction.predicted[i] = output[i];
+            prediction.held[i] = values[i];
+        }
+        ++m_pendingCount;
+    }
+}
+
+PredictionStatistics OutputPredictor::statistics() const
+{
+    PredictionStatistics statistics;
+    statistics.samples = m_samples;
+    if (m_samples == 0)
+    {
+        return statistics;
+    }
+
+    double wheelSamples = static_cast<double>(m_samples) * WHEEL_COUNT;
+    for (qint32 i = 0; i < WHEEL_COUNT; ++i)
+    {
+        statistics.angularSpeedError += m_errorSums[i] / wheelSamples;
+        statistics.heldAngularSpeedError += m_heldErrorSums[i] / wheelSamples;
+        statistics.slipError += m_errorSums[WHEEL_COUNT + i] / wheelSamples;
+        statistics.heldSlipError += m_heldErrorSums[WHEEL_COUNT + i] / wheelSamples;
+    }
+    statistics.speedError = m_errorSums[SPEED_VALUE] / static_cast<double>(m_samples);
+    statistics.heldSpeedError = m_heldErrorSums[SPEED_VALUE] / static_cast<double>(m_samples);
+    return statistics;
+}
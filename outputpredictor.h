@@ -0,0 +1,90 @@
+#ifndef OUTPUTPREDICTOR_E827A356DA2348BB95527C405C9EAAE9
+#define OUTPUTPREDICTOR_E827A356DA2348BB95527C405C9EAAE9
+
+#include <QtGlobal>
+#include <QString>
+#include "telemetryframe.h"
+
+// Mean absolute errors of the predictions, measured against the frames that
+// arrived at the predicted time. The held errors are those of using the
+// values of one lead time ago as they are, i.e. of not predicting.
+struct PredictionStatistics
+{
+    quint64 samples = 0;
+    // rad/s
+    double angularSpeedError = 0.0;
+    double heldAngularSpeedError = 0.0;
+    double slipError = 0.0;
+    double heldSlipError = 0.0;
+    // km/h
+    double speedError = 0.0;
+    double heldSpeedError = 0.0;
+
+    QString summary() const;
+};
+
+// Extrapolates the wheel angular speeds, the slip and the speed a lead time
+// ahead with one alpha-beta filter per value, to make up for the time
+// between the physics step and the motors reacting. Fixed size, nothing
+// is allocated per frame.
+class OutputPredictor
+{
+public:
+    OutputPredictor();
+
+    // 0 turns the prediction off
+    void setLead(qint64 leadNs);
+    qint64 lead() const;
+
+    // Forgets the filter states, e.g. when a session starts
+    void reset();
+
+    // Feeds a new physics step to the filters and writes the frame expected
+    // one lead time after it into predicted. All other fields are copied.
+    // A frame of the same physics step only moves the prediction ahead in time.
+    void predict(const TelemetryFrame &frame, TelemetryFrame &predicted);
+
+    PredictionStatistics statistics() const;
+
+private:
+    // Angular speeds, slips and the speed
+    static const qint32 VALUE_COUNT = (2 * WHEEL_COUNT) + 1;
+    static const qint32 SPEED_VALUE = 2 * WHEEL_COUNT;
+    // Enough for the longest lead at the highest physics rate
+    static const qint32 PENDING_SIZE = 64;
+
+    struct AlphaBeta
+    {
+        float value = 0.0f;
+        // Per second
+        float rate = 0.0f;
+    };
+
+    struct Prediction
+    {
+        qint64 targetNs = 0;
+        float predicted[VALUE_COUNT];
+        float held[VALUE_COUNT];
+    };
+
+    static void readValues(const TelemetryFrame &frame, float* values);
+    void measure(const TelemetryFrame &frame, const float* values);
+    void update(const float* values, float dt);
+
+    qint64 m_leadNs;
+    bool m_started;
+    qint32 m_lastPacketId;
+    qint64 m_lastUpdateNs;
+    AlphaBeta m_filters[VALUE_COUNT];
+
+    // Predictions waiting for the frame at their target time
+    Prediction m_pending[PENDING_SIZE];
+    qint32 m_pendingFirst;
+    qint32 m_pendingCount;
+
+    quint64 m_samples;
+    double m_errorSums[VALUE_COUNT];
+    double m_heldErrorSums[VALUE_COUNT];
+};
+
+#endif // OUTPUTPREDICTOR_E827A356DA2348BB95527C405C9EAAE9
@@ -0,0 +1,147 @@
+#include "posixsharedmemorybackend.h"
+#include <QDebug>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+
+PosixSharedMemoryBackend::PosixSharedMemoryBackend()
+{
+    (void)reopen();
+}
+
+PosixSharedMemoryBackend::~PosixSharedMemoryBackend()
+{
+    dismiss(m_physics);
+    dismiss(m_graphics);
+    dismiss(m_static);
+}
+
+bool PosixSharedMemoryBackend::isOpen() const
+{
+    return ((m_physics.mapFileBuffer != nullptr)
+            && (m_graphics.mapFileBuffer != nullptr)
+            && (m_static.mapFileBuffer != nullptr));
+}
+
+bool PosixSharedMemoryBackend::reopen()
+{
+    bool report = !m_reported;
+    m_reported = true;
+
+    if (m_physics.mapFileBuffer == nullptr)
+    {
+        m_physics = map(SHM_PHYSICS_NAME, sizeof(SPageFilePhysics), report);
+    }
+
+    if (m_graphics.mapFileBuffer == nullptr)
+    {
+        m_graphics = map(SHM_GRAPHICS_NAME, sizeof(SPageFileGraphic), report);
+    }
+
+    if (m_static.mapFileBuffer == nullptr)
+    {
+        m_static = map(SHM_STATIC_NAME, sizeof(SPageFileStatic), report);
+    }
+
+    return isOpen();
+}
+
+const SPageFilePhysics* PosixSharedMemoryBackend::physics() const
+{
+    return static_cast<const SPageFilePhysics*>(m_physics.mapFileBuffer);
+}
+
+const SPageFileGraphic* PosixSharedMemoryBackend::graphics() const
+{
+    return static_cast<const SPageFileGraphic*>(m_graphics.mapFileBuffer);
+}
+
+const SPageFileStatic* PosixSharedMemoryBackend::staticData() const
+{
+    return static_cast<const SPageFileStatic*>(m_static.mapFileBuffer);
+}
+
+SMSegment PosixSharedMemoryBackend::map(const char* name, size_t size, bool report)
+{
+    SMSegment segment;
+
+    // The producer owns an existing segment, we only need to read it
+    int fd = shm_open(name, O_RDONLY, 0);
+    if ((fd < 0) && (errno == ENOENT))
+    {
+        // Like CreateFileMapping on Windows: create the segment if the
+        // producer is not running yet, so the reader can be started first
+        fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0666);
+        if (fd >= 0)
+        {
+            if (ftruncate(fd, static_cast<off_t>(size)) != 0)
+            {
+                if (report)
+                {
+                    qWarning() << "ftruncate failed for" << name << ":" << strerror(errno);
+                }
+                close(fd);
+                return segment;
+            }
+        }
+        else if (errno == EEXIST)
+        {
+            // The producer created it in the meantime
+            fd = shm_open(name, O_RDONLY, 0);
+        }
+    }
+
+    if (fd < 0)
+    {
+        if (report)
+        {
+            qWarning() << "shm_open failed for" << name << ":" << strerror(errno);
+        }
+        return segment;
+    }
+
+    // Reading beyond the end of a shorter segment raises SIGBUS, so wait
+    // until the producer has sized it
+    struct stat info;
+    if ((fstat(fd, &info) != 0) || (static_cast<size_t>(info.st_size) < size))
+    {
+        if (report)
+        {
+            qWarning() << "Shared memory" << name << "is not ready yet";
+        }
+        close(fd);
+        return segment;
+    }
+
+    void* buffer = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+
+    // The mapping stays valid after closing the descriptor
+    close(fd);
+
+    if (buffer == MAP_FAILED)
+    {
+        if (report)
+        {
+            qWarning() << "mmap failed for" << name << ":" << strerror(errno);
+        }
+        return segment;
+    }
+
+    segment.mapFileBuffer = buffer;
+    segment.size = size;
+    return segment;
+}
+
+void PosixSharedMemoryBackend::dismiss(SMSegment &segment)
+{
+    if (segment.mapFileBuffer != nullptr)
+    {
+        munmap(segment.mapFileBuffer, segment.size);
+        segment.mapFileBuffer = nullptr;
+        segment.size = 0;
+    }
+}
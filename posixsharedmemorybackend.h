@@ -0,0 +1,46 @@
+#ifndef POSIXSHAREDMEMORYBACKEND_DD18291976D84F14B9C0CC23DC9F9DDE
+#define POSIXSHAREDMEMORYBACKEND_DD18291976D84F14B9C0CC23DC9F9DDE
+
+#include "telemetrybackend.h"
+#include <cstddef>
+
+// Shared memory names used on POSIX systems.
+// A producer (e.g. a local stand-in for the game) has to create the
+// segments with the same names and the layouts from sharedfileout.h.
+static const char* const SHM_PHYSICS_NAME = "/acpmf_physics";
+static const char* const SHM_GRAPHICS_NAME = "/acpmf_graphics";
+static const char* const SHM_STATIC_NAME = "/acpmf_static";
+
+struct SMSegment
+{
+    void* mapFileBuffer = nullptr;
+    size_t size = 0;
+};
+
+class PosixSharedMemoryBackend : public TelemetryBackend
+{
+public:
+    PosixSharedMemoryBackend();
+    ~PosixSharedMemoryBackend() override;
+
+    bool isOpen() const override;
+    bool reopen() override;
+
+    const SPageFilePhysics* physics() const override;
+    const SPageFileGraphic* graphics() const override;
+    const SPageFileStatic* staticData() const override;
+
+private:
+    SMSegment map(const char* name, size_t size, bool report);
+    void dismiss(SMSegment &segment);
+
+    SMSegment m_physics;
+    SMSegment m_graphics;
+    SMSegment m_static;
+
+    // Failures are logged on the first attempt only, reopen() is retried
+    // with every frame until the producer is running
+    bool m_reported = false;
+};
+
+#endif // POSIXSHAREDMEMORYBACKEND_DD18291976D84F14B9C0CC23DC9F9DDE
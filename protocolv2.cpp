@@ -0,0 +1,262 @@
+#include "protocolv2.h"
+#include <cstring>
+
+namespace
+{
+// CRC-16/CCITT-FALSE: polynomial 0x1021, initial value 0xffff
+struct CrcTable
+{
+    quint16 values[256];
+
+    CrcTable()
+    {
+        for (qint32 i = 0; i < 256; ++i)
+        {
+            quint16 crc = static_cast<quint16>(i << 8);
+            for (qint32 bit = 0; bit < 8; ++bit)
+            {
+                crc = ((crc & 0x8000) != 0) ? static_cast<quint16>((crc << 1) ^ 0x1021) : static_cast<quint16>(crc << 1);
+            }
+            values[i] = crc;
+        }
+    }
+};
+
+const CrcTable CRC_TABLE;
+}
+
+namespace ProtocolV2
+{
+quint16 crc16(const quint8* data, qint32 size)
+{
+    quint16 crc = 0xffff;
+    for (qint32 i = 0; i < size; ++i)
+    {
+        crc = static_cast<quint16>((crc << 8) ^ CRC_TABLE.values[((crc >> 8) ^ data[i]) & 0xff]);
+    }
+
+    return crc;
+}
+
+qint32 cobsEncode(const quint8* input, qint32 size, quint8* output)
+{
+    // Every block starts with the distance to the next zero
+    qint32 codeIndex = 0;
+    qint32 outputIndex = 1;
+    quint8 code = 1;
+    for (qint32 i = 0; i < size; ++i)
+    {
+        if (input[i] == 0)
+        {
+            output[codeIndex] = code;
+            codeIndex = outputIndex++;
+            code = 1;
+            continue;
+        }
+
+        output[outputIndex++] = input[i];
+        ++code;
+        if (code == 0xff)
+        {
+            output[codeIndex] = code;
+            codeIndex = outputIndex++;
+            code = 1;
+        }
+    }
+
+    output[codeIndex] = code;
+    return outputIndex;
+}
+
+qint32 cobsDecode(const quint8* input, qint32 size, quint8* output)
+{
+    qint32 inputIndex = 0;
+    qint32 outputIndex = 0;
+    while (inputIndex < size)
+    {
+        quint8 code = input[inputIndex++];
+        if ((code == 0) || ((inputIndex + code - 1) > size))
+        {
+            return -1;
+        }
+
+        for (qint32 i = 1; i < code; ++i)
+        {
+            if (input[inputIndex] == 0)
+            {
+                return -1;
+            }
+            output[outputIndex++] = input[inputIndex++];
+        }
+
+        // A zero follows every block except the last and the full ones
+        if ((code != 0xff) && (inputIndex < size))
+        {
+            output[outputIndex++] = 0;
+        }
+    }
+
+    return outputIndex;
+}
+
+void encodeTiming(quint8 sequence, quint32 deviceTimeUs, quint8* value)
+{
+    value[0] = sequence;
+    value[1] = static_cast<quint8>(deviceTimeUs >> 24);
+    value[2] = static_cast<quint8>(deviceTimeUs >> 16);
+    value[3] = static_cast<quint8>(deviceTimeUs >> 8);
+    value[4] = static_cast<quint8>(deviceTimeUs);
+}
+
+bool decodeTiming(const ChannelView &channel, quint8 &sequence, quint32 &deviceTimeUs)
+{
+    if (channel.size != TIMING_SIZE)
+    {
+        return false;
+    }
+
+    sequence = channel.value[0];
+    deviceTimeUs = (static_cast<quint32>(channel.value[1]) << 24) | (static_cast<quint32>(channel.value[2]) << 16)
+            | (static_cast<quint32>(channel.value[3]) << 8) | static_cast<quint32>(channel.value[4]);
+    return true;
+}
+
+void FrameEncoder::begin(quint8 sequence)
+{
+    m_payload[0] = VERSION;
+    m_payload[1] = sequence;
+    m_size = HEADER_SIZE;
+    m_channelCount = 0;
+}
+
+bool FrameEncoder::addChannel(quint8 type, const quint8* value, qint32 size)
+{
+    if ((size < 0) || (size > 0xff) || (m_channelCount >= MAX_CHANNELS)
+            || ((m_size + channelSize(size) + CRC_SIZE) > MAX_PAYLOAD_SIZE))
+    {
+        return false;
+    }
+
+    m_payload[m_size++] = type;
+    m_payload[m_size++] = static_cast<quint8>(size);
+    std::memcpy(m_payload + m_size, value, static_cast<size_t>(size));
+    m_size += size;
+    ++m_channelCount;
+    return true;
+}
+
+qint32 FrameEncoder::channelCount() const
+{
+    return m_channelCount;
+}
+
+qint32 FrameEncoder::finish(quint8* output)
+{
+    quint16 crc = crc16(m_payload, m_size);
+    m_payload[m_size] = static_cast<quint8>(crc >> 8);
+    m_payload[m_size + 1] = static_cast<quint8>(crc & 0xff);
+
+    qint32 size = cobsEncode(m_payload, m_size + CRC_SIZE, output);
+    output[size++] = DELIMITER;
+    return size;
+}
+
+bool FrameDecoder::push(quint8 byte)
+{
+    ++m_statistics.bytes;
+    if (byte != DELIMITER)
+    {
+        if (m_size < MAX_FRAME_SIZE)
+        {
+            m_buffer[m_size++] = byte;
+        }
+        else if (!m_overflow)
+        {
+            // Skipped up to the next delimiter
+            m_overflow = true;
+            ++m_statistics.overflows;
+        }
+        return false;
+    }
+
+    bool valid = false;
+    if (m_overflow)
+    {
+        m_overflow = false;
+    }
+    else if (m_size > 0)
+    {
+        valid = decodeFrame();
+    }
+
+    m_size = 0;
+    return valid;
+}
+
+bool FrameDecoder::decodeFrame()
+{
+    qint32 size = cobsDecode(m_buffer, m_size, m_buffer);
+    if ((size < (HEADER_SIZE + CRC_SIZE)) || (m_buffer[0] != VERSION))
+    {
+        ++m_statistics.formatErrors;
+        return false;
+    }
+
+    qint32 payloadSize = size - CRC_SIZE;
+    quint16 crc = static_cast<quint16>((m_buffer[payloadSize] << 8) | m_buffer[payloadSize + 1]);
+    if (crc16(m_buffer, payloadSize) != crc)
+    {
+        ++m_statistics.crcErrors;
+        return false;
+    }
+
+    qint32 count = 0;
+    qint32 index = HEADER_SIZE;
+    while (index < payloadSize)
+    {
+        if ((count >= MAX_CHANNELS) || ((index + CHANNEL_HEADER_SIZE) > payloadSize)
+                || ((index + channelSize(m_buffer[index + 1])) > payloadSize))
+        {
+            ++m_statistics.formatErrors;
+            return false;
+        }
+
+        m_channels[count].type = m_buffer[index];
+        m_channels[count].size = m_buffer[index + 1];
+        m_channels[count].value = m_buffer + index + CHANNEL_HEADER_SIZE;
+        index += channelSize(m_channels[count].size);
+        ++count;
+    }
+
+    quint8 sequence = m_buffer[1];
+    if (m_hasSequence)
+    {
+        m_statistics.lostFrames += static_cast<quint8>(sequence - m_sequence - 1);
+    }
+    m_sequence = sequence;
+    m_hasSequence = true;
+    m_channelCount = count;
+    ++m_statistics.frames;
+    return true;
+}
+
+quint8 FrameDecoder::sequence() const
+{
+    return m_sequence;
+}
+
+qint32 FrameDecoder::channelCount() const
+{
+    return m_channelCount;
+}
+
+const ChannelView &FrameDecoder::channel(qint32 index) const
+{
+    return m_channels[index];
+}
+
+const DecoderStatistics &FrameDecoder::statistics() const
+{
+    return m_statistics;
+}
+}
@@ -0,0 +1,134 @@
+#ifndef PROTOCOLV2_DB4CF3D76F8E45F99D688D3733069F47
+#define PROTOCOLV2_DB4CF3D76F8E45F99D688D3733069F47
+
+#include <QtGlobal>
+
+// Serial protocol v2. A frame carries several channels at once:
+//
+//   version (0x02) | sequence | type, length, value... | CRC-16 (big endian)
+//
+// The type of a channel is the message ID, its value the bytes of the v1
+// message after the header. The CRC is CRC-16/CCITT-FALSE over everything
+// before it. The frame is COBS encoded and ends with a 0x00 byte, so a
+// receiver finds the next frame after any corrupted byte.
+//
+// Encoder and decoder work on fixed buffers and only depend on QtGlobal's
+// integer types, so device firmware and tests can use the same code.
+namespace ProtocolV2
+{
+static const quint8 VERSION = 0x02;
+static const quint8 DELIMITER = 0x00;
+static const qint32 HEADER_SIZE = 2;
+static const qint32 CRC_SIZE = 2;
+static const qint32 CHANNEL_HEADER_SIZE = 2;
+static const qint32 MAX_CHANNELS = 16;
+// Before COBS, one channel per message id with a v1 message of up to 8
+// bytes fits, and COBS adds a single byte below 254 bytes
+static const qint32 MAX_PAYLOAD_SIZE = 160;
+static const qint32 MAX_FRAME_SIZE = MAX_PAYLOAD_SIZE + 2;
+// Bytes a frame adds on the wire besides its channels
+static const qint32 FRAME_OVERHEAD = HEADER_SIZE + CRC_SIZE + 2;
+
+inline qint32 channelSize(qint32 valueSize)
+{
+    return CHANNEL_HEADER_SIZE + valueSize;
+}
+
+// Value of the timing channel a device answers a frame with: the sequence
+// number of the frame and the device clock in microseconds, big endian
+static const qint32 TIMING_SIZE = 5;
+
+quint16 crc16(const quint8* data, qint32 size);
+
+// Returns the encoded size without the delimiter, output needs size + 1 + size / 254 bytes
+qint32 cobsEncode(const quint8* input, qint32 size, quint8* output);
+// Returns the decoded size or -1 if the input is no valid COBS data.
+// Decoding in place (output == input) is allowed.
+qint32 cobsDecode(const quint8* input, qint32 size, quint8* output);
+
+class FrameEncoder
+{
+public:
+    void begin(quint8 sequence);
+
+    // Returns false if the channel does not fit into the frame anymore
+    bool addChannel(quint8 type, const quint8* value, qint32 size);
+    qint32 channelCount() const;
+
+    // Writes the complete frame including the delimiter and returns its
+    // size, output needs MAX_FRAME_SIZE bytes
+    qint32 finish(quint8* output);
+
+private:
+    quint8 m_payload[MAX_PAYLOAD_SIZE];
+    qint32 m_size = 0;
+    qint32 m_channelCount = 0;
+};
+
+// Channel of a decoded frame, points into the decoder's buffer and is only
+// valid until the next byte is pushed
+struct ChannelView
+{
+    quint8 type = 0;
+    quint8 size = 0;
+    const quint8* value = nullptr;
+};
+
+void encodeTiming(quint8 sequence, quint32 deviceTimeUs, quint8* value);
+// Returns false if the channel has the wrong size
+bool decodeTiming(const ChannelView &channel, quint8 &sequence, quint32 &deviceTimeUs);
+
+struct DecoderStatistics
+{
+    quint64 bytes = 0;
+    quint64 frames = 0;
+    quint64 crcErrors = 0;
+    // Invalid COBS, too short, wrong version or channels that do not add up
+    quint64 formatErrors = 0;
+    // Longer than MAX_FRAME_SIZE without a delimiter
+    quint64 overflows = 0;
+    // Gaps in the sequence numbers between valid frames
+    quint64 lostFrames = 0;
+};
+
+class FrameDecoder
+{
+public:
+    // Returns true when the byte completed a valid frame
+    bool push(quint8 byte);
+
+    // Calls onFrame(decoder) for every valid frame in the data
+    template <typename Callback>
+    void feed(const quint8* data, qint32 size, Callback onFrame)
+    {
+        for (qint32 i = 0; i < size; ++i)
+        {
+            if (push(data[i]))
+            {
+                onFrame(*this);
+            }
+        }
+    }
+
+    quint8 sequence() const;
+    qint32 channelCount() const;
+    const ChannelView &channel(qint32 index) const;
+
+    const DecoderStatistics &statistics() const;
+
+private:
+    bool decodeFrame();
+
+    quint8 m_buffer[MAX_FRAME_SIZE];
+    qint32 m_size = 0;
+    bool m_overflow = false;
+
+    quint8 m_sequence = 0;
+    bool m_hasSequence = false;
+    ChannelView m_channels[MAX_CHANNELS];
+    qint32 m_channelCount = 0;
+    DecoderStatistics m_statistics;
+};
+}
+
+#endif // PROTOCOLV2_DB4CF3D76F8E45F99D688D3733069F47
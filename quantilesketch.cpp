@@ -0,0 +1,229 @@
+#include "quantilesketch.h"
+#include <QStringList>
+#include <algorithm>
+#include <cmath>
+
+
+P2Quantile::P2Quantile(double quantile)
+    : m_quantile(qBound(0.0, quantile, 1.0))
+{
+}
+
+void P2Quantile::reset()
+{
+    m_count = 0;
+}
+
+double P2Quantile::desiredPosition(qint32 marker) const
+{
+    // Marker i should be at 1 + (n - 1) * {0, p/2, p, (1+p)/2, 1}[i]
+    static const double HALF = 0.5;
+    double fraction = 0.0;
+    switch (marker)
+    {
+    case 1:
+        fraction = m_quantile * HALF;
+        break;
+    case 2:
+        fraction = m_quantile;
+        break;
+    case 3:
+        fraction = (1.0 + m_quantile) * HALF;
+        break;
+    case 4:
+        fraction = 1.0;
+        break;
+    default:
+        break;
+    }
+
+    return 1.0 + (static_cast<double>(m_count - 1) * fraction);
+}
+
+double P2Quantile::parabolic(qint32 marker, double direction) const
+{
+    double previous = m_positions[marker - 1];
+    double current = m_positions[marker];
+    double next = m_positions[marker + 1];
+    return m_heights[marker]
+            + ((direction / (next - previous))
+               * ((((current - previous) + direction) * (m_heights[marker + 1] - m_heights[marker]) / (next - current))
+                  + (((next - current) - direction) * (m_heights[marker] - m_heights[marker - 1]) / (current - previous))));
+}
+
+double P2Quantile::linear(qint32 marker, qint32 direction) const
+{
+    return m_heights[marker]
+            + (direction * (m_heights[marker + direction] - m_heights[marker])
+               / (m_positions[marker + direction] - m_positions[marker]));
+}
+
+void P2Quantile::add(double value)
+{
+    if (!std::isfinite(value))
+    {
+        return;
+    }
+
+    // The first five values initialize the markers
+    if (m_count < MARKERS)
+    {
+        m_heights[m_count] = value;
+        ++m_count;
+        if (m_count == MARKERS)
+        {
+            std::sort(m_heights, m_heights + MARKERS);
+            for (qint32 i = 0; i < MARKERS; ++i)
+            {
+                m_positions[i] = i + 1;
+            }
+        }
+        return;
+    }
+
+    // Cell of the new value, the outer markers follow minimum and maximum
+    qint32 cell = 0;
+    if (value < m_heights[0])
+    {
+        m_heights[0] = value;
+    }
+    else if (value >= m_heights[MARKERS - 1])
+    {
+        m_heights[MARKERS - 1] = value;
+        cell = MARKERS - 2;
+    }
+    else
+    {
+        while (value >= m_heights[cell + 1])
+        {
+            ++cell;
+        }
+    }
+
+    for (qint32 i = cell + 1; i < MARKERS; ++i)
+    {
+        m_positions[i] += 1.0;
+    }
+    ++m_count;
+
+    // Move the inner markers towards their desired positions
+    for (qint32 i = 1; i < (MARKERS - 1); ++i)
+    {
+        double offset = desiredPosition(i) - m_positions[i];
+        if (((offset >= 1.0) && ((m_positions[i + 1] - m_positions[i]) > 1.0))
+                || ((offset <= -1.0) && ((m_positions[i - 1] - m_positions[i]) < -1.0)))
+        {
+            qint32 direction = (offset > 0.0) ? 1 : -1;
+            double height = parabolic(i, direction);
+            if ((m_heights[i - 1] < height) && (height < m_heights[i + 1]))
+            {
+                m_heights[i] = height;
+            }
+            else
+            {
+                m_heights[i] = linear(i, direction);
+            }
+            m_positions[i] += direction;
+        }
+    }
+}
+
+double P2Quantile::value() const
+{
+    if (m_count >= MARKERS)
+    {
+        return m_heights[2];
+    }
+
+    if (m_count == 0)
+    {
+        return 0.0;
+    }
+
+    double sorted[MARKERS];
+    std::copy(m_heights, m_heights + m_count, sorted);
+    std::sort(sorted, sorted + m_count);
+    return sorted[qRound(static_cast<double>(m_count - 1) * m_quantile)];
+}
+
+quint64 P2Quantile::count() const
+{
+    return m_count;
+}
+
+double P2Quantile::quantile() const
+{
+    return m_quantile;
+}
+
+QString P2Quantile::toString() const
+{
+    // "<count> <5 heights> <5 positions>"
+    QStringList parts;
+    parts << QString::number(m_count);
+    for (qint32 i = 0; i < MARKERS; ++i)
+    {
+        parts << QString::number(m_heights[i], 'g', 17);
+    }
+    for (qint32 i = 0; i < MARKERS; ++i)
+    {
+        parts << QString::number(m_positions[i], 'g', 17);
+    }
+
+    return parts.join(' ');
+}
+
+bool P2Quantile::fromString(const QString &state)
+{
+    QStringList parts = state.split(' ');
+    if (parts.size() != (1 + (2 * MARKERS)))
+    {
+        return false;
+    }
+
+    bool ok = false;
+    quint64 count = parts[0].toULongLong(&ok);
+    if (!ok)
+    {
+        return false;
+    }
+
+    double heights[MARKERS];
+    double positions[MARKERS];
+    for (qint32 i = 0; i < MARKERS; ++i)
+    {
+        heights[i] = parts[1 + i].toDouble(&ok);
+        if (!ok || !std::isfinite(heights[i]))
+        {
+            return false;
+        }
+
+        positions[i] = parts[1 + MARKERS + i].toDouble(&ok);
+        if (!ok)
+        {
+            return false;
+        }
+    }
+
+    // Once initialized, the markers have to be ordered and end at the count
+    if (count >= MARKERS)
+    {
+        for (qint32 i = 1; i < MARKERS; ++i)
+        {
+            if ((heights[i] < heights[i - 1]) || (positions[i] <= positions[i - 1]))
+            {
+                return false;
+            }
+        }
+
+        if ((positions[0] != 1.0) || (positions[MARKERS - 1] != static_cast<double>(count)))
+        {
+            return false;
+        }
+    }
+
+    m_count = count;
+    std::copy(heights, heights + MARKERS, m_heights);
+    std::copy(positions, positions + MARKERS, m_positions);
+    return true;
+}
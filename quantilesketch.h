@@ -0,0 +1,41 @@
+#ifndef QUANTILESKETCH_485982ACDE6A4CE98C41EB96698F308A
+#define QUANTILESKETCH_485982ACDE6A4CE98C41EB96698F308A
+
+#include <QString>
+
+// Streaming estimate of one quantile with the P² algorithm (Jain and
+// Chlamtac): five markers whose heights are moved with a parabolic
+// prediction, O(1) per value and without allocating.
+class P2Quantile
+{
+public:
+    explicit P2Quantile(double quantile = 0.5);
+
+    void reset();
+    void add(double value);
+
+    // Exact while fewer than five values were added
+    double value() const;
+    quint64 count() const;
+    double quantile() const;
+
+    // Marker state as text, e.g. for QSettings. fromString() keeps the
+    // current state and returns false if the text is not valid.
+    QString toString() const;
+    bool fromString(const QString &state);
+
+private:
+    static const qint32 MARKERS = 5;
+
+    double desiredPosition(qint32 marker) const;
+    double parabolic(qint32 marker, double direction) const;
+    double linear(qint32 marker, qint32 direction) const;
+
+    double m_quantile;
+    quint64 m_count = 0;
+    double m_heights[MARKERS] = {};
+    // Positions are counted from 1 like in the paper
+    double m_positions[MARKERS] = {};
+};
+
+#endif // QUANTILESKETCH_485982ACDE6A4CE98C41EB96698F308A
@@ -0,0 +1,118 @@
+#ifndef RECORDINGFORMAT_51DCD02B2A594DA18026B7BDBF8F3C4A
+#define RECORDINGFORMAT_51DCD02B2A594DA18026B7BDBF8F3C4A
+
+#include <QtGlobal>
+#include "sharedfileout.h"
+
+// Layout of a telemetry recording (*.pvrec):
+//
+//   RecordingFileHeader
+//   RecordHeader + page, RecordHeader + page, ...   (8 byte aligned)
+//   TimeIndexEntry[timeIndexCount]
+//   LapIndexEntry[lapIndexCount]
+//
+// Every index entry points to a key frame: a static and a graphics record
+// in a row, followed by the physics page of the same tick, so replay can
+// start there without reading anything before it. The index is written
+// when the recording is closed.
+// In uncompressed recordings the key frame's physics page is a plain
+// physics record right after the graphics record. In compressed recordings
+// the physics and graphics pages are stored in compressed blocks (see
+// framecodec.h) that start at a key frame, and the key frame's physics
+// page is the first page of the block that follows it. Only the repeated
+// static and graphics records of a key frame are stored as they are.
+// indexOffset stays 0 for recordings that were not closed properly,
+// readers rebuild the index by scanning the records then.
+
+static const char RECORDING_MAGIC[8] = {'P', 'V', 'R', 'E', 'C', '0', '0', '1'};
+static const quint32 RECORDING_VERSION = 1;
+
+// RecordingFileHeader::flags
+static const quint32 RECORDING_FLAG_COMPRESSED = 0x1;
+
+enum RecordType
+{
+    InvalidRecord = 0,
+    PhysicsRecord = 1,
+    GraphicsRecord = 2,
+    StaticRecord = 3,
+    CompressedBlockRecord = 4
+};
+
+struct RecordingFileHeader
+{
+    char magic[8];
+    quint32 version;
+    quint32 headerSize;
+    quint32 physicsSize;
+    quint32 graphicsSize;
+    quint32 staticSize;
+    quint32 timeIndexCount;
+    quint32 lapIndexCount;
+    quint32 flags;
+    qint64 indexOffset;
+};
+
+struct RecordHeader
+{
+    quint16 type;
+    quint16 reserved;
+    quint32 size;
+    qint64 timestampNs;
+};
+
+struct TimeIndexEntry
+{
+    qint64 timestampNs;
+    qint64 offset;
+};
+
+struct LapIndexEntry
+{
+    qint32 lap;
+    qint32 reserved;
+    qint64 timestampNs;
+    qint64 offset;
+};
+
+static_assert(sizeof(RecordingFileHeader) == 48, "Unexpected recording header size");
+static_assert(sizeof(RecordHeader) == 16, "Unexpected record header size");
+
+// A record as it is found in a recording, or a page decoded from a
+// compressed block
+struct RecordView
+{
+    RecordType type = InvalidRecord;
+    qint64 timestampNs = 0;
+    const uchar* payload = nullptr;
+    quint32 size = 0;
+    qint64 nextOffset = 0;
+};
+
+// Size of the pages, 0 for records without a fixed size
+inline quint32 recordPayloadSize(RecordType type)
+{
+    switch (type)
+    {
+    case PhysicsRecord:
+        return sizeof(SPageFilePhysics);
+    case GraphicsRecord:
+        return sizeof(SPageFileGraphic);
+    case StaticRecord:
+        return sizeof(SPageFileStatic);
+    case CompressedBlockRecord:
+    case InvalidRecord:
+    default:
+        break;
+    }
+
+    return 0;
+}
+
+// Size of a record including its header, padded to 8 bytes
+inline qint64 recordSize(quint32 payloadSize)
+{
+    return static_cast<qint64>((sizeof(RecordHeader) + payloadSize + 7) & ~static_cast<quint32>(7));
+}
+
+#endif // RECORDINGFORMAT_51DCD02B2A594DA18026B7BDBF8F3C4A
@@ -0,0 +1,54 @@
+#include "replaybackend.h"
+#include <cstring>
+
+
+ReplayBackend::ReplayBackend()
+{
+    clear();
+}
+
+bool ReplayBackend::isOpen() const
+{
+    return true;
+}
+
+const SPageFilePhysics* ReplayBackend::physics() const
+{
+    return &m_physics;
+}
+
+const SPageFileGraphic* ReplayBackend::graphics() const
+{
+    return &m_graphics;
+}
+
+const SPageFileStatic* ReplayBackend::staticData() const
+{
+    return &m_static;
+}
+
+void ReplayBackend::apply(const RecordView &record)
+{
+    switch (record.type)
+    {
+    case PhysicsRecord:
+        std::memcpy(&m_physics, record.payload, sizeof(SPageFilePhysics));
+        break;
+    case GraphicsRecord:
+        std::memcpy(&m_graphics, record.payload, sizeof(SPageFileGraphic));
+        break;
+    case StaticRecord:
+        std::memcpy(&m_static, record.payload, sizeof(SPageFileStatic));
+        break;
+    case InvalidRecord:
+    default:
+        break;
+    }
+}
+
+void ReplayBackend::clear()
+{
+    m_physics = SPageFilePhysics();
+    m_graphics = SPageFileGraphic();
+    m_static = SPageFileStatic();
+}
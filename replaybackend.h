@@ -0,0 +1,30 @@
+#ifndef REPLAYBACKEND_ED11E095DCC343468087926D9D9FDDF6
+#define REPLAYBACKEND_ED11E095DCC343468087926D9D9FDDF6
+
+#include "telemetrybackend.h"
+#include "telemetryrecording.h"
+
+// Serves pages taken from a recording instead of the game's shared memory.
+// The pages are only changed by apply(), which has to be called from the
+// thread that reads them.
+class ReplayBackend : public TelemetryBackend
+{
+public:
+    ReplayBackend();
+
+    bool isOpen() const override;
+
+    const SPageFilePhysics* physics() const override;
+    const SPageFileGraphic* graphics() const override;
+    const SPageFileStatic* staticData() const override;
+
+    void apply(const RecordView &record);
+    void clear();
+
+private:
+    SPageFilePhysics m_physics;
+    SPageFileGraphic m_graphics;
+    SPageFileStatic m_static;
+};
+
+#endif // REPLAYBACKEND_ED11E095DCC343468087926D9D9FDDF6
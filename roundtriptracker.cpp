@@ -0,0 +1,95 @@
+#include "roundtriptracker.h"
+#include <limits>
+
+QString RoundTripStatistics::summary() const
+{
+    QString offset = synchronized ? (QString::number(static_cast<double>(clockOffsetNs) / 1e6, 'f', 3) + "ms") : QString("unknown");
+    return QString("responses=%1 unmatched=%2 clock offset=%3 round trip %4")
+            .arg(responses).arg(unmatched).arg(offset).arg(roundTrip.summary());
+}
+
+RoundTripTracker::RoundTripTracker()
+{
+    reset();
+}
+
+void RoundTripTracker::reset()
+{
+    for (qint64 &sentNs : m_sentNs)
+    {
+        sentNs = NOT_SENT;
+    }
+
+    m_roundTrip.reset();
+    m_responses = 0;
+    m_unmatched = 0;
+    m_hasDeviceTime = false;
+    m_lastDeviceTimeUs = 0;
+    m_deviceTimeUs = 0;
+    m_windowCount = 0;
+    m_windowRoundTripNs = std::numeric_limits<qint64>::max();
+    m_windowOffsetNs = 0;
+    m_synchronized = false;
+    m_clockOffsetNs = 0;
+}
+
+void RoundTripTracker::frameSent(quint8 sequence, qint64 nowNs)
+{
+    m_sentNs[sequence] = nowNs;
+}
+
+bool RoundTripTracker::responseReceived(quint8 sequence, quint32 deviceTimeUs, qint64 nowNs)
+{
+    // Each frame is answered once, an answer after MAX_ROUND_TRIP_NS could
+    // belong to an older frame with the same sequence number
+    qint64 sentNs = m_sentNs[sequence];
+    m_sentNs[sequence] = NOT_SENT;
+    qint64 roundTripNs = nowNs - sentNs;
+    if ((sentNs == NOT_SENT) || (roundTripNs < 0) || (roundTripNs > MAX_ROUND_TRIP_NS))
+    {
+        ++m_unmatched;
+        return false;
+    }
+
+    ++m_responses;
+    m_roundTrip.addSample(roundTripNs);
+
+    if (m_hasDeviceTime)
+    {
+        m_deviceTimeUs += static_cast<qint32>(deviceTimeUs - m_lastDeviceTimeUs);
+    }
+    else
+    {
+        m_deviceTimeUs = deviceTimeUs;
+        m_hasDeviceTime = true;
+    }
+    m_lastDeviceTimeUs = deviceTimeUs;
+
+    // The device read its clock halfway through the round trip, at best
+    if (roundTripNs < m_windowRoundTripNs)
+    {
+        m_windowRoundTripNs = roundTripNs;
+        m_windowOffsetNs = (m_deviceTimeUs * 1000) - (sentNs + (roundTripNs / 2));
+    }
+
+    if (++m_windowCount >= OFFSET_WINDOW)
+    {
+        m_clockOffsetNs = m_windowOffsetNs;
+        m_synchronized = true;
+        m_windowCount = 0;
+        m_windowRoundTripNs = std::numeric_limits<qint64>::max();
+    }
+
+    return true;
+}
+
+RoundTripStatistics RoundTripTracker::statistics() const
+{
+    RoundTripStatistics statistics;
+    statistics.responses = m_responses;
+    statistics.unmatched = m_unmatched;
+    statistics.roundTrip = m_roundTrip;
+    statistics.synchronized = m_synchronized;
+    statistics.clockOffsetNs = m_clockOffsetNs;
+    return statistics;
+}
@@ -0,0 +1,63 @@
+#ifndef ROUNDTRIPTRACKER_741AE77E382640388C9EA9706D4E8CCB
+#define ROUNDTRIPTRACKER_741AE77E382640388C9EA9706D4E8CCB
+
+#include <QString>
+#include "latencystatistics.h"
+
+struct RoundTripStatistics
+{
+    QString port;
+    // Answers matched to a frame, and answers to frames that were not sent
+    // or are older than MAX_ROUND_TRIP_NS
+    quint64 responses = 0;
+    quint64 unmatched = 0;
+    LatencyStatistics roundTrip;
+    // Device clock minus host clock (AcquisitionThread::now()), valid once
+    // the first window of responses is complete
+    bool synchronized = false;
+    qint64 clockOffsetNs = 0;
+
+    QString summary() const;
+};
+
+// Round trip times and clock offset of one device. The device answers v2
+// frames with their sequence number and its own clock, see ID::LinkTiming.
+// The clock offset is taken from the fastest answer of each window, its
+// delay was the most symmetric. Nothing allocates, so the serial thread
+// can use it for every frame.
+class RoundTripTracker
+{
+public:
+    static const qint64 MAX_ROUND_TRIP_NS = 500000000;
+    static const qint32 OFFSET_WINDOW = 64;
+
+    RoundTripTracker();
+
+    void reset();
+    void frameSent(quint8 sequence, qint64 nowNs);
+    // Returns false if no frame with this sequence number is waiting for an answer
+    bool responseReceived(quint8 sequence, quint32 deviceTimeUs, qint64 nowNs);
+
+    RoundTripStatistics statistics() const;
+
+private:
+    static const qint64 NOT_SENT = -1;
+
+    qint64 m_sentNs[256];
+    LatencyStatistics m_roundTrip;
+    quint64 m_responses;
+    quint64 m_unmatched;
+
+    // Device clock extended to 64 bits, it wraps every 71 minutes
+    bool m_hasDeviceTime;
+    quint32 m_lastDeviceTimeUs;
+    qint64 m_deviceTimeUs;
+
+    qint32 m_windowCount;
+    qint64 m_windowRoundTripNs;
+    qint64 m_windowOffsetNs;
+    bool m_synchronized;
+    qint64 m_clockOffsetNs;
+};
+
+#endif // ROUNDTRIPTRACKER_741AE77E382640388C9EA9706D4E8CCB
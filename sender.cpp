@@ -1,225 +1,307 @@
-#include "sender.h"
-#include <QDebug>
-#include "settings.h"
-#include "globals.h"
-
-
-Sender::Sender(QObject *parent)
-    : QObject(parent)
-{
-    Settings* settings = Settings::getInstance();
-    (void)connect(settings, &Settings::wheelSlipEnabledChanged, this, &Sender::onWheelSlipEnabledChanged);
-    (void)connect(settings, &Settings::windFanEnabledChanged, this, &Sender::onWindFanEnabledChanged);
-    (void)connect(settings, &Settings::ledFlagEnabledChanged, this, &Sender::onLedFlagEnabledChanged);
-
-    (void)connect(settings, &Settings::wheelSlipPortChanged, this, &Sender::onSelectedPortsChanged);
-    (void)connect(settings, &Settings::ledFlagPortChanged, this, &Sender::onSelectedPortsChanged);
-    (void)connect(settings, &Settings::windFanPortChanged, this, &Sender::onSelectedPortsChanged);
-}
-
-void Sender::onSerialError(const QString &error)
-{
-    qWarning() << "Error in serial thread!" << error;
-}
-
-void Sender::onSendInitialValues()
-{
-    onSendWheelSlipValues(0, 0);
-    onSendWindFanValue(0);
-    onSendLedFlagValue(0);
-}
-
-void Sender::onSendWheelSlipValues(quint8 gasValue, quint8 brakeValue)
-{
-    if (!Settings::getInstance()->getWheelSlipEnabled())
-    {
-        return;
-    }
-
-    qDebug() << QString("sendWheelSlipValues(%1, %2)").arg(gasValue).arg(brakeValue);
-
-    QString port = Settings::getInstance()->getWheelSlipPort();
-    if (port.isEmpty() || (!Settings::getInstance()->isWheelSlipPortActive()))
-    {
-        qWarning() << "Wheel slip port not found";
-        return;
-    }
-
-    std::bitset<BYTE_SIZE*3> data = ((START_BIT << (BYTE_SIZE*2))
-                                     | (ID::WheelSlip << (BYTE_SIZE*2))
-                                     | (gasValue << BYTE_SIZE)
-                                     | (brakeValue));
-
-    QByteArray dataOut = bitsetToQByteArray<3>(data);
-    for (qint32 i = 0; i < dataOut.size(); ++i)
-    {
-        qDebug() << "Byte" << i << ")" << static_cast<unsigned char>(dataOut.at(i));
-    }
-
-    SerialThread* thread = m_serialThreads.value(port);
-    if (thread == nullptr)
-    {
-        thread = new SerialThread();
-        (void)connect(thread, &SerialThread::error, this, &Sender::onSerialError);
-        m_serialThreads.insert(port, thread);
-    }
-
-    thread->transaction(port, dataOut);
-}
-
-void Sender::onSendWindFanValue(quint8 value)
-{
-    if (!Settings::getInstance()->getWindFanEnabled())
-    {
-        return;
-    }
-
-    qDebug() << QString("onSendWindFanValue(%1)").arg(value);
-
-    QString port = Settings::getInstance()->getWindFanPort();
-    if (port.isEmpty() || (!Settings::getInstance()->isWindFanPortActive()))
-    {
-        qWarning() << "Wind fan port not found";
-        return;
-    }
-
-    std::bitset<BYTE_SIZE*2> data = ((START_BIT << BYTE_SIZE)
-                                     | (ID::WindFan << BYTE_SIZE)
-                                     | (value));
-
-    QByteArray dataOut = bitsetToQByteArray<2>(data);
-    for (qint32 i = 0; i < dataOut.size(); ++i)
-    {
-        qDebug() << "Byte" << i << ")" << static_cast<unsigned char>(dataOut.at(i));
-    }
-
-    //m_windFanSerialThread.transaction(port, dataOut);
-
-    SerialThread* thread = m_serialThreads.value(port);
-    if (thread == nullptr)
-    {
-        thread = new SerialThread(this);
-        (void)connect(thread, &SerialThread::error, this, &Sender::onSerialError);
-        m_serialThreads.insert(port, thread);
-    }
-
-    thread->transaction(port, dataOut);
-}
-
-void Sender::onSendLedFlagValue(quint8 value)
-{
-    if (!Settings::getInstance()->getLedFlagEnabled())
-    {
-        return;
-    }
-
-    qDebug() << QString("onSendLedFlagValue(%1)").arg(value);
-
-    QString port = Settings::getInstance()->getLedFlagPort();
-    if (port.isEmpty() || (!Settings::getInstance()->isLedFlagPortActive()))
-    {
-        qWarning() << "LED flag port not found";
-        return;
-    }
-
-    std::bitset<BYTE_SIZE*2> data = ((START_BIT << BYTE_SIZE)
-                                     | (ID::LEDFlag << BYTE_SIZE)
-                                     | (value));
-
-    QByteArray dataOut = bitsetToQByteArray<2>(data);
-    for (qint32 i = 0; i < dataOut.size(); ++i)
-    {
-        qDebug() << "Byte" << i << ")" << static_cast<unsigned char>(dataOut.at(i));
-    }
-
-    //m_ledFlagSerialThread.transaction(port, dataOut);
-
-    SerialThread* thread = m_serialThreads.value(port);
-    if (thread == nullptr)
-    {
-        qDebug() << "Create" << port << "thread";
-        thread = new SerialThread(this);
-        (void)connect(thread, &SerialThread::error, this, &Sender::onSerialError);
-        m_serialThreads.insert(port, thread);
-    }
-
-    thread->transaction(port, dataOut);
-}
-
-void Sender::onWheelSlipEnabledChanged()
-{
-    if (!Settings::getInstance()->getWheelSlipEnabled())
-    {
-        onSendWheelSlipValues(0, 0);
-    }
-}
-
-void Sender::onWindFanEnabledChanged()
-{
-    if (!Settings::getInstance()->getWindFanEnabled())
-    {
-        onSendWindFanValue(0);
-    }
-}
-
-void Sender::onLedFlagEnabledChanged()
-{
-    if (!Settings::getInstance()->getLedFlagEnabled())
-    {
-        onSendLedFlagValue(0);
-    }
-}
-
-void Sender::onSelectedPortsChanged()
-{
-    qDebug() << "onSelectedPortsChanged()";
-    QList<QString> threadPorts = m_serialThreads.keys();
-    QList<QString> selectedPorts;
-    selectedPorts << Settings::getInstance()->getWheelSlipPort();
-    selectedPorts << Settings::getInstance()->getLedFlagPort();
-    selectedPorts << Settings::getInstance()->getWindFanPort();
-
-    QList<QString> portsToDelete;
-    for (QString port : threadPorts)
-    {
-        if (!selectedPorts.contains(port))
-        {
-            qDebug() << "Thread" << port << "shall be killed";
-            portsToDelete << port;
-        }
-    }
-
-    for (QString port : portsToDelete)
-    {
-        SerialThread* thread = m_serialThreads.value(port);
-        if (thread != nullptr)
-        {
-            qDebug() << "Kill" << port << "thread";
-            thread->terminate();
-            (void)disconnect(thread, &SerialThread::error, this, &Sender::onSerialError);
-            delete thread;
-            thread = nullptr;
-        }
-
-        m_serialThreads.remove(port);
-    }
-}
-
-template <unsigned int N>
-QByteArray Sender::bitsetToQByteArray(std::bitset<BYTE_SIZE*N> data)
-{
-    QByteArray result;
-
-    quint32 filter = 0xff;
-    filter <<= BYTE_SIZE * (N-1);
-
-    for (quint8 i = N; i > 0; --i)
-    {
-        quint32 dataULong = ((data & std::bitset<BYTE_SIZE*N>(filter)) >> (BYTE_SIZE * (i - 1))).to_ulong();
-        unsigned char dataUChar = static_cast<unsigned char>(dataULong);
-        result.append(dataUChar);
-        filter >>= BYTE_SIZE;
-    }
-
-    return result;
-}
+#include "sender.h"
+#include <QDebug>
+#include "settings.h"
+#include "globals.h"
+#include "protocolv2.h"
+
+
+Sender::Sender(QObject *parent)
+    : QObject(parent)
+{
+    Settings* settings = Settings::getInstance();
+    (void)connect(settings, &Settings::wheelSlipEnabledChanged, this, &Sender::onWheelSlipEnabledChanged);
+    (void)connect(settings, &Settings::windFanEnabledChanged, this, &Sender::onWindFanEnabledChanged);
+    (void)connect(settings, &Settings::ledFlagEnabledChanged, this, &Sender::onLedFlagEnabledChanged);
+
+    (void)connect(settings, &Settings::wheelSlipPortChanged, this, &Sender::onSelectedPortsChanged);
+    (void)connect(settings, &Settings::ledFlagPortChanged, this, &Sender::onSelectedPortsChanged);
+    (void)connect(settings, &Settings::windFanPortChanged, this, &Sender::onSelectedPortsChanged);
+
+    (void)connect(settings, &Settings::wheelSlipEnabledChanged, this, &Sender::updateBandwidthPlan);
+    (void)connect(settings, &Settings::windFanEnabledChanged, this, &Sender::updateBandwidthPlan);
+    (void)connect(settings, &Settings::ledFlagEnabledChanged, this, &Sender::updateBandwidthPlan);
+    (void)connect(settings, &Settings::upsChanged, this, &Sender::updateBandwidthPlan);
+
+    (void)connect(&m_serialThread, &SerialThread::error, this, &Sender::onSerialError);
+    (void)connect(&m_serialThread, &SerialThread::linkConfigured, this, &Sender::onLinkConfigured);
+    (void)connect(&m_serialThread, &SerialThread::portAppeared, this, &Sender::serialPortsChanged);
+    (void)connect(&m_serialThread, &SerialThread::portDisappeared, this, &Sender::serialPortsChanged);
+
+    updatePortHandles();
+    updateBandwidthPlan();
+}
+
+SerialFrame Sender::encodeWheelSlipValues(quint8 gasValue, quint8 brakeValue)
+{
+    SerialFrame frame;
+    frame.size = 3;
+    frame.data[0] = static_cast<char>(START_BIT | ID::WheelSlip);
+    frame.data[1] = static_cast<char>(gasValue);
+    frame.data[2] = static_cast<char>(brakeValue);
+
+    return frame;
+}
+
+SerialFrame Sender::encodePerWheelSlipValues(quint8 gasMask, quint8 frontLeft, quint8 frontRight, quint8 rearLeft, quint8 rearRight)
+{
+    // Only the header has the start bit set, every following byte carries
+    // 7 bits: the gas mask, then the intensity of each wheel
+    SerialFrame frame;
+    frame.size = 6;
+    frame.data[0] = static_cast<char>(START_BIT | ID::WheelSlipPerWheel);
+    frame.data[1] = static_cast<char>(gasMask & 0x0f);
+    frame.data[2] = static_cast<char>(frontLeft & 0x7f);
+    frame.data[3] = static_cast<char>(frontRight & 0x7f);
+    frame.data[4] = static_cast<char>(rearLeft & 0x7f);
+    frame.data[5] = static_cast<char>(rearRight & 0x7f);
+
+    return frame;
+}
+
+SerialFrame Sender::encodeWindFanValue(quint8 value)
+{
+    SerialFrame frame;
+    frame.size = 2;
+    frame.data[0] = static_cast<char>(START_BIT | ID::WindFan);
+    frame.data[1] = static_cast<char>(value);
+
+    return frame;
+}
+
+SerialFrame Sender::encodeLedFlagValue(quint8 value)
+{
+    SerialFrame frame;
+    frame.size = 2;
+    frame.data[0] = static_cast<char>(START_BIT | ID::LEDFlag);
+    frame.data[1] = static_cast<char>(value);
+
+    return frame;
+}
+
+QList<PortHealth> Sender::portHealth() const
+{
+    return m_serialThread.portHealth();
+}
+
+void Sender::onSerialError(const QString &error)
+{
+    qWarning() << "Error in serial thread!" << error;
+}
+
+void Sender::onLinkConfigured(const QString &portName, qint32 baudRate)
+{
+    m_bandwidthPlanner.setBaudRate(portName, baudRate);
+    updateBandwidthPlan();
+}
+
+void Sender::updateBandwidthPlan()
+{
+    // Worst case: every channel changes at every tick
+    Settings* settings = Settings::getInstance();
+    m_bandwidthPlanner.setTickRate(settings->getPacketDrivenAcquisition() ? MAX_UPS : settings->getUps());
+    m_bandwidthPlanner.clearChannels();
+    if (settings->getWheelSlipEnabled() && !settings->getWheelSlipPort().isEmpty())
+    {
+        if (settings->getPerWheelSlip())
+        {
+            m_bandwidthPlanner.addChannel(settings->getWheelSlipPort(), ID::WheelSlipPerWheel, messageBytes(settings->getWheelSlipPort(), encodePerWheelSlipValues(0, 0, 0, 0, 0)), 2);
+        }
+        else
+        {
+            m_bandwidthPlanner.addChannel(settings->getWheelSlipPort(), ID::WheelSlip, messageBytes(settings->getWheelSlipPort(), encodeWheelSlipValues(0, 0)), 2);
+        }
+    }
+    if (settings->getWindFanEnabled() && !settings->getWindFanPort().isEmpty())
+    {
+        m_bandwidthPlanner.addChannel(settings->getWindFanPort(), ID::WindFan, messageBytes(settings->getWindFanPort(), encodeWindFanValue(0)), 1);
+    }
+    if (settings->getLedFlagEnabled() && !settings->getLedFlagPort().isEmpty())
+    {
+        m_bandwidthPlanner.addChannel(settings->getLedFlagPort(), ID::LEDFlag, messageBytes(settings->getLedFlagPort(), encodeLedFlagValue(0)), 0);
+    }
+
+    if (!m_bandwidthPlanner.plan())
+    {
+        qWarning() << "A serial link is too slow even for the minimum rate of its channels";
+    }
+
+    for (const QString &warning : m_bandwidthPlanner.warnings())
+    {
+        qWarning().noquote() << "Serial link overrun:" << warning;
+    }
+
+    for (auto it = m_ports.cbegin(); it != m_ports.cend(); ++it)
+    {
+        applyBandwidthPlan(it.key());
+    }
+}
+
+qint32 Sender::messageBytes(const QString &port, const SerialFrame &message)
+{
+    if (Settings::getInstance()->getProtocol(port) != SerialThread::PROTOCOL_V2)
+    {
+        return message.size;
+    }
+
+    // Worst case: the channel goes out alone in its frame
+    return ProtocolV2::channelSize(message.size - 1) + ProtocolV2::FRAME_OVERHEAD;
+}
+
+void Sender::applyBandwidthPlan(const QString &port)
+{
+    qint32 handle = m_ports.value(port, -1);
+    for (const PlannedChannel &channel : m_bandwidthPlanner.channels())
+    {
+        if (channel.port == port)
+        {
+            m_serialThread.setMinimumInterval(handle, channel.id, channel.minIntervalNs);
+        }
+    }
+}
+
+void Sender::sendInitialValues(bool perWheelSlip)
+{
+    if (perWheelSlip)
+    {
+        sendPerWheelSlipValues(0, 0, 0, 0, 0);
+    }
+    else
+    {
+        sendWheelSlipValues(0, 0);
+    }
+    sendWindFanValue(0);
+    sendLedFlagValue(0);
+}
+
+void Sender::sendWheelSlipValues(quint8 gasValue, quint8 brakeValue)
+{
+    (void)m_serialThread.transaction(m_wheelSlipHandle.load(std::memory_order_acquire), encodeWheelSlipValues(gasValue, brakeValue));
+}
+
+void Sender::sendPerWheelSlipValues(quint8 gasMask, quint8 frontLeft, quint8 frontRight, quint8 rearLeft, quint8 rearRight)
+{
+    (void)m_serialThread.transaction(m_wheelSlipHandle.load(std::memory_order_acquire), encodePerWheelSlipValues(gasMask, frontLeft, frontRight, rearLeft, rearRight));
+}
+
+void Sender::sendWindFanValue(quint8 value)
+{
+    (void)m_serialThread.transaction(m_windFanHandle.load(std::memory_order_acquire), encodeWindFanValue(value));
+}
+
+void Sender::sendLedFlagValue(quint8 value)
+{
+    (void)m_serialThread.transaction(m_ledFlagHandle.load(std::memory_order_acquire), encodeLedFlagValue(value));
+}
+
+void Sender::postLedFlagValue(quint8 value)
+{
+    (void)m_serialThread.post(m_ledFlagHandle.load(std::memory_order_relaxed), encodeLedFlagValue(value));
+}
+
+void Sender::onWheelSlipEnabledChanged()
+{
+    // Turned off on the port that is still known, before it is dropped
+    if (!Settings::getInstance()->getWheelSlipEnabled())
+    {
+        qint32 handle = m_wheelSlipHandle.load(std::memory_order_relaxed);
+        if (Settings::getInstance()->getPerWheelSlip())
+        {
+            (void)m_serialThread.post(handle, encodePerWheelSlipValues(0, 0, 0, 0, 0));
+        }
+        else
+        {
+            (void)m_serialThread.post(handle, encodeWheelSlipValues(0, 0));
+        }
+    }
+
+    updatePortHandles();
+}
+
+void Sender::onWindFanEnabledChanged()
+{
+    if (!Settings::getInstance()->getWindFanEnabled())
+    {
+        (void)m_serialThread.post(m_windFanHandle.load(std::memory_order_relaxed), encodeWindFanValue(0));
+    }
+
+    updatePortHandles();
+}
+
+void Sender::onLedFlagEnabledChanged()
+{
+    if (!Settings::getInstance()->getLedFlagEnabled())
+    {
+        postLedFlagValue(0);
+    }
+
+    updatePortHandles();
+}
+
+void Sender::onSelectedPortsChanged()
+{
+    qDebug() << "onSelectedPortsChanged()";
+    QList<QString> selectedPorts;
+    selectedPorts << Settings::getInstance()->getWheelSlipPort();
+    selectedPorts << Settings::getInstance()->getLedFlagPort();
+    selectedPorts << Settings::getInstance()->getWindFanPort();
+
+    QList<QString> portsToClose;
+    for (auto it = m_ports.cbegin(); it != m_ports.cend(); ++it)
+    {
+        if (!selectedPorts.contains(it.key()))
+        {
+            portsToClose << it.key();
+        }
+    }
+
+    // A handle carries the generation of its slot, so a message the
+    // acquisition thread still sends to a closed port is dropped, also
+    // when updatePortHandles() gives the slot to a new port
+    for (const QString &port : portsToClose)
+    {
+        qDebug() << "Close" << port;
+        m_serialThread.closePort(m_ports.take(port));
+    }
+
+    updatePortHandles();
+    updateBandwidthPlan();
+}
+
+void Sender::updatePortHandles()
+{
+    Settings* settings = Settings::getInstance();
+    m_wheelSlipHandle.store(portHandle(settings->getWheelSlipEnabled(), settings->getWheelSlipPort(), settings->isWheelSlipPortActive()), std::memory_order_release);
+    m_windFanHandle.store(portHandle(settings->getWindFanEnabled(), settings->getWindFanPort(), settings->isWindFanPortActive()), std::memory_order_release);
+    m_ledFlagHandle.store(portHandle(settings->getLedFlagEnabled(), settings->getLedFlagPort(), settings->isLedFlagPortActive()), std::memory_order_release);
+}
+
+qint32 Sender::portHandle(bool enabled, const QString &port, bool active)
+{
+    if (!enabled)
+    {
+        return -1;
+    }
+
+    if (port.isEmpty() || !active)
+    {
+        qDebug() << "Port" << port << "not found";
+        return -1;
+    }
+
+    auto it = m_ports.find(port);
+    if (it == m_ports.end())
+    {
+        // The port is opened with its first message
+        Settings* settings = Settings::getInstance();
+        qint32 handle = m_serialThread.addPort(port, settings->getMaxBaudRate(port), settings->getProtocol(port));
+        if (handle < 0)
+        {
+            return -1;
+        }
+
+        it = m_ports.insert(port, handle);
+        applyBandwidthPlan(port);
+    }
+
+    return it.value();
+}
@@ -1,45 +1,79 @@
-#ifndef SENDER_6C348842166C430B809BD8E73B5AF2FC
-#define SENDER_6C348842166C430B809BD8E73B5AF2FC
-
-#include <QObject>
-#include <QMap>
-#include <bitset>
-#include "serialthread.h"
-#include "globals.h"
-
-
-class Sender : public QObject
-{
-    Q_OBJECT
-public:
-    explicit Sender(QObject *parent = nullptr);
-
-public Q_SLOTS:
-    void onSendInitialValues();
-
-    void onSendWheelSlipValues(quint8 gasValue, quint8 brakeValue);
-    void onSendWindFanValue(quint8 value);
-    void onSendLedFlagValue(quint8 value);
-
-    void onWheelSlipEnabledChanged();
-    void onWindFanEnabledChanged();
-    void onLedFlagEnabledChanged();
-
-    void onSelectedPortsChanged();
-
-private Q_SLOTS:
-    void onSerialError(const QString &error);
-
-private:
-    template <unsigned int N>
-    QByteArray bitsetToQByteArray(std::bitset<BYTE_SIZE*N> data);
-
-    //SerialThread m_wheelSlipSerialThread;
-    //SerialThread m_ledFlagSerialThread;
-    //SerialThread m_windFanSerialThread;
-
-    QMap<QString, SerialThread*> m_serialThreads;
-
-};
-
-#endif // SENDER_6C348842166C430B809BD8E73B5AF2FC
+#ifndef SENDER_6C348842166C430B809BD8E73B5AF2FC
+#define SENDER_6C348842166C430B809BD8E73B5AF2FC
+
+#include <QObject>
+#include <QMap>
+#include <atomic>
+#include "serialthread.h"
+#include "bandwidthplanner.h"
+#include "globals.h"
+
+
+class Sender : public QObject
+{
+    Q_OBJECT
+public:
+    explicit Sender(QObject *parent = nullptr);
+
+    // Serial messages for the given values, built on the stack
+    static SerialFrame encodeWheelSlipValues(quint8 gasValue, quint8 brakeValue);
+    static SerialFrame encodePerWheelSlipValues(quint8 gasMask, quint8 frontLeft, quint8 frontRight, quint8 rearLeft, quint8 rearRight);
+    static SerialFrame encodeWindFanValue(quint8 value);
+    static SerialFrame encodeLedFlagValue(quint8 value);
+
+    // Reconnects and downtime of the ports in use
+    QList<PortHealth> portHealth() const;
+
+    // Called by the acquisition thread only, the values are handed to the
+    // serial thread without blocking or allocating. Outputs that are
+    // disabled or have no port drop them.
+    void sendInitialValues(bool perWheelSlip);
+    void sendWheelSlipValues(quint8 gasValue, quint8 brakeValue);
+    void sendPerWheelSlipValues(quint8 gasMask, quint8 frontLeft, quint8 frontRight, quint8 rearLeft, quint8 rearRight);
+    void sendWindFanValue(quint8 value);
+    void sendLedFlagValue(quint8 value);
+
+    // For the UI thread, e.g. to test the flag LEDs
+    void postLedFlagValue(quint8 value);
+
+public Q_SLOTS:
+
+    void onWheelSlipEnabledChanged();
+    void onWindFanEnabledChanged();
+    void onLedFlagEnabledChanged();
+
+    void onSelectedPortsChanged();
+
+Q_SIGNALS:
+    // A serial port was plugged in or removed
+    void serialPortsChanged();
+
+private Q_SLOTS:
+    void onSerialError(const QString &error);
+    void onLinkConfigured(const QString &portName, qint32 baudRate);
+    void updateBandwidthPlan();
+
+private:
+    // Looks up the settings of the outputs once, so sending a value needs
+    // neither settings nor a port lookup
+    void updatePortHandles();
+    // Handle of the port, or -1 if the output is disabled or has no port.
+    // Only the UI thread adds and closes ports.
+    qint32 portHandle(bool enabled, const QString &port, bool active);
+    void applyBandwidthPlan(const QString &port);
+    // Bytes a message takes on the wire with the protocol of the port
+    static qint32 messageBytes(const QString &port, const SerialFrame &message);
+
+    // One thread for all ports, m_ports are the handles of the ones used so far
+    SerialThread m_serialThread;
+    QMap<QString, qint32> m_ports;
+    // Written by the UI thread, read by the acquisition thread
+    std::atomic<qint32> m_wheelSlipHandle {-1};
+    std::atomic<qint32> m_windFanHandle {-1};
+    std::atomic<qint32> m_ledFlagHandle {-1};
+    // Rates of the channels each link can carry at the update rate
+    BandwidthPlanner m_bandwidthPlanner;
+
+};
+
+#endif // SENDER_6C348842166C430B809BD8E73B5AF2FC
@@ -1,129 +1,886 @@
-#include "serialthread.h"
-#include <QSerialPort>
-#include <QTime>
-#include <QDebug>
-
-SerialThread::SerialThread(QObject *parent)
-    : QThread(parent)
-{
-
-}
-
-SerialThread::~SerialThread()
-{
-    m_mutex.lock();
-    m_quit = true;
-    m_cond.wakeOne();
-    m_mutex.unlock();
-    wait();
-}
-
-void SerialThread::transaction(const QString &portName, const QByteArray &data)
-{
-    const QMutexLocker locker(&m_mutex);
-    m_portName = portName;
-    m_data = data;
-
-    if (!isRunning())
-    {
-        start();
-    }
-    else
-    {
-        m_cond.wakeOne();
-    }
-}
-
-void SerialThread::run()
-{
-    qDebug() << "SerialThread::run()";
-    bool currentPortNameChanged = false;
-
-    m_mutex.lock();
-    QString currentPortName;
-    if (currentPortName != m_portName)
-    {
-        currentPortName = m_portName;
-        currentPortNameChanged = true;
-    }
-
-    qint32 currentWaitTimeout = m_waitTimeout;
-    QByteArray currentData = m_data;
-    m_mutex.unlock();
-    QSerialPort serial;
-
-    if (currentPortName.isEmpty())
-    {
-        Q_EMIT error("No port name specified");
-        return;
-    }
-
-    while (!m_quit)
-    {
-        if (currentPortNameChanged)
-        {
-            serial.close();
-            serial.setPortName(currentPortName);
-            serial.setBaudRate(9600);
-
-            if (!serial.open(QIODevice::ReadWrite))
-            {
-                Q_EMIT error("Can't open " + m_portName + ", error code " + serial.error());
-                return;
-            }
-        }
-        // write data
-        const QByteArray currentDataConst = currentData;
-
-        qDebug() << "Data:";
-        for (qint32 i = 0; i < currentDataConst.size(); ++i)
-        {
-            unsigned char current = static_cast<unsigned char>(currentDataConst.at(i));
-            qDebug() << i << ") " << current;
-        }
-
-        qint64 bytesSent = serial.write(currentDataConst);
-        if (serial.waitForBytesWritten(m_waitTimeout))
-        {
-            qDebug() << "Sent" << bytesSent << "Bytes";
-
-            if (READ_RESPONSE)
-            {
-                // Read response
-                if (serial.waitForReadyRead(currentWaitTimeout))
-                {
-                    QByteArray responseData = serial.readAll();
-                    while (serial.waitForReadyRead(10))
-                    {
-                        responseData += serial.readAll();
-                    }
-
-                    qDebug() << "Response:";
-                    for (qint32 i = 0; i < responseData.size(); ++i)
-                    {
-                        QChar current = responseData.at(i);
-                        qDebug() << i << ") " << QString::number(current.toLatin1());
-                    }
-                }
-            }
-        }
-
-        m_mutex.lock();
-        m_cond.wait(&m_mutex);
-        if (currentPortName != m_portName)
-        {
-            currentPortName = m_portName;
-            currentPortNameChanged = true;
-        }
-        else
-        {
-            currentPortNameChanged = false;
-        }
-
-        //currentWaitTimeout = m_waitTimeout;
-        currentData = m_data;
-        m_mutex.unlock();
-    }
-
-    serial.close();
-}
+#include "serialthread.h"
+#include <QDebug>
+#include <cstring>
+#include <limits>
+#include "acquisitionthread.h"
+#include "globals.h"
+
+// Rates a device is asked for, the index is the code in the request. The
+// device answers with the same two bytes and switches after the answer.
+static const qint32 BAUD_RATES[] = {2000000, 1000000, 921600, 500000, 460800, 250000, 230400, 115200, 57600, 38400, 19200};
+static const qint32 BAUD_RATE_COUNT = sizeof(BAUD_RATES) / sizeof(BAUD_RATES[0]);
+// Time a device has to answer a request before the next slower rate is tried
+static const qint32 NEGOTIATION_TIMEOUT_MS = 100;
+static const qint64 NEVER_WRITTEN = std::numeric_limits<qint64>::min() / 2;
+// Bytes a port may hold back before the next messages wait in their
+// mailboxes. Keeps the values short of the port's buffer fresh.
+static const qint64 MAX_BUFFERED_BYTES = 32;
+// How often the round trips and outages of the devices are logged
+static const qint32 LINK_REPORT_INTERVAL_MS = 10000;
+// Reconnect backoff of a device that is gone, doubled after every failed open
+static const qint32 INITIAL_RECONNECT_MS = 250;
+static const qint32 MAX_RECONNECT_MS = 8000;
+// The kernel announces a device before its node is ready to be opened
+static const qint32 PLUG_SETTLE_MS = 100;
+// Largest write of a flush in either protocol
+static const qint32 MAX_V1_BATCH_SIZE = SerialThread::MAX_MESSAGE_IDS * SerialFrame::MAX_SIZE;
+static const qint32 MAX_BATCH_SIZE = (MAX_V1_BATCH_SIZE > ProtocolV2::MAX_FRAME_SIZE) ? MAX_V1_BATCH_SIZE : ProtocolV2::MAX_FRAME_SIZE;
+
+// Settings and QSerialPortInfo name ports without /dev/, users may not
+static bool isSamePort(const QString &name, const QString &portName)
+{
+    return (name == portName) || (name == ("/dev/" + portName));
+}
+
+
+SerialThread::SerialThread(QObject *parent)
+    : QThread(parent)
+{
+    m_clock.start();
+
+    // Wait for the event loop so that messages can be queued right away
+    QMutexLocker locker(&m_mutex);
+    start();
+    while (m_context == nullptr)
+    {
+        m_started.wait(&m_mutex);
+    }
+
+    // Hot plug events come from the watcher's thread
+    (void)connect(&m_deviceWatcher, &DeviceWatcher::portAdded, m_context, [this](const QString &portName)
+    {
+        onPortAppeared(portName);
+    });
+    (void)connect(&m_deviceWatcher, &DeviceWatcher::portRemoved, m_context, [this](const QString &portName)
+    {
+        onPortDisappeared(portName);
+    });
+    m_deviceWatcher.start();
+}
+
+SerialThread::~SerialThread()
+{
+    m_deviceWatcher.stop();
+
+    // run() flushes the last messages before it closes the ports
+    (void)QMetaObject::invokeMethod(m_context, [this]() { quit(); }, Qt::QueuedConnection);
+    wait();
+}
+
+qint32 SerialThread::addPort(const QString &portName, qint32 maxBaudRate, qint32 protocol)
+{
+    for (qint32 i = 0; i < MAX_PORTS; ++i)
+    {
+        if ((m_ports[i].state.load(std::memory_order_acquire) == ActivePort) && (m_ports[i].name == portName))
+        {
+            return makeHandle(i, m_ports[i].generation.load(std::memory_order_relaxed));
+        }
+    }
+
+    for (qint32 i = 0; i < MAX_PORTS; ++i)
+    {
+        Port &port = m_ports[i];
+        if (port.state.load(std::memory_order_acquire) == FreePort)
+        {
+            port.name = portName;
+            port.maxBaudRate.store(maxBaudRate, std::memory_order_relaxed);
+            port.protocol.store(protocol, std::memory_order_relaxed);
+            port.sequence = 0;
+            port.written = 0;
+            port.replay = 0;
+            port.backoffMs = 0;
+            port.retryAtNs = 0;
+            port.connected.store(false, std::memory_order_relaxed);
+            port.reconnects.store(0, std::memory_order_relaxed);
+            port.downtimeNs.store(0, std::memory_order_relaxed);
+            port.downSinceNs.store(-1, std::memory_order_relaxed);
+            for (qint32 id = 0; id < MAX_MESSAGE_IDS; ++id)
+            {
+                port.minIntervalNs[id].store(0, std::memory_order_relaxed);
+                port.lastWriteNs[id] = NEVER_WRITTEN;
+            }
+            quint32 generation = (port.generation.load(std::memory_order_relaxed) + 1) & MAX_GENERATION;
+            port.generation.store(generation, std::memory_order_relaxed);
+            port.state.store(ActivePort, std::memory_order_release);
+            return makeHandle(i, generation);
+        }
+    }
+
+    Q_EMIT error("Too many serial ports, " + portName + " is not used");
+    return -1;
+}
+
+qint32 SerialThread::makeHandle(qint32 slot, quint32 generation)
+{
+    return static_cast<qint32>(generation << PORT_SLOT_BITS) | slot;
+}
+
+quint32 SerialThread::handleGeneration(qint32 handle)
+{
+    return static_cast<quint32>(handle) >> PORT_SLOT_BITS;
+}
+
+SerialThread::Port* SerialThread::portForHandle(qint32 handle)
+{
+    if (handle < 0)
+    {
+        return nullptr;
+    }
+
+    Port &port = m_ports[handle & PORT_SLOT_MASK];
+    if (port.generation.load(std::memory_order_acquire) != handleGeneration(handle))
+    {
+        return nullptr;
+    }
+
+    return &port;
+}
+
+bool SerialThread::transaction(qint32 port, const SerialFrame &frame)
+{
+    if ((port < 0) || (frame.size == 0) || (frame.size > SerialFrame::MAX_SIZE))
+    {
+        return false;
+    }
+
+    // The slot may be closed and reused while the message is on its way,
+    // the serial thread drops it then by its generation
+    PortMessage message;
+    message.generation = handleGeneration(port);
+    message.frame = frame;
+    qint32 id = static_cast<quint8>(frame.data[0]) % MAX_MESSAGE_IDS;
+    Port &target = m_ports[port & PORT_SLOT_MASK];
+    (void)target.mailboxes[id].push(message);
+    if (target.dirty.fetch_or(1u << id, std::memory_order_release) == 0)
+    {
+        wake();
+    }
+
+    return true;
+}
+
+bool SerialThread::post(qint32 port, const SerialFrame &frame)
+{
+    if ((port < 0) || (frame.size == 0) || (frame.size > SerialFrame::MAX_SIZE))
+    {
+        return false;
+    }
+
+    (void)QMetaObject::invokeMethod(m_context, [this, port, frame]()
+    {
+        Port* found = portForHandle(port);
+        if ((found == nullptr) || (found->state.load(std::memory_order_acquire) != ActivePort))
+        {
+            return;
+        }
+        Port &target = *found;
+
+        // Goes out like a message to write again after a reconnect, the
+        // older messages in the mailbox are dropped
+        qint32 id = static_cast<quint8>(frame.data[0]) % MAX_MESSAGE_IDS;
+        target.mailboxes[id].clear();
+        target.lastFrames[id] = frame;
+        target.replay |= (1u << id);
+        flush();
+    }, Qt::QueuedConnection);
+
+    return true;
+}
+
+void SerialThread::setMinimumInterval(qint32 port, qint32 id, qint64 intervalNs)
+{
+    Port* target = portForHandle(port);
+    if ((target == nullptr) || (id < 0) || (id >= MAX_MESSAGE_IDS))
+    {
+        return;
+    }
+
+    target->minIntervalNs[id].store(qMax<qint64>(0, intervalNs), std::memory_order_relaxed);
+}
+
+QList<qint32> SerialThread::supportedBaudRates()
+{
+    QList<qint32> baudRates;
+    for (qint32 baudRate : BAUD_RATES)
+    {
+        baudRates.append(baudRate);
+    }
+
+    return baudRates;
+}
+
+void SerialThread::closePort(qint32 port)
+{
+    Port* target = portForHandle(port);
+    if (target == nullptr)
+    {
+        return;
+    }
+
+    qint32 active = ActivePort;
+    if (target->state.compare_exchange_strong(active, ClosingPort, std::memory_order_acq_rel))
+    {
+        wake();
+    }
+}
+
+QList<RoundTripStatistics> SerialThread::roundTripStatistics() const
+{
+    QList<RoundTripStatistics> result;
+    QMutexLocker locker(&m_roundTripMutex);
+    for (const Port &port : m_ports)
+    {
+        if ((port.state.load(std::memory_order_acquire) == ActivePort)
+                && (port.protocol.load(std::memory_order_relaxed) == PROTOCOL_V2))
+        {
+            RoundTripStatistics statistics = port.roundTrip.statistics();
+            statistics.port = port.name;
+            result.append(statistics);
+        }
+    }
+
+    return result;
+}
+
+QList<PortHealth> SerialThread::portHealth() const
+{
+    QList<PortHealth> result;
+    qint64 nowNs = m_clock.nsecsElapsed();
+    for (const Port &port : m_ports)
+    {
+        if (port.state.load(std::memory_order_acquire) != ActivePort)
+        {
+            continue;
+        }
+
+        PortHealth health;
+        health.port = port.name;
+        health.connected = port.connected.load(std::memory_order_relaxed);
+        health.reconnects = port.reconnects.load(std::memory_order_relaxed);
+        health.downtimeNs = port.downtimeNs.load(std::memory_order_relaxed);
+        qint64 downSinceNs = port.downSinceNs.load(std::memory_order_relaxed);
+        if (downSinceNs >= 0)
+        {
+            health.downtimeNs += nowNs - downSinceNs;
+        }
+        result.append(health);
+    }
+
+    return result;
+}
+
+SerialStatistics SerialThread::statistics() const
+{
+    SerialStatistics statistics;
+    statistics.messages = m_messages.load(std::memory_order_relaxed);
+    statistics.writes = m_writes.load(std::memory_order_relaxed);
+    statistics.bytes = m_bytes.load(std::memory_order_relaxed);
+    statistics.dropped = m_dropped.load(std::memory_order_relaxed);
+    statistics.elapsedNs = m_clock.nsecsElapsed();
+    for (const Port &port : m_ports)
+    {
+        for (const LatestValueMailbox<PortMessage> &mailbox : port.mailboxes)
+        {
+            statistics.replaced += mailbox.overwritten();
+        }
+    }
+
+    return statistics;
+}
+
+void SerialThread::wake()
+{
+    // One flush takes everything queued until it runs, so only the first
+    // message after a flush wakes the event loop. Waking it posts no event
+    // and allocates nothing, the loop flushes in aboutToBlock().
+    if (!m_flushQueued.exchange(true, std::memory_order_acq_rel))
+    {
+        m_dispatcher->wakeUp();
+    }
+}
+
+void SerialThread::run()
+{
+    qDebug() << "SerialThread::run()";
+    QObject context;
+    QAbstractEventDispatcher* dispatcher = eventDispatcher();
+    (void)connect(dispatcher, &QAbstractEventDispatcher::aboutToBlock, &context, [this]()
+    {
+        if (m_flushQueued.load(std::memory_order_acquire))
+        {
+            flush();
+        }
+    });
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_dispatcher = dispatcher;
+        m_context = &context;
+        m_started.wakeAll();
+    }
+
+    QTimer reconnectTimer;
+    reconnectTimer.setSingleShot(true);
+    (void)connect(&reconnectTimer, &QTimer::timeout, &context, [this]()
+    {
+        flush();
+    });
+    m_reconnectTimer = &reconnectTimer;
+
+    QTimer reportTimer;
+    (void)connect(&reportTimer, &QTimer::timeout, &context, [this]()
+    {
+        reportLinks();
+    });
+    reportTimer.start(LINK_REPORT_INTERVAL_MS);
+
+    (void)exec();
+
+    flush();
+    m_reconnectTimer = nullptr;
+    reportLinks();
+    SerialStatistics summary = statistics();
+    qDebug() << "Serial messages:" << summary.messages << "| writes:" << summary.writes
+             << "| replaced:" << summary.replaced << "| dropped:" << summary.dropped
+             << "| bytes/s:" << summary.bytesPerSecond();
+
+    for (Port &port : m_ports)
+    {
+        closeSerial(port);
+    }
+}
+
+void SerialThread::flush()
+{
+    // Writing or closing a port can emit its signals, which flush again.
+    // That flush runs after this one instead of inside it.
+    if (m_flushing)
+    {
+        wake();
+        return;
+    }
+    m_flushing = true;
+
+    // Cleared first, a message pushed from now on posts a new flush
+    m_flushQueued.store(false, std::memory_order_release);
+
+    quint64 messages = 0;
+    quint64 writes = 0;
+    quint64 bytes = 0;
+    quint64 dropped = 0;
+    for (Port &port : m_ports)
+    {
+        qint32 state = port.state.load(std::memory_order_acquire);
+        if (state == FreePort)
+        {
+            // A message the sending thread handed over just after the port
+            // was closed must not go to the next port in this slot
+            quint32 stale = port.dirty.exchange(0, std::memory_order_acquire);
+            for (qint32 id = 0; (stale != 0) && (id < MAX_MESSAGE_IDS); ++id)
+            {
+                if ((stale & (1u << id)) != 0)
+                {
+                    port.mailboxes[id].clear();
+                }
+            }
+            continue;
+        }
+
+        if ((port.dirty.load(std::memory_order_relaxed) != 0) || (port.replay != 0))
+        {
+            // A closing port that is not open is not opened again for its
+            // last messages, they are dropped below
+            QSerialPort* serial = (state == ClosingPort) ? port.serial : openPort(port);
+            if ((serial == nullptr) && (state != ClosingPort))
+            {
+                // Written once the device is back, newer messages replace
+                // these until then
+                continue;
+            }
+
+            if ((serial != nullptr) && (state != ClosingPort)
+                    && (port.negotiating || (serial->bytesToWrite() >= MAX_BUFFERED_BYTES)))
+            {
+                // Written from bytesWritten() or once the rate is settled
+                continue;
+            }
+
+            // All messages of the port in one write, in v1 they are framed by
+            // their headers, in v2 they become the channels of one frame
+            char batch[MAX_BATCH_SIZE];
+            qint32 size = 0;
+            qint32 count = 0;
+            bool framed = (port.protocol.load(std::memory_order_relaxed) == PROTOCOL_V2);
+            ProtocolV2::FrameEncoder encoder;
+            encoder.begin(port.sequence);
+            quint32 dirty = port.dirty.exchange(0, std::memory_order_acquire);
+            quint32 pending = dirty | port.replay;
+            quint32 postponed = 0;
+            qint64 nowNs = m_clock.nsecsElapsed();
+            qint64 nextDueNs = std::numeric_limits<qint64>::max();
+            quint32 generation = port.generation.load(std::memory_order_relaxed);
+            PortMessage message;
+            SerialFrame &frame = message.frame;
+            for (qint32 id = 0; id < MAX_MESSAGE_IDS; ++id)
+            {
+                quint32 bit = 1u << id;
+                if ((pending & bit) == 0)
+                {
+                    continue;
+                }
+
+                // Channels the link has no room for at every tick wait for their interval
+                qint64 dueNs = port.lastWriteNs[id] + port.minIntervalNs[id].load(std::memory_order_relaxed);
+                if ((dueNs > nowNs) && (state != ClosingPort))
+                {
+                    postponed |= (dirty & bit);
+                    nextDueNs = qMin(nextDueNs, dueNs);
+                    continue;
+                }
+
+                // A newer message replaces the one to write again
+                bool taken = port.mailboxes[id].take(message);
+                if (taken && (message.generation != generation))
+                {
+                    // Sent to the port that had the slot before
+                    ++dropped;
+                    taken = false;
+                }
+                if (!taken && ((port.replay & bit) != 0))
+                {
+                    frame = port.lastFrames[id];
+                    taken = true;
+                }
+                port.replay &= ~bit;
+
+                if (taken)
+                {
+                    port.lastFrames[id] = frame;
+                    port.written |= bit;
+                    if (framed)
+                    {
+                        // The value of a channel is the message without its header
+                        (void)encoder.addChannel(static_cast<quint8>(id), reinterpret_cast<const quint8*>(frame.data + 1), frame.size - 1);
+                    }
+                    else
+                    {
+                        std::memcpy(batch + size, frame.data, frame.size);
+                        size += frame.size;
+                    }
+                    ++count;
+                    port.lastWriteNs[id] = nowNs;
+                }
+            }
+
+            if (((postponed != 0) || (port.replay != 0)) && (serial != nullptr))
+            {
+                (void)port.dirty.fetch_or(postponed, std::memory_order_relaxed);
+                if (!port.intervalTimer->isActive())
+                {
+                    port.intervalTimer->start(static_cast<qint32>((nextDueNs - nowNs) / 1000000) + 1);
+                }
+            }
+
+            if (count == 0)
+            {
+                continue;
+            }
+
+            if (framed)
+            {
+                size = encoder.finish(reinterpret_cast<quint8*>(batch));
+            }
+
+            if ((serial == nullptr) || (serial->write(batch, size) != size))
+            {
+                dropped += static_cast<quint64>(count);
+            }
+            else
+            {
+                messages += static_cast<quint64>(count);
+                bytes += static_cast<quint64>(size);
+                ++writes;
+                if (framed)
+                {
+                    port.roundTrip.frameSent(port.sequence, AcquisitionThread::now());
+                }
+            }
+
+            if (framed)
+            {
+                ++port.sequence;
+            }
+        }
+
+        if (state == ClosingPort)
+        {
+            closeSerial(port);
+            port.state.store(FreePort, std::memory_order_release);
+        }
+    }
+
+    m_messages.fetch_add(messages, std::memory_order_relaxed);
+    m_writes.fetch_add(writes, std::memory_order_relaxed);
+    m_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    m_dropped.fetch_add(dropped, std::memory_order_relaxed);
+    m_flushing = false;
+}
+
+QSerialPort* SerialThread::openPort(Port &port)
+{
+    if (port.serial != nullptr)
+    {
+        return port.serial;
+    }
+
+    qint64 nowNs = m_clock.nsecsElapsed();
+    if (nowNs < port.retryAtNs)
+    {
+        return nullptr;
+    }
+
+    QSerialPort* serial = new QSerialPort(port.name);
+    serial->setBaudRate(DEFAULT_BAUD_RATE);
+    if (!serial->open(QIODevice::ReadWrite))
+    {
+        // Reported once per outage, the retries only go to the log
+        if (port.backoffMs == 0)
+        {
+            Q_EMIT error("Can't open " + port.name + ", " + serial->errorString());
+            port.backoffMs = INITIAL_RECONNECT_MS;
+        }
+        else
+        {
+            port.backoffMs = qMin(port.backoffMs * 2, MAX_RECONNECT_MS);
+        }
+        qDebug() << "Can't open" << port.name << "| retry in" << port.backoffMs << "ms";
+        delete serial;
+
+        setConnected(port, false);
+        port.retryAtNs = nowNs + (static_cast<qint64>(port.backoffMs) * 1000000);
+        scheduleReconnect();
+        return nullptr;
+    }
+
+    qDebug() << "Opened" << port.name;
+    port.backoffMs = 0;
+    port.retryAtNs = 0;
+    setConnected(port, true);
+    // Messages that waited for the port go out as soon as it has room
+    (void)connect(serial, &QSerialPort::bytesWritten, serial, [this]()
+    {
+        flush();
+    });
+
+    // The slot outlives the serial port, after a reconnect it belongs to a new one
+    (void)connect(serial, &QSerialPort::readyRead, serial, [this, &port, serial]()
+    {
+        if (port.serial == serial)
+        {
+            onReadyRead(port);
+        }
+    });
+
+    (void)connect(serial, &QSerialPort::errorOccurred, serial, [this, &port, serial](QSerialPort::SerialPortError serialError)
+    {
+        if ((serialError == QSerialPort::NoError) || (serialError == QSerialPort::TimeoutError))
+        {
+            return;
+        }
+
+        Q_EMIT error(serial->portName() + ": " + serial->errorString());
+
+        if ((serialError == QSerialPort::ResourceError) && (port.serial == serial))
+        {
+            portLost(port);
+        }
+    });
+
+    // The timers belong to the port and go with it
+    port.intervalTimer = new QTimer(serial);
+    port.intervalTimer->setSingleShot(true);
+    (void)connect(port.intervalTimer, &QTimer::timeout, serial, [this]()
+    {
+        flush();
+    });
+
+    port.negotiationTimer = new QTimer(serial);
+    port.negotiationTimer->setSingleShot(true);
+    port.negotiationTimer->setInterval(NEGOTIATION_TIMEOUT_MS);
+    (void)connect(port.negotiationTimer, &QTimer::timeout, serial, [this, &port, serial]()
+    {
+        if (port.serial == serial)
+        {
+            onNegotiationTimeout(port);
+        }
+    });
+
+    port.serial = serial;
+    {
+        // A device that was plugged in again starts a new clock
+        QMutexLocker locker(&m_roundTripMutex);
+        port.decoder = ProtocolV2::FrameDecoder();
+        port.roundTrip.reset();
+    }
+
+    // Start with the fastest rate the settings allow
+    qint32 maxBaudRate = port.maxBaudRate.load(std::memory_order_relaxed);
+    port.candidate = 0;
+    while ((port.candidate < BAUD_RATE_COUNT) && (BAUD_RATES[port.candidate] > maxBaudRate))
+    {
+        ++port.candidate;
+    }
+
+    if ((port.candidate < BAUD_RATE_COUNT) && (BAUD_RATES[port.candidate] > DEFAULT_BAUD_RATE))
+    {
+        port.negotiating = true;
+        requestBaudRate(port);
+    }
+    else
+    {
+        Q_EMIT linkConfigured(port.name, DEFAULT_BAUD_RATE);
+    }
+
+    return serial;
+}
+
+void SerialThread::requestBaudRate(Port &port)
+{
+    qDebug() << "Ask" << port.name << "for" << BAUD_RATES[port.candidate] << "baud";
+    char request[2] = {static_cast<char>(START_BIT | ID::LinkConfig), static_cast<char>(port.candidate)};
+    (void)port.serial->write(request, sizeof(request));
+    port.negotiationTimer->start();
+}
+
+void SerialThread::onReadyRead(Port &port)
+{
+    QByteArray data = port.serial->readAll();
+    if (port.negotiating)
+    {
+        onNegotiationResponse(port, data);
+        return;
+    }
+
+    // Besides the rate, v1 devices do not answer. v2 devices may answer
+    // every frame with its sequence number and their clock.
+    if (port.protocol.load(std::memory_order_relaxed) != PROTOCOL_V2)
+    {
+        return;
+    }
+
+    qint64 nowNs = AcquisitionThread::now();
+    QMutexLocker locker(&m_roundTripMutex);
+    port.decoder.feed(reinterpret_cast<const quint8*>(data.constData()), data.size(), [&port, nowNs](const ProtocolV2::FrameDecoder &frame)
+    {
+        for (qint32 i = 0; i < frame.channelCount(); ++i)
+        {
+            quint8 sequence = 0;
+            quint32 deviceTimeUs = 0;
+            if ((frame.channel(i).type == ID::LinkTiming) && ProtocolV2::decodeTiming(frame.channel(i), sequence, deviceTimeUs))
+            {
+                (void)port.roundTrip.responseReceived(sequence, deviceTimeUs, nowNs);
+            }
+        }
+    });
+}
+
+void SerialThread::onNegotiationResponse(Port &port, const QByteArray &data)
+{
+    port.response.append(data);
+    for (qint32 i = 0; (i + 1) < port.response.size(); ++i)
+    {
+        if ((static_cast<quint8>(port.response.at(i)) == (START_BIT | ID::LinkConfig))
+                && (port.response.at(i + 1) == static_cast<char>(port.candidate)))
+        {
+            qint32 baudRate = BAUD_RATES[port.candidate];
+            if (!port.serial->setBaudRate(baudRate))
+            {
+                baudRate = DEFAULT_BAUD_RATE;
+                Q_EMIT error("Can't set " + port.name + " to " + QString::number(BAUD_RATES[port.candidate]) + " baud");
+            }
+
+            finishNegotiation(port, baudRate);
+            return;
+        }
+    }
+}
+
+void SerialThread::onNegotiationTimeout(Port &port)
+{
+    if (!port.negotiating)
+    {
+        return;
+    }
+
+    ++port.candidate;
+    if ((port.candidate >= BAUD_RATE_COUNT) || (BAUD_RATES[port.candidate] <= DEFAULT_BAUD_RATE))
+    {
+        finishNegotiation(port, DEFAULT_BAUD_RATE);
+        return;
+    }
+
+    requestBaudRate(port);
+}
+
+void SerialThread::finishNegotiation(Port &port, qint32 baudRate)
+{
+    qDebug() << port.name << "runs at" << baudRate << "baud";
+    port.negotiating = false;
+    port.negotiationTimer->stop();
+    port.response = QByteArray();
+    Q_EMIT linkConfigured(port.name, baudRate);
+
+    // Send what waited for the negotiation
+    flush();
+}
+
+void SerialThread::reportLinks() const
+{
+    for (const RoundTripStatistics &statistics : roundTripStatistics())
+    {
+        if ((statistics.responses + statistics.unmatched) > 0)
+        {
+            qDebug().noquote() << statistics.port << statistics.summary();
+        }
+    }
+
+    for (const PortHealth &health : portHealth())
+    {
+        if (!health.connected || (health.reconnects > 0))
+        {
+            qDebug().noquote() << health.port << (health.connected ? "connected" : "disconnected") << "| reconnects:"
+                               << health.reconnects << "| downtime:" << (health.downtimeNs / 1000000) << "ms";
+        }
+    }
+}
+
+void SerialThread::portLost(Port &port)
+{
+    if (port.serial == nullptr)
+    {
+        return;
+    }
+
+    // Called from the port's own signals, so it may only go later
+    qDebug() << port.name << "is gone";
+    detachSerial(port)->deleteLater();
+
+    setConnected(port, false);
+    port.replay = port.written;
+    port.backoffMs = INITIAL_RECONNECT_MS;
+    port.retryAtNs = m_clock.nsecsElapsed() + (static_cast<qint64>(INITIAL_RECONNECT_MS) * 1000000);
+    scheduleReconnect();
+}
+
+void SerialThread::setConnected(Port &port, bool connected)
+{
+    qint64 nowNs = m_clock.nsecsElapsed();
+    qint64 downSinceNs = port.downSinceNs.load(std::memory_order_relaxed);
+    if (connected && (downSinceNs >= 0))
+    {
+        (void)port.downtimeNs.fetch_add(nowNs - downSinceNs, std::memory_order_relaxed);
+        (void)port.reconnects.fetch_add(1, std::memory_order_relaxed);
+        port.downSinceNs.store(-1, std::memory_order_relaxed);
+        qDebug() << port.name << "is back after" << ((nowNs - downSinceNs) / 1000000) << "ms";
+    }
+    else if (!connected && (downSinceNs < 0))
+    {
+        port.downSinceNs.store(nowNs, std::memory_order_relaxed);
+    }
+
+    port.connected.store(connected, std::memory_order_relaxed);
+}
+
+void SerialThread::scheduleReconnect()
+{
+    qint64 nextRetryNs = std::numeric_limits<qint64>::max();
+    for (const Port &port : m_ports)
+    {
+        if ((port.serial == nullptr) && (port.retryAtNs > 0)
+                && (port.state.load(std::memory_order_acquire) == ActivePort))
+        {
+            nextRetryNs = qMin(nextRetryNs, port.retryAtNs);
+        }
+    }
+
+    if ((m_reconnectTimer == nullptr) || (nextRetryNs == std::numeric_limits<qint64>::max()))
+    {
+        return;
+    }
+
+    qint32 delayMs = static_cast<qint32>(qMax<qint64>(0, nextRetryNs - m_clock.nsecsElapsed()) / 1000000) + 1;
+    if (!m_reconnectTimer->isActive() || (m_reconnectTimer->remainingTime() > delayMs))
+    {
+        m_reconnectTimer->start(delayMs);
+    }
+}
+
+void SerialThread::onPortAppeared(const QString &portName)
+{
+    Q_EMIT portAppeared(portName);
+
+    for (Port &port : m_ports)
+    {
+        if ((port.serial == nullptr) && (port.state.load(std::memory_order_acquire) == ActivePort)
+                && isSamePort(port.name, portName))
+        {
+            // Try again right away instead of waiting out the backoff
+            port.backoffMs = INITIAL_RECONNECT_MS;
+            port.retryAtNs = m_clock.nsecsElapsed() + (static_cast<qint64>(PLUG_SETTLE_MS) * 1000000);
+            scheduleReconnect();
+        }
+    }
+}
+
+void SerialThread::onPortDisappeared(const QString &portName)
+{
+    Q_EMIT portDisappeared(portName);
+
+    // Writes to a removed device do not always fail right away
+    for (Port &port : m_ports)
+    {
+        if ((port.serial != nullptr) && (port.state.load(std::memory_order_acquire) == ActivePort)
+                && isSamePort(port.name, portName))
+        {
+            portLost(port);
+        }
+    }
+}
+
+void SerialThread::closeSerial(Port &port)
+{
+    if (port.serial == nullptr)
+    {
+        return;
+    }
+
+    // Detached first: flush() below and the port's own signals, which may
+    // have called this, must not reach the port again
+    qDebug() << "Close" << port.name;
+    QSerialPort* serial = detachSerial(port);
+    (void)serial->flush();
+    serial->close();
+    serial->deleteLater();
+}
+
+QSerialPort* SerialThread::detachSerial(Port &port)
+{
+    // Signals that are already queued or come late must not reach the slot,
+    // it may be closed or hold the next serial port by then
+    QSerialPort* serial = port.serial;
+    port.serial = nullptr;
+    port.negotiating = false;
+    for (QTimer* timer : {port.negotiationTimer, port.intervalTimer})
+    {
+        if (timer != nullptr)
+        {
+            timer->stop();
+            (void)QObject::disconnect(timer, nullptr, nullptr, nullptr);
+        }
+    }
+    port.negotiationTimer = nullptr;
+    port.intervalTimer = nullptr;
+
+    (void)QObject::disconnect(serial, nullptr, nullptr, nullptr);
+    return serial;
+}
@@ -1,34 +1,258 @@
-#ifndef SERIALTHREAD_FF743A8002DA468BA6F0DE694971841D
-#define SERIALTHREAD_FF743A8002DA468BA6F0DE694971841D
-
-#include <QSerialPort>
-#include <QMutex>
-#include <QThread>
-#include <QWaitCondition>
-
-class SerialThread : public QThread
-{
-    Q_OBJECT
-public:
-    explicit SerialThread(QObject* parent = nullptr);
-    ~SerialThread() override;
-
-    void transaction(const QString &portName, const QByteArray &request);
-
-Q_SIGNALS:
-    void error(const QString &s);
-
-private:
-    void run() override;
-
-    QSerialPort m_serial;
-    QString m_portName;
-    QByteArray m_data;
-    QMutex m_mutex;
-    QWaitCondition m_cond;
-    qint32 m_waitTimeout = 100;
-    bool m_quit = false;
-    const bool READ_RESPONSE = false;
-};
-
-#endif // SERIALTHREAD_FF743A8002DA468BA6F0DE694971841D
+#ifndef SERIALTHREAD_FF743A8002DA468BA6F0DE694971841D
+#define SERIALTHREAD_FF743A8002DA468BA6F0DE694971841D
+
+#include <QSerialPort>
+#include <QAbstractEventDispatcher>
+#include <QElapsedTimer>
+#include <QList>
+#include <QTimer>
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+#include <atomic>
+#include "devicewatcher.h"
+#include "latestvaluemailbox.h"
+#include "protocolv2.h"
+#include "roundtriptracker.h"
+
+// One serial message, copied by value so queueing it never allocates
+struct SerialFrame
+{
+    static const qint32 MAX_SIZE = 8;
+
+    quint8 size = 0;
+    char data[MAX_SIZE];
+};
+
+// Messages of all ports since the serial thread was started
+struct SerialStatistics
+{
+    // Handed to a port, all messages of a port that are due are packed
+    // into one write
+    quint64 messages = 0;
+    quint64 writes = 0;
+    quint64 bytes = 0;
+    // Replaced by a newer message with the same id before being written,
+    // i.e. the ports could not keep up with the telemetry
+    quint64 replaced = 0;
+    // Not written because the write failed or the port was closed while
+    // its device was gone
+    quint64 dropped = 0;
+    qint64 elapsedNs = 0;
+
+    double coalescingRatio() const
+    {
+        return (writes > 0) ? (static_cast<double>(messages) / static_cast<double>(writes)) : 0.0;
+    }
+
+    double bytesPerSecond() const
+    {
+        return (elapsedNs > 0) ? (static_cast<double>(bytes) * 1e9 / static_cast<double>(elapsedNs)) : 0.0;
+    }
+};
+
+// Connection of one port since it was added
+struct PortHealth
+{
+    QString port;
+    bool connected = false;
+    // Times the device came back after it was lost or could not be opened
+    quint64 reconnects = 0;
+    // Time without the device, including the current outage
+    qint64 downtimeNs = 0;
+};
+
+// One thread for all serial ports. The ports are non-blocking and live in
+// the event loop of this thread, which waits for all of them at once, so
+// more devices do not mean more threads or context switches per message.
+// Every port has one lock-free mailbox per message id between the thread
+// sending the messages and this one, and a dirty bit per mailbox. A flush
+// writes the newest message of every dirty mailbox of a port at once; while
+// the port is still busy the messages wait in their mailboxes.
+// A device that is gone or cannot be opened is retried with a growing
+// backoff, or soon after the DeviceWatcher sees it again. Its messages wait
+// meanwhile, and the last message of every id is written again once it is
+// back, so a device that restarted gets the current state.
+class SerialThread : public QThread
+{
+    Q_OBJECT
+public:
+    static const qint32 MAX_PORTS = 16;
+    static const qint32 MAX_MESSAGE_IDS = 16;
+    // Every device starts at this rate, faster rates are negotiated
+    static const qint32 DEFAULT_BAUD_RATE = 9600;
+    // Legacy messages framed by their start bit, or one frame per flush
+    // with all messages as channels, see protocolv2.h. The rate request is
+    // always sent as a v1 message.
+    static const qint32 PROTOCOL_V1 = 1;
+    static const qint32 PROTOCOL_V2 = 2;
+
+    explicit SerialThread(QObject* parent = nullptr);
+    ~SerialThread() override;
+
+    // Returns the handle of the port, or -1 if all MAX_PORTS are in use.
+    // A handle stays bound to its port: once the port is closed, messages
+    // for the handle are dropped, also if the slot is reused meanwhile.
+    // The port is opened with the first message. Ports are added and closed
+    // by one thread, the messages may come from another one, but all
+    // transaction() calls of a port come from the same thread. Above
+    // DEFAULT_BAUD_RATE the device is
+    // asked for the fastest rate up to maxBaudRate it supports; devices
+    // that do not answer stay at DEFAULT_BAUD_RATE.
+    qint32 addPort(const QString &portName, qint32 maxBaudRate = DEFAULT_BAUD_RATE, qint32 protocol = PROTOCOL_V1);
+
+    // Messages with this id are written at most once per interval, the
+    // newest one waits in its mailbox until then. 0 writes every message.
+    void setMinimumInterval(qint32 port, qint32 id, qint64 intervalNs);
+
+    // Hands a message to the port without blocking or allocating. A message
+    // with the same id that was not written yet is replaced, only the latest
+    // value of a message counts. The id is in the low bits of the first byte.
+    bool transaction(qint32 port, const SerialFrame &frame);
+
+    // For threads other than the one calling transaction(), e.g. the UI.
+    // The message is queued to the serial thread, which allocates, and
+    // replaces the pending message with the same id. A message handed to
+    // transaction() afterwards replaces this one.
+    bool post(qint32 port, const SerialFrame &frame);
+
+    // Closes the port after its last messages, the handle becomes invalid
+    void closePort(qint32 port);
+
+    SerialStatistics statistics() const;
+
+    // Round trips of the active v2 ports whose devices answer frames
+    QList<RoundTripStatistics> roundTripStatistics() const;
+
+    // Reconnects and downtime of the active ports
+    QList<PortHealth> portHealth() const;
+
+    // Baud rates a device can be asked for, fastest first
+    static QList<qint32> supportedBaudRates();
+
+Q_SIGNALS:
+    void error(const QString &s);
+    // The port is open and runs at this rate
+    void linkConfigured(const QString &portName, qint32 baudRate);
+    // A serial port of the system was plugged in or removed, not only the
+    // ones in use
+    void portAppeared(const QString &portName);
+    void portDisappeared(const QString &portName);
+
+private:
+    enum PortState
+    {
+        FreePort,
+        ActivePort,
+        ClosingPort
+    };
+
+    // A handle is the slot of the port plus the generation of the slot,
+    // which addPort() counts up whenever it reuses the slot
+    static const qint32 PORT_SLOT_BITS = 4;
+    static const qint32 PORT_SLOT_MASK = (1 << PORT_SLOT_BITS) - 1;
+    static const quint32 MAX_GENERATION = 0x7FFFFFFF >> PORT_SLOT_BITS;
+    static_assert(MAX_PORTS <= (1 << PORT_SLOT_BITS), "Port slots do not fit into a handle");
+
+    // A message and the generation of the handle it was sent to
+    struct PortMessage
+    {
+        quint32 generation = 0;
+        SerialFrame frame;
+    };
+
+    struct Port
+    {
+        std::atomic<qint32> state {FreePort};
+        // Written by addPort() before the port becomes active
+        QString name;
+        std::atomic<quint32> generation {0};
+        LatestValueMailbox<PortMessage> mailboxes[MAX_MESSAGE_IDS];
+        // Bit n is set when mailbox n got a message
+        std::atomic<quint32> dirty {0};
+        std::atomic<qint32> maxBaudRate {DEFAULT_BAUD_RATE};
+        std::atomic<qint32> protocol {PROTOCOL_V1};
+        std::atomic<qint64> minIntervalNs[MAX_MESSAGE_IDS];
+        std::atomic<bool> connected {false};
+        std::atomic<quint64> reconnects {0};
+        std::atomic<qint64> downtimeNs {0};
+        // Since when the device is gone, -1 while it is there
+        std::atomic<qint64> downSinceNs {-1};
+
+        // Only used by the serial thread
+        QSerialPort* serial = nullptr;
+        qint64 lastWriteNs[MAX_MESSAGE_IDS];
+        // Of the next v2 frame
+        quint8 sequence = 0;
+        // Last message written per id, and the ids to write again because
+        // the device was gone
+        SerialFrame lastFrames[MAX_MESSAGE_IDS];
+        quint32 written = 0;
+        quint32 replay = 0;
+        // Reconnect backoff, 0 until an open failed
+        qint32 backoffMs = 0;
+        qint64 retryAtNs = 0;
+        // Messages wait while a rate is negotiated
+        bool negotiating = false;
+        qint32 candidate = 0;
+        QByteArray response;
+        QTimer* negotiationTimer = nullptr;
+        // Wakes the port when a postponed message is due
+        QTimer* intervalTimer = nullptr;
+        // Answers of v2 devices, the tracker is shared with
+        // roundTripStatistics() under m_roundTripMutex
+        ProtocolV2::FrameDecoder decoder;
+        RoundTripTracker roundTrip;
+    };
+
+    void run() override;
+    void wake();
+
+    static qint32 makeHandle(qint32 slot, quint32 generation);
+    static quint32 handleGeneration(qint32 handle);
+    // The port of the handle, or nullptr if the handle is invalid or its
+    // port was closed and the slot reused
+    Port* portForHandle(qint32 handle);
+
+    // Called in the serial thread only
+    void flush();
+    QSerialPort* openPort(Port &port);
+    void closeSerial(Port &port);
+    QSerialPort* detachSerial(Port &port);
+    void requestBaudRate(Port &port);
+    void onReadyRead(Port &port);
+    void onNegotiationResponse(Port &port, const QByteArray &data);
+    void onNegotiationTimeout(Port &port);
+    void finishNegotiation(Port &port, qint32 baudRate);
+    void reportLinks() const;
+    void portLost(Port &port);
+    void setConnected(Port &port, bool connected);
+    void scheduleReconnect();
+    void onPortAppeared(const QString &portName);
+    void onPortDisappeared(const QString &portName);
+
+    QMutex m_mutex;
+    QWaitCondition m_started;
+    // Lives in the serial thread. Woken up by wake(), the event loop
+    // flushes before it waits again.
+    QObject* m_context = nullptr;
+    QAbstractEventDispatcher* m_dispatcher = nullptr;
+    std::atomic<bool> m_flushQueued {false};
+    // Only used by the serial thread
+    bool m_flushing = false;
+    // Lives in the serial thread, retries the ports whose devices are gone
+    QTimer* m_reconnectTimer = nullptr;
+    DeviceWatcher m_deviceWatcher;
+
+    Port m_ports[MAX_PORTS];
+    mutable QMutex m_roundTripMutex;
+
+    // Written by the serial thread
+    QElapsedTimer m_clock;
+    std::atomic<quint64> m_messages {0};
+    std::atomic<quint64> m_writes {0};
+    std::atomic<quint64> m_bytes {0};
+    std::atomic<quint64> m_dropped {0};
+};
+
+#endif // SERIALTHREAD_FF743A8002DA468BA6F0DE694971841D
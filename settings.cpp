@@ -1,336 +1,772 @@
-#include "settings.h"
-#include <QDir>
-#include <QDebug>
-
-
-static const QString WHEEL_SLIP_ENABLED = "WheelSlipEnabled";
-static const QString LED_FLAG_ENABLED = "LEDFlagEnabled";
-static const QString WIND_FAN_ENABLED = "WindFanEnabled";
-static const QString WHEEL_SLIP_PORT = "WheelSlipPort";
-static const QString WIND_FAN_PORT = "WindFanPort";
-static const QString LED_FLAG_PORT = "LEDFlagPort";
-static const QString UPS = "UPS";
-static const QString MINIMIZE_WITH_X = "MinimizeWithX";
-
-static const QString BRAKE_INDEX = "BrakeIndex";
-static const qint32 BRAKE_INDEX_MIN = 0;
-static const qint32 BRAKE_INDEX_MAX = 25;
-static const QString GAS_INDEX = "GasIndex";
-static const qint32 GAS_INDEX_MIN = 0;
-static const qint32 GAS_INDEX_MAX = 25;
-static const QString BUMPING_INDEX = "BumpingIndex";
-static const qint32 BUMPING_INDEX_MIN = 0;
-static const qint32 BUMPING_INDEX_MAX = 10;
-static const QString WIND_FAN_INDEX = "WindFanIndex";
-static const qint32 WIND_FAN_INDEX_MIN = 0;
-static const qint32 WIND_FAN_INDEX_MAX = 10;
-
-
-Settings::Settings(QObject *parent)
-    : QObject(parent)
-    , m_wheelSlipEnabled(false)
-    , m_ledFlagEnabled(false)
-    , m_windFanEnabled(false)
-    , m_ups(10)
-    , m_minimizeWithX(false)
-    , m_brakeIndex(0)
-    , m_gasIndex(0)
-    , m_bumpingIndex(0)
-{
-    loadSettings();
-}
-
-void Settings::setWindFanPortActive(bool windFanPortActive)
-{
-    m_windFanPortActive = windFanPortActive;
-}
-
-void Settings::setLedFlagPortActive(bool ledFlagPortActive)
-{
-    m_ledFlagPortActive = ledFlagPortActive;
-}
-
-void Settings::setWheelSlipPortActive(bool wheelSlipPortActive)
-{
-    m_wheelSlipPortActive = wheelSlipPortActive;
-}
-
-bool Settings::isWheelSlipPortActive() const
-{
-    return m_wheelSlipPortActive;
-}
-
-bool Settings::isLedFlagPortActive() const
-{
-    return m_ledFlagPortActive;
-}
-
-bool Settings::isWindFanPortActive() const
-{
-    return m_windFanPortActive;
-}
-
-Settings* Settings::getInstance()
-{
-    static Settings* settings;
-    if (settings == nullptr)
-    {
-        settings = new Settings();
-    }
-
-    return settings;
-}
-
-Settings::~Settings()
-{
-
-}
-
-void Settings::loadSettings()
-{
-    QSettings settings;
-
-    m_wheelSlipEnabled = settings.value(WHEEL_SLIP_ENABLED, false).toBool();
-    m_ledFlagEnabled = settings.value(LED_FLAG_ENABLED, false).toBool();
-    m_windFanEnabled = settings.value(WIND_FAN_ENABLED, false).toBool();
-
-    QString wheelSlipPort = settings.value(WHEEL_SLIP_PORT, QString()).toString();
-    if (!wheelSlipPort.isEmpty())
-    {
-        m_wheelSlipPort = wheelSlipPort;
-    }
-
-    QString ledFlagPort = settings.value(LED_FLAG_PORT, QString()).toString();
-    if (!ledFlagPort.isEmpty())
-    {
-        m_ledFlagPort = ledFlagPort;
-    }
-
-    QString windFanPort = settings.value(WIND_FAN_PORT, QString()).toString();
-    if (!windFanPort.isEmpty())
-    {
-        m_windFanPort = windFanPort;
-    }
-
-    qint32 ups = settings.value(UPS, 10).toInt();
-    if (ups > 0)
-    {
-        m_ups = ups;
-    }
-
-    m_minimizeWithX = settings.value(MINIMIZE_WITH_X, false).toBool();
-
-    qint32 brakeIndex = settings.value(BRAKE_INDEX, 2).toInt();
-    if ((brakeIndex >= BRAKE_INDEX_MIN) && (brakeIndex <= BRAKE_INDEX_MAX))
-    {
-        m_brakeIndex = brakeIndex;
-    }
-
-    qint32 gasIndex = settings.value(GAS_INDEX, 8).toInt();
-    if ((gasIndex >= GAS_INDEX_MIN) && (gasIndex <= GAS_INDEX_MAX))
-    {
-        m_gasIndex = gasIndex;
-    }
-
-    qint32 bumpingIndex = settings.value(BUMPING_INDEX, 3).toInt();
-    if ((bumpingIndex >= BUMPING_INDEX_MIN) && (bumpingIndex <= BUMPING_INDEX_MAX))
-    {
-        m_bumpingIndex = bumpingIndex;
-    }
-
-    qint32 windFanIndex = settings.value(WIND_FAN_INDEX, 5).toInt();
-    if ((windFanIndex >= WIND_FAN_INDEX_MIN) && (windFanIndex <= WIND_FAN_INDEX_MAX))
-    {
-        m_windFanIndex = windFanIndex;
-    }
-}
-
-bool Settings::getWheelSlipEnabled() const
-{
-    return m_wheelSlipEnabled;
-}
-
-void Settings::setWheelSlipEnabled(bool wheelSlipEnabled)
-{
-    if (m_wheelSlipEnabled != wheelSlipEnabled)
-    {
-        qDebug() << "Settings::setWheelSlipEnabled(" << wheelSlipEnabled << ")";
-        m_wheelSlipEnabled = wheelSlipEnabled;
-        QSettings().setValue(WHEEL_SLIP_ENABLED, m_wheelSlipEnabled);
-        Q_EMIT wheelSlipEnabledChanged();
-    }
-}
-
-bool Settings::getLedFlagEnabled() const
-{
-    return m_ledFlagEnabled;
-}
-
-void Settings::setLedFlagEnabled(bool ledFlagEnabled)
-{
-    if (m_ledFlagEnabled != ledFlagEnabled)
-    {
-        qDebug() << "Settings::setLedFlagEnabled(" << ledFlagEnabled << ")";
-        m_ledFlagEnabled = ledFlagEnabled;
-        QSettings().setValue(LED_FLAG_ENABLED, m_ledFlagEnabled);
-        Q_EMIT ledFlagEnabledChanged();
-    }
-}
-
-bool Settings::getWindFanEnabled() const
-{
-    return m_windFanEnabled;
-}
-
-void Settings::setWindFanEnabled(bool windFanEnabled)
-{
-    if (m_windFanEnabled != windFanEnabled)
-    {
-        qDebug() << "Settings::setWindFanEnabled(" << windFanEnabled << ")";
-        m_windFanEnabled = windFanEnabled;
-        QSettings().setValue(WIND_FAN_ENABLED, m_windFanEnabled);
-        Q_EMIT windFanEnabledChanged();
-    }
-}
-
-QString Settings::getWheelSlipPort() const
-{
-    return m_wheelSlipPort;
-}
-
-void Settings::setWheelSlipPort(const QString &port)
-{
-    if (m_wheelSlipPort != port)
-    {
-        qDebug() << "Settings::setPort(" << port << ")";
-        m_wheelSlipPort = port;
-        QSettings().setValue(WHEEL_SLIP_PORT, m_wheelSlipPort);
-        Q_EMIT wheelSlipPortChanged();
-    }
-
-    m_wheelSlipPortActive = true;
-}
-
-QString Settings::getLedFlagPort() const
-{
-    return m_ledFlagPort;
-}
-
-void Settings::setLedFlagPort(const QString &ledFlagPort)
-{
-    if (m_ledFlagPort != ledFlagPort)
-    {
-        qDebug() << "Settings::setPort(" << ledFlagPort << ")";
-        m_ledFlagPort = ledFlagPort;
-        QSettings().setValue(LED_FLAG_PORT, m_ledFlagPort);
-        Q_EMIT ledFlagPortChanged();
-    }
-
-    m_ledFlagPortActive = true;
-}
-
-QString Settings::getWindFanPort() const
-{
-    return m_windFanPort;
-}
-
-void Settings::setWindFanPort(const QString &windFanPort)
-{
-    if (m_windFanPort != windFanPort)
-    {
-        qDebug() << "Settings::setPort(" << windFanPort << ")";
-        m_windFanPort = windFanPort;
-        QSettings().setValue(WIND_FAN_PORT, m_windFanPort);
-        Q_EMIT windFanPortChanged();
-    }
-
-    m_windFanPortActive = true;
-}
-
-qint32 Settings::getUps() const
-{
-    return m_ups;
-}
-
-void Settings::setUps(const qint32 &ups)
-{
-    if (m_ups != ups)
-    {
-        m_ups = ups;
-        QSettings().setValue(UPS, m_ups);
-    }
-}
-
-bool Settings::getMinimizeWithX() const
-{
-    return m_minimizeWithX;
-}
-
-void Settings::setMinimizeWithX(bool minimizeWithX)
-{
-    if (m_minimizeWithX != minimizeWithX)
-    {
-        m_minimizeWithX = minimizeWithX;
-        QSettings().setValue(MINIMIZE_WITH_X, m_minimizeWithX);
-    }
-}
-
-qint32 Settings::getBrakeIndex() const
-{
-    return m_brakeIndex;
-}
-
-void Settings::setBrakeIndex(const qint32 &brakeIndex)
-{
-    if (m_brakeIndex != brakeIndex)
-    {
-        m_brakeIndex = brakeIndex;
-        QSettings().setValue(BRAKE_INDEX, m_brakeIndex);
-        Q_EMIT brakeIndexChanged();
-    }
-}
-
-qint32 Settings::getGasIndex() const
-{
-    return m_gasIndex;
-}
-
-void Settings::setGasIndex(const qint32 &gasIndex)
-{
-    if (m_gasIndex != gasIndex)
-    {
-        m_gasIndex = gasIndex;
-        QSettings().setValue(GAS_INDEX, m_gasIndex);
-        Q_EMIT gasIndexChanged();
-    }
-}
-
-qint32 Settings::getBumpingIndex() const
-{
-    return m_bumpingIndex;
-}
-
-void Settings::setBumpingIndex(const qint32 &bumpingIndex)
-{
-    if (m_bumpingIndex != bumpingIndex)
-    {
-        m_bumpingIndex = bumpingIndex;
-        QSettings().setValue(BUMPING_INDEX, m_bumpingIndex);
-        Q_EMIT bumpingIndexChanged();
-    }
-}
-
-qint32 Settings::getWindFanIndex() const
-{
-    return m_windFanIndex;
-}
-
-void Settings::setWindFanIndex(const qint32 &windFanIndex)
-{
-    if (m_windFanIndex != windFanIndex)
-    {
-        m_windFanIndex = windFanIndex;
-        QSettings().setValue(WIND_FAN_INDEX, m_windFanIndex);
-        Q_EMIT windFanIndexChanged();
-    }
-}
+#include "settings.h"
+#include <QDir>
+#include <QDebug>
+#include "globals.h"
+
+
+static const QString WHEEL_SLIP_ENABLED = "WheelSlipEnabled";
+static const QString LED_FLAG_ENABLED = "LEDFlagEnabled";
+static const QString WIND_FAN_ENABLED = "WindFanEnabled";
+static const QString WHEEL_SLIP_PORT = "WheelSlipPort";
+static const QString WIND_FAN_PORT = "WindFanPort";
+static const QString LED_FLAG_PORT = "LEDFlagPort";
+static const QString UPS = "UPS";
+static const QString MINIMIZE_WITH_X = "MinimizeWithX";
+
+static const QString BRAKE_INDEX = "BrakeIndex";
+static const qint32 BRAKE_INDEX_MIN = 0;
+static const qint32 BRAKE_INDEX_MAX = 25;
+static const QString GAS_INDEX = "GasIndex";
+static const qint32 GAS_INDEX_MIN = 0;
+static const qint32 GAS_INDEX_MAX = 25;
+static const QString BUMPING_INDEX = "BumpingIndex";
+static const qint32 BUMPING_INDEX_MIN = 0;
+static const qint32 BUMPING_INDEX_MAX = 10;
+static const QString WIND_FAN_INDEX = "WindFanIndex";
+static const qint32 WIND_FAN_INDEX_MIN = 0;
+static const qint32 WIND_FAN_INDEX_MAX = 10;
+static const QString ACQUISITION_CPU = "AcquisitionCpu";
+static const QString REALTIME_PRIORITY = "RealtimePriority";
+static const QString PACKET_DRIVEN_ACQUISITION = "PacketDrivenAcquisition";
+static const QString RECORDING_DIRECTORY = "RecordingDirectory";
+static const QString COMPRESS_RECORDINGS = "CompressRecordings";
+static const QString GAS_FILTER = "GasFilter";
+static const QString BRAKE_FILTER = "BrakeFilter";
+static const QString WIND_FAN_FILTER = "WindFanFilter";
+static const QString PER_WHEEL_SLIP = "PerWheelSlip";
+static const QString WHEEL_FILTER = "WheelFilter";
+static const QString ABS_FREQUENCY = "AbsFrequency";
+static const QString ABS_INTENSITY = "AbsIntensity";
+static const QString TC_FREQUENCY = "TcFrequency";
+static const QString TC_INTENSITY = "TcIntensity";
+static const qint32 PULSE_FREQUENCY_MIN = 1;
+static const qint32 PULSE_FREQUENCY_MAX = 50;
+static const qint32 PULSE_INTENSITY_MIN = 0;
+static const qint32 PULSE_INTENSITY_MAX = 127;
+static const QString ROAD_TEXTURE_INTENSITY = "RoadTextureIntensity";
+static const QString ROAD_TEXTURE_MIN_FREQUENCY = "RoadTextureMinFrequency";
+static const QString ROAD_TEXTURE_MAX_FREQUENCY = "RoadTextureMaxFrequency";
+static const qint32 ROAD_TEXTURE_FREQUENCY_MIN = 1;
+static const qint32 ROAD_TEXTURE_FREQUENCY_MAX = 160;
+static const QString SLIP_CALIBRATION = "SlipCalibration";
+static const QString SLIP_CALIBRATION_DATA = "SlipCalibrationData/";
+static const QString PREDICTION_LEAD = "PredictionLead";
+static const qint32 PREDICTION_LEAD_MIN = 0;
+static const qint32 PREDICTION_LEAD_MAX = 100;
+static const QString MAX_BAUD_RATE = "MaxBaudRate/";
+static const qint32 DEFAULT_BAUD_RATE = 9600;
+static const QString PROTOCOL = "Protocol/";
+
+
+Settings::Settings(QObject *parent)
+    : QObject(parent)
+    , m_wheelSlipEnabled(false)
+    , m_ledFlagEnabled(false)
+    , m_windFanEnabled(false)
+    , m_ups(10)
+    , m_minimizeWithX(false)
+    , m_brakeIndex(0)
+    , m_gasIndex(0)
+    , m_bumpingIndex(0)
+    , m_acquisitionCpu(-1)
+    , m_realtimePriority(false)
+    , m_packetDrivenAcquisition(false)
+    , m_compressRecordings(true)
+    , m_perWheelSlip(false)
+    , m_absFrequency(12)
+    , m_absIntensity(0)
+    , m_tcFrequency(8)
+    , m_tcIntensity(0)
+    , m_roadTextureIntensity(0)
+    , m_roadTextureMinFrequency(20)
+    , m_roadTextureMaxFrequency(80)
+    , m_slipCalibration(false)
+    , m_predictionLead(0)
+{
+    loadSettings();
+}
+
+void Settings::setWindFanPortActive(bool windFanPortActive)
+{
+    if (m_windFanPortActive != windFanPortActive)
+    {
+        m_windFanPortActive = windFanPortActive;
+        Q_EMIT windFanPortChanged();
+    }
+}
+
+void Settings::setLedFlagPortActive(bool ledFlagPortActive)
+{
+    if (m_ledFlagPortActive != ledFlagPortActive)
+    {
+        m_ledFlagPortActive = ledFlagPortActive;
+        Q_EMIT ledFlagPortChanged();
+    }
+}
+
+void Settings::setWheelSlipPortActive(bool wheelSlipPortActive)
+{
+    if (m_wheelSlipPortActive != wheelSlipPortActive)
+    {
+        m_wheelSlipPortActive = wheelSlipPortActive;
+        Q_EMIT wheelSlipPortChanged();
+    }
+}
+
+bool Settings::isWheelSlipPortActive() const
+{
+    return m_wheelSlipPortActive;
+}
+
+bool Settings::isLedFlagPortActive() const
+{
+    return m_ledFlagPortActive;
+}
+
+bool Settings::isWindFanPortActive() const
+{
+    return m_windFanPortActive;
+}
+
+Settings* Settings::getInstance()
+{
+    static Settings* settings;
+    if (settings == nullptr)
+    {
+        settings = new Settings();
+    }
+
+    return settings;
+}
+
+Settings::~Settings()
+{
+
+}
+
+void Settings::loadSettings()
+{
+    QSettings settings;
+
+    m_wheelSlipEnabled = settings.value(WHEEL_SLIP_ENABLED, false).toBool();
+    m_ledFlagEnabled = settings.value(LED_FLAG_ENABLED, false).toBool();
+    m_windFanEnabled = settings.value(WIND_FAN_ENABLED, false).toBool();
+
+    QString wheelSlipPort = settings.value(WHEEL_SLIP_PORT, QString()).toString();
+    if (!wheelSlipPort.isEmpty())
+    {
+        m_wheelSlipPort = wheelSlipPort;
+    }
+
+    QString ledFlagPort = settings.value(LED_FLAG_PORT, QString()).toString();
+    if (!ledFlagPort.isEmpty())
+    {
+        m_ledFlagPort = ledFlagPort;
+    }
+
+    QString windFanPort = settings.value(WIND_FAN_PORT, QString()).toString();
+    if (!windFanPort.isEmpty())
+    {
+        m_windFanPort = windFanPort;
+    }
+
+    qint32 ups = settings.value(UPS, 10).toInt();
+    if ((ups > 0) && (ups <= MAX_UPS))
+    {
+        m_ups = ups;
+    }
+
+    m_minimizeWithX = settings.value(MINIMIZE_WITH_X, false).toBool();
+
+    qint32 brakeIndex = settings.value(BRAKE_INDEX, 2).toInt();
+    if ((brakeIndex >= BRAKE_INDEX_MIN) && (brakeIndex <= BRAKE_INDEX_MAX))
+    {
+        m_brakeIndex = brakeIndex;
+    }
+
+    qint32 gasIndex = settings.value(GAS_INDEX, 8).toInt();
+    if ((gasIndex >= GAS_INDEX_MIN) && (gasIndex <= GAS_INDEX_MAX))
+    {
+        m_gasIndex = gasIndex;
+    }
+
+    qint32 bumpingIndex = settings.value(BUMPING_INDEX, 3).toInt();
+    if ((bumpingIndex >= BUMPING_INDEX_MIN) && (bumpingIndex <= BUMPING_INDEX_MAX))
+    {
+        m_bumpingIndex = bumpingIndex;
+    }
+
+    qint32 windFanIndex = settings.value(WIND_FAN_INDEX, 5).toInt();
+    if ((windFanIndex >= WIND_FAN_INDEX_MIN) && (windFanIndex <= WIND_FAN_INDEX_MAX))
+    {
+        m_windFanIndex = windFanIndex;
+    }
+
+    m_acquisitionCpu = settings.value(ACQUISITION_CPU, -1).toInt();
+    m_realtimePriority = settings.value(REALTIME_PRIORITY, false).toBool();
+    m_packetDrivenAcquisition = settings.value(PACKET_DRIVEN_ACQUISITION, false).toBool();
+
+    // Sessions are only recorded if a directory is set
+    m_recordingDirectory = settings.value(RECORDING_DIRECTORY, QString()).toString();
+    m_compressRecordings = settings.value(COMPRESS_RECORDINGS, true).toBool();
+
+    // Filter chains of the effect outputs, see FilterChain. Empty passes
+    // the values through unchanged, as before there were filters.
+    m_gasFilter = settings.value(GAS_FILTER, QString()).toString();
+    m_brakeFilter = settings.value(BRAKE_FILTER, QString()).toString();
+    m_windFanFilter = settings.value(WIND_FAN_FILTER, QString()).toString();
+
+    // One shaker per corner instead of one per pedal
+    m_perWheelSlip = settings.value(PER_WHEEL_SLIP, false).toBool();
+    m_wheelFilter = settings.value(WHEEL_FILTER, QString()).toString();
+
+    // ABS and traction control pulses, off while the intensity is 0
+    qint32 absFrequency = settings.value(ABS_FREQUENCY, 12).toInt();
+    if ((absFrequency >= PULSE_FREQUENCY_MIN) && (absFrequency <= PULSE_FREQUENCY_MAX))
+    {
+        m_absFrequency = absFrequency;
+    }
+
+    qint32 absIntensity = settings.value(ABS_INTENSITY, 0).toInt();
+    if ((absIntensity >= PULSE_INTENSITY_MIN) && (absIntensity <= PULSE_INTENSITY_MAX))
+    {
+        m_absIntensity = absIntensity;
+    }
+
+    qint32 tcFrequency = settings.value(TC_FREQUENCY, 8).toInt();
+    if ((tcFrequency >= PULSE_FREQUENCY_MIN) && (tcFrequency <= PULSE_FREQUENCY_MAX))
+    {
+        m_tcFrequency = tcFrequency;
+    }
+
+    qint32 tcIntensity = settings.value(TC_INTENSITY, 0).toInt();
+    if ((tcIntensity >= PULSE_INTENSITY_MIN) && (tcIntensity <= PULSE_INTENSITY_MAX))
+    {
+        m_tcIntensity = tcIntensity;
+    }
+
+    // Road texture from the suspension travel, off while the intensity is 0
+    qint32 roadTextureIntensity = settings.value(ROAD_TEXTURE_INTENSITY, 0).toInt();
+    if ((roadTextureIntensity >= PULSE_INTENSITY_MIN) && (roadTextureIntensity <= PULSE_INTENSITY_MAX))
+    {
+        m_roadTextureIntensity = roadTextureIntensity;
+    }
+
+    qint32 roadTextureMinFrequency = settings.value(ROAD_TEXTURE_MIN_FREQUENCY, 20).toInt();
+    qint32 roadTextureMaxFrequency = settings.value(ROAD_TEXTURE_MAX_FREQUENCY, 80).toInt();
+    if ((roadTextureMinFrequency >= ROAD_TEXTURE_FREQUENCY_MIN)
+            && (roadTextureMaxFrequency <= ROAD_TEXTURE_FREQUENCY_MAX)
+            && (roadTextureMinFrequency <= roadTextureMaxFrequency))
+    {
+        m_roadTextureMinFrequency = roadTextureMinFrequency;
+        m_roadTextureMaxFrequency = roadTextureMaxFrequency;
+    }
+
+    // Scale the slip to the range learnt for each car
+    m_slipCalibration = settings.value(SLIP_CALIBRATION, false).toBool();
+
+    // Milliseconds the outputs are predicted ahead, 0 is off
+    qint32 predictionLead = settings.value(PREDICTION_LEAD, 0).toInt();
+    if ((predictionLead >= PREDICTION_LEAD_MIN) && (predictionLead <= PREDICTION_LEAD_MAX))
+    {
+        m_predictionLead = predictionLead;
+    }
+}
+
+bool Settings::getWheelSlipEnabled() const
+{
+    return m_wheelSlipEnabled;
+}
+
+void Settings::setWheelSlipEnabled(bool wheelSlipEnabled)
+{
+    if (m_wheelSlipEnabled != wheelSlipEnabled)
+    {
+        qDebug() << "Settings::setWheelSlipEnabled(" << wheelSlipEnabled << ")";
+        m_wheelSlipEnabled = wheelSlipEnabled;
+        QSettings().setValue(WHEEL_SLIP_ENABLED, m_wheelSlipEnabled);
+        Q_EMIT wheelSlipEnabledChanged();
+    }
+}
+
+bool Settings::getLedFlagEnabled() const
+{
+    return m_ledFlagEnabled;
+}
+
+void Settings::setLedFlagEnabled(bool ledFlagEnabled)
+{
+    if (m_ledFlagEnabled != ledFlagEnabled)
+    {
+        qDebug() << "Settings::setLedFlagEnabled(" << ledFlagEnabled << ")";
+        m_ledFlagEnabled = ledFlagEnabled;
+        QSettings().setValue(LED_FLAG_ENABLED, m_ledFlagEnabled);
+        Q_EMIT ledFlagEnabledChanged();
+    }
+}
+
+bool Settings::getWindFanEnabled() const
+{
+    return m_windFanEnabled;
+}
+
+void Settings::setWindFanEnabled(bool windFanEnabled)
+{
+    if (m_windFanEnabled != windFanEnabled)
+    {
+        qDebug() << "Settings::setWindFanEnabled(" << windFanEnabled << ")";
+        m_windFanEnabled = windFanEnabled;
+        QSettings().setValue(WIND_FAN_ENABLED, m_windFanEnabled);
+        Q_EMIT windFanEnabledChanged();
+    }
+}
+
+QString Settings::getWheelSlipPort() const
+{
+    return m_wheelSlipPort;
+}
+
+void Settings::setWheelSlipPort(const QString &port)
+{
+    if (m_wheelSlipPort != port)
+    {
+        qDebug() << "Settings::setPort(" << port << ")";
+        m_wheelSlipPort = port;
+        m_wheelSlipPortActive = true;
+        QSettings().setValue(WHEEL_SLIP_PORT, m_wheelSlipPort);
+        Q_EMIT wheelSlipPortChanged();
+    }
+
+    setWheelSlipPortActive(true);
+}
+
+QString Settings::getLedFlagPort() const
+{
+    return m_ledFlagPort;
+}
+
+void Settings::setLedFlagPort(const QString &ledFlagPort)
+{
+    if (m_ledFlagPort != ledFlagPort)
+    {
+        qDebug() << "Settings::setPort(" << ledFlagPort << ")";
+        m_ledFlagPort = ledFlagPort;
+        m_ledFlagPortActive = true;
+        QSettings().setValue(LED_FLAG_PORT, m_ledFlagPort);
+        Q_EMIT ledFlagPortChanged();
+    }
+
+    setLedFlagPortActive(true);
+}
+
+QString Settings::getWindFanPort() const
+{
+    return m_windFanPort;
+}
+
+void Settings::setWindFanPort(const QString &windFanPort)
+{
+    if (m_windFanPort != windFanPort)
+    {
+        qDebug() << "Settings::setPort(" << windFanPort << ")";
+        m_windFanPort = windFanPort;
+        m_windFanPortActive = true;
+        QSettings().setValue(WIND_FAN_PORT, m_windFanPort);
+        Q_EMIT windFanPortChanged();
+    }
+
+    setWindFanPortActive(true);
+}
+
+qint32 Settings::getUps() const
+{
+    return m_ups;
+}
+
+void Settings::setUps(const qint32 &ups)
+{
+    if (m_ups != ups)
+    {
+        m_ups = ups;
+        QSettings().setValue(UPS, m_ups);
+    }
+}
+
+bool Settings::getMinimizeWithX() const
+{
+    return m_minimizeWithX;
+}
+
+void Settings::setMinimizeWithX(bool minimizeWithX)
+{
+    if (m_minimizeWithX != minimizeWithX)
+    {
+        m_minimizeWithX = minimizeWithX;
+        QSettings().setValue(MINIMIZE_WITH_X, m_minimizeWithX);
+    }
+}
+
+qint32 Settings::getBrakeIndex() const
+{
+    return m_brakeIndex;
+}
+
+void Settings::setBrakeIndex(const qint32 &brakeIndex)
+{
+    if (m_brakeIndex != brakeIndex)
+    {
+        m_brakeIndex = brakeIndex;
+        QSettings().setValue(BRAKE_INDEX, m_brakeIndex);
+        Q_EMIT brakeIndexChanged();
+    }
+}
+
+qint32 Settings::getGasIndex() const
+{
+    return m_gasIndex;
+}
+
+void Settings::setGasIndex(const qint32 &gasIndex)
+{
+    if (m_gasIndex != gasIndex)
+    {
+        m_gasIndex = gasIndex;
+        QSettings().setValue(GAS_INDEX, m_gasIndex);
+        Q_EMIT gasIndexChanged();
+    }
+}
+
+qint32 Settings::getBumpingIndex() const
+{
+    return m_bumpingIndex;
+}
+
+void Settings::setBumpingIndex(const qint32 &bumpingIndex)
+{
+    if (m_bumpingIndex != bumpingIndex)
+    {
+        m_bumpingIndex = bumpingIndex;
+        QSettings().setValue(BUMPING_INDEX, m_bumpingIndex);
+        Q_EMIT bumpingIndexChanged();
+    }
+}
+
+qint32 Settings::getWindFanIndex() const
+{
+    return m_windFanIndex;
+}
+
+void Settings::setWindFanIndex(const qint32 &windFanIndex)
+{
+    if (m_windFanIndex != windFanIndex)
+    {
+        m_windFanIndex = windFanIndex;
+        QSettings().setValue(WIND_FAN_INDEX, m_windFanIndex);
+        Q_EMIT windFanIndexChanged();
+    }
+}
+
+qint32 Settings::getAcquisitionCpu() const
+{
+    return m_acquisitionCpu;
+}
+
+void Settings::setAcquisitionCpu(const qint32 &acquisitionCpu)
+{
+    if (m_acquisitionCpu != acquisitionCpu)
+    {
+        m_acquisitionCpu = acquisitionCpu;
+        QSettings().setValue(ACQUISITION_CPU, m_acquisitionCpu);
+    }
+}
+
+bool Settings::getRealtimePriority() const
+{
+    return m_realtimePriority;
+}
+
+void Settings::setRealtimePriority(bool realtimePriority)
+{
+    if (m_realtimePriority != realtimePriority)
+    {
+        m_realtimePriority = realtimePriority;
+        QSettings().setValue(REALTIME_PRIORITY, m_realtimePriority);
+    }
+}
+
+bool Settings::getPacketDrivenAcquisition() const
+{
+    return m_packetDrivenAcquisition;
+}
+
+void Settings::setPacketDrivenAcquisition(bool packetDrivenAcquisition)
+{
+    if (m_packetDrivenAcquisition != packetDrivenAcquisition)
+    {
+        m_packetDrivenAcquisition = packetDrivenAcquisition;
+        QSettings().setValue(PACKET_DRIVEN_ACQUISITION, m_packetDrivenAcquisition);
+    }
+}
+
+QString Settings::getRecordingDirectory() const
+{
+    return m_recordingDirectory;
+}
+
+void Settings::setRecordingDirectory(const QString &recordingDirectory)
+{
+    if (m_recordingDirectory != recordingDirectory)
+    {
+        m_recordingDirectory = recordingDirectory;
+        QSettings().setValue(RECORDING_DIRECTORY, m_recordingDirectory);
+    }
+}
+
+bool Settings::getCompressRecordings() const
+{
+    return m_compressRecordings;
+}
+
+void Settings::setCompressRecordings(bool compressRecordings)
+{
+    if (m_compressRecordings != compressRecordings)
+    {
+        m_compressRecordings = compressRecordings;
+        QSettings().setValue(COMPRESS_RECORDINGS, m_compressRecordings);
+    }
+}
+
+QString Settings::getGasFilter() const
+{
+    return m_gasFilter;
+}
+
+void Settings::setGasFilter(const QString &gasFilter)
+{
+    if (m_gasFilter != gasFilter)
+    {
+        m_gasFilter = gasFilter;
+        QSettings().setValue(GAS_FILTER, m_gasFilter);
+    }
+}
+
+QString Settings::getBrakeFilter() const
+{
+    return m_brakeFilter;
+}
+
+void Settings::setBrakeFilter(const QString &brakeFilter)
+{
+    if (m_brakeFilter != brakeFilter)
+    {
+        m_brakeFilter = brakeFilter;
+        QSettings().setValue(BRAKE_FILTER, m_brakeFilter);
+    }
+}
+
+QString Settings::getWindFanFilter() const
+{
+    return m_windFanFilter;
+}
+
+void Settings::setWindFanFilter(const QString &windFanFilter)
+{
+    if (m_windFanFilter != windFanFilter)
+    {
+        m_windFanFilter = windFanFilter;
+        QSettings().setValue(WIND_FAN_FILTER, m_windFanFilter);
+    }
+}
+
+bool Settings::getPerWheelSlip() const
+{
+    return m_perWheelSlip;
+}
+
+void Settings::setPerWheelSlip(bool perWheelSlip)
+{
+    if (m_perWheelSlip != perWheelSlip)
+    {
+        m_perWheelSlip = perWheelSlip;
+        QSettings().setValue(PER_WHEEL_SLIP, m_perWheelSlip);
+    }
+}
+
+QString Settings::getWheelFilter() const
+{
+    return m_wheelFilter;
+}
+
+void Settings::setWheelFilter(const QString &wheelFilter)
+{
+    if (m_wheelFilter != wheelFilter)
+    {
+        m_wheelFilter = wheelFilter;
+        QSettings().setValue(WHEEL_FILTER, m_wheelFilter);
+    }
+}
+
+qint32 Settings::getAbsFrequency() const
+{
+    return m_absFrequency;
+}
+
+void Settings::setAbsFrequency(const qint32 &absFrequency)
+{
+    if (m_absFrequency != absFrequency)
+    {
+        m_absFrequency = absFrequency;
+        QSettings().setValue(ABS_FREQUENCY, m_absFrequency);
+    }
+}
+
+qint32 Settings::getAbsIntensity() const
+{
+    return m_absIntensity;
+}
+
+void Settings::setAbsIntensity(const qint32 &absIntensity)
+{
+    if (m_absIntensity != absIntensity)
+    {
+        m_absIntensity = absIntensity;
+        QSettings().setValue(ABS_INTENSITY, m_absIntensity);
+    }
+}
+
+qint32 Settings::getTcFrequency() const
+{
+    return m_tcFrequency;
+}
+
+void Settings::setTcFrequency(const qint32 &tcFrequency)
+{
+    if (m_tcFrequency != tcFrequency)
+    {
+        m_tcFrequency = tcFrequency;
+        QSettings().setValue(TC_FREQUENCY, m_tcFrequency);
+    }
+}
+
+qint32 Settings::getTcIntensity() const
+{
+    return m_tcIntensity;
+}
+
+void Settings::setTcIntensity(const qint32 &tcIntensity)
+{
+    if (m_tcIntensity != tcIntensity)
+    {
+        m_tcIntensity = tcIntensity;
+        QSettings().setValue(TC_INTENSITY, m_tcIntensity);
+    }
+}
+
+qint32 Settings::getRoadTextureIntensity() const
+{
+    return m_roadTextureIntensity;
+}
+
+void Settings::setRoadTextureIntensity(const qint32 &roadTextureIntensity)
+{
+    if (m_roadTextureIntensity != roadTextureIntensity)
+    {
+        m_roadTextureIntensity = roadTextureIntensity;
+        QSettings().setValue(ROAD_TEXTURE_INTENSITY, m_roadTextureIntensity);
+    }
+}
+
+qint32 Settings::getRoadTextureMinFrequency() const
+{
+    return m_roadTextureMinFrequency;
+}
+
+void Settings::setRoadTextureMinFrequency(const qint32 &roadTextureMinFrequency)
+{
+    if (m_roadTextureMinFrequency != roadTextureMinFrequency)
+    {
+        m_roadTextureMinFrequency = roadTextureMinFrequency;
+        QSettings().setValue(ROAD_TEXTURE_MIN_FREQUENCY, m_roadTextureMinFrequency);
+    }
+}
+
+qint32 Settings::getRoadTextureMaxFrequency() const
+{
+    return m_roadTextureMaxFrequency;
+}
+
+void Settings::setRoadTextureMaxFrequency(const qint32 &roadTextureMaxFrequency)
+{
+    if (m_roadTextureMaxFrequency != roadTextureMaxFrequency)
+    {
+        m_roadTextureMaxFrequency = roadTextureMaxFrequency;
+        QSettings().setValue(ROAD_TEXTURE_MAX_FREQUENCY, m_roadTextureMaxFrequency);
+    }
+}
+
+bool Settings::getSlipCalibration() const
+{
+    return m_slipCalibration;
+}
+
+void Settings::setSlipCalibration(bool slipCalibration)
+{
+    if (m_slipCalibration != slipCalibration)
+    {
+        m_slipCalibration = slipCalibration;
+        QSettings().setValue(SLIP_CALIBRATION, m_slipCalibration);
+    }
+}
+
+QString Settings::getSlipCalibrationData(const QString &carModel) const
+{
+    return QSettings().value(SLIP_CALIBRATION_DATA + carModel, QString()).toString();
+}
+
+void Settings::setSlipCalibrationData(const QString &carModel, const QString &data)
+{
+    QSettings().setValue(SLIP_CALIBRATION_DATA + carModel, data);
+}
+
+QStringList Settings::getSlipCalibrationCars() const
+{
+    QSettings settings;
+    settings.beginGroup(SLIP_CALIBRATION_DATA);
+    return settings.childKeys();
+}
+
+qint32 Settings::getPredictionLead() const
+{
+    return m_predictionLead;
+}
+
+void Settings::setPredictionLead(const qint32 &predictionLead)
+{
+    if (m_predictionLead != predictionLead)
+    {
+        m_predictionLead = predictionLead;
+        QSettings().setValue(PREDICTION_LEAD, m_predictionLead);
+    }
+}
+
+qint32 Settings::getMaxBaudRate(const QString &port) const
+{
+    qint32 baudRate = QSettings().value(MAX_BAUD_RATE + port, DEFAULT_BAUD_RATE).toInt();
+    return (baudRate > 0) ? baudRate : DEFAULT_BAUD_RATE;
+}
+
+void Settings::setMaxBaudRate(const QString &port, qint32 baudRate)
+{
+    QSettings().setValue(MAX_BAUD_RATE + port, baudRate);
+}
+
+qint32 Settings::getProtocol(const QString &port) const
+{
+    qint32 protocol = QSettings().value(PROTOCOL + port, 1).toInt();
+    return ((protocol >= 1) && (protocol <= 2)) ? protocol : 1;
+}
+
+void Settings::setProtocol(const QString &port, qint32 protocol)
+{
+    QSettings().setValue(PROTOCOL + port, protocol);
+}
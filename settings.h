@@ -1,97 +1,193 @@
-#ifndef SETTINGS_698F9153BC7A4C5289DDC784D0BBB172
-#define SETTINGS_698F9153BC7A4C5289DDC784D0BBB172
-
-#include <QObject>
-#include <QSettings>
-
-class Settings : public QObject
-{
-    Q_OBJECT
-public:
-    static Settings *getInstance();
-    virtual ~Settings();
-
-    void loadSettings();
-
-    bool getWheelSlipEnabled() const;
-    void setWheelSlipEnabled(bool wheelSlipEnabled);
-
-    bool getLedFlagEnabled() const;
-    void setLedFlagEnabled(bool ledFlagEnabled);
-
-    bool getWindFanEnabled() const;
-    void setWindFanEnabled(bool windFanEnabled);
-
-    QString getWheelSlipPort() const;
-    void setWheelSlipPort(const QString &port);
-
-    QString getLedFlagPort() const;
-    void setLedFlagPort(const QString &ledFlagPort);
-
-    QString getWindFanPort() const;
-    void setWindFanPort(const QString &windFanPort);
-
-    qint32 getUps() const;
-    void setUps(const qint32 &ups);
-
-    bool getMinimizeWithX() const;
-    void setMinimizeWithX(bool minimizeWithX);
-
-    qint32 getBrakeIndex() const;
-    void setBrakeIndex(const qint32 &brakeIndex);
-
-    qint32 getGasIndex() const;
-    void setGasIndex(const qint32 &gasIndex);
-
-    qint32 getBumpingIndex() const;
-    void setBumpingIndex(const qint32 &bumpingIndex);
-
-    qint32 getWindFanIndex() const;
-    void setWindFanIndex(const qint32 &windFanIndex);
-
-    bool isWheelSlipPortActive() const;
-    bool isLedFlagPortActive() const;
-    bool isWindFanPortActive() const;
-
-    void setWheelSlipPortActive(bool wheelSlipPortActive);
-    void setLedFlagPortActive(bool ledFlagPortActive);
-    void setWindFanPortActive(bool windFanPortActive);
-
-Q_SIGNALS:
-    void wheelSlipPortChanged();
-    void ledFlagPortChanged();
-    void windFanPortChanged();
-    void upsChanged();
-    void minimizeWithXChanged();
-
-    void brakeIndexChanged();
-    void gasIndexChanged();
-    void bumpingIndexChanged();
-    void windFanIndexChanged();
-
-    void wheelSlipEnabledChanged();
-    void windFanEnabledChanged();
-    void ledFlagEnabledChanged();
-
-private:
-    explicit Settings(QObject* parent = nullptr);
-
-    bool m_wheelSlipEnabled = false;
-    bool m_ledFlagEnabled = false;
-    bool m_windFanEnabled = false;
-    QString m_wheelSlipPort;
-    QString m_ledFlagPort;
-    QString m_windFanPort;
-    bool m_wheelSlipPortActive = false;
-    bool m_ledFlagPortActive = false;
-    bool m_windFanPortActive = false;
-    qint32 m_ups;
-    bool m_minimizeWithX = false;
-
-    qint32 m_brakeIndex;
-    qint32 m_gasIndex;
-    qint32 m_bumpingIndex;
-    qint32 m_windFanIndex;
-};
-
-#endif // SETTINGS_698F9153BC7A4C5289DDC784D0BBB172
+#ifndef SETTINGS_698F9153BC7A4C5289DDC784D0BBB172
+#define SETTINGS_698F9153BC7A4C5289DDC784D0BBB172
+
+#include <QObject>
+#include <QSettings>
+
+class Settings : public QObject
+{
+    Q_OBJECT
+public:
+    static Settings *getInstance();
+    virtual ~Settings();
+
+    void loadSettings();
+
+    bool getWheelSlipEnabled() const;
+    void setWheelSlipEnabled(bool wheelSlipEnabled);
+
+    bool getLedFlagEnabled() const;
+    void setLedFlagEnabled(bool ledFlagEnabled);
+
+    bool getWindFanEnabled() const;
+    void setWindFanEnabled(bool windFanEnabled);
+
+    QString getWheelSlipPort() const;
+    void setWheelSlipPort(const QString &port);
+
+    QString getLedFlagPort() const;
+    void setLedFlagPort(const QString &ledFlagPort);
+
+    QString getWindFanPort() const;
+    void setWindFanPort(const QString &windFanPort);
+
+    qint32 getUps() const;
+    void setUps(const qint32 &ups);
+
+    bool getMinimizeWithX() const;
+    void setMinimizeWithX(bool minimizeWithX);
+
+    qint32 getBrakeIndex() const;
+    void setBrakeIndex(const qint32 &brakeIndex);
+
+    qint32 getGasIndex() const;
+    void setGasIndex(const qint32 &gasIndex);
+
+    qint32 getBumpingIndex() const;
+    void setBumpingIndex(const qint32 &bumpingIndex);
+
+    qint32 getWindFanIndex() const;
+    void setWindFanIndex(const qint32 &windFanIndex);
+
+    qint32 getAcquisitionCpu() const;
+    void setAcquisitionCpu(const qint32 &acquisitionCpu);
+
+    bool getRealtimePriority() const;
+    void setRealtimePriority(bool realtimePriority);
+
+    bool getPacketDrivenAcquisition() const;
+    void setPacketDrivenAcquisition(bool packetDrivenAcquisition);
+
+    QString getRecordingDirectory() const;
+    void setRecordingDirectory(const QString &recordingDirectory);
+
+    bool getCompressRecordings() const;
+    void setCompressRecordings(bool compressRecordings);
+
+    QString getGasFilter() const;
+    void setGasFilter(const QString &gasFilter);
+
+    QString getBrakeFilter() const;
+    void setBrakeFilter(const QString &brakeFilter);
+
+    QString getWindFanFilter() const;
+    void setWindFanFilter(const QString &windFanFilter);
+
+    bool getPerWheelSlip() const;
+    void setPerWheelSlip(bool perWheelSlip);
+
+    QString getWheelFilter() const;
+    void setWheelFilter(const QString &wheelFilter);
+
+    qint32 getAbsFrequency() const;
+    void setAbsFrequency(const qint32 &absFrequency);
+
+    qint32 getAbsIntensity() const;
+    void setAbsIntensity(const qint32 &absIntensity);
+
+    qint32 getTcFrequency() const;
+    void setTcFrequency(const qint32 &tcFrequency);
+
+    qint32 getTcIntensity() const;
+    void setTcIntensity(const qint32 &tcIntensity);
+
+    qint32 getRoadTextureIntensity() const;
+    void setRoadTextureIntensity(const qint32 &roadTextureIntensity);
+
+    qint32 getRoadTextureMinFrequency() const;
+    void setRoadTextureMinFrequency(const qint32 &roadTextureMinFrequency);
+
+    qint32 getRoadTextureMaxFrequency() const;
+    void setRoadTextureMaxFrequency(const qint32 &roadTextureMaxFrequency);
+
+    bool getSlipCalibration() const;
+    void setSlipCalibration(bool slipCalibration);
+
+    // State of the slip calibration of one car, see SlipCalibration.
+    // Read from and written to the settings directly, from any thread.
+    QString getSlipCalibrationData(const QString &carModel) const;
+    void setSlipCalibrationData(const QString &carModel, const QString &data);
+    QStringList getSlipCalibrationCars() const;
+
+    qint32 getPredictionLead() const;
+    void setPredictionLead(const qint32 &predictionLead);
+
+    // Fastest rate the device on this port is asked for, 9600 (the default)
+    // keeps devices without rate negotiation working
+    qint32 getMaxBaudRate(const QString &port) const;
+    void setMaxBaudRate(const QString &port, qint32 baudRate);
+
+    // Serial protocol of the device on this port, 1 (the default) for the
+    // legacy messages or 2 for framed batches
+    qint32 getProtocol(const QString &port) const;
+    void setProtocol(const QString &port, qint32 protocol);
+
+    bool isWheelSlipPortActive() const;
+    bool isLedFlagPortActive() const;
+    bool isWindFanPortActive() const;
+
+    void setWheelSlipPortActive(bool wheelSlipPortActive);
+    void setLedFlagPortActive(bool ledFlagPortActive);
+    void setWindFanPortActive(bool windFanPortActive);
+
+Q_SIGNALS:
+    // Also emitted when the port becomes active or inactive
+    void wheelSlipPortChanged();
+    void ledFlagPortChanged();
+    void windFanPortChanged();
+    void upsChanged();
+    void minimizeWithXChanged();
+
+    void brakeIndexChanged();
+    void gasIndexChanged();
+    void bumpingIndexChanged();
+    void windFanIndexChanged();
+
+    void wheelSlipEnabledChanged();
+    void windFanEnabledChanged();
+    void ledFlagEnabledChanged();
+
+private:
+    explicit Settings(QObject* parent = nullptr);
+
+    bool m_wheelSlipEnabled = false;
+    bool m_ledFlagEnabled = false;
+    bool m_windFanEnabled = false;
+    QString m_wheelSlipPort;
+    QString m_ledFlagPort;
+    QString m_windFanPort;
+    bool m_wheelSlipPortActive = false;
+    bool m_ledFlagPortActive = false;
+    bool m_windFanPortActive = false;
+    qint32 m_ups;
+    bool m_minimizeWithX = false;
+
+    qint32 m_brakeIndex;
+    qint32 m_gasIndex;
+    qint32 m_bumpingIndex;
+    qint32 m_windFanIndex;
+
+    qint32 m_acquisitionCpu;
+    bool m_realtimePriority = false;
+    bool m_packetDrivenAcquisition = false;
+    QString m_recordingDirectory;
+    bool m_compressRecordings = true;
+    QString m_gasFilter;
+    QString m_brakeFilter;
+    QString m_windFanFilter;
+    bool m_perWheelSlip = false;
+    QString m_wheelFilter;
+
+    qint32 m_absFrequency;
+    qint32 m_absIntensity;
+    qint32 m_tcFrequency;
+    qint32 m_tcIntensity;
+
+    qint32 m_roadTextureIntensity;
+    qint32 m_roadTextureMinFrequency;
+    qint32 m_roadTextureMaxFrequency;
+    bool m_slipCalibration = false;
+    qint32 m_predictionLead;
+};
+
+#endif // SETTINGS_698F9153BC7A4C5289DDC784D0BBB172
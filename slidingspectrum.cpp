@@ -0,0 +1,159 @@
+#include "slidingspectrum.h"
+#include <QtMath>
+#include <cmath>
+
+// Keeps the rounding errors of the recursion from adding up, the bins are
+// recomputed from the window once per this many samples
+static const qint32 RESYNC_INTERVAL = 4096;
+
+
+bool SlidingSpectrum::configure(float sampleRate, float minFrequency, float maxFrequency)
+{
+    m_binCount = 0;
+    m_firstBin = 0;
+
+    if ((sampleRate > 0.0f) && (minFrequency <= maxFrequency))
+    {
+        float binWidth = sampleRate / WINDOW_SIZE;
+        qint32 first = qMax(1, static_cast<qint32>(std::ceil(minFrequency / binWidth)));
+        qint32 last = qMin(MAX_BINS, static_cast<qint32>(std::floor(maxFrequency / binWidth)));
+        if (first <= last)
+        {
+            m_firstBin = first;
+            m_binCount = (last - first) + 1;
+        }
+    }
+
+    for (qint32 i = 0; i < m_binCount; ++i)
+    {
+        double omega = (2.0 * M_PI * (m_firstBin + i)) / WINDOW_SIZE;
+        m_bins[i].cosine = static_cast<float>(std::cos(omega));
+        m_bins[i].sine = static_cast<float>(std::sin(omega));
+    }
+
+    reset();
+    return (m_binCount > 0);
+}
+
+void SlidingSpectrum::reset()
+{
+    for (qint32 i = 0; i < WINDOW_SIZE; ++i)
+    {
+        m_window[i] = WheelValueFloat();
+    }
+
+    for (qint32 i = 0; i < m_binCount; ++i)
+    {
+        m_bins[i].real = WheelValueFloat();
+        m_bins[i].imaginary = WheelValueFloat();
+    }
+
+    m_position = 0;
+    m_samples = 0;
+}
+
+void SlidingSpectrum::addSample(const WheelValueFloat &sample)
+{
+    WheelValueFloat &oldest = m_window[m_position];
+    WheelValueFloat delta;
+    for (qint32 w = 0; w < WHEEL_COUNT; ++w)
+    {
+        delta[w] = sample[w] - oldest[w];
+    }
+    oldest = sample;
+    m_position = (m_position + 1) % WINDOW_SIZE;
+
+    // X(k) = (X(k) + new - oldest) * e^(i*2*pi*k/N), four wheels at once
+    for (qint32 i = 0; i < m_binCount; ++i)
+    {
+        Bin &bin = m_bins[i];
+        for (qint32 w = 0; w < WHEEL_COUNT; ++w)
+        {
+            float real = bin.real[w] + delta[w];
+            float imaginary = bin.imaginary[w];
+            bin.real[w] = (real * bin.cosine) - (imaginary * bin.sine);
+            bin.imaginary[w] = (real * bin.sine) + (imaginary * bin.cosine);
+        }
+    }
+
+    if (++m_samples == RESYNC_INTERVAL)
+    {
+        m_samples = 0;
+        for (qint32 i = 0; i < m_binCount; ++i)
+        {
+            Bin &bin = m_bins[i];
+            bin.real = WheelValueFloat();
+            bin.imaginary = WheelValueFloat();
+
+            // The oldest sample is at the current position
+            for (qint32 n = 0; n < WINDOW_SIZE; ++n)
+            {
+                const WheelValueFloat &value = m_window[(m_position + n) % WINDOW_SIZE];
+                double omega = (2.0 * M_PI * (m_firstBin + i) * (WINDOW_SIZE - n)) / WINDOW_SIZE;
+                float cosine = static_cast<float>(std::cos(omega));
+                float sine = static_cast<float>(std::sin(omega));
+                for (qint32 w = 0; w < WHEEL_COUNT; ++w)
+                {
+                    bin.real[w] += value[w] * cosine;
+                    bin.imaginary[w] += value[w] * sine;
+                }
+            }
+        }
+    }
+}
+
+void SlidingSpectrum::bandRms(WheelValueFloat &rms) const
+{
+    // Parseval: a real signal has the same energy in bin k and N - k
+    WheelValueFloat energy;
+    for (qint32 i = 0; i < m_binCount; ++i)
+    {
+        const Bin &bin = m_bins[i];
+        for (qint32 w = 0; w < WHEEL_COUNT; ++w)
+        {
+            energy[w] += (bin.real[w] * bin.real[w]) + (bin.imaginary[w] * bin.imaginary[w]);
+        }
+    }
+
+    for (qint32 w = 0; w < WHEEL_COUNT; ++w)
+    {
+        rms[w] = std::sqrt(2.0f * energy[w]) / WINDOW_SIZE;
+    }
+}
+
+qint32 SlidingSpectrum::binCount() const
+{
+    return m_binCount;
+}
+
+qint32 SlidingSpectrum::firstBin() const
+{
+    return m_firstBin;
+}
+
+void SlidingSpectrum::bandRmsFromWindow(WheelValueFloat &rms) const
+{
+    WheelValueFloat energy;
+    for (qint32 i = 0; i < m_binCount; ++i)
+    {
+        float coefficient = 2.0f * m_bins[i].cosine;
+        for (qint32 w = 0; w < WHEEL_COUNT; ++w)
+        {
+            float s1 = 0.0f;
+            float s2 = 0.0f;
+            for (qint32 n = 0; n < WINDOW_SIZE; ++n)
+            {
+                float s0 = m_window[(m_position + n) % WINDOW_SIZE][w] + (coefficient * s1) - s2;
+                s2 = s1;
+                s1 = s0;
+            }
+
+            energy[w] += (s1 * s1) + (s2 * s2) - (coefficient * s1 * s2);
+        }
+    }
+
+    for (qint32 w = 0; w < WHEEL_COUNT; ++w)
+    {
+        rms[w] = std::sqrt(2.0f * energy[w]) / WINDOW_SIZE;
+    }
+}
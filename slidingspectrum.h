@@ -0,0 +1,54 @@
+#ifndef SLIDINGSPECTRUM_6E1628F1A49F406B82D0DE6FC4730E4D
+#define SLIDINGSPECTRUM_6E1628F1A49F406B82D0DE6FC4730E4D
+
+#include <QtGlobal>
+#include "globals.h"
+
+// Energy of a frequency band in the last WINDOW_SIZE samples of a value
+// per wheel. Every sample updates each bin of a sliding DFT once, instead
+// of transforming the whole window again.
+class SlidingSpectrum
+{
+public:
+    static const qint32 WINDOW_SIZE = 32;
+    // Bins 1 to N/2 - 1, each stands for itself and its mirror N - k. The
+    // Nyquist bin N/2 has no mirror and is left out.
+    static const qint32 MAX_BINS = (WINDOW_SIZE / 2) - 1;
+
+    // Uses the DFT bins between the two frequencies, at most up to just
+    // below half the sample rate. Returns false if none fits, e.g. because
+    // the band is above half the sample rate.
+    bool configure(float sampleRate, float minFrequency, float maxFrequency);
+    void reset();
+
+    void addSample(const WheelValueFloat &sample);
+
+    // Root mean square of the band over the window
+    void bandRms(WheelValueFloat &rms) const;
+
+    qint32 binCount() const;
+    qint32 firstBin() const;
+
+    // Same result, computed from the window with one Goertzel filter per
+    // bin. Much slower, used to check and benchmark the sliding version.
+    void bandRmsFromWindow(WheelValueFloat &rms) const;
+
+private:
+    struct Bin
+    {
+        float cosine = 1.0f;
+        float sine = 0.0f;
+        WheelValueFloat real;
+        WheelValueFloat imaginary;
+    };
+
+    Bin m_bins[MAX_BINS];
+    qint32 m_binCount = 0;
+    qint32 m_firstBin = 0;
+
+    WheelValueFloat m_window[WINDOW_SIZE];
+    qint32 m_position = 0;
+    qint32 m_samples = 0;
+};
+
+#endif // SLIDINGSPECTRUM_6E1628F1A49F406B82D0DE6FC4730E4D
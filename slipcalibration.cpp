@@ -0,0 +1,115 @@
+#include "slipcalibration.h"
+#include <QDebug>
+#include <QStringList>
+#include <cmath>
+#include "settings.h"
+
+// The output that the usual strong slip of a car is scaled to
+static const double CALIBRATION_QUANTILE = 0.95;
+static const qint32 MAX_OUTPUT = 127;
+// About 10 s of slipping wheels at 333 updates per second
+static const quint64 MIN_CALIBRATION_SAMPLES = 3000;
+// Below this speed in km/h the wheel speed deviation is mostly noise
+static const qint32 MIN_DEVIATION_SPEED = 10;
+static const double MIN_RANGE = 1e-3;
+
+
+SlipCalibration::SlipCalibration()
+    : m_slip(CALIBRATION_QUANTILE)
+    , m_speedDeviation(CALIBRATION_QUANTILE)
+{
+}
+
+void SlipCalibration::setCar(const QString &carModel)
+{
+    if (carModel == m_carModel)
+    {
+        return;
+    }
+
+    save();
+
+    m_carModel = carModel;
+    m_slip.reset();
+    m_speedDeviation.reset();
+    if (m_carModel.isEmpty())
+    {
+        return;
+    }
+
+    // "<slip state>;<wheel speed deviation state>"
+    QStringList states = Settings::getInstance()->getSlipCalibrationData(m_carModel).split(';');
+    if ((states.size() == 2) && m_slip.fromString(states[0]) && m_speedDeviation.fromString(states[1]))
+    {
+        qDebug() << "Slip calibration of" << m_carModel << "loaded:" << m_slip.count() << "samples, slip range" << m_slip.value();
+    }
+    else
+    {
+        m_slip.reset();
+        m_speedDeviation.reset();
+        qDebug() << "Slip calibration of" << m_carModel << "starts";
+    }
+}
+
+QString SlipCalibration::car() const
+{
+    return m_carModel;
+}
+
+void SlipCalibration::save()
+{
+    if (m_carModel.isEmpty() || (m_slip.count() == 0))
+    {
+        return;
+    }
+
+    Settings::getInstance()->setSlipCalibrationData(m_carModel, m_slip.toString() + ";" + m_speedDeviation.toString());
+}
+
+void SlipCalibration::add(const TelemetryFrame &frame, const SlipKernelResult &slip, qint32 speed)
+{
+    for (qint32 i = 0; i < WHEEL_COUNT; ++i)
+    {
+        if (slip.slip[i] == 0)
+        {
+            continue;
+        }
+
+        // Unclamped, to learn about cars that go beyond 255
+        m_slip.add(frame.wheels.slip[i]);
+
+        if ((slip.status[i] != NotSlipping) && (speed >= MIN_DEVIATION_SPEED))
+        {
+            m_speedDeviation.add(std::fabs((slip.calculatedSpeed[i] / static_cast<float>(speed)) - 1.0f));
+        }
+    }
+}
+
+bool SlipCalibration::isCalibrated() const
+{
+    return (m_slip.count() >= MIN_CALIBRATION_SAMPLES) && (m_slip.value() > MIN_RANGE);
+}
+
+qint32 SlipCalibration::scale(qint32 wheel, const TelemetryFrame &frame, const SlipKernelResult &slip, qint32 speed) const
+{
+    double level = qMax(0.0f, frame.wheels.slip[wheel]) / m_slip.value();
+
+    if ((m_speedDeviation.count() >= MIN_CALIBRATION_SAMPLES) && (m_speedDeviation.value() > MIN_RANGE)
+            && (speed >= MIN_DEVIATION_SPEED))
+    {
+        double deviation = std::fabs((slip.calculatedSpeed[wheel] / static_cast<float>(speed)) - 1.0f);
+        level = qMax(level, deviation / m_speedDeviation.value());
+    }
+
+    return qBound(1, static_cast<qint32>(std::lround(level * MAX_OUTPUT)), MAX_OUTPUT);
+}
+
+const P2Quantile &SlipCalibration::slipRange() const
+{
+    return m_slip;
+}
+
+const P2Quantile &SlipCalibration::speedDeviationRange() const
+{
+    return m_speedDeviation;
+}
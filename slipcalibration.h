@@ -0,0 +1,47 @@
+#ifndef SLIPCALIBRATION_892AECD494764D56B73CF888C3716214
+#define SLIPCALIBRATION_892AECD494764D56B73CF888C3716214
+
+#include <QString>
+#include "quantilesketch.h"
+#include "slipkernel.h"
+#include "telemetryframe.h"
+
+// Learns how far the slip of the current car goes and scales the slip
+// values so that every car uses the whole range of the shakers instead of
+// saturating or barely moving them. The state is kept per car model in
+// the settings.
+class SlipCalibration
+{
+public:
+    SlipCalibration();
+
+    // Stores what was learnt for the previous car and loads the state of
+    // this one. Not for the per tick path, it reads the settings.
+    void setCar(const QString &carModel);
+    QString car() const;
+
+    // Stores the state of the current car
+    void save();
+
+    // Learns from all wheels of one tick, O(1) and without allocating
+    void add(const TelemetryFrame &frame, const SlipKernelResult &slip, qint32 speed);
+
+    // False until enough slip was seen on the current car
+    bool isCalibrated() const;
+
+    // Value between 1 and 127 for a slipping wheel, the strongest of the
+    // slip and the wheel speed deviation relative to what is usual for the car
+    qint32 scale(qint32 wheel, const TelemetryFrame &frame, const SlipKernelResult &slip, qint32 speed) const;
+
+    const P2Quantile &slipRange() const;
+    const P2Quantile &speedDeviationRange() const;
+
+private:
+    QString m_carModel;
+    // Raw slip of the wheels that slip at all
+    P2Quantile m_slip;
+    // |wheel speed / car speed - 1| of the wheels classified as slipping
+    P2Quantile m_speedDeviation;
+};
+
+#endif // SLIPCALIBRATION_892AECD494764D56B73CF888C3716214
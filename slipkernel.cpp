@@ -0,0 +1,165 @@
+#include "slipkernel.h"
+
+#if defined(SLIP_KERNEL_SSE2)
+#include <emmintrin.h>
+#elif defined(SLIP_KERNEL_NEON)
+#include <arm_neon.h>
+#endif
+
+// Speed of the wheel's circumference, the operations have to stay in this
+// order in every implementation to give the same result
+static const float SPEED_TWO = 2.0f;
+static const float SPEED_PI = 3.14159265358979323846f;
+static const float SPEED_SIXTY = 60.0f;
+static const float SPEED_HUNDRED = 100.0f;
+
+static const qint32 MAX_SLIP = 255;
+
+
+void classifyWheelSlipScalar(const WheelFrame &wheels, const WheelValueFloat &tyreRadius,
+                             float brakeSpeed, float gasSpeed, SlipKernelResult &result)
+{
+    result.maxBrakeValue = 0;
+    result.maxGasValue = 0;
+    result.bumpingMask = 0;
+
+    for (qint32 i = 0; i < WHEEL_COUNT; ++i)
+    {
+        qint32 slip = qBound(0, static_cast<qint32>(wheels.slip[i]), MAX_SLIP);
+        float calculatedSpeed = ((((SPEED_TWO * tyreRadius[i]) * SPEED_PI) * wheels.angularSpeed[i]) * SPEED_SIXTY) / SPEED_HUNDRED;
+
+        WheelSlipStatus status = NotSlipping;
+        if (static_cast<float>(slip) != 0.0f)
+        {
+            if (calculatedSpeed < brakeSpeed)
+            {
+                status = SlippingFromBraking;
+                result.maxBrakeValue = qMax(result.maxBrakeValue, slip);
+            }
+            else if (calculatedSpeed > gasSpeed)
+            {
+                status = SlippingFromGas;
+                result.maxGasValue = qMax(result.maxGasValue, slip);
+            }
+        }
+
+        if (wheels.load[i] == 0.0f)
+        {
+            result.bumpingMask |= (1u << i);
+        }
+
+        result.slip[i] = slip;
+        result.status[i] = status;
+        result.calculatedSpeed[i] = calculatedSpeed;
+    }
+}
+
+#if defined(SLIP_KERNEL_SSE2)
+
+namespace
+{
+// Maximum of four values between 0 and 255
+qint32 horizontalMax(__m128i value)
+{
+    // The values fit into the low 16 bits, the high 16 bits are 0
+    value = _mm_max_epi16(value, _mm_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2)));
+    value = _mm_max_epi16(value, _mm_shuffle_epi32(value, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(value);
+}
+}
+
+void classifyWheelSlip(const WheelFrame &wheels, const WheelValueFloat &tyreRadius,
+                       float brakeSpeed, float gasSpeed, SlipKernelResult &result)
+{
+    __m128 radius = _mm_load_ps(tyreRadius.value);
+    __m128 angularSpeed = _mm_load_ps(wheels.angularSpeed.value);
+    __m128 calculatedSpeed = _mm_mul_ps(_mm_set1_ps(SPEED_TWO), radius);
+    calculatedSpeed = _mm_mul_ps(calculatedSpeed, _mm_set1_ps(SPEED_PI));
+    calculatedSpeed = _mm_mul_ps(calculatedSpeed, angularSpeed);
+    calculatedSpeed = _mm_mul_ps(calculatedSpeed, _mm_set1_ps(SPEED_SIXTY));
+    calculatedSpeed = _mm_div_ps(calculatedSpeed, _mm_set1_ps(SPEED_HUNDRED));
+
+    // Truncate like static_cast<qint32>, then clamp to 0..255
+    __m128i slip = _mm_cvttps_epi32(_mm_load_ps(wheels.slip.value));
+    slip = _mm_and_si128(slip, _mm_cmpgt_epi32(slip, _mm_setzero_si128()));
+    __m128i maxSlip = _mm_set1_epi32(MAX_SLIP);
+    __m128i tooLarge = _mm_cmpgt_epi32(slip, maxSlip);
+    slip = _mm_or_si128(_mm_andnot_si128(tooLarge, slip), _mm_and_si128(tooLarge, maxSlip));
+
+    __m128 slipping = _mm_cmpneq_ps(_mm_cvtepi32_ps(slip), _mm_setzero_ps());
+    __m128 braking = _mm_and_ps(slipping, _mm_cmplt_ps(calculatedSpeed, _mm_set1_ps(brakeSpeed)));
+    __m128 gas = _mm_andnot_ps(braking, _mm_and_ps(slipping, _mm_cmpgt_ps(calculatedSpeed, _mm_set1_ps(gasSpeed))));
+    __m128i brakingMask = _mm_castps_si128(braking);
+    __m128i gasMask = _mm_castps_si128(gas);
+
+    __m128i status = _mm_or_si128(_mm_and_si128(brakingMask, _mm_set1_epi32(SlippingFromBraking)),
+                                  _mm_and_si128(gasMask, _mm_set1_epi32(SlippingFromGas)));
+
+    _mm_store_si128(reinterpret_cast<__m128i*>(result.slip.value), slip);
+    _mm_store_si128(reinterpret_cast<__m128i*>(result.status.value), status);
+    _mm_store_ps(result.calculatedSpeed.value, calculatedSpeed);
+    result.maxBrakeValue = horizontalMax(_mm_and_si128(brakingMask, slip));
+    result.maxGasValue = horizontalMax(_mm_and_si128(gasMask, slip));
+    result.bumpingMask = static_cast<quint32>(_mm_movemask_ps(_mm_cmpeq_ps(_mm_load_ps(wheels.load.value), _mm_setzero_ps())));
+}
+
+const char* slipKernelName()
+{
+    return "SSE2";
+}
+
+#elif defined(SLIP_KERNEL_NEON)
+
+void classifyWheelSlip(const WheelFrame &wheels, const WheelValueFloat &tyreRadius,
+                       float brakeSpeed, float gasSpeed, SlipKernelResult &result)
+{
+    float32x4_t radius = vld1q_f32(tyreRadius.value);
+    float32x4_t angularSpeed = vld1q_f32(wheels.angularSpeed.value);
+    float32x4_t calculatedSpeed = vmulq_f32(vdupq_n_f32(SPEED_TWO), radius);
+    calculatedSpeed = vmulq_f32(calculatedSpeed, vdupq_n_f32(SPEED_PI));
+    calculatedSpeed = vmulq_f32(calculatedSpeed, angularSpeed);
+    calculatedSpeed = vmulq_f32(calculatedSpeed, vdupq_n_f32(SPEED_SIXTY));
+    calculatedSpeed = vdivq_f32(calculatedSpeed, vdupq_n_f32(SPEED_HUNDRED));
+
+    // Truncate like static_cast<qint32>, then clamp to 0..255
+    int32x4_t slip = vcvtq_s32_f32(vld1q_f32(wheels.slip.value));
+    slip = vminq_s32(vmaxq_s32(slip, vdupq_n_s32(0)), vdupq_n_s32(MAX_SLIP));
+
+    uint32x4_t slipping = vmvnq_u32(vceqq_f32(vcvtq_f32_s32(slip), vdupq_n_f32(0.0f)));
+    uint32x4_t braking = vandq_u32(slipping, vcltq_f32(calculatedSpeed, vdupq_n_f32(brakeSpeed)));
+    uint32x4_t gas = vbicq_u32(vandq_u32(slipping, vcgtq_f32(calculatedSpeed, vdupq_n_f32(gasSpeed))), braking);
+
+    uint32x4_t status = vorrq_u32(vandq_u32(braking, vdupq_n_u32(SlippingFromBraking)),
+                                  vandq_u32(gas, vdupq_n_u32(SlippingFromGas)));
+
+    uint32x4_t slipBits = vreinterpretq_u32_s32(slip);
+    static const uint32_t WHEEL_BITS[WHEEL_COUNT] = {1, 2, 4, 8};
+    uint32x4_t noLoad = vceqq_f32(vld1q_f32(wheels.load.value), vdupq_n_f32(0.0f));
+
+    vst1q_s32(result.slip.value, slip);
+    vst1q_s32(result.status.value, vreinterpretq_s32_u32(status));
+    vst1q_f32(result.calculatedSpeed.value, calculatedSpeed);
+    result.maxBrakeValue = static_cast<qint32>(vmaxvq_u32(vandq_u32(braking, slipBits)));
+    result.maxGasValue = static_cast<qint32>(vmaxvq_u32(vandq_u32(gas, slipBits)));
+    result.bumpingMask = vaddvq_u32(vandq_u32(noLoad, vld1q_u32(WHEEL_BITS)));
+}
+
+const char* slipKernelName()
+{
+    return "NEON";
+}
+
+#else
+
+void classifyWheelSlip(const WheelFrame &wheels, const WheelValueFloat &tyreRadius,
+                       float brakeSpeed, float gasSpeed, SlipKernelResult &result)
+{
+    classifyWheelSlipScalar(wheels, tyreRadius, brakeSpeed, gasSpeed, result);
+}
+
+const char* slipKernelName()
+{
+    return "scalar";
+}
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef SLIPKERNEL_E6E3DEA920CE4D7D891F9852275960C1
+#define SLIPKERNEL_E6E3DEA920CE4D7D891F9852275960C1
+
+#include <QtGlobal>
+#include "telemetryframe.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define SLIP_KERNEL_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define SLIP_KERNEL_NEON
+#endif
+
+struct SlipKernelResult
+{
+    // Slip clamped to 0..255
+    WheelValueInt slip;
+    // WheelSlipStatus of every wheel
+    WheelValueInt status;
+    WheelValueFloat calculatedSpeed;
+    qint32 maxBrakeValue = 0;
+    qint32 maxGasValue = 0;
+    // Bit n is set if wheel n has no load
+    quint32 bumpingMask = 0;
+};
+
+// Classifies the slip of all four wheels at once, without branches.
+// A slipping wheel turns slower than brakeSpeed when braking and faster
+// than gasSpeed when accelerating, where both are the car's speed scaled
+// by the brake and gas index. Uses SSE2 or NEON if available and gives
+// the same bits as classifyWheelSlipScalar() on the same platform.
+void classifyWheelSlip(const WheelFrame &wheels, const WheelValueFloat &tyreRadius,
+                       float brakeSpeed, float gasSpeed, SlipKernelResult &result);
+
+// Reference implementation, one wheel after the other
+void classifyWheelSlipScalar(const WheelFrame &wheels, const WheelValueFloat &tyreRadius,
+                             float brakeSpeed, float gasSpeed, SlipKernelResult &result);
+
+// Name of the implementation classifyWheelSlip() uses
+const char* slipKernelName();
+
+#endif // SLIPKERNEL_E6E3DEA920CE4D7D891F9852275960C1
@@ -0,0 +1,77 @@
+#ifndef SPSCRING_781A8D662F114933A9AD2F5D0DA06D9F
+#define SPSCRING_781A8D662F114933A9AD2F5D0DA06D9F
+
+#include <QtGlobal>
+#include <atomic>
+#include <memory>
+
+// Bounded lock-free ring buffer for exactly one producer and one consumer
+// thread. Items are written and read in place. They are allocated once by
+// the constructor, so a large ring does not end up on the stack with its
+// owner. N has to be a power of two.
+template <typename T, quint32 N>
+class SpscRing
+{
+    static_assert((N & (N - 1)) == 0, "SpscRing size has to be a power of two");
+
+public:
+    SpscRing()
+        : m_head(0)
+        , m_tail(0)
+        , m_items(new T[N])
+    {
+
+    }
+
+    // Producer: returns the next free slot or nullptr if the ring is full.
+    // The slot is handed to the consumer by commitPush().
+    T* beginPush()
+    {
+        quint32 tail = m_tail.load(std::memory_order_relaxed);
+        if ((tail - m_head.load(std::memory_order_acquire)) == N)
+        {
+            return nullptr;
+        }
+
+        return &m_items[tail & (N - 1)];
+    }
+
+    void commitPush()
+    {
+        m_tail.store(m_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Consumer: returns the oldest item or nullptr if the ring is empty.
+    // The slot is handed back to the producer by pop().
+    const T* front() const
+    {
+        quint32 head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire))
+        {
+            return nullptr;
+        }
+
+        return &m_items[head & (N - 1)];
+    }
+
+    void pop()
+    {
+        m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    bool isEmpty() const
+    {
+        return (m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire));
+    }
+
+private:
+    // Head and tail are padded onto separate cache lines so producer and
+    // consumer do not invalidate each other's line on every update
+    std::atomic<quint32> m_head;
+    char m_headPadding[64 - sizeof(std::atomic<quint32>)];
+    std::atomic<quint32> m_tail;
+    char m_tailPadding[64 - sizeof(std::atomic<quint32>)];
+    std::unique_ptr<T[]> m_items;
+};
+
+#endif // SPSCRING_781A8D662F114933A9AD2F5D0DA06D9F
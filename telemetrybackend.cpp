@@ -0,0 +1,18 @@
+#include "telemetrybackend.h"
+#include <QtGlobal>
+
+#if defined(Q_OS_WIN)
+#include "winsharedmemorybackend.h"
+#else
+#include "posixsharedmemorybackend.h"
+#endif
+
+
+TelemetryBackend* TelemetryBackend::create()
+{
+#if defined(Q_OS_WIN)
+    return new WinSharedMemoryBackend();
+#else
+    return new PosixSharedMemoryBackend();
+#endif
+}
@@ -0,0 +1,28 @@
+#ifndef TELEMETRYBACKEND_492C27FA1B3D42B6B1619EDF2B80A6EB
+#define TELEMETRYBACKEND_492C27FA1B3D42B6B1619EDF2B80A6EB
+
+#include "sharedfileout.h"
+
+// Source of the three Assetto Corsa pages.
+// Implementations hand out pointers into memory they own (e.g. a shared
+// memory mapping), so no copy is made when the pages are accessed.
+class TelemetryBackend
+{
+public:
+    virtual ~TelemetryBackend() {}
+
+    virtual bool isOpen() const = 0;
+
+    // Tries again to open pages that were not available yet, e.g. because
+    // the game was started after us. Returns isOpen().
+    virtual bool reopen() { return isOpen(); }
+
+    virtual const SPageFilePhysics* physics() const = 0;
+    virtual const SPageFileGraphic* graphics() const = 0;
+    virtual const SPageFileStatic* staticData() const = 0;
+
+    // Creates the shared memory backend of the current platform
+    static TelemetryBackend* create();
+};
+
+#endif // TELEMETRYBACKEND_492C27FA1B3D42B6B1619EDF2B80A6EB
@@ -0,0 +1,40 @@
+#ifndef TELEMETRYFRAME_60ACD391E0EE4721B32BC317DC71075B
+#define TELEMETRYFRAME_60ACD391E0EE4721B32BC317DC71075B
+
+#include <QtGlobal>
+#include "sharedfileout.h"
+#include "globals.h"
+
+// Per-wheel fields of one physics step, one 4-wide value per field
+struct WheelFrame
+{
+    WheelValueFloat slip;
+    WheelValueFloat load;
+    WheelValueFloat angularSpeed;
+    WheelValueFloat suspensionTravel;
+};
+
+// Consistent copy of the fields the pipeline needs from one physics step.
+// Filled by AssettoCorsaData::readFrame().
+struct TelemetryFrame
+{
+    // Acquisition clock, see AcquisitionThread::now()
+    long long timestampNs = 0;
+
+    // Physics page
+    int physicsPacketId = 0;
+    float gas = 0.0f;
+    float brake = 0.0f;
+    float speedKmh = 0.0f;
+    float abs = 0.0f;
+    float tc = 0.0f;
+    WheelFrame wheels;
+
+    // Graphics page
+    int graphicsPacketId = 0;
+    AC_STATUS status = AC_OFF;
+    AC_FLAG_TYPE flag = AC_NO_FLAG;
+    int completedLaps = 0;
+};
+
+#endif // TELEMETRYFRAME_60ACD391E0EE4721B32BC317DC71075B
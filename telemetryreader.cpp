@@ -1,481 +1,669 @@
-#include "telemetryreader.h"
-#include <QDebug>
-#include <QtMath>
-#include <QString>
-#include <QChar>
-#include <QProcess>
-#include <QBuffer>
-#include <QDataStream>
-#include <QtEndian>
-#include "settings.h"
-
-
-TelemetryReader::TelemetryReader(QObject *parent)
-    : QObject(parent)
-    , m_standbyInterval(1000)
-    , m_liveInterval(0)
-    , m_lastStatus(AC_OFF)
-    , m_readStaticData(false)
-    , m_speed(0)
-    , m_lastSpeed(0)
-    , m_lastBumping(false)
-{
-    (void)connect(&m_readTimer, &QTimer::timeout, this, &TelemetryReader::readData);
-
-    Settings* settings = Settings::getInstance();
-    (void)connect(settings, &Settings::gasIndexChanged, this, &TelemetryReader::onGasIndexChanged);
-    (void)connect(settings, &Settings::brakeIndexChanged, this, &TelemetryReader::onBrakeIndexChanged);
-    (void)connect(settings, &Settings::bumpingIndexChanged, this, &TelemetryReader::onBumpingIndexChanged);
-    (void)connect(settings, &Settings::windFanIndexChanged, this, &TelemetryReader::onWindFanIndexChanged);
-
-    m_readTimer.setInterval(m_standbyInterval);
-}
-
-TelemetryReader::~TelemetryReader()
-{
-    m_readTimer.stop();
-    (void)disconnect(this);
-}
-
-void TelemetryReader::run()
-{
-    if (m_liveInterval == 0)
-    {
-        qDebug() << "Cannot start read timer. No update rate set";
-        return;
-    }
-
-    // Initially read settings once
-    // Changes will be notified by signals from the settings
-    readSettings();
-
-    m_readTimer.start();
-    qDebug() << "Started read timer";
-}
-
-void TelemetryReader::stop()
-{
-    m_readTimer.stop();
-    qDebug() << "Stopped read timer";
-}
-
-void TelemetryReader::setUpdatesPerSecond(qint32 ups)
-{
-    double ms = 1000.0 / static_cast<double>(ups);
-    m_liveInterval = qRound(ms + 0.5); // Round up
-}
-
-void TelemetryReader::onGasIndexChanged()
-{
-    qint32 newIndex = Settings::getInstance()->getGasIndex();
-    m_gasIndex = (static_cast<float>(newIndex) / 100);
-}
-
-void TelemetryReader::onBrakeIndexChanged()
-{
-    qint32 newIndex = Settings::getInstance()->getBrakeIndex();
-    m_brakeIndex = (static_cast<float>(100 - newIndex) / 100);
-}
-
-void TelemetryReader::onBumpingIndexChanged()
-{
-    m_bumpingIndex = Settings::getInstance()->getBumpingIndex();
-}
-
-void TelemetryReader::onWindFanIndexChanged()
-{
-    m_windFanIndex = Settings::getInstance()->getWindFanIndex();
-}
-
-void TelemetryReader::readData()
-{
-    m_acData.update();
-
-    AC_STATUS status = m_acData.getStatus();
-    if (status != m_lastStatus)
-    {
-        Q_EMIT setStatus(status);
-
-        if (m_lastStatus == AC_LIVE)
-        {
-            m_readTimer.setInterval(m_standbyInterval);
-            m_lastStatus = status;
-            Q_EMIT sendInitialValues();
-            Q_EMIT speedUpdated(0);
-            return;
-        }
-        else if (status == AC_LIVE)
-        {
-            if (m_liveInterval > 0)
-            {
-                m_readTimer.setInterval(m_liveInterval);
-            }
-
-            // Reset wheel slip states when switching to live state
-            Q_EMIT frontLeftStatusUpdated(WheelSlipStatus::NotSlipping);
-            Q_EMIT frontRightStatusUpdated(WheelSlipStatus::NotSlipping);
-            Q_EMIT rearLeftStatusUpdated(WheelSlipStatus::NotSlipping);
-            Q_EMIT rearRightStatusUpdated(WheelSlipStatus::NotSlipping);
-        }
-
-        m_lastStatus = status;
-    }
-    else if (status != AC_LIVE)
-    {
-        // Status did not change and is not AC_LIVE
-        // Do nothing
-        return;
-    }
-
-    //  Check if tyre radius is not set yet
-    if (!m_readStaticData)
-    {
-        // Reset serial data to 0
-        Q_EMIT sendInitialValues();
-        Q_EMIT speedUpdated(0);
-        m_tyreRadius.frontLeft = m_acData.getTyreRadius((Wheel::FrontLeft));
-        m_tyreRadius.frontRight = m_acData.getTyreRadius(Wheel::FrontRight);
-        m_tyreRadius.rearLeft = m_acData.getTyreRadius(Wheel::RearLeft);
-        m_tyreRadius.rearRight = m_acData.getTyreRadius(Wheel::RearRight);
-        m_readStaticData = true;
-    }
-
-    m_lastSpeed = m_speed;
-
-    qint32 wheelAngularSpeedFL = qRound(m_acData.getWheelAngularSpeed(Wheel::FrontLeft));
-    qint32 wheelAngularSpeedFR = qRound(m_acData.getWheelAngularSpeed(Wheel::FrontRight));
-    qint32 wheelAngularSpeedRL = qRound(m_acData.getWheelAngularSpeed(Wheel::RearLeft));
-    qint32 wheelAngularSpeedRR = qRound(m_acData.getWheelAngularSpeed(Wheel::RearRight));
-
-    if ((wheelAngularSpeedFL <= 0)
-            && (wheelAngularSpeedFR <= 0)
-            && (wheelAngularSpeedRL <= 0)
-            && (wheelAngularSpeedRR <= 0))
-    {
-        m_speed = 0;
-    }
-    else
-    {
-        m_speed = qRound(m_acData.getSpeedKmh());
-    }
-
-    if (m_speed != m_lastSpeed)
-    {
-        Q_EMIT speedUpdated(m_speed);
-    }
-
-    if (Settings::getInstance()->getWheelSlipEnabled())
-    {
-        calculateWheelSlip();
-    }
-
-    if (Settings::getInstance()->getLedFlagEnabled())
-    {
-        calculateLedFlagStatus();
-    }
-
-    if (Settings::getInstance()->getWindFanEnabled())
-    {
-        calculateWindFanSpeed();
-    }
-}
-
-void TelemetryReader::readSettings()
-{
-    Settings* settings = Settings::getInstance();
-    m_brakeIndex = (static_cast<float>(100 - settings->getBrakeIndex()) / 100);
-    m_gasIndex = (static_cast<float>(settings->getGasIndex()) / 100);
-    m_bumpingIndex = settings->getBumpingIndex();
-
-    qDebug() << "BrakeIndex:" << m_brakeIndex;
-    qDebug() << "GasIndex:" << m_gasIndex;
-    qDebug() << "BumpingIndex:" << m_bumpingIndex;
-}
-
-void TelemetryReader::calculateWheelSlip()
-{
-    WheelValueInt slip = getWheelSlip();
-    WheelValueFloat calculatedSpeed = getCalculatedSpeed();
-
-    WheelSlipStatus frontLeftSlipStatus = getSlipStatus(slip.frontLeft, calculatedSpeed.frontLeft);
-    WheelSlipStatus frontRightSlipStatus = getSlipStatus(slip.frontRight, calculatedSpeed.frontRight);
-    WheelSlipStatus rearLeftSlipStatus = getSlipStatus(slip.rearLeft, calculatedSpeed.rearLeft);
-    WheelSlipStatus rearRightSlipStatus = getSlipStatus(slip.rearRight, calculatedSpeed.rearRight);
-
-    // Check for bumping effect
-    bool bumping = false;
-    bumping |= (m_acData.getWheelLoad(Wheel::FrontLeft) == 0.0f);
-    bumping |= (m_acData.getWheelLoad(Wheel::FrontRight) == 0.0f);
-    bumping |= (m_acData.getWheelLoad(Wheel::RearLeft) == 0.0f);
-    bumping |= (m_acData.getWheelLoad(Wheel::RearRight) == 0.0f);
-    if (m_lastBumping != bumping)
-    {
-        Q_EMIT setBumpingState(bumping);
-        m_lastBumping = bumping;
-    }
-
-    m_maxBrakeValue = 0;
-    m_maxGasValue = 0;
-
-    switch (frontLeftSlipStatus)
-    {
-    case SlippingFromBraking:
-    {
-        if (slip.frontLeft > m_maxBrakeValue)
-        {
-            m_maxBrakeValue = slip.frontLeft;
-        }
-
-        break;
-    }
-    case SlippingFromGas:
-    {
-        if (slip.frontLeft > m_maxGasValue)
-        {
-            m_maxGasValue = slip.frontLeft;
-        }
-
-        break;
-    }
-    case NotSlipping:
-        break;
-    }
-
-    if (m_oldFrontLeftSlipStatus != frontLeftSlipStatus)
-    {
-        Q_EMIT frontLeftStatusUpdated(frontLeftSlipStatus);
-        m_oldFrontLeftSlipStatus = frontLeftSlipStatus;
-    }
-
-    switch (frontRightSlipStatus)
-    {
-    case SlippingFromBraking:
-    {
-        if (slip.frontRight > m_maxBrakeValue)
-        {
-            m_maxBrakeValue = slip.frontRight;
-        }
-
-        break;
-    }
-    case SlippingFromGas:
-    {
-        if (slip.frontRight > m_maxGasValue)
-        {
-            m_maxGasValue = slip.frontRight;
-        }
-
-        break;
-    }
-    case NotSlipping:
-        break;
-    }
-
-    if (m_oldFrontRightSlipStatus != frontRightSlipStatus)
-    {
-        Q_EMIT frontRightStatusUpdated(frontRightSlipStatus);
-        m_oldFrontRightSlipStatus = frontRightSlipStatus;
-    }
-
-    switch (rearLeftSlipStatus)
-    {
-    case SlippingFromBraking:
-    {
-        if (slip.rearLeft > m_maxBrakeValue)
-        {
-            m_maxBrakeValue = slip.rearLeft;
-        }
-
-        break;
-    }
-    case SlippingFromGas:
-    {
-        if (slip.rearLeft > m_maxGasValue)
-        {
-            m_maxGasValue = slip.rearLeft;
-        }
-
-        break;
-    }
-    case NotSlipping:
-        break;
-    }
-
-    if (m_oldRearLeftSlipStatus != rearLeftSlipStatus)
-    {
-        Q_EMIT rearLeftStatusUpdated(rearLeftSlipStatus);
-        m_oldRearLeftSlipStatus = rearLeftSlipStatus;
-    }
-
-    switch (rearRightSlipStatus)
-    {
-    case SlippingFromBraking:
-    {
-        if (slip.rearRight > m_maxBrakeValue)
-        {
-            m_maxBrakeValue = slip.rearRight;
-        }
-
-        break;
-    }
-    case SlippingFromGas:
-    {
-        if (slip.rearRight > m_maxGasValue)
-        {
-            m_maxGasValue = slip.rearRight;
-        }
-
-        break;
-    }
-    case NotSlipping:
-        break;
-    }
-
-    if (m_oldRearRightSlipStatus != rearRightSlipStatus)
-    {
-        Q_EMIT rearRightStatusUpdated(rearRightSlipStatus);
-        m_oldRearRightSlipStatus = rearRightSlipStatus;
-    }
-
-    // Let everything vibrate a bit if bumping was detected
-    if (bumping)
-    {
-        if (m_maxBrakeValue < m_bumpingIndex)
-        {
-            m_maxBrakeValue = m_bumpingIndex;
-        }
-
-        if (m_maxGasValue < m_bumpingIndex)
-        {
-            m_maxGasValue = m_bumpingIndex;
-        }
-    }
-
-    // Only send if something has changed
-    if (dataChanged())
-    {
-        quint8 gasValue = static_cast<quint8>(qBound(0, m_maxGasValue, 127));
-        quint8 brakeValue = static_cast<quint8>(qBound(0, m_maxBrakeValue, 127));
-
-        Q_EMIT sendWheelSlipValues(gasValue, brakeValue);
-    }
-
-    // Save current values for comparison with future values
-    m_lastMaxBrakeValue = m_maxBrakeValue;
-    m_lastMaxGasValue = m_maxGasValue;
-}
-
-bool TelemetryReader::dataChanged()
-{
-    return ((m_lastMaxBrakeValue != m_maxBrakeValue) || (m_lastMaxGasValue != m_maxGasValue));
-}
-
-WheelValueInt TelemetryReader::getWheelSlip()
-{
-    WheelValueInt slip;
-    slip.frontLeft = static_cast<qint32>(m_acData.getWheelSlip(Wheel::FrontLeft));
-    slip.frontRight = static_cast<qint32>(m_acData.getWheelSlip(Wheel::FrontRight));
-    slip.rearLeft = static_cast<qint32>(m_acData.getWheelSlip(Wheel::RearLeft));
-    slip.rearRight = static_cast<qint32>(m_acData.getWheelSlip(Wheel::RearRight));
-
-    // Be sure to stay between 0 and 255
-    slip.frontLeft = qBound(0, slip.frontLeft, 255);
-    slip.frontRight = qBound(0, slip.frontRight, 255);
-    slip.rearLeft = qBound(0, slip.rearLeft, 255);
-    slip.rearRight = qBound(0, slip.rearRight, 255);
-
-    return slip;
-}
-
-float TelemetryReader::calculateSpeed(float tyreRadius, float wheelAngularSpeed)
-{
-    return ((2 * tyreRadius * static_cast<float>(M_PI) * wheelAngularSpeed * 60) / 100);
-}
-
-WheelValueFloat TelemetryReader::getCalculatedSpeed()
-{
-    WheelValueFloat calculatedSpeed;
-    calculatedSpeed.frontLeft = calculateSpeed(m_tyreRadius.frontLeft, m_acData.getWheelAngularSpeed(Wheel::FrontLeft));
-    calculatedSpeed.frontRight = calculateSpeed(m_tyreRadius.frontRight, m_acData.getWheelAngularSpeed(Wheel::FrontRight));
-    calculatedSpeed.rearLeft = calculateSpeed(m_tyreRadius.rearLeft, m_acData.getWheelAngularSpeed(Wheel::RearLeft));
-    calculatedSpeed.rearRight = calculateSpeed(m_tyreRadius.rearRight, m_acData.getWheelAngularSpeed(Wheel::RearRight));
-    return calculatedSpeed;
-}
-
-WheelSlipStatus TelemetryReader::getSlipStatus(float slipValue, float calculatedSpeed)
-{
-    if (slipValue == 0.0f)
-    {
-        return NotSlipping;
-    }
-    else
-    {
-        qDebug() << "SlipValue:" << slipValue << "| calculated speed:" << calculatedSpeed << "| speed:" << m_speed << "| brakeIndex:" << m_brakeIndex;
-        qDebug() << "speed*brakeIndex =" << (m_speed * m_brakeIndex);
-
-        if (calculatedSpeed < (m_speed * m_brakeIndex))
-        {
-            return SlippingFromBraking;
-        }
-        else if (calculatedSpeed > (m_speed * m_gasIndex))
-        {
-            return SlippingFromGas;
-        }
-    }
-
-    return NotSlipping;
-}
-
-void TelemetryReader::calculateLedFlagStatus()
-{
-    AC_FLAG_TYPE flagStatus =  m_acData.getFlagStatus();
-    if (flagStatus == m_lastFlagStatus)
-    {
-        return;
-    }
-
-    Q_EMIT flagStatusUpdated(flagStatus);
-    m_lastFlagStatus = flagStatus;
-
-    quint8 flagValue = 0;
-    switch (flagStatus)
-    {
-    case AC_BLUE_FLAG:
-        flagValue = 1;
-        break;
-    case AC_YELLOW_FLAG:
-        flagValue = 2;
-        break;
-    case AC_BLACK_FLAG:
-        flagValue = 3;
-        break;
-    case AC_WHITE_FLAG:
-        flagValue = 4;
-        break;
-    case AC_CHECKERED_FLAG:
-        flagValue = 5;
-        break;
-    case AC_PENALTY_FLAG:
-        flagValue = 6;
-        break;
-    case AC_NO_FLAG:
-    default:
-        break;
-    }
-
-    Q_EMIT sendLedFlagValue(flagValue);
-}
-
-void TelemetryReader::calculateWindFanSpeed()
-{
-    if (m_speed != m_lastSpeed)
-    {
-        quint8 windFanValue = static_cast<quint8>(qBound(0, ((m_speed / 3) * 2), 127));
-        if (m_lastWindFanValue != windFanValue)
-        {
-            m_lastWindFanValue = windFanValue;
-            //TODO add adjustable parameter for speed sensitivity
-            Q_EMIT sendWindFanValue(windFanValue);
-        }
-    }
-}
+#include "telemetryreader.h"
+#include <QDebug>
+#include <QtMath>
+#include <QString>
+#include <QChar>
+#include <QProcess>
+#include <QBuffer>
+#include <QDataStream>
+#include <QtEndian>
+#include <QDir>
+#include <QDateTime>
+#include "settings.h"
+#include "sender.h"
+
+static const qint64 STANDBY_PERIOD_NS = 1000000000;
+
+static void configureFilter(FilterChain &filter, const QString &description, float sampleRate, const char* name)
+{
+    if (!filter.configure(description, sampleRate))
+    {
+        qWarning() << "Invalid" << name << "filter" << description << "- output is not filtered";
+    }
+}
+
+
+TelemetryReader::TelemetryReader(TelemetryBackend* backend, QObject *parent)
+    : QObject(parent)
+    , m_acquisitionThread(this)
+    , m_standbyPeriod(STANDBY_PERIOD_NS)
+    , m_livePeriod(0)
+    , m_acData(backend)
+    , m_lastStatus(AC_OFF)
+    , m_readStaticData(false)
+    , m_speed(0)
+    , m_lastSpeed(0)
+    , m_lastBumping(false)
+{
+    Settings* settings = Settings::getInstance();
+    (void)connect(settings, &Settings::gasIndexChanged, this, &TelemetryReader::onGasIndexChanged);
+    (void)connect(settings, &Settings::brakeIndexChanged, this, &TelemetryReader::onBrakeIndexChanged);
+    (void)connect(settings, &Settings::bumpingIndexChanged, this, &TelemetryReader::onBumpingIndexChanged);
+    (void)connect(settings, &Settings::windFanIndexChanged, this, &TelemetryReader::onWindFanIndexChanged);
+    (void)connect(settings, &Settings::wheelSlipEnabledChanged, this, &TelemetryReader::onEffectsEnabledChanged);
+    (void)connect(settings, &Settings::windFanEnabledChanged, this, &TelemetryReader::onEffectsEnabledChanged);
+    (void)connect(settings, &Settings::ledFlagEnabledChanged, this, &TelemetryReader::onEffectsEnabledChanged);
+
+    m_acquisitionThread.setPeriod(m_standbyPeriod);
+}
+
+TelemetryReader::~TelemetryReader()
+{
+    m_acquisitionThread.stop();
+    m_recorder.stopRecording();
+    m_slipCalibration.save();
+    (void)disconnect(this);
+}
+
+void TelemetryReader::run()
+{
+    if (m_livePeriod == 0)
+    {
+        qDebug() << "Cannot start acquisition thread. No update rate set";
+        return;
+    }
+
+    // Initially read settings once
+    // Changes will be notified by signals from the settings
+    readSettings();
+
+    Settings* settings = Settings::getInstance();
+    m_acquisitionThread.setCpuAffinity(settings->getAcquisitionCpu());
+    m_acquisitionThread.setRealtimePriority(settings->getRealtimePriority());
+    m_packetDriven = settings->getPacketDrivenAcquisition();
+    m_recordingDirectory = settings->getRecordingDirectory();
+    m_compressRecordings = settings->getCompressRecordings();
+    m_acquisitionThread.setPeriod((m_lastStatus == AC_LIVE) ? m_livePeriod : m_standbyPeriod);
+    m_acquisitionThread.start();
+    qDebug() << "Started acquisition thread";
+}
+
+void TelemetryReader::stop()
+{
+    m_acquisitionThread.stop();
+    m_recorder.stopRecording();
+    qDebug() << "Stopped acquisition thread";
+}
+
+void TelemetryReader::setUpdatesPerSecond(qint32 ups)
+{
+    if (ups <= 0)
+    {
+        m_livePeriod = 0;
+        return;
+    }
+
+    m_livePeriod = 1000000000 / ups;
+    if (m_lastStatus == AC_LIVE)
+    {
+        m_acquisitionThread.setPeriod(m_livePeriod);
+    }
+}
+
+void TelemetryReader::setSender(Sender* sender)
+{
+    m_sender = sender;
+}
+
+qint32 TelemetryReader::currentPacketId() const
+{
+    return m_acData.getPacketId();
+}
+
+bool TelemetryReader::isSourceOpen() const
+{
+    return m_acData.isOpen();
+}
+
+void TelemetryReader::reportFrameStatistics()
+{
+    qDebug() << "Frames processed:" << m_framesProcessed << "| skipped:" << m_skippedFrames << "| duplicates:" << m_duplicateFrames;
+    qDebug() << "Wheel slip writes:" << m_outputStatistics.wheelSlipWrites << "| unfiltered:" << m_outputStatistics.unfilteredWheelSlipWrites;
+    qDebug() << "Wind fan writes:" << m_outputStatistics.windFanWrites << "| unfiltered:" << m_outputStatistics.unfilteredWindFanWrites;
+    if (m_predictor.lead() > 0)
+    {
+        qDebug() << "Prediction error:" << m_predictor.statistics().summary();
+    }
+}
+
+OutputStatistics TelemetryReader::outputStatistics() const
+{
+    return m_outputStatistics;
+}
+
+const SlipCalibration &TelemetryReader::slipCalibration() const
+{
+    return m_slipCalibration;
+}
+
+PredictionStatistics TelemetryReader::predictionStatistics() const
+{
+    return m_predictor.statistics();
+}
+
+bool TelemetryReader::takeDashboardState(DashboardState &state)
+{
+    return m_dashboard.take(state);
+}
+
+void TelemetryReader::onGasIndexChanged()
+{
+    qint32 newIndex = Settings::getInstance()->getGasIndex();
+    m_gasIndex = (static_cast<float>(newIndex) / 100);
+}
+
+void TelemetryReader::onBrakeIndexChanged()
+{
+    qint32 newIndex = Settings::getInstance()->getBrakeIndex();
+    m_brakeIndex = (static_cast<float>(100 - newIndex) / 100);
+}
+
+void TelemetryReader::onBumpingIndexChanged()
+{
+    m_bumpingIndex = Settings::getInstance()->getBumpingIndex();
+}
+
+void TelemetryReader::onWindFanIndexChanged()
+{
+    m_windFanIndex = Settings::getInstance()->getWindFanIndex();
+}
+
+void TelemetryReader::onEffectsEnabledChanged()
+{
+    updateActiveOutputs();
+}
+
+void TelemetryReader::readData(qint64 timestampNs)
+{
+    processFrame(timestampNs);
+
+    // Hand the display values to the UI thread. If it did not pick up the
+    // previous state yet, that state is simply replaced.
+    if (m_dashboardChanged)
+    {
+        m_dashboardChanged = false;
+        if (m_dashboard.push(m_dashboardState))
+        {
+            Q_EMIT dashboardUpdated();
+        }
+    }
+}
+
+void TelemetryReader::processFrame(qint64 timestampNs)
+{
+    m_acData.update();
+    if (!m_acData.isOpen())
+    {
+        // Tried again with the next frame
+        return;
+    }
+
+    // Take one consistent copy of the current physics step,
+    // everything below works on this copy only
+    if (m_recorder.isRecording())
+    {
+        if (m_acData.readFrame(m_frame, &m_recordPhysics, &m_recordGraphics))
+        {
+            m_recorder.record(timestampNs, m_recordPhysics, m_recordGraphics, m_acData);
+        }
+    }
+    else
+    {
+        (void)m_acData.readFrame(m_frame);
+    }
+
+    m_frame.timestampNs = timestampNs;
+
+    AC_STATUS status = m_frame.status;
+    if (status != m_lastStatus)
+    {
+        Q_EMIT setStatus(status);
+
+        if (m_lastStatus == AC_LIVE)
+        {
+            qDebug() << "Snapshot retries:" << m_acData.getSnapshotRetries() << "| failures:" << m_acData.getSnapshotFailures();
+            reportFrameStatistics();
+            // A pause continues the session and its recording
+            if (status != AC_PAUSE)
+            {
+                finishSession();
+            }
+            m_acquisitionThread.setPacketDriven(false);
+            m_acquisitionThread.setPeriod(m_standbyPeriod);
+            m_lastStatus = status;
+            sendInitial();
+            setDashboardSpeed(0);
+            return;
+        }
+        else if (status == AC_LIVE)
+        {
+            if (m_livePeriod > 0)
+            {
+                m_acquisitionThread.setPeriod(m_livePeriod);
+            }
+
+            // Watch the physics packet id only while live, it does not
+            // change in the other states
+            m_acquisitionThread.setPacketDriven(m_packetDriven);
+            m_frameCountStarted = false;
+            if (!m_sessionActive)
+            {
+                startSession();
+            }
+
+            for (FilterChain &filter : m_filters)
+            {
+                filter.reset();
+            }
+            m_predictor.reset();
+
+            // Reset wheel slip states when switching to live state
+            for (qint32 i = 0; i < WHEEL_COUNT; ++i)
+            {
+                setDashboardSlipStatus(i, WheelSlipStatus::NotSlipping);
+            }
+        }
+        else if (m_sessionActive && (status != AC_PAUSE))
+        {
+            // Left the game from the pause
+            finishSession();
+        }
+
+        m_lastStatus = status;
+    }
+    else if (status != AC_LIVE)
+    {
+        // Status did not change and is not AC_LIVE
+        // Do nothing
+        return;
+    }
+
+    countFrame(m_frame.physicsPacketId);
+
+    //  Check if tyre radius is not set yet
+    if (!m_readStaticData)
+    {
+        sendInitial();
+        setDashboardSpeed(0);
+        m_acData.getTyreRadius(m_effectContext.tyreRadius);
+        m_acData.getSuspensionMaxTravel(m_effectContext.suspensionMaxTravel);
+        loadSlipCalibration(m_acData.getCarModel());
+        m_readStaticData = true;
+    }
+
+    // Learned only once the calibration of the car was loaded
+    m_effectContext.slipCalibration = (m_slipCalibrationEnabled && (m_calibratedSession.load(std::memory_order_acquire) == m_session))
+            ? &m_slipCalibration : nullptr;
+
+    // Work on the values expected when the output reaches the motors
+    const TelemetryFrame* frame = &m_frame;
+    if (m_predictor.lead() > 0)
+    {
+        m_predictor.predict(m_frame, m_predictedFrame);
+        frame = &m_predictedFrame;
+    }
+
+    m_lastSpeed = m_speed;
+
+    // Standing still if no wheel turns forward
+    bool rolling = false;
+    for (qint32 i = 0; i < WHEEL_COUNT; ++i)
+    {
+        rolling |= (qRound(frame->wheels.angularSpeed[i]) > 0);
+    }
+
+    if (!rolling)
+    {
+        m_speed = 0;
+    }
+    else
+    {
+        m_speed = qRound(frame->speedKmh);
+    }
+
+    if (m_speed != m_lastSpeed)
+    {
+        setDashboardSpeed(m_speed);
+    }
+
+    m_effectContext.frame = frame;
+    m_effectContext.speed = m_speed;
+    m_effectContext.brakeIndex = m_brakeIndex;
+    m_effectContext.gasIndex = m_gasIndex;
+    m_effectContext.bumpingIndex = m_bumpingIndex;
+    m_effects.evaluate(m_effectContext);
+
+    quint32 outputs = m_activeOutputs.load(std::memory_order_relaxed);
+    if ((outputs & SLIP_CLASSIFICATION) != 0)
+    {
+        updateDashboardSlip();
+    }
+
+    if ((outputs & PEDAL_OUTPUTS) != 0)
+    {
+        sendWheelSlip();
+    }
+
+    if ((outputs & WHEEL_OUTPUTS) != 0)
+    {
+        sendPerWheelSlip();
+    }
+
+    if ((outputs & LED_FLAG_OUTPUT) != 0)
+    {
+        sendLedFlag();
+    }
+
+    if ((outputs & WIND_FAN_OUTPUT) != 0)
+    {
+        sendWindFan();
+    }
+}
+
+void TelemetryReader::countFrame(qint32 packetId)
+{
+    if (m_frameCountStarted)
+    {
+        qint64 delta = static_cast<qint64>(packetId) - static_cast<qint64>(m_lastFramePacketId);
+        if (delta == 0)
+        {
+            ++m_duplicateFrames;
+        }
+        else if (delta > 1)
+        {
+            m_skippedFrames += static_cast<quint64>(delta - 1);
+        }
+    }
+
+    ++m_framesProcessed;
+    m_lastFramePacketId = packetId;
+    m_frameCountStarted = true;
+}
+
+void TelemetryReader::startSession()
+{
+    m_sessionActive = true;
+    ++m_session;
+    // The car may have changed since the last session
+    m_readStaticData = false;
+
+    // Creating the file may block, the thread of the reader does it. Called
+    // directly if the frames are fed by that thread, e.g. by a replay.
+    (void)QMetaObject::invokeMethod(this, [this]()
+    {
+        startRecording();
+    }, Qt::AutoConnection);
+}
+
+void TelemetryReader::finishSession()
+{
+    m_sessionActive = false;
+    ++m_session;
+
+    // The calibration is not used until the next session loaded it again
+    (void)QMetaObject::invokeMethod(this, [this]()
+    {
+        m_recorder.stopRecording();
+        m_slipCalibration.save();
+    }, Qt::AutoConnection);
+}
+
+void TelemetryReader::loadSlipCalibration(const QString &carModel)
+{
+    // Saving the previous car and loading this one go to the settings
+    quint32 session = m_session;
+    (void)QMetaObject::invokeMethod(this, [this, carModel, session]()
+    {
+        m_slipCalibration.setCar(carModel);
+        m_calibratedSession.store(session, std::memory_order_release);
+    }, Qt::AutoConnection);
+}
+
+void TelemetryReader::startRecording()
+{
+    if (m_recordingDirectory.isEmpty())
+    {
+        return;
+    }
+
+    QDir directory(m_recordingDirectory);
+    if (!directory.exists() && !directory.mkpath("."))
+    {
+        qWarning() << "Cannot create recording directory" << m_recordingDirectory;
+        return;
+    }
+
+    QString fileName = QString("session-%1.pvrec").arg(QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss"));
+    m_recorder.startRecording(directory.filePath(fileName), m_compressRecordings);
+}
+
+void TelemetryReader::setDashboardSpeed(qint32 speed)
+{
+    m_dashboardState.speed = speed;
+    m_dashboardChanged = true;
+}
+
+void TelemetryReader::setDashboardSlipStatus(qint32 wheel, WheelSlipStatus status)
+{
+    m_dashboardState.slipStatus[wheel] = status;
+    m_dashboardChanged = true;
+}
+
+void TelemetryReader::readSettings()
+{
+    Settings* settings = Settings::getInstance();
+    m_brakeIndex = (static_cast<float>(100 - settings->getBrakeIndex()) / 100);
+    m_gasIndex = (static_cast<float>(settings->getGasIndex()) / 100);
+    m_bumpingIndex = settings->getBumpingIndex();
+
+    qDebug() << "BrakeIndex:" << m_brakeIndex.load();
+    qDebug() << "GasIndex:" << m_gasIndex.load();
+    qDebug() << "BumpingIndex:" << m_bumpingIndex.load();
+
+    // The filters run once per tick, which is once per physics step if
+    // the acquisition is packet driven
+    float sampleRate = static_cast<float>(settings->getPacketDrivenAcquisition() ? MAX_UPS : settings->getUps());
+    m_effectContext.sampleRate = sampleRate;
+    configureFilter(m_filters[GasChannel], settings->getGasFilter(), sampleRate, "gas");
+    configureFilter(m_filters[BrakeChannel], settings->getBrakeFilter(), sampleRate, "brake");
+    configureFilter(m_filters[WindFanChannel], settings->getWindFanFilter(), sampleRate, "wind fan");
+    for (qint32 i = 0; i < WHEEL_COUNT; ++i)
+    {
+        configureFilter(m_filters[wheelChannel(i)], settings->getWheelFilter(), sampleRate, "wheel");
+    }
+
+    m_effectContext.absFrequency = static_cast<float>(settings->getAbsFrequency());
+    m_effectContext.absIntensity = settings->getAbsIntensity();
+    m_effectContext.tcFrequency = static_cast<float>(settings->getTcFrequency());
+    m_effectContext.tcIntensity = settings->getTcIntensity();
+    m_effectContext.roadTextureIntensity = settings->getRoadTextureIntensity();
+    m_effectContext.roadTextureMinFrequency = static_cast<float>(settings->getRoadTextureMinFrequency());
+    m_effectContext.roadTextureMaxFrequency = static_cast<float>(settings->getRoadTextureMaxFrequency());
+    if ((m_effectContext.roadTextureIntensity > 0) && ((2.0f * m_effectContext.roadTextureMaxFrequency) > sampleRate))
+    {
+        qWarning() << "Road texture band up to" << m_effectContext.roadTextureMaxFrequency << "Hz is above half the update rate of"
+                   << sampleRate << "Hz - the part above is not detected";
+    }
+
+    m_predictor.setLead(static_cast<qint64>(settings->getPredictionLead()) * 1000000);
+    m_slipCalibrationEnabled = settings->getSlipCalibration();
+    m_perWheelSlip = settings->getPerWheelSlip();
+    updateActiveOutputs();
+}
+
+void TelemetryReader::updateActiveOutputs()
+{
+    Settings* settings = Settings::getInstance();
+    quint32 outputs = 0;
+    if (settings->getWheelSlipEnabled())
+    {
+        // The dashboard shows the slip status in both modes
+        outputs |= (m_perWheelSlip ? WHEEL_OUTPUTS : PEDAL_OUTPUTS) | SLIP_CLASSIFICATION;
+    }
+
+    if (settings->getWindFanEnabled())
+    {
+        outputs |= WIND_FAN_OUTPUT;
+    }
+
+    if (settings->getLedFlagEnabled())
+    {
+        outputs |= LED_FLAG_OUTPUT;
+    }
+
+    // For a tick the reader may send an output the engine did not evaluate
+    // yet, it is 0 then
+    m_effects.setActiveOutputs(outputs);
+    m_activeOutputs.store(outputs, std::memory_order_relaxed);
+}
+
+bool TelemetryReader::updateChannel(EffectChannel channel, bool &rawChanged)
+{
+    qint32 value = qBound(0, m_effectContext.channels[channel], 127);
+    rawChanged |= (value != m_rawValues[channel]);
+    m_rawValues[channel] = value;
+
+    value = qBound(0, m_filters[channel].process(value), 127);
+    bool changed = (value != m_sentValues[channel]);
+    m_sentValues[channel] = value;
+    return changed;
+}
+
+void TelemetryReader::updateDashboardSlip()
+{
+    bool bumping = m_effectContext.bumping;
+    if (m_lastBumping != bumping)
+    {
+        m_dashboardState.bumping = bumping;
+        m_dashboardChanged = true;
+        m_lastBumping = bumping;
+    }
+
+    for (qint32 i = 0; i < WHEEL_COUNT; ++i)
+    {
+        WheelSlipStatus slipStatus = static_cast<WheelSlipStatus>(m_effectContext.slip.status[i]);
+        if (m_lastSlipStatus[i] != slipStatus)
+        {
+            setDashboardSlipStatus(i, slipStatus);
+            m_lastSlipStatus[i] = slipStatus;
+        }
+    }
+}
+
+void TelemetryReader::sendWheelSlip()
+{
+    bool rawChanged = false;
+    bool changed = updateChannel(GasChannel, rawChanged);
+    changed |= updateChannel(BrakeChannel, rawChanged);
+
+    if (rawChanged)
+    {
+        ++m_outputStatistics.unfilteredWheelSlipWrites;
+    }
+
+    // Only send if something has changed
+    if (changed)
+    {
+        ++m_outputStatistics.wheelSlipWrites;
+        quint8 gasValue = static_cast<quint8>(m_sentValues[GasChannel]);
+        quint8 brakeValue = static_cast<quint8>(m_sentValues[BrakeChannel]);
+        if (m_sender != nullptr)
+        {
+            m_sender->sendWheelSlipValues(gasValue, brakeValue);
+        }
+        Q_EMIT sendWheelSlipValues(gasValue, brakeValue);
+    }
+}
+
+void TelemetryReader::sendPerWheelSlip()
+{
+    qint32 gasMask = 0;
+    for (qint32 i = 0; i < WHEEL_COUNT; ++i)
+    {
+        if (m_effectContext.slip.status[i] == SlippingFromGas)
+        {
+            gasMask |= (1 << i);
+        }
+    }
+
+    bool rawChanged = (gasMask != m_lastRawGasMask);
+    bool changed = (gasMask != m_lastGasMask);
+    for (qint32 i = 0; i < WHEEL_COUNT; ++i)
+    {
+        changed |= updateChannel(wheelChannel(i), rawChanged);
+    }
+
+    if (rawChanged)
+    {
+        ++m_outputStatistics.unfilteredWheelSlipWrites;
+        m_lastRawGasMask = gasMask;
+    }
+
+    // All wheels go out in one packet, only if something has changed
+    if (changed)
+    {
+        ++m_outputStatistics.wheelSlipWrites;
+        quint8 frontLeft = static_cast<quint8>(m_sentValues[FrontLeftChannel]);
+        quint8 frontRight = static_cast<quint8>(m_sentValues[FrontRightChannel]);
+        quint8 rearLeft = static_cast<quint8>(m_sentValues[RearLeftChannel]);
+        quint8 rearRight = static_cast<quint8>(m_sentValues[RearRightChannel]);
+        if (m_sender != nullptr)
+        {
+            m_sender->sendPerWheelSlipValues(static_cast<quint8>(gasMask), frontLeft, frontRight, rearLeft, rearRight);
+        }
+        Q_EMIT sendPerWheelSlipValues(static_cast<quint8>(gasMask), frontLeft, frontRight, rearLeft, rearRight);
+        m_lastGasMask = gasMask;
+    }
+}
+
+void TelemetryReader::sendLedFlag()
+{
+    AC_FLAG_TYPE flagStatus = m_frame.flag;
+    if (flagStatus != m_lastFlagStatus)
+    {
+        Q_EMIT flagStatusUpdated(flagStatus);
+        m_lastFlagStatus = flagStatus;
+    }
+
+    bool rawChanged = false;
+    if (updateChannel(LedFlagChannel, rawChanged))
+    {
+        quint8 value = static_cast<quint8>(m_sentValues[LedFlagChannel]);
+        if (m_sender != nullptr)
+        {
+            m_sender->sendLedFlagValue(value);
+        }
+        Q_EMIT sendLedFlagValue(value);
+    }
+}
+
+void TelemetryReader::sendWindFan()
+{
+    bool rawChanged = false;
+    bool changed = updateChannel(WindFanChannel, rawChanged);
+    if (rawChanged)
+    {
+        ++m_outputStatistics.unfilteredWindFanWrites;
+    }
+
+    if (changed)
+    {
+        ++m_outputStatistics.windFanWrites;
+        quint8 value = static_cast<quint8>(m_sentValues[WindFanChannel]);
+        if (m_sender != nullptr)
+        {
+            m_sender->sendWindFanValue(value);
+        }
+        Q_EMIT sendWindFanValue(value);
+    }
+}
+
+void TelemetryReader::sendInitial()
+{
+    // Reset serial data to 0
+    if (m_sender != nullptr)
+    {
+        m_sender->sendInitialValues(m_perWheelSlip);
+    }
+    Q_EMIT sendInitialValues();
+}
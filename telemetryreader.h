@@ -1,89 +1,192 @@
-#ifndef TELEMETRYREADER_122A5A0D4A0B4698AA1164390F74EBFE
-#define TELEMETRYREADER_122A5A0D4A0B4698AA1164390F74EBFE
-
-#include <QObject>
-#include <QTimer>
-#include "assettocorsadata.h"
-#include "globals.h"
-
-
-class TelemetryReader : public QObject
-{
-    Q_OBJECT
-public:
-    explicit TelemetryReader(QObject *parent = nullptr);
-    ~TelemetryReader();
-
-    void run();
-    void stop();
-
-    void setUpdatesPerSecond(qint32 ups);
-
-Q_SIGNALS:
-    void setStatus(const AC_STATUS &status);
-    void setBumpingState(bool bumping);
-    void frontLeftStatusUpdated(WheelSlipStatus status);
-    void frontRightStatusUpdated(WheelSlipStatus status);
-    void rearLeftStatusUpdated(WheelSlipStatus status);
-    void rearRightStatusUpdated(WheelSlipStatus status);
-    void speedUpdated(qint32 speed);
-    void flagStatusUpdated(AC_FLAG_TYPE flagStatus);
-    void error(const QString &error);
-
-    void sendInitialValues();
-    void sendWheelSlipValues(quint8 gasValue, quint8 brakeValue);
-    void sendWindFanValue(quint8 windFanValue);
-    void sendLedFlagValue(quint8 ledFlagValue);
-
-public Q_SLOTS:
-    void onGasIndexChanged();
-    void onBrakeIndexChanged();
-    void onBumpingIndexChanged();
-    void onWindFanIndexChanged();
-
-private Q_SLOTS:
-    void readData();
-
-private:
-    WheelValueInt getWheelSlip();
-    WheelValueFloat getCalculatedSpeed();
-    float calculateSpeed(float tyreRadius, float wheelAngularSpeed);
-    WheelSlipStatus getSlipStatus(float slipValue, float calculatedSpeed);
-    bool dataChanged();
-    void readSettings();
-
-    void calculateWheelSlip();
-    void calculateLedFlagStatus();
-    void calculateWindFanSpeed();
-
-    QTimer m_readTimer;
-    qint32 m_standbyInterval = 0;
-    qint32 m_liveInterval = 0;
-    AssettoCorsaData m_acData;
-    AC_STATUS m_lastStatus;
-
-    bool m_readStaticData = false;
-    WheelValueFloat m_tyreRadius;
-    float m_brakeIndex = 0.0f;
-    float m_gasIndex = 0.0f;
-    qint32 m_bumpingIndex = 0;
-    qint32 m_windFanIndex = 0;
-    qint32 m_speed = 0;
-    qint32 m_lastSpeed = 0;
-    quint8 m_lastWindFanValue = 0;
-    bool m_lastBumping = false;
-    AC_FLAG_TYPE m_lastFlagStatus = AC_NO_FLAG;
-
-    WheelSlipStatus m_oldFrontLeftSlipStatus = NotSlipping;
-    WheelSlipStatus m_oldFrontRightSlipStatus = NotSlipping;
-    WheelSlipStatus m_oldRearLeftSlipStatus = NotSlipping;
-    WheelSlipStatus m_oldRearRightSlipStatus = NotSlipping;
-
-    qint32 m_maxBrakeValue = 0;
-    qint32 m_lastMaxBrakeValue = 0;
-    qint32 m_maxGasValue = 0;
-    qint32 m_lastMaxGasValue = 0;
-
-};
-
-#endif // TELEMETRYREADER_122A5A0D4A0B4698AA1164390F74EBFE
+#ifndef TELEMETRYREADER_122A5A0D4A0B4698AA1164390F74EBFE
+#define TELEMETRYREADER_122A5A0D4A0B4698AA1164390F74EBFE
+
+#include <QObject>
+#include <atomic>
+#include "assettocorsadata.h"
+#include "telemetryframe.h"
+#include "acquisitionthread.h"
+#include "conflatingqueue.h"
+#include "telemetryrecorder.h"
+#include "filterchain.h"
+#include "effects.h"
+#include "slipcalibration.h"
+#include "outputpredictor.h"
+#include "globals.h"
+
+class Sender;
+
+// Values shown by the main window, handed over from the acquisition thread
+struct DashboardState
+{
+    qint32 speed = 0;
+    WheelSlipStatus slipStatus[WHEEL_COUNT] = {NotSlipping, NotSlipping, NotSlipping, NotSlipping};
+    bool bumping = false;
+};
+
+// Serial writes of the effects, as sent and as they would have been sent
+// without the output filters
+struct OutputStatistics
+{
+    quint64 wheelSlipWrites = 0;
+    quint64 unfilteredWheelSlipWrites = 0;
+    quint64 windFanWrites = 0;
+    quint64 unfilteredWindFanWrites = 0;
+};
+
+
+class TelemetryReader : public QObject
+{
+    Q_OBJECT
+public:
+    // Takes ownership of the backend, the shared memory of the game is used
+    // if none is given
+    explicit TelemetryReader(TelemetryBackend* backend = nullptr, QObject *parent = nullptr);
+    ~TelemetryReader();
+
+    void run();
+    void stop();
+
+    // Done by run(), has to be called before frames are fed to readData()
+    // without the acquisition thread, e.g. by a replay
+    void readSettings();
+
+    void setUpdatesPerSecond(qint32 ups);
+
+    // The acquisition thread hands the values straight to the sender, they
+    // do not go through the event loop of another thread. Has to be set
+    // before run().
+    void setSender(Sender* sender);
+
+    // Called by the acquisition thread once per tick
+    void readData(qint64 timestampNs);
+
+    // Called by the acquisition thread to detect new physics steps
+    qint32 currentPacketId() const;
+    // False until the telemetry pages are mapped, readData() keeps trying
+    bool isSourceOpen() const;
+    void reportFrameStatistics();
+
+    // Returns false if the state did not change since it was taken last
+    bool takeDashboardState(DashboardState &state);
+
+    OutputStatistics outputStatistics() const;
+
+    // Only to be read while the acquisition thread is not running
+    const SlipCalibration &slipCalibration() const;
+    PredictionStatistics predictionStatistics() const;
+
+Q_SIGNALS:
+    void setStatus(const AC_STATUS &status);
+    void dashboardUpdated();
+    void flagStatusUpdated(AC_FLAG_TYPE flagStatus);
+    void error(const QString &error);
+
+    // Emitted from the acquisition thread next to the call of the sender,
+    // for observers such as the replay command
+    void sendInitialValues();
+    void sendWheelSlipValues(quint8 gasValue, quint8 brakeValue);
+    // Bit n of gasMask is set if wheel n slips from gas, otherwise it slips
+    // from braking or not at all
+    void sendPerWheelSlipValues(quint8 gasMask, quint8 frontLeft, quint8 frontRight, quint8 rearLeft, quint8 rearRight);
+    void sendWindFanValue(quint8 windFanValue);
+    void sendLedFlagValue(quint8 ledFlagValue);
+
+public Q_SLOTS:
+    void onGasIndexChanged();
+    void onBrakeIndexChanged();
+    void onBumpingIndexChanged();
+    void onWindFanIndexChanged();
+    void onEffectsEnabledChanged();
+
+private:
+    void processFrame(qint64 timestampNs);
+    void countFrame(qint32 packetId);
+    // A session lasts from AC_LIVE until the game leaves it for anything
+    // but AC_PAUSE. The file and settings work of its start and end is done
+    // by the thread of the reader, not the acquisition thread.
+    void startSession();
+    void finishSession();
+    void loadSlipCalibration(const QString &carModel);
+    void startRecording();
+    void setDashboardSpeed(qint32 speed);
+    void setDashboardSlipStatus(qint32 wheel, WheelSlipStatus status);
+    void updateActiveOutputs();
+    bool updateChannel(EffectChannel channel, bool &rawChanged);
+
+    void updateDashboardSlip();
+    void sendWheelSlip();
+    void sendPerWheelSlip();
+    void sendLedFlag();
+    void sendWindFan();
+    void sendInitial();
+
+    AcquisitionThread m_acquisitionThread;
+    Sender* m_sender = nullptr;
+    qint64 m_standbyPeriod = 0;
+    qint64 m_livePeriod = 0;
+    AssettoCorsaData m_acData;
+    TelemetryFrame m_frame;
+    // Copy of m_frame a lead time ahead, used if the prediction is on
+    OutputPredictor m_predictor;
+    TelemetryFrame m_predictedFrame;
+    AC_STATUS m_lastStatus;
+    bool m_packetDriven = false;
+
+    // Session recording, the pages are copied here before being queued
+    TelemetryRecorder m_recorder;
+    QString m_recordingDirectory;
+    bool m_compressRecordings = true;
+    SPageFilePhysics m_recordPhysics;
+    SPageFileGraphic m_recordGraphics;
+
+    // Physics steps that were never seen or were processed more than once
+    bool m_frameCountStarted = false;
+    qint32 m_lastFramePacketId = 0;
+    quint64 m_framesProcessed = 0;
+    quint64 m_skippedFrames = 0;
+    quint64 m_duplicateFrames = 0;
+
+    bool m_sessionActive = false;
+    // Counted up when a session starts and when it ends
+    quint32 m_session = 0;
+    bool m_readStaticData = false;
+    // Written by the settings slots on the UI thread
+    std::atomic<float> m_brakeIndex {0.0f};
+    std::atomic<float> m_gasIndex {0.0f};
+    std::atomic<qint32> m_bumpingIndex {0};
+    std::atomic<qint32> m_windFanIndex {0};
+    qint32 m_speed = 0;
+    qint32 m_lastSpeed = 0;
+    bool m_lastBumping = false;
+    AC_FLAG_TYPE m_lastFlagStatus = AC_NO_FLAG;
+
+    WheelSlipStatus m_lastSlipStatus[WHEEL_COUNT] = {NotSlipping, NotSlipping, NotSlipping, NotSlipping};
+
+    // Effects and the outputs routed to an enabled device
+    RegisteredEffects m_effects;
+    EffectContext m_effectContext;
+    std::atomic<quint32> m_activeOutputs {0};
+    bool m_perWheelSlip = false;
+    SlipCalibration m_slipCalibration;
+    bool m_slipCalibrationEnabled = false;
+    // Set by the thread of the reader to the session whose car it loaded,
+    // the calibration is only used while that session lasts
+    std::atomic<quint32> m_calibratedSession {0};
+
+    // Filters between the effects and the sender, configured by readSettings().
+    // The raw values are the ones before filtering, only used for statistics.
+    FilterChain m_filters[EFFECT_CHANNEL_COUNT];
+    qint32 m_rawValues[EFFECT_CHANNEL_COUNT] = {};
+    qint32 m_sentValues[EFFECT_CHANNEL_COUNT] = {};
+    qint32 m_lastRawGasMask = 0;
+    qint32 m_lastGasMask = 0;
+    OutputStatistics m_outputStatistics;
+
+    DashboardState m_dashboardState;
+    bool m_dashboardChanged = false;
+    ConflatingQueue<DashboardState> m_dashboard;
+
+};
+
+#endif // TELEMETRYREADER_122A5A0D4A0B4698AA1164390F74EBFE
@@ -0,0 +1,439 @@
+#include "telemetryrecorder.h"
+#include <QDebug>
+#include <cstring>
+#include "assettocorsadata.h"
+
+// The file grows and is mapped in chunks of this size
+static const qint64 MAP_CHUNK_SIZE = 16 * 1024 * 1024;
+
+// A key frame with an index entry is written at least once per second
+static const qint64 TIME_INDEX_INTERVAL_NS = 1000000000;
+static const qint32 MAX_TIME_INDEX_ENTRIES = 65536;
+static const qint32 MAX_LAP_INDEX_ENTRIES = 4096;
+
+static const unsigned long WRITER_IDLE_SLEEP_MS = 2;
+
+
+TelemetryRecorder::TelemetryRecorder(QObject *parent)
+    : QThread(parent)
+    , m_recording(false)
+    , m_stopRequested(false)
+{
+
+}
+
+TelemetryRecorder::~TelemetryRecorder()
+{
+    stopRecording();
+    wait();
+}
+
+void TelemetryRecorder::startRecording(const QString &path, bool compress)
+{
+    if (m_recording.load())
+    {
+        stopRecording();
+    }
+
+    // Let a previous recording finish writing its index
+    wait();
+
+    m_path = path;
+    m_compress = compress;
+    m_firstItem = true;
+    m_queuedItems = 0;
+    m_droppedItems = 0;
+    m_stopRequested.store(false);
+    m_recording.store(true);
+    start();
+}
+
+void TelemetryRecorder::stopRecording()
+{
+    if (m_recording.load())
+    {
+        m_recording.store(false);
+        m_stopRequested.store(true);
+        qDebug() << "Recorder queued" << m_queuedItems << "items, dropped" << m_droppedItems;
+    }
+}
+
+bool TelemetryRecorder::isRecording() const
+{
+    return m_recording.load();
+}
+
+RecorderItem* TelemetryRecorder::beginItem(RecordType type, qint64 timestampNs)
+{
+    RecorderItem* item = m_ring.beginPush();
+    if (item == nullptr)
+    {
+        ++m_droppedItems;
+        return nullptr;
+    }
+
+    item->type = static_cast<quint16>(type);
+    item->timestampNs = timestampNs;
+    return item;
+}
+
+void TelemetryRecorder::record(qint64 timestampNs, const SPageFilePhysics &physics, const SPageFileGraphic &graphics, AssettoCorsaData &data)
+{
+    if (!m_recording.load())
+    {
+        return;
+    }
+
+    // Static and graphics pages go first, so a physics record always
+    // follows the pages that were valid when it was taken
+    RecorderItem* item = beginItem(StaticRecord, timestampNs);
+    if (item != nullptr)
+    {
+        SPageFileStatic* page = reinterpret_cast<SPageFileStatic*>(item->payload);
+        data.copyStaticPage(page);
+        if (m_firstItem || (std::memcmp(page, &m_lastStatic, sizeof(SPageFileStatic)) != 0))
+        {
+            std::memcpy(&m_lastStatic, page, sizeof(SPageFileStatic));
+            m_ring.commitPush();
+            ++m_queuedItems;
+        }
+    }
+
+    if (m_firstItem || (graphics.packetId != m_lastGraphicsPacketId))
+    {
+        item = beginItem(GraphicsRecord, timestampNs);
+        if (item != nullptr)
+        {
+            std::memcpy(item->payload, &graphics, sizeof(SPageFileGraphic));
+            m_ring.commitPush();
+            ++m_queuedItems;
+            m_lastGraphicsPacketId = graphics.packetId;
+        }
+    }
+
+    item = beginItem(PhysicsRecord, timestampNs);
+    if (item != nullptr)
+    {
+        std::memcpy(item->payload, &physics, sizeof(SPageFilePhysics));
+        m_ring.commitPush();
+        ++m_queuedItems;
+    }
+
+    m_firstItem = false;
+}
+
+void TelemetryRecorder::run()
+{
+    m_fileOk = openFile();
+
+    while (true)
+    {
+        const RecorderItem* item = m_ring.front();
+        if (item != nullptr)
+        {
+            if (m_fileOk)
+            {
+                writeItem(item);
+            }
+
+            m_ring.pop();
+            continue;
+        }
+
+        if (m_stopRequested.load())
+        {
+            // The producer does not push anymore once stop was requested,
+            // so an empty ring here means everything has been written
+            if (m_ring.isEmpty())
+            {
+                break;
+            }
+
+            continue;
+        }
+
+        QThread::msleep(WRITER_IDLE_SLEEP_MS);
+    }
+
+    closeFile();
+}
+
+RecordingFileHeader TelemetryRecorder::fileHeader() const
+{
+    RecordingFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, RECORDING_MAGIC, sizeof(header.magic));
+    header.version = RECORDING_VERSION;
+    header.headerSize = sizeof(RecordingFileHeader);
+    header.physicsSize = sizeof(SPageFilePhysics);
+    header.graphicsSize = sizeof(SPageFileGraphic);
+    header.staticSize = sizeof(SPageFileStatic);
+    header.flags = m_compress ? RECORDING_FLAG_COMPRESSED : 0;
+    return header;
+}
+
+bool TelemetryRecorder::openFile()
+{
+    m_file.setFileName(m_path);
+    if (!m_file.open(QIODevice::ReadWrite | QIODevice::Truncate))
+    {
+        qWarning() << "Cannot open recording" << m_path << ":" << m_file.errorString();
+        return false;
+    }
+
+    RecordingFileHeader header = fileHeader();
+    if (m_file.write(reinterpret_cast<const char*>(&header), sizeof(header)) != sizeof(header))
+    {
+        qWarning() << "Cannot write recording header:" << m_file.errorString();
+        m_file.close();
+        return false;
+    }
+
+    m_writeOffset = sizeof(RecordingFileHeader);
+    m_map = nullptr;
+    m_mapStart = 0;
+    m_mapEnd = 0;
+
+    m_haveGraphics = false;
+    m_haveStatic = false;
+    m_keyFramePending = true;
+    m_lastKeyFrameNs = 0;
+    m_indexedLap = -1;
+    m_blockRawBytes = 0;
+    m_blockBytes = 0;
+
+    // Reserved once, so indexing does not allocate while recording
+    m_timeIndex.clear();
+    m_timeIndex.reserve(MAX_TIME_INDEX_ENTRIES);
+    m_lapIndex.clear();
+    m_lapIndex.reserve(MAX_LAP_INDEX_ENTRIES);
+
+    qDebug() << "Recording to" << m_path;
+    return true;
+}
+
+void TelemetryRecorder::writeItem(const RecorderItem* item)
+{
+    switch (item->type)
+    {
+    case StaticRecord:
+        // Pages of the pending block were taken before this one
+        finishBlock();
+        std::memcpy(&m_currentStatic, item->payload, sizeof(SPageFileStatic));
+        m_haveStatic = true;
+        writeRecord(StaticRecord, item->timestampNs, &m_currentStatic, sizeof(SPageFileStatic));
+        break;
+
+    case GraphicsRecord:
+        std::memcpy(&m_currentGraphics, item->payload, sizeof(SPageFileGraphic));
+        m_haveGraphics = true;
+        if (m_currentGraphics.completedLaps != m_indexedLap)
+        {
+            m_keyFramePending = true;
+        }
+
+        if (m_compress)
+        {
+            addToBlock(GraphicsRecord, item->timestampNs, &m_currentGraphics);
+        }
+        else
+        {
+            writeRecord(GraphicsRecord, item->timestampNs, &m_currentGraphics, sizeof(SPageFileGraphic));
+        }
+        break;
+
+    case PhysicsRecord:
+        if (m_keyFramePending || ((item->timestampNs - m_lastKeyFrameNs) >= TIME_INDEX_INTERVAL_NS))
+        {
+            // Blocks end at key frames, so replay can start at any of them
+            finishBlock();
+            writeKeyFrame(item->timestampNs);
+        }
+
+        if (m_compress)
+        {
+            addToBlock(PhysicsRecord, item->timestampNs, item->payload);
+        }
+        else
+        {
+            writeRecord(PhysicsRecord, item->timestampNs, item->payload, sizeof(SPageFilePhysics));
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+void TelemetryRecorder::writeKeyFrame(qint64 timestampNs)
+{
+    qint64 offset = m_writeOffset;
+
+    // Repeat the current static and graphics pages, so replay can start at
+    // the index entry without looking at earlier records
+    if (m_haveStatic)
+    {
+        writeRecord(StaticRecord, timestampNs, &m_currentStatic, sizeof(SPageFileStatic));
+    }
+
+    if (m_haveGraphics)
+    {
+        writeRecord(GraphicsRecord, timestampNs, &m_currentGraphics, sizeof(SPageFileGraphic));
+    }
+
+    if (m_timeIndex.size() < MAX_TIME_INDEX_ENTRIES)
+    {
+        TimeIndexEntry entry;
+        entry.timestampNs = timestampNs;
+        entry.offset = offset;
+        m_timeIndex.append(entry);
+    }
+
+    if (m_haveGraphics && (m_currentGraphics.completedLaps != m_indexedLap))
+    {
+        m_indexedLap = m_currentGraphics.completedLaps;
+        if (m_lapIndex.size() < MAX_LAP_INDEX_ENTRIES)
+        {
+            LapIndexEntry entry;
+            entry.lap = m_indexedLap;
+            entry.reserved = 0;
+            entry.timestampNs = timestampNs;
+            entry.offset = offset;
+            m_lapIndex.append(entry);
+        }
+    }
+
+    m_lastKeyFrameNs = timestampNs;
+    m_keyFramePending = false;
+}
+
+void TelemetryRecorder::addToBlock(RecordType type, qint64 timestampNs, const void* payload)
+{
+    if (!m_encoder.add(type, timestampNs, payload))
+    {
+        finishBlock();
+        (void)m_encoder.add(type, timestampNs, payload);
+    }
+}
+
+void TelemetryRecorder::finishBlock()
+{
+    if (m_encoder.isEmpty())
+    {
+        return;
+    }
+
+    // A block is stamped with the time of its last page
+    qint64 timestampNs = m_encoder.lastTimestamp();
+    m_blockRawBytes += m_encoder.rawSize();
+    quint32 size = m_encoder.finish();
+    m_blockBytes += size;
+    writeRecord(CompressedBlockRecord, timestampNs, m_encoder.data(), size);
+}
+
+void TelemetryRecorder::writeRecord(RecordType type, qint64 timestampNs, const void* payload, quint32 payloadSize)
+{
+    qint64 size = recordSize(payloadSize);
+    if (!ensureSpace(size))
+    {
+        return;
+    }
+
+    uchar* destination = m_map + (m_writeOffset - m_mapStart);
+
+    RecordHeader header;
+    header.type = static_cast<quint16>(type);
+    header.reserved = 0;
+    header.size = payloadSize;
+    header.timestampNs = timestampNs;
+    std::memcpy(destination, &header, sizeof(header));
+    std::memcpy(destination + sizeof(header), payload, payloadSize);
+
+    m_writeOffset += size;
+}
+
+bool TelemetryRecorder::ensureSpace(qint64 size)
+{
+    if ((m_map != nullptr) && ((m_writeOffset + size) <= m_mapEnd))
+    {
+        return true;
+    }
+
+    if (m_map != nullptr)
+    {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+
+    qint64 end = m_writeOffset + qMax(size, MAP_CHUNK_SIZE);
+    if (!m_file.resize(end))
+    {
+        qWarning() << "Cannot grow recording:" << m_file.errorString();
+        m_fileOk = false;
+        return false;
+    }
+
+    m_map = m_file.map(m_writeOffset, end - m_writeOffset);
+    if (m_map == nullptr)
+    {
+        qWarning() << "Cannot map recording:" << m_file.errorString();
+        m_fileOk = false;
+        return false;
+    }
+
+    m_mapStart = m_writeOffset;
+    m_mapEnd = end;
+    return true;
+}
+
+void TelemetryRecorder::closeFile()
+{
+    if (!m_file.isOpen())
+    {
+        return;
+    }
+
+    if (m_fileOk)
+    {
+        finishBlock();
+    }
+
+    if (m_map != nullptr)
+    {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+
+    // Cut off the unused part of the last chunk and append the index
+    (void)m_file.resize(m_writeOffset);
+    (void)m_file.seek(m_writeOffset);
+
+    qint64 timeIndexBytes = static_cast<qint64>(m_timeIndex.size()) * sizeof(TimeIndexEntry);
+    qint64 lapIndexBytes = static_cast<qint64>(m_lapIndex.size()) * sizeof(LapIndexEntry);
+    bool indexWritten = (m_file.write(reinterpret_cast<const char*>(m_timeIndex.constData()), timeIndexBytes) == timeIndexBytes)
+            && (m_file.write(reinterpret_cast<const char*>(m_lapIndex.constData()), lapIndexBytes) == lapIndexBytes);
+
+    if (indexWritten)
+    {
+        RecordingFileHeader header = fileHeader();
+        header.timeIndexCount = static_cast<quint32>(m_timeIndex.size());
+        header.lapIndexCount = static_cast<quint32>(m_lapIndex.size());
+        header.indexOffset = m_writeOffset;
+
+        (void)m_file.seek(0);
+        (void)m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+    else
+    {
+        qWarning() << "Cannot write recording index:" << m_file.errorString();
+    }
+
+    qDebug() << "Closed recording" << m_path << "with" << m_writeOffset << "bytes of records,"
+             << m_timeIndex.size() << "time and" << m_lapIndex.size() << "lap index entries";
+    if (m_compress)
+    {
+        qDebug() << "Compressed" << m_blockRawBytes << "bytes of pages into" << m_blockBytes << "bytes";
+    }
+
+    m_file.close();
+}
@@ -0,0 +1,100 @@
+#ifndef TELEMETRYRECORDER_B06779DFAB284FB29B758C0C7F56A3CD
+#define TELEMETRYRECORDER_B06779DFAB284FB29B758C0C7F56A3CD
+
+#include <QThread>
+#include <QFile>
+#include <QVector>
+#include <atomic>
+#include "recordingformat.h"
+#include "framecodec.h"
+#include "spscring.h"
+
+class AssettoCorsaData;
+
+// Largest page that can be queued
+static const quint32 RECORDER_PAYLOAD_SIZE = (sizeof(SPageFileStatic) > sizeof(SPageFileGraphic))
+        ? ((sizeof(SPageFileStatic) > sizeof(SPageFilePhysics)) ? sizeof(SPageFileStatic) : sizeof(SPageFilePhysics))
+        : ((sizeof(SPageFileGraphic) > sizeof(SPageFilePhysics)) ? sizeof(SPageFileGraphic) : sizeof(SPageFilePhysics));
+
+struct RecorderItem
+{
+    quint16 type;
+    qint64 timestampNs;
+    qint64 payload[(RECORDER_PAYLOAD_SIZE + 7) / 8];
+};
+
+// Records the shared memory pages into an append-only memory mapped file.
+// The acquisition thread only copies the pages into a lock-free ring, the
+// file is written by the recorder thread. Nothing is allocated while
+// recording; the index has a fixed capacity reserved when recording starts.
+class TelemetryRecorder : public QThread
+{
+    Q_OBJECT
+public:
+    explicit TelemetryRecorder(QObject* parent = nullptr);
+    ~TelemetryRecorder() override;
+
+    // Called by the thread that owns the reader, not the acquisition thread:
+    // starting waits for a previous recording to be written. Stopping does
+    // not wait, the file is finished by the recorder thread.
+    void startRecording(const QString &path, bool compress);
+    void stopRecording();
+    bool isRecording() const;
+
+    // Queues the physics page, plus the graphics and static pages if they
+    // changed since they were queued last. Items are dropped and counted if
+    // the recorder thread cannot keep up.
+    void record(qint64 timestampNs, const SPageFilePhysics &physics, const SPageFileGraphic &graphics, AssettoCorsaData &data);
+
+private:
+    void run() override;
+
+    RecorderItem* beginItem(RecordType type, qint64 timestampNs);
+    RecordingFileHeader fileHeader() const;
+    bool openFile();
+    void writeItem(const RecorderItem* item);
+    void writeRecord(RecordType type, qint64 timestampNs, const void* payload, quint32 payloadSize);
+    void writeKeyFrame(qint64 timestampNs);
+    void addToBlock(RecordType type, qint64 timestampNs, const void* payload);
+    void finishBlock();
+    bool ensureSpace(qint64 size);
+    void closeFile();
+
+    SpscRing<RecorderItem, 2048> m_ring;
+    std::atomic<bool> m_recording;
+    std::atomic<bool> m_stopRequested;
+    QString m_path;
+    bool m_compress = false;
+
+    // Acquisition thread
+    bool m_firstItem = true;
+    qint32 m_lastGraphicsPacketId = 0;
+    SPageFileStatic m_lastStatic;
+    quint64 m_queuedItems = 0;
+    quint64 m_droppedItems = 0;
+
+    // Recorder thread
+    QFile m_file;
+    uchar* m_map = nullptr;
+    qint64 m_mapStart = 0;
+    qint64 m_mapEnd = 0;
+    qint64 m_writeOffset = 0;
+    bool m_fileOk = false;
+
+    SPageFileGraphic m_currentGraphics;
+    SPageFileStatic m_currentStatic;
+    bool m_haveGraphics = false;
+    bool m_haveStatic = false;
+    qint64 m_lastKeyFrameNs = 0;
+    bool m_keyFramePending = true;
+    qint32 m_indexedLap = -1;
+
+    QVector<TimeIndexEntry> m_timeIndex;
+    QVector<LapIndexEntry> m_lapIndex;
+
+    FrameBlockEncoder m_encoder;
+    qint64 m_blockRawBytes = 0;
+    qint64 m_blockBytes = 0;
+};
+
+#endif // TELEMETRYRECORDER_B06779DFAB284FB29B758C0C7F56A3CD
@@ -0,0 +1,287 @@
+#include "telemetryrecording.h"
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+#include "framecodec.h"
+
+// Key frames found while rebuilding the index are at least this far apart,
+// same as when recording
+static const qint64 REBUILT_INDEX_INTERVAL_NS = 1000000000;
+
+
+TelemetryRecording::TelemetryRecording()
+{
+
+}
+
+TelemetryRecording::~TelemetryRecording()
+{
+    close();
+}
+
+bool TelemetryRecording::open(const QString &path)
+{
+    close();
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly))
+    {
+        qWarning() << "Cannot open recording" << path << ":" << m_file.errorString();
+        return false;
+    }
+
+    m_size = m_file.size();
+    if (m_size < static_cast<qint64>(sizeof(RecordingFileHeader)))
+    {
+        qWarning() << "Recording" << path << "is too small";
+        close();
+        return false;
+    }
+
+    m_data = m_file.map(0, m_size);
+    if (m_data == nullptr)
+    {
+        qWarning() << "Cannot map recording" << path << ":" << m_file.errorString();
+        close();
+        return false;
+    }
+
+    RecordingFileHeader header;
+    std::memcpy(&header, m_data, sizeof(header));
+    if ((std::memcmp(header.magic, RECORDING_MAGIC, sizeof(header.magic)) != 0)
+            || (header.version != RECORDING_VERSION)
+            || (header.headerSize != sizeof(RecordingFileHeader))
+            || (header.physicsSize != sizeof(SPageFilePhysics))
+            || (header.graphicsSize != sizeof(SPageFileGraphic))
+            || (header.staticSize != sizeof(SPageFileStatic)))
+    {
+        qWarning() << "Recording" << path << "has an unknown format";
+        close();
+        return false;
+    }
+
+    m_compressed = ((header.flags & RECORDING_FLAG_COMPRESSED) != 0);
+
+    if (!readIndex(header))
+    {
+        // Not closed properly, the file may end with unused space
+        qDebug() << "Rebuilding index of recording" << path;
+        rebuildIndex();
+    }
+
+    return true;
+}
+
+void TelemetryRecording::close()
+{
+    if (m_data != nullptr)
+    {
+        m_file.unmap(const_cast<uchar*>(m_data));
+        m_data = nullptr;
+    }
+
+    if (m_file.isOpen())
+    {
+        m_file.close();
+    }
+
+    m_size = 0;
+    m_recordsEnd = 0;
+    m_lastTimestamp = 0;
+    m_compressed = false;
+    m_timeIndex.clear();
+    m_lapIndex.clear();
+}
+
+bool TelemetryRecording::isOpen() const
+{
+    return (m_data != nullptr);
+}
+
+bool TelemetryRecording::isCompressed() const
+{
+    return m_compressed;
+}
+
+qint64 TelemetryRecording::firstOffset() const
+{
+    return sizeof(RecordingFileHeader);
+}
+
+qint64 TelemetryRecording::endOffset() const
+{
+    return m_recordsEnd;
+}
+
+bool TelemetryRecording::readRecord(qint64 offset, RecordView &record) const
+{
+    if ((m_data == nullptr) || (offset < firstOffset()) || ((offset + static_cast<qint64>(sizeof(RecordHeader))) > m_recordsEnd))
+    {
+        return false;
+    }
+
+    RecordHeader header;
+    std::memcpy(&header, m_data + offset, sizeof(header));
+
+    RecordType type = static_cast<RecordType>(header.type);
+    if (type == CompressedBlockRecord)
+    {
+        if ((header.size < sizeof(CompressedBlockHeader)) || (header.size > MAX_COMPRESSED_BLOCK_SIZE))
+        {
+            return false;
+        }
+    }
+    else
+    {
+        quint32 expectedSize = recordPayloadSize(type);
+        if ((expectedSize == 0) || (header.size != expectedSize))
+        {
+            return false;
+        }
+    }
+
+    qint64 size = recordSize(header.size);
+    if ((offset + size) > m_recordsEnd)
+    {
+        return false;
+    }
+
+    record.type = type;
+    record.timestampNs = header.timestampNs;
+    record.payload = m_data + offset + sizeof(RecordHeader);
+    record.size = header.size;
+    record.nextOffset = offset + size;
+    return true;
+}
+
+qint64 TelemetryRecording::seekToTime(qint64 timestampNs) const
+{
+    if (m_timeIndex.isEmpty())
+    {
+        return firstOffset();
+    }
+
+    // First entry after the time, the one before it is where to start
+    auto it = std::upper_bound(m_timeIndex.constBegin(), m_timeIndex.constEnd(), timestampNs,
+                               [](qint64 time, const TimeIndexEntry &entry) { return time < entry.timestampNs; });
+    if (it == m_timeIndex.constBegin())
+    {
+        return it->offset;
+    }
+
+    return (it - 1)->offset;
+}
+
+qint64 TelemetryRecording::seekToLap(qint32 lap) const
+{
+    auto it = std::lower_bound(m_lapIndex.constBegin(), m_lapIndex.constEnd(), lap,
+                               [](const LapIndexEntry &entry, qint32 value) { return entry.lap < value; });
+    if ((it == m_lapIndex.constEnd()) || (it->lap != lap))
+    {
+        return -1;
+    }
+
+    return it->offset;
+}
+
+qint64 TelemetryRecording::firstTimestamp() const
+{
+    return m_timeIndex.isEmpty() ? 0 : m_timeIndex.first().timestampNs;
+}
+
+qint64 TelemetryRecording::lastTimestamp() const
+{
+    return m_lastTimestamp;
+}
+
+qint32 TelemetryRecording::timeIndexCount() const
+{
+    return m_timeIndex.size();
+}
+
+qint32 TelemetryRecording::lapIndexCount() const
+{
+    return m_lapIndex.size();
+}
+
+bool TelemetryRecording::readIndex(const RecordingFileHeader &header)
+{
+    if (header.indexOffset < firstOffset())
+    {
+        return false;
+    }
+
+    qint64 timeBytes = static_cast<qint64>(header.timeIndexCount) * sizeof(TimeIndexEntry);
+    qint64 lapBytes = static_cast<qint64>(header.lapIndexCount) * sizeof(LapIndexEntry);
+    if ((header.indexOffset + timeBytes + lapBytes) != m_size)
+    {
+        return false;
+    }
+
+    m_recordsEnd = header.indexOffset;
+
+    m_timeIndex.resize(static_cast<qint32>(header.timeIndexCount));
+    std::memcpy(m_timeIndex.data(), m_data + header.indexOffset, static_cast<size_t>(timeBytes));
+    m_lapIndex.resize(static_cast<qint32>(header.lapIndexCount));
+    std::memcpy(m_lapIndex.data(), m_data + header.indexOffset + timeBytes, static_cast<size_t>(lapBytes));
+
+    // The time index may have been full, look at the last record for the end
+    m_lastTimestamp = firstTimestamp();
+    qint64 offset = m_timeIndex.isEmpty() ? firstOffset() : m_timeIndex.last().offset;
+    RecordView record;
+    while (readRecord(offset, record))
+    {
+        m_lastTimestamp = record.timestampNs;
+        offset = record.nextOffset;
+    }
+
+    return true;
+}
+
+void TelemetryRecording::rebuildIndex()
+{
+    m_timeIndex.clear();
+    m_lapIndex.clear();
+    m_recordsEnd = m_size;
+
+    // A key frame starts with a static record followed by a graphics record
+    qint64 offset = firstOffset();
+    qint64 lastKeyFrameNs = 0;
+    qint32 lastLap = -1;
+    qint64 end = offset;
+    RecordView record;
+    while (readRecord(offset, record))
+    {
+        RecordView next;
+        if ((record.type == StaticRecord) && readRecord(record.nextOffset, next) && (next.type == GraphicsRecord))
+        {
+            qint32 lap = reinterpret_cast<const SPageFileGraphic*>(next.payload)->completedLaps;
+            if (m_timeIndex.isEmpty() || ((record.timestampNs - lastKeyFrameNs) >= REBUILT_INDEX_INTERVAL_NS))
+            {
+                TimeIndexEntry entry;
+                entry.timestampNs = record.timestampNs;
+                entry.offset = offset;
+                m_timeIndex.append(entry);
+                lastKeyFrameNs = record.timestampNs;
+            }
+
+            if (lap != lastLap)
+            {
+                LapIndexEntry entry;
+                entry.lap = lap;
+                entry.reserved = 0;
+                entry.timestampNs = record.timestampNs;
+                entry.offset = offset;
+                m_lapIndex.append(entry);
+                lastLap = lap;
+            }
+        }
+
+        m_lastTimestamp = record.timestampNs;
+        offset = record.nextOffset;
+        end = offset;
+    }
+
+    // Anything after the last complete record is unused space
+    m_recordsEnd = end;
+}
@@ -0,0 +1,57 @@
+#ifndef TELEMETRYRECORDING_3EBD6DF960414845B0F637C9096B31F1
+#define TELEMETRYRECORDING_3EBD6DF960414845B0F637C9096B31F1
+
+#include <QFile>
+#include <QVector>
+#include "recordingformat.h"
+
+// Read-only access to a recording written by TelemetryRecorder.
+// The whole file is mapped, records are read in place without copying.
+class TelemetryRecording
+{
+public:
+    TelemetryRecording();
+    ~TelemetryRecording();
+
+    TelemetryRecording(const TelemetryRecording&) = delete;
+    TelemetryRecording& operator=(const TelemetryRecording&) = delete;
+
+    bool open(const QString &path);
+    void close();
+    bool isOpen() const;
+    bool isCompressed() const;
+
+    // Offset of the first record
+    qint64 firstOffset() const;
+    qint64 endOffset() const;
+
+    // Returns false at the end of the records or on a damaged record
+    bool readRecord(qint64 offset, RecordView &record) const;
+
+    // Offset of the last key frame at or before the given time/the first key
+    // frame of the given lap, -1 if the lap is not indexed. Binary search
+    // over the index.
+    qint64 seekToTime(qint64 timestampNs) const;
+    qint64 seekToLap(qint32 lap) const;
+
+    qint64 firstTimestamp() const;
+    qint64 lastTimestamp() const;
+    qint32 timeIndexCount() const;
+    qint32 lapIndexCount() const;
+
+private:
+    bool readIndex(const RecordingFileHeader &header);
+    void rebuildIndex();
+
+    QFile m_file;
+    const uchar* m_data = nullptr;
+    qint64 m_size = 0;
+    qint64 m_recordsEnd = 0;
+    qint64 m_lastTimestamp = 0;
+    bool m_compressed = false;
+
+    QVector<TimeIndexEntry> m_timeIndex;
+    QVector<LapIndexEntry> m_lapIndex;
+};
+
+#endif // TELEMETRYRECORDING_3EBD6DF960414845B0F637C9096B31F1
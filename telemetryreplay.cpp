@@ -0,0 +1,160 @@
+#include "telemetryreplay.h"
+#include <QDebug>
+#include <QThread>
+#include "acquisitionthread.h"
+#include "replaybackend.h"
+#include "telemetryreader.h"
+
+// Waits longer than this are sliced, so stop() is noticed in time
+static const qint64 MAX_WAIT_NS = 100000000;
+
+
+double ReplayStatistics::framesPerSecond() const
+{
+    if (wallNs <= 0)
+    {
+        return 0.0;
+    }
+
+    return (static_cast<double>(frames) * 1e9) / static_cast<double>(wallNs);
+}
+
+TelemetryReplay::TelemetryReplay(TelemetryReader* reader, ReplayBackend* backend)
+    : m_reader(reader)
+    , m_backend(backend)
+    , m_stopRequested(false)
+{
+
+}
+
+bool TelemetryReplay::open(const QString &path)
+{
+    if (!m_recording.open(path))
+    {
+        return false;
+    }
+
+    m_startOffset = m_recording.firstOffset();
+    m_clockNs = m_recording.firstTimestamp();
+    qDebug() << "Opened recording" << path << "with" << m_recording.timeIndexCount() << "time and"
+             << m_recording.lapIndexCount() << "lap index entries";
+    return true;
+}
+
+const TelemetryRecording& TelemetryReplay::recording() const
+{
+    return m_recording;
+}
+
+void TelemetryReplay::setSpeed(double speed)
+{
+    m_speed = (speed > 0.0) ? speed : 0.0;
+}
+
+double TelemetryReplay::getSpeed() const
+{
+    return m_speed;
+}
+
+void TelemetryReplay::seekToTime(qint64 timestampNs)
+{
+    m_startOffset = m_recording.seekToTime(timestampNs);
+}
+
+bool TelemetryReplay::seekToLap(qint32 lap)
+{
+    qint64 offset = m_recording.seekToLap(lap);
+    if (offset < 0)
+    {
+        return false;
+    }
+
+    m_startOffset = offset;
+    return true;
+}
+
+ReplayStatistics TelemetryReplay::run()
+{
+    ReplayStatistics statistics;
+    if (!m_recording.isOpen())
+    {
+        return statistics;
+    }
+
+    m_stopRequested.store(false);
+    m_backend->clear();
+
+    m_started = false;
+    m_firstNs = 0;
+    m_wallStartNs = AcquisitionThread::now();
+
+    qint64 offset = m_startOffset;
+    RecordView record;
+    while (!m_stopRequested.load() && m_recording.readRecord(offset, record))
+    {
+        offset = record.nextOffset;
+        if (record.type == CompressedBlockRecord)
+        {
+            if (!m_decoder.decode(record.payload, record.size))
+            {
+                qWarning() << "Damaged block in recording, replay stopped";
+                break;
+            }
+
+            for (qint32 i = 0; (i < m_decoder.count()) && !m_stopRequested.load(); ++i)
+            {
+                replayPage(m_decoder.page(i), statistics);
+            }
+        }
+        else
+        {
+            replayPage(record, statistics);
+        }
+    }
+
+    statistics.simulatedNs = m_clockNs - m_firstNs;
+    statistics.wallNs = AcquisitionThread::now() - m_wallStartNs;
+    return statistics;
+}
+
+void TelemetryReplay::replayPage(const RecordView &record, ReplayStatistics &statistics)
+{
+    m_backend->apply(record);
+    if (record.type != PhysicsRecord)
+    {
+        return;
+    }
+
+    if (!m_started)
+    {
+        m_firstNs = record.timestampNs;
+        m_started = true;
+    }
+
+    m_clockNs = record.timestampNs;
+
+    if (m_speed > 0.0)
+    {
+        // Wait until the frame is due in real time
+        qint64 dueNs = m_wallStartNs + static_cast<qint64>(static_cast<double>(m_clockNs - m_firstNs) / m_speed);
+        qint64 remainingNs = dueNs - AcquisitionThread::now();
+        while ((remainingNs > 0) && !m_stopRequested.load())
+        {
+            QThread::usleep(static_cast<unsigned long>(qMin(remainingNs, MAX_WAIT_NS) / 1000));
+            remainingNs = dueNs - AcquisitionThread::now();
+        }
+    }
+
+    m_reader->readData(m_clockNs);
+    ++statistics.frames;
+}
+
+void TelemetryReplay::stop()
+{
+    m_stopRequested.store(true);
+}
+
+qint64 TelemetryReplay::now() const
+{
+    return m_clockNs;
+}
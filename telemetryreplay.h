@@ -0,0 +1,66 @@
+#ifndef TELEMETRYREPLAY_DCA82E6EA83B4CEFBECACCF0CC367780
+#define TELEMETRYREPLAY_DCA82E6EA83B4CEFBECACCF0CC367780
+
+#include <QString>
+#include <atomic>
+#include "telemetryrecording.h"
+#include "framecodec.h"
+
+class ReplayBackend;
+class TelemetryReader;
+
+struct ReplayStatistics
+{
+    quint64 frames = 0;
+    qint64 simulatedNs = 0;
+    qint64 wallNs = 0;
+
+    double framesPerSecond() const;
+};
+
+// Feeds the frames of a recording through TelemetryReader::readData().
+// Frames are stamped with a simulated clock that follows the recorded
+// timestamps, so the pipeline sees the same input at any replay speed.
+// The speed only decides how long to wait between frames in real time.
+class TelemetryReplay
+{
+public:
+    // The backend has to be the one the reader was constructed with
+    TelemetryReplay(TelemetryReader* reader, ReplayBackend* backend);
+
+    bool open(const QString &path);
+    const TelemetryRecording& recording() const;
+
+    // 1.0 replays in real time, 0 replays as fast as possible
+    void setSpeed(double speed);
+    double getSpeed() const;
+
+    // Where to start, applied by the next run()
+    void seekToTime(qint64 timestampNs);
+    bool seekToLap(qint32 lap);
+
+    // Replays until the end of the recording or until stop() is called
+    ReplayStatistics run();
+    void stop();
+
+    // Current time of the simulated clock
+    qint64 now() const;
+
+private:
+    void replayPage(const RecordView &record, ReplayStatistics &statistics);
+
+    TelemetryReader* m_reader;
+    ReplayBackend* m_backend;
+    TelemetryRecording m_recording;
+    double m_speed = 1.0;
+    qint64 m_startOffset = 0;
+    qint64 m_clockNs = 0;
+    std::atomic<bool> m_stopRequested;
+
+    FrameBlockDecoder m_decoder;
+    bool m_started = false;
+    qint64 m_firstNs = 0;
+    qint64 m_wallStartNs = 0;
+};
+
+#endif // TELEMETRYREPLAY_DCA82E6EA83B4CEFBECACCF0CC367780
@@ -0,0 +1,30 @@
+#-------------------------------------------------
+#
+# Writes synthetic Assetto Corsa pages into shared memory,
+# a local stand-in for the game
+#
+#-------------------------------------------------
+
+QT       += core
+QT       -= gui
+
+TARGET = acproducer
+TEMPLATE = app
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+    main.cpp \
+    sharedmemorywriter.cpp \
+    scenario.cpp
+
+HEADERS += \
+    sharedmemorywriter.h \
+    scenario.h \
+    ../../sharedfileout.h
+
+unix:!macx: LIBS += -lrt
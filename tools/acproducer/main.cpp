@@ -0,0 +1,130 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTextStream>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <thread>
+#include "scenario.h"
+#include "sharedmemorywriter.h"
+
+static const qint32 DEFAULT_RATE_HZ = 333;
+static const qint32 MAX_RATE_HZ = 1000;
+static const qint64 REPORT_INTERVAL_NS = 10000000000LL;
+
+static std::atomic<bool> s_stopRequested(false);
+
+static void onSignal(int signal)
+{
+    (void)signal;
+    s_stopRequested.store(true);
+}
+
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("acproducer");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Writes synthetic Assetto Corsa telemetry into shared memory.");
+    parser.addHelpOption();
+    QCommandLineOption scenarioOption("scenario", "One of: " + Scenario::names().join(", "), "name", "mixed");
+    QCommandLineOption rateOption("rate", QString("Physics updates per second, up to %1").arg(MAX_RATE_HZ), "hz", QString::number(DEFAULT_RATE_HZ));
+    QCommandLineOption durationOption("duration", "Seconds to run, 0 runs until interrupted", "seconds", "0");
+    QCommandLineOption seedOption("seed", "Seed of the noise on the values", "seed", "1");
+    QCommandLineOption unlinkOption("unlink", "Remove the shared memory segments on exit");
+    parser.addOption(scenarioOption);
+    parser.addOption(rateOption);
+    parser.addOption(durationOption);
+    parser.addOption(seedOption);
+    parser.addOption(unlinkOption);
+    parser.process(a);
+
+    QTextStream out(stdout);
+
+    ScenarioType type;
+    if (!Scenario::fromName(parser.value(scenarioOption), type))
+    {
+        out << "Unknown scenario " << parser.value(scenarioOption) << "\n";
+        return 1;
+    }
+
+    qint32 rate = parser.value(rateOption).toInt();
+    if ((rate <= 0) || (rate > MAX_RATE_HZ))
+    {
+        out << "Rate has to be between 1 and " << MAX_RATE_HZ << "\n";
+        return 1;
+    }
+
+    SharedMemoryWriter writer;
+    if (!writer.isOpen())
+    {
+        return 1;
+    }
+
+    writer.setUnlinkOnExit(parser.isSet(unlinkOption));
+
+    (void)std::signal(SIGINT, onSignal);
+    (void)std::signal(SIGTERM, onSignal);
+
+    Scenario scenario(type, parser.value(seedOption).toUInt());
+    qint64 periodNs = 1000000000LL / rate;
+    qint64 durationNs = static_cast<qint64>(parser.value(durationOption).toDouble() * 1e9);
+
+    out << "Producing scenario " << parser.value(scenarioOption) << " at " << rate << " Hz\n";
+    out.flush();
+
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+    qint64 timeNs = 0;
+    qint64 nextReportNs = REPORT_INTERVAL_NS;
+    quint64 steps = 0;
+    quint64 lateSteps = 0;
+
+    while (!s_stopRequested.load() && ((durationNs <= 0) || (timeNs < durationNs)))
+    {
+        // The static page goes first, so a reader never sees a new car with
+        // the tyres of the previous one
+        scenario.step(timeNs);
+        if (scenario.staticChanged())
+        {
+            writer.publishStatic(scenario.staticData());
+        }
+
+        if (scenario.graphicsChanged())
+        {
+            writer.publishGraphics(scenario.graphics());
+        }
+
+        if (scenario.physicsChanged())
+        {
+            writer.publishPhysics(scenario.physics());
+        }
+
+        ++steps;
+
+        if (timeNs >= nextReportNs)
+        {
+            out << "t=" << (timeNs / 1000000000LL) << "s physics packet " << scenario.physics().packetId
+                << ", laps " << scenario.graphics().completedLaps << ", late steps " << lateSteps << "\n";
+            out.flush();
+            nextReportNs += REPORT_INTERVAL_NS;
+        }
+
+        // Absolute deadlines, so the rate does not drift
+        timeNs += periodNs;
+        Clock::time_point deadline = start + std::chrono::nanoseconds(timeNs);
+        if (Clock::now() > deadline)
+        {
+            ++lateSteps;
+        }
+        else
+        {
+            std::this_thread::sleep_until(deadline);
+        }
+    }
+
+    out << "Wrote " << steps << " steps, " << lateSteps << " of them late\n";
+    return 0;
+}
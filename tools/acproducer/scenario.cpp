@@ -0,0 +1,401 @@
+#include "scenario.h"
+#include <cmath>
+
+static const double PI = 3.14159265358979323846;
+
+// Made-up track: a lap is a speed wave between the slow and fast corners
+static const double TRACK_LENGTH_M = 4000.0;
+static const double SPEED_WAVE_PERIOD_S = 20.0;
+static const float MIN_SPEED_KMH = 80.0f;
+static const float MAX_SPEED_KMH = 220.0f;
+
+// Each event is active for a part of every event period
+static const double EVENT_PERIOD_S = 5.0;
+static const double EVENT_DURATION_S = 1.0;
+static const double AIRBORNE_DURATION_S = 0.3;
+static const double MIXED_SCENARIO_S = 10.0;
+
+// Car swaps leave the session for a moment, like going back to the menu
+static const double CAR_SWAP_PERIOD_S = 30.0;
+static const double MIXED_CAR_SWAP_PERIOD_S = 60.0;
+static const double MENU_DURATION_S = 2.0;
+
+// The game updates the graphics page far less often than the physics page
+static const double GRAPHICS_INTERVAL_S = 1.0 / 60.0;
+
+static const float STATIC_WHEEL_LOAD_N = 3500.0f;
+
+struct CarInfo
+{
+    const char* model;
+    float frontTyreRadius;
+    float rearTyreRadius;
+    qint32 maxRpm;
+    // Aid settings as the game reports them, they do not say whether the aid
+    // is working. 0 if the car has none.
+    float abs;
+    float tc;
+};
+
+static const CarInfo CARS[] =
+{
+    {"ks_mazda_mx5_cup", 0.300f, 0.300f, 7500, 0.0f, 0.0f},
+    {"ks_bmw_m235i_racing", 0.327f, 0.335f, 7000, 1.0f, 0.2f},
+    {"ks_porsche_911_gt3_r_2016", 0.340f, 0.355f, 9250, 1.0f, 0.1f}
+};
+static const qint32 CAR_COUNT = sizeof(CARS) / sizeof(CARS[0]);
+
+static const AC_FLAG_TYPE FLAGS[] =
+{
+    AC_NO_FLAG, AC_BLUE_FLAG, AC_YELLOW_FLAG, AC_BLACK_FLAG, AC_WHITE_FLAG, AC_CHECKERED_FLAG, AC_PENALTY_FLAG
+};
+static const qint32 FLAG_COUNT = sizeof(FLAGS) / sizeof(FLAGS[0]);
+
+namespace
+{
+template <int N>
+void copyString(AC_WCHAR (&destination)[N], const char* source)
+{
+    int i = 0;
+    for (; (i < (N - 1)) && (source[i] != '\0'); ++i)
+    {
+        destination[i] = static_cast<AC_WCHAR>(source[i]);
+    }
+
+    for (; i < N; ++i)
+    {
+        destination[i] = 0;
+    }
+}
+
+// Angular speed of a wheel rolling without slip at the given speed
+float rollingAngularSpeed(float speedKmh, float tyreRadius)
+{
+    return speedKmh / (3.6f * tyreRadius);
+}
+}
+
+Scenario::Scenario(ScenarioType type, quint32 seed)
+    : m_type(type)
+    , m_random(seed)
+    , m_noise(-1.0f, 1.0f)
+{
+    m_physics = SPageFilePhysics();
+    m_graphics = SPageFileGraphic();
+    m_static = SPageFileStatic();
+
+    copyString(m_static.smVersion, "1.7");
+    copyString(m_static.acVersion, "1.16");
+    copyString(m_static.track, "pv_test_track");
+    copyString(m_static.playerName, "Synthetic");
+    copyString(m_static.playerSurname, "Driver");
+    copyString(m_static.playerNick, "SYN");
+    m_static.numberOfSessions = 1;
+    m_static.numCars = 1;
+    m_static.sectorCount = 3;
+    m_static.maxFuel = 60.0f;
+
+    m_graphics.status = AC_LIVE;
+    m_graphics.session = AC_PRACTICE;
+    m_graphics.position = 1;
+    m_physics.fuel = 30.0f;
+
+    loadCar(0);
+}
+
+bool Scenario::fromName(const QString &name, ScenarioType &type)
+{
+    QStringList scenarios = names();
+    qint32 index = scenarios.indexOf(name);
+    if (index < 0)
+    {
+        return false;
+    }
+
+    type = static_cast<ScenarioType>(index);
+    return true;
+}
+
+QStringList Scenario::names()
+{
+    // In the order of ScenarioType
+    return QStringList() << "cruise" << "lockup" << "wheelspin" << "airborne" << "flags" << "carswap" << "mixed";
+}
+
+bool Scenario::physicsChanged() const
+{
+    return m_physicsChanged;
+}
+
+bool Scenario::graphicsChanged() const
+{
+    return m_graphicsChanged;
+}
+
+bool Scenario::staticChanged() const
+{
+    return m_staticChanged;
+}
+
+const SPageFilePhysics& Scenario::physics() const
+{
+    return m_physics;
+}
+
+const SPageFileGraphic& Scenario::graphics() const
+{
+    return m_graphics;
+}
+
+const SPageFileStatic& Scenario::staticData() const
+{
+    return m_static;
+}
+
+void Scenario::step(qint64 timeNs)
+{
+    double time = static_cast<double>(timeNs) / 1e9;
+    double deltaTime = qMax(0.0, time - m_lastTime);
+    m_lastTime = time;
+
+    m_physicsChanged = false;
+    m_graphicsChanged = false;
+    m_staticChanged = false;
+
+    updateSession(time);
+    if (m_graphics.status == AC_LIVE)
+    {
+        updateDriving(time, deltaTime);
+        applyEvent(activeEvent(time), time);
+
+        ++m_physics.packetId;
+        m_physicsChanged = true;
+    }
+
+    updateGraphics(time);
+}
+
+ScenarioType Scenario::activeEvent(double time) const
+{
+    ScenarioType event = m_type;
+    if (m_type == MixedScenario)
+    {
+        // Lock-ups, wheelspin, jumps and flags take turns
+        qint32 slot = static_cast<qint32>(time / MIXED_SCENARIO_S) % 4;
+        event = static_cast<ScenarioType>(LockUpScenario + slot);
+    }
+
+    return event;
+}
+
+void Scenario::updateSession(double time)
+{
+    double swapPeriod = 0.0;
+    if (m_type == CarSwapScenario)
+    {
+        swapPeriod = CAR_SWAP_PERIOD_S;
+    }
+    else if (m_type == MixedScenario)
+    {
+        swapPeriod = MIXED_CAR_SWAP_PERIOD_S;
+    }
+
+    if (swapPeriod <= 0.0)
+    {
+        return;
+    }
+
+    // The last seconds of every period are spent in the menu,
+    // the next car is loaded when the session starts again
+    double phase = std::fmod(time, swapPeriod);
+    qint32 car = static_cast<qint32>(time / swapPeriod) % CAR_COUNT;
+    AC_STATUS status = (phase >= (swapPeriod - MENU_DURATION_S)) ? AC_OFF : AC_LIVE;
+
+    if (status != m_graphics.status)
+    {
+        m_graphics.status = status;
+        m_graphicsChanged = true;
+    }
+
+    if ((status == AC_LIVE) && (car != m_car))
+    {
+        loadCar(car);
+        m_distance = 0.0;
+        m_graphics.completedLaps = 0;
+        m_graphicsChanged = true;
+    }
+}
+
+void Scenario::loadCar(qint32 car)
+{
+    const CarInfo &info = CARS[car];
+    copyString(m_static.carModel, info.model);
+    copyString(m_graphics.tyreCompound, "Semislicks");
+    m_static.maxRpm = info.maxRpm;
+    m_static.tyreRadius[0] = info.frontTyreRadius;
+    m_static.tyreRadius[1] = info.frontTyreRadius;
+    m_static.tyreRadius[2] = info.rearTyreRadius;
+    m_static.tyreRadius[3] = info.rearTyreRadius;
+    for (qint32 i = 0; i < 4; ++i)
+    {
+        m_static.suspensionMaxTravel[i] = 0.12f;
+    }
+
+    m_car = car;
+    m_staticChanged = true;
+}
+
+void Scenario::updateDriving(double time, double deltaTime)
+{
+    // Speed follows the corners of the track, gas and brake follow the speed
+    double wave = std::sin((2.0 * PI * time) / SPEED_WAVE_PERIOD_S);
+    double slope = std::cos((2.0 * PI * time) / SPEED_WAVE_PERIOD_S);
+    float speed = MIN_SPEED_KMH + (((MAX_SPEED_KMH - MIN_SPEED_KMH) * static_cast<float>(wave + 1.0)) / 2.0f);
+
+    m_physics.speedKmh = speed;
+    m_physics.gas = (slope > 0.0) ? qBound(0.0f, 0.4f + static_cast<float>(slope), 1.0f) : 0.0f;
+    m_physics.brake = (slope < -0.3) ? qBound(0.0f, static_cast<float>(-slope), 1.0f) : 0.0f;
+    m_physics.gear = qBound(1, static_cast<qint32>(speed / 40.0f) + 1, 6);
+    float gearPosition = std::fmod(speed, 40.0f) / 40.0f;
+    m_physics.rpms = 2000 + static_cast<qint32>(gearPosition * static_cast<float>(m_static.maxRpm - 2000));
+    m_physics.abs = CARS[m_car].abs;
+    m_physics.tc = CARS[m_car].tc;
+
+    double speedMs = static_cast<double>(speed) / 3.6;
+    m_physics.velocity[0] = 0.0f;
+    m_physics.velocity[1] = 0.0f;
+    m_physics.velocity[2] = static_cast<float>(speedMs);
+    m_distance += speedMs * deltaTime;
+
+    // Road texture on top of the body movement
+    for (qint32 i = 0; i < 4; ++i)
+    {
+        float tyreRadius = m_static.tyreRadius[i];
+        m_physics.wheelAngularSpeed[i] = rollingAngularSpeed(speed, tyreRadius);
+        m_physics.wheelSlip[i] = 0.0f;
+        m_physics.wheelLoad[i] = STATIC_WHEEL_LOAD_N + noise(150.0f);
+        m_physics.suspensionTravel[i] = 0.05f
+                + (0.004f * static_cast<float>(std::sin(2.0 * PI * 12.0 * time + i)))
+                + noise(0.001f);
+        m_physics.wheelsPressure[i] = 27.5f;
+        m_physics.tyreCoreTemperature[i] = 80.0f;
+    }
+
+    // Weight moves to the front when braking and to the rear when accelerating
+    float transfer = 800.0f * (m_physics.brake - (m_physics.gas * 0.5f));
+    m_physics.wheelLoad[0] += transfer;
+    m_physics.wheelLoad[1] += transfer;
+    m_physics.wheelLoad[2] -= transfer;
+    m_physics.wheelLoad[3] -= transfer;
+}
+
+void Scenario::applyEvent(ScenarioType event, double time)
+{
+    double phase = std::fmod(time, EVENT_PERIOD_S);
+    bool active = (phase < EVENT_DURATION_S);
+
+    if (event != FlagScenario)
+    {
+        m_flag = AC_NO_FLAG;
+    }
+
+    switch (event)
+    {
+    case LockUpScenario:
+        if (active)
+        {
+            // Front wheels stop under hard braking. With ABS they keep
+            // turning a bit slower than the car and slip less.
+            m_physics.gas = 0.0f;
+            m_physics.brake = 1.0f;
+            if (m_physics.abs > 0.0f)
+            {
+                m_physics.wheelAngularSpeed[0] *= 0.85f;
+                m_physics.wheelAngularSpeed[1] *= 0.85f;
+                m_physics.wheelSlip[0] = 20.0f + noise(5.0f);
+                m_physics.wheelSlip[1] = 20.0f + noise(5.0f);
+            }
+            else
+            {
+                m_physics.wheelAngularSpeed[0] = 0.0f;
+                m_physics.wheelAngularSpeed[1] = 0.0f;
+                m_physics.wheelSlip[0] = 80.0f + noise(10.0f);
+                m_physics.wheelSlip[1] = 80.0f + noise(10.0f);
+            }
+        }
+        break;
+
+    case WheelSpinScenario:
+        if (active)
+        {
+            // Rear wheels turn faster than the car is going. Traction
+            // control holds them closer to the speed of the car.
+            float spin = (m_physics.tc > 0.0f) ? 1.15f : 1.6f;
+            float slip = (m_physics.tc > 0.0f) ? 15.0f : 60.0f;
+            m_physics.gas = 1.0f;
+            m_physics.brake = 0.0f;
+            m_physics.wheelAngularSpeed[2] *= spin;
+            m_physics.wheelAngularSpeed[3] *= spin;
+            m_physics.wheelSlip[2] = slip + noise(slip / 6.0f);
+            m_physics.wheelSlip[3] = slip + noise(slip / 6.0f);
+        }
+        break;
+
+    case AirborneScenario:
+        if (phase < AIRBORNE_DURATION_S)
+        {
+            // Over a crest, every wheel leaves the ground
+            for (qint32 i = 0; i < 4; ++i)
+            {
+                m_physics.wheelLoad[i] = 0.0f;
+                m_physics.suspensionTravel[i] = 0.0f;
+            }
+        }
+        else if ((phase >= 2.0) && (phase < (2.0 + AIRBORNE_DURATION_S)))
+        {
+            // Over a kerb, only the inner wheels
+            m_physics.wheelLoad[0] = 0.0f;
+            m_physics.wheelLoad[2] = 0.0f;
+        }
+        break;
+
+    case FlagScenario:
+    {
+        qint32 flag = static_cast<qint32>(time / EVENT_PERIOD_S) % FLAG_COUNT;
+        m_flag = FLAGS[flag];
+        break;
+    }
+
+    case CruiseScenario:
+    case CarSwapScenario:
+    case MixedScenario:
+    default:
+        break;
+    }
+}
+
+void Scenario::updateGraphics(double time)
+{
+    if (!m_graphicsChanged && ((time - m_lastGraphicsTime) < GRAPHICS_INTERVAL_S))
+    {
+        return;
+    }
+
+    m_lastGraphicsTime = time;
+    m_graphicsChanged = true;
+
+    qint32 laps = static_cast<qint32>(m_distance / TRACK_LENGTH_M);
+    m_graphics.completedLaps = laps;
+    m_graphics.distanceTraveled = static_cast<float>(m_distance);
+    m_graphics.normalizedCarPosition = static_cast<float>(std::fmod(m_distance, TRACK_LENGTH_M) / TRACK_LENGTH_M);
+    m_graphics.currentSectorIndex = static_cast<qint32>(m_graphics.normalizedCarPosition * 3.0f);
+    m_graphics.iCurrentTime = static_cast<qint32>(time * 1000.0);
+    m_graphics.flag = m_flag;
+    m_graphics.surfaceGrip = 0.98f;
+    ++m_graphics.packetId;
+}
+
+float Scenario::noise(float amplitude)
+{
+    return m_noise(m_random) * amplitude;
+}
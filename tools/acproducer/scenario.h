@@ -0,0 +1,70 @@
+#ifndef SCENARIO_A7A9A50A3A0041ED90DA5A1850493498
+#define SCENARIO_A7A9A50A3A0041ED90DA5A1850493498
+
+#include <QString>
+#include <QStringList>
+#include <random>
+#include "sharedfileout.h"
+
+enum ScenarioType
+{
+    CruiseScenario,
+    LockUpScenario,
+    WheelSpinScenario,
+    AirborneScenario,
+    FlagScenario,
+    CarSwapScenario,
+    MixedScenario
+};
+
+// Generates the pages of a car driving laps on a made-up track, with
+// scripted events on top. The same type and seed always give the same
+// pages for the same step times.
+class Scenario
+{
+public:
+    Scenario(ScenarioType type, quint32 seed);
+
+    static bool fromName(const QString &name, ScenarioType &type);
+    static QStringList names();
+
+    // Advances to the given time since the start and updates the pages
+    void step(qint64 timeNs);
+
+    // The physics page only changes while live
+    bool physicsChanged() const;
+    bool graphicsChanged() const;
+    bool staticChanged() const;
+
+    const SPageFilePhysics& physics() const;
+    const SPageFileGraphic& graphics() const;
+    const SPageFileStatic& staticData() const;
+
+private:
+    ScenarioType activeEvent(double time) const;
+    void updateSession(double time);
+    void loadCar(qint32 car);
+    void updateDriving(double time, double deltaTime);
+    void applyEvent(ScenarioType event, double time);
+    void updateGraphics(double time);
+    float noise(float amplitude);
+
+    ScenarioType m_type;
+    std::mt19937 m_random;
+    std::uniform_real_distribution<float> m_noise;
+
+    SPageFilePhysics m_physics;
+    SPageFileGraphic m_graphics;
+    SPageFileStatic m_static;
+    bool m_physicsChanged = false;
+    bool m_graphicsChanged = false;
+    bool m_staticChanged = false;
+
+    double m_lastTime = 0.0;
+    double m_lastGraphicsTime = -1.0;
+    double m_distance = 0.0;
+    qint32 m_car = -1;
+    AC_FLAG_TYPE m_flag = AC_NO_FLAG;
+};
+
+#endif // SCENARIO_A7A9A50A3A0041ED90DA5A1850493498
@@ -0,0 +1,176 @@
+#include "sharedmemorywriter.h"
+#include <QDebug>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+
+#ifdef _WIN32
+static const char* const PHYSICS_NAME = "Local\\acpmf_physics";
+static const char* const GRAPHICS_NAME = "Local\\acpmf_graphics";
+static const char* const STATIC_NAME = "Local\\acpmf_static";
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "posixsharedmemorybackend.h"
+
+static const char* const PHYSICS_NAME = SHM_PHYSICS_NAME;
+static const char* const GRAPHICS_NAME = SHM_GRAPHICS_NAME;
+static const char* const STATIC_NAME = SHM_STATIC_NAME;
+#endif
+
+namespace
+{
+// Writes everything behind the packet id, then the packet id itself
+template <typename Page>
+void publish(const WriterSegment &segment, const Page &page)
+{
+    if (segment.buffer == nullptr)
+    {
+        return;
+    }
+
+    unsigned char* destination = static_cast<unsigned char*>(segment.buffer);
+    const unsigned char* source = reinterpret_cast<const unsigned char*>(&page);
+    std::memcpy(destination + sizeof(int), source + sizeof(int), sizeof(Page) - sizeof(int));
+
+    std::atomic_thread_fence(std::memory_order_release);
+    *static_cast<volatile int*>(segment.buffer) = page.packetId;
+}
+}
+
+SharedMemoryWriter::SharedMemoryWriter()
+{
+    m_physics = create(PHYSICS_NAME, sizeof(SPageFilePhysics));
+    m_graphics = create(GRAPHICS_NAME, sizeof(SPageFileGraphic));
+    m_static = create(STATIC_NAME, sizeof(SPageFileStatic));
+}
+
+SharedMemoryWriter::~SharedMemoryWriter()
+{
+    dismiss(m_physics, PHYSICS_NAME);
+    dismiss(m_graphics, GRAPHICS_NAME);
+    dismiss(m_static, STATIC_NAME);
+}
+
+bool SharedMemoryWriter::isOpen() const
+{
+    return ((m_physics.buffer != nullptr)
+            && (m_graphics.buffer != nullptr)
+            && (m_static.buffer != nullptr));
+}
+
+void SharedMemoryWriter::publishPhysics(const SPageFilePhysics &physics)
+{
+    publish(m_physics, physics);
+}
+
+void SharedMemoryWriter::publishGraphics(const SPageFileGraphic &graphics)
+{
+    publish(m_graphics, graphics);
+}
+
+void SharedMemoryWriter::publishStatic(const SPageFileStatic &staticData)
+{
+    if (m_static.buffer != nullptr)
+    {
+        std::memcpy(m_static.buffer, &staticData, sizeof(SPageFileStatic));
+    }
+}
+
+void SharedMemoryWriter::setUnlinkOnExit(bool unlinkOnExit)
+{
+    m_unlinkOnExit = unlinkOnExit;
+}
+
+#ifdef _WIN32
+
+WriterSegment SharedMemoryWriter::create(const char* name, size_t size)
+{
+    WriterSegment segment;
+    segment.mapFile = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, static_cast<DWORD>(size), name);
+    if (segment.mapFile == NULL)
+    {
+        qWarning() << "CreateFileMapping failed for" << name << ":" << GetLastError();
+        return segment;
+    }
+
+    segment.buffer = MapViewOfFile(segment.mapFile, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (segment.buffer == NULL)
+    {
+        qWarning() << "MapViewOfFile failed for" << name << ":" << GetLastError();
+        CloseHandle(segment.mapFile);
+        segment.mapFile = nullptr;
+        return segment;
+    }
+
+    segment.size = size;
+    return segment;
+}
+
+void SharedMemoryWriter::dismiss(WriterSegment &segment, const char* name)
+{
+    (void)name;
+    if (segment.buffer != nullptr)
+    {
+        UnmapViewOfFile(segment.buffer);
+        segment.buffer = nullptr;
+    }
+
+    if (segment.mapFile != nullptr)
+    {
+        CloseHandle(segment.mapFile);
+        segment.mapFile = nullptr;
+    }
+}
+
+#else
+
+WriterSegment SharedMemoryWriter::create(const char* name, size_t size)
+{
+    WriterSegment segment;
+    int fd = shm_open(name, O_RDWR | O_CREAT, 0666);
+    if (fd < 0)
+    {
+        qWarning() << "shm_open failed for" << name << ":" << strerror(errno);
+        return segment;
+    }
+
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0)
+    {
+        qWarning() << "ftruncate failed for" << name << ":" << strerror(errno);
+        close(fd);
+        return segment;
+    }
+
+    void* buffer = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (buffer == MAP_FAILED)
+    {
+        qWarning() << "mmap failed for" << name << ":" << strerror(errno);
+        return segment;
+    }
+
+    segment.buffer = buffer;
+    segment.size = size;
+    return segment;
+}
+
+void SharedMemoryWriter::dismiss(WriterSegment &segment, const char* name)
+{
+    if (segment.buffer != nullptr)
+    {
+        munmap(segment.buffer, segment.size);
+        segment.buffer = nullptr;
+        segment.size = 0;
+    }
+
+    if (m_unlinkOnExit)
+    {
+        (void)shm_unlink(name);
+    }
+}
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef SHAREDMEMORYWRITER_B8D1FE1EE5A04384BAF5ACA8186C8665
+#define SHAREDMEMORYWRITER_B8D1FE1EE5A04384BAF5ACA8186C8665
+
+#include <cstddef>
+#include "sharedfileout.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+struct WriterSegment
+{
+    void* buffer = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    HANDLE mapFile = nullptr;
+#endif
+};
+
+// Creates the three pages the game would create and publishes new
+// contents into them. The page body is written first and the packet id
+// last. The game does not document its order, so the reader does not rely
+// on it and compares two copies of the page as well.
+class SharedMemoryWriter
+{
+public:
+    SharedMemoryWriter();
+    ~SharedMemoryWriter();
+
+    SharedMemoryWriter(const SharedMemoryWriter&) = delete;
+    SharedMemoryWriter& operator=(const SharedMemoryWriter&) = delete;
+
+    bool isOpen() const;
+
+    void publishPhysics(const SPageFilePhysics &physics);
+    void publishGraphics(const SPageFileGraphic &graphics);
+    void publishStatic(const SPageFileStatic &staticData);
+
+    // Removes the segments when the writer is destroyed (POSIX only)
+    void setUnlinkOnExit(bool unlinkOnExit);
+
+private:
+    WriterSegment create(const char* name, size_t size);
+    void dismiss(WriterSegment &segment, const char* name);
+
+    WriterSegment m_physics;
+    WriterSegment m_graphics;
+    WriterSegment m_static;
+    bool m_unlinkOnExit = false;
+};
+
+#endif // SHAREDMEMORYWRITER_B8D1FE1EE5A04384BAF5ACA8186C8665
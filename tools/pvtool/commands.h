@@ -0,0 +1,19 @@
+#ifndef COMMANDS_32356E85658041378F4BFF6467A330EF
+#define COMMANDS_32356E85658041378F4BFF6467A330EF
+
+#include <QStringList>
+
+// Every command gets its name followed by its own arguments and returns
+// the exit code of the tool
+int runReplayCommand(const QStringList &arguments);
+int runCompressCommand(const QStringList &arguments);
+int runSlipCheckCommand(const QStringList &arguments);
+int runSpectrumCommand(const QStringList &arguments);
+int runSweepCommand(const QStringList &arguments);
+int runSerialBenchCommand(const QStringList &arguments);
+int runProtocolBenchCommand(const QStringList &arguments);
+int runProtocolFuzzCommand(const QStringList &arguments);
+int runPortWatchCommand(const QStringList &arguments);
+int runMailboxStressCommand(const QStringList &arguments);
+
+#endif // COMMANDS_32356E85658041378F4BFF6467A330EF
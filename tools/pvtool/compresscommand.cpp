@@ -0,0 +1,223 @@
+#include <QCommandLineParser>
+#include <QTextStream>
+#include <QVector>
+#include <cstring>
+#include "commands.h"
+#include "acquisitionthread.h"
+#include "framecodec.h"
+#include "telemetryrecording.h"
+
+static const qint32 PAGE_SLOT_SIZE = (sizeof(SPageFilePhysics) > sizeof(SPageFileGraphic)) ? sizeof(SPageFilePhysics) : sizeof(SPageFileGraphic);
+
+namespace
+{
+struct PageList
+{
+    QVector<uchar> data;
+    QVector<RecordType> types;
+    QVector<qint64> timestamps;
+
+    // Set for the first page after a static page, blocks end there
+    QVector<bool> keyFrames;
+
+    qint64 rawBytes = 0;
+
+    qint32 count() const
+    {
+        return types.size();
+    }
+
+    const uchar* page(qint32 index) const
+    {
+        return data.constData() + (static_cast<qint64>(index) * PAGE_SLOT_SIZE);
+    }
+};
+
+void appendPage(PageList &pages, const RecordView &record, bool keyFrame)
+{
+    qint32 index = pages.count();
+    pages.data.resize((index + 1) * PAGE_SLOT_SIZE);
+    std::memcpy(pages.data.data() + (static_cast<qint64>(index) * PAGE_SLOT_SIZE), record.payload, record.size);
+    pages.types.append(record.type);
+    pages.timestamps.append(record.timestampNs);
+    pages.keyFrames.append(keyFrame);
+    pages.rawBytes += record.size;
+}
+
+// Loads the physics and graphics pages of a recording, compressed or not
+bool loadPages(const TelemetryRecording &recording, qint32 maxPages, PageList &pages)
+{
+    FrameBlockDecoder decoder;
+    bool keyFrame = true;
+    qint64 offset = recording.firstOffset();
+    RecordView record;
+    while ((pages.count() < maxPages) && recording.readRecord(offset, record))
+    {
+        offset = record.nextOffset;
+        switch (record.type)
+        {
+        case StaticRecord:
+            keyFrame = true;
+            break;
+
+        case PhysicsRecord:
+        case GraphicsRecord:
+            appendPage(pages, record, keyFrame);
+            keyFrame = false;
+            break;
+
+        case CompressedBlockRecord:
+            if (!decoder.decode(record.payload, record.size))
+            {
+                return false;
+            }
+
+            for (qint32 i = 0; (i < decoder.count()) && (pages.count() < maxPages); ++i)
+            {
+                appendPage(pages, decoder.page(i), keyFrame);
+                keyFrame = false;
+            }
+            break;
+
+        case InvalidRecord:
+        default:
+            break;
+        }
+    }
+
+    return true;
+}
+
+double megabytesPerSecond(qint64 bytes, qint64 ns)
+{
+    if (ns <= 0)
+    {
+        return 0.0;
+    }
+
+    return (static_cast<double>(bytes) / (1024.0 * 1024.0)) / (static_cast<double>(ns) / 1e9);
+}
+}
+
+int runCompressCommand(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Compresses the pages of a recording like the recorder does and reports "
+                                     "the compression ratio and the encoding and decoding speed.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("recording", "Recording (*.pvrec), compressed or not");
+    QCommandLineOption pagesOption("pages", "Only use the first pages of the recording", "count", "1000000");
+    parser.addOption(pagesOption);
+    parser.process(arguments);
+
+    QTextStream out(stdout);
+    if (parser.positionalArguments().size() != 1)
+    {
+        parser.showHelp(1);
+    }
+
+    TelemetryRecording recording;
+    if (!recording.open(parser.positionalArguments().first()))
+    {
+        out << "Cannot open " << parser.positionalArguments().first() << "\n";
+        return 1;
+    }
+
+    PageList pages;
+    if (!loadPages(recording, qMax(1, parser.value(pagesOption).toInt()), pages))
+    {
+        out << "Recording contains a damaged block\n";
+        return 1;
+    }
+
+    if (pages.count() == 0)
+    {
+        out << "Recording contains no pages\n";
+        return 1;
+    }
+
+    // Encode, keeping the blocks in memory
+    FrameBlockEncoder encoder;
+    QVector<uchar> blocks;
+    QVector<qint64> blockOffsets;
+    blocks.reserve(static_cast<qint32>(qMin<qint64>(pages.rawBytes / 4, 0x40000000)));
+    auto storeBlock = [&]()
+    {
+        quint32 size = encoder.finish();
+        blockOffsets.append(blocks.size());
+        blocks.resize(blocks.size() + static_cast<qint32>(size));
+        std::memcpy(blocks.data() + blockOffsets.last(), encoder.data(), size);
+    };
+
+    qint64 encodeStartNs = AcquisitionThread::now();
+    for (qint32 i = 0; i <= pages.count(); ++i)
+    {
+        bool end = (i == pages.count());
+        if (!encoder.isEmpty() && (end || pages.keyFrames[i]))
+        {
+            storeBlock();
+        }
+
+        if (end)
+        {
+            break;
+        }
+
+        if (!encoder.add(pages.types[i], pages.timestamps[i], pages.page(i)))
+        {
+            storeBlock();
+            (void)encoder.add(pages.types[i], pages.timestamps[i], pages.page(i));
+        }
+    }
+    qint64 encodeNs = AcquisitionThread::now() - encodeStartNs;
+    blockOffsets.append(blocks.size());
+
+    // Decode every block, then compare the pages outside of the timing
+    FrameBlockDecoder decoder;
+    quint64 decodedPages = 0;
+    qint64 decodeStartNs = AcquisitionThread::now();
+    for (qint32 block = 0; (block + 1) < blockOffsets.size(); ++block)
+    {
+        qint64 offset = blockOffsets[block];
+        if (decoder.decode(blocks.constData() + offset, static_cast<quint32>(blockOffsets[block + 1] - offset)))
+        {
+            decodedPages += static_cast<quint64>(decoder.count());
+        }
+    }
+    qint64 decodeNs = AcquisitionThread::now() - decodeStartNs;
+
+    qint32 page = 0;
+    quint64 mismatches = 0;
+    for (qint32 block = 0; (block + 1) < blockOffsets.size(); ++block)
+    {
+        qint64 offset = blockOffsets[block];
+        if (!decoder.decode(blocks.constData() + offset, static_cast<quint32>(blockOffsets[block + 1] - offset)))
+        {
+            ++mismatches;
+            continue;
+        }
+
+        for (qint32 i = 0; (i < decoder.count()) && (page < pages.count()); ++i, ++page)
+        {
+            RecordView record = decoder.page(i);
+            if ((record.type != pages.types[page])
+                    || (record.timestampNs != pages.timestamps[page])
+                    || (std::memcmp(record.payload, pages.page(page), record.size) != 0))
+            {
+                ++mismatches;
+            }
+        }
+    }
+
+    qint64 compressedBytes = blocks.size();
+    double ratio = static_cast<double>(pages.rawBytes) / static_cast<double>(qMax<qint64>(1, compressedBytes));
+    out << pages.count() << " pages in " << (blockOffsets.size() - 1) << " blocks\n"
+        << "Raw:        " << pages.rawBytes << " bytes\n"
+        << "Compressed: " << compressedBytes << " bytes, ratio " << QString::number(ratio, 'f', 2) << "\n"
+        << "Encoding:   " << QString::number(megabytesPerSecond(pages.rawBytes, encodeNs), 'f', 1) << " MB/s\n"
+        << "Decoding:   " << QString::number(megabytesPerSecond(pages.rawBytes, decodeNs), 'f', 1) << " MB/s ("
+        << decodedPages << " pages)\n"
+        << "Round trip: " << ((mismatches == 0) ? QString("identical") : QString("%1 pages differ").arg(mismatches)) << "\n";
+
+    return (mismatches == 0) ? 0 : 1;
+}
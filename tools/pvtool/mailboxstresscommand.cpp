@@ -0,0 +1,116 @@
+#include <QCommandLineParser>
+#include <QTextStream>
+#include <atomic>
+#include <thread>
+#include "commands.h"
+#include "acquisitionthread.h"
+#include "latestvaluemailbox.h"
+#include "serialthread.h"
+
+namespace
+{
+// The sequence number and its complement fill the frame, a frame mixed from
+// two pushes does not match itself
+SerialFrame createFrame(quint32 sequence)
+{
+    SerialFrame frame;
+    frame.size = SerialFrame::MAX_SIZE;
+    for (qint32 i = 0; i < 4; ++i)
+    {
+        frame.data[i] = static_cast<char>(sequence >> (8 * i));
+        frame.data[i + 4] = static_cast<char>(~sequence >> (8 * i));
+    }
+
+    return frame;
+}
+
+bool readFrame(const SerialFrame &frame, quint32 &sequence)
+{
+    sequence = 0;
+    quint32 complement = 0;
+    for (qint32 i = 0; i < 4; ++i)
+    {
+        sequence |= static_cast<quint32>(static_cast<quint8>(frame.data[i])) << (8 * i);
+        complement |= static_cast<quint32>(static_cast<quint8>(frame.data[i + 4])) << (8 * i);
+    }
+
+    return ((frame.size == SerialFrame::MAX_SIZE) && (sequence == ~complement));
+}
+}
+
+int runMailboxStressCommand(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Pushes frames through one serial mailbox from one thread and takes them "
+                                     "in another, as fast as both can. No frame may be torn or come out of "
+                                     "order, and every frame has to be taken or replaced by a newer one.");
+    parser.addHelpOption();
+    QCommandLineOption framesOption("frames", "Number of frames", "count", "20000000");
+    parser.addOption(framesOption);
+    parser.process(arguments);
+
+    QTextStream out(stdout);
+    quint32 frameCount = qMax(1u, parser.value(framesOption).toUInt());
+
+    LatestValueMailbox<SerialFrame> mailbox;
+    std::atomic<bool> done {false};
+    quint64 taken = 0;
+    quint64 torn = 0;
+    quint64 reordered = 0;
+
+    // Consumer side, like a flush of the serial thread
+    std::thread consumer([&]()
+    {
+        SerialFrame frame;
+        quint32 sequence = 0;
+        qint64 last = -1;
+        bool finished = false;
+        while (!finished)
+        {
+            // Everything was pushed before done is set, one more take gets the rest
+            finished = done.load(std::memory_order_acquire);
+            while (mailbox.take(frame))
+            {
+                ++taken;
+                if (!readFrame(frame, sequence))
+                {
+                    ++torn;
+                    continue;
+                }
+
+                if (static_cast<qint64>(sequence) <= last)
+                {
+                    ++reordered;
+                }
+                last = sequence;
+            }
+        }
+    });
+
+    qint64 startNs = AcquisitionThread::now();
+    quint64 wakeUps = 0;
+    for (quint32 sequence = 0; sequence < frameCount; ++sequence)
+    {
+        if (mailbox.push(createFrame(sequence)))
+        {
+            ++wakeUps;
+        }
+    }
+    done.store(true, std::memory_order_release);
+    consumer.join();
+    qint64 elapsedNs = AcquisitionThread::now() - startNs;
+
+    quint64 overwritten = mailbox.overwritten();
+    out << frameCount << " frames pushed in " << (elapsedNs / 1000000) << " ms, "
+        << QString::number(static_cast<double>(elapsedNs) / frameCount, 'f', 1) << " ns per frame\n"
+        << "Taken: " << taken << " | replaced: " << overwritten << " | pushes into an empty mailbox: " << wakeUps << "\n"
+        << "Torn: " << torn << " | out of order: " << reordered << "\n";
+
+    if ((taken + overwritten) != frameCount)
+    {
+        out << "Frames lost: taken and replaced do not add up to the pushed frames\n";
+        return 1;
+    }
+
+    return ((torn == 0) && (reordered == 0)) ? 0 : 1;
+}
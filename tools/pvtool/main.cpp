@@ -0,0 +1,118 @@
+#include <QCoreApplication>
+#include <QSettings>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <cstdio>
+#include "commands.h"
+
+static bool s_verbose = false;
+
+static void messageHandler(QtMsgType type, const QMessageLogContext &context, const QString &message)
+{
+    (void)context;
+
+    // The pipeline logs a lot while live, which would dominate any benchmark
+    if ((type == QtDebugMsg) && !s_verbose)
+    {
+        return;
+    }
+
+    fprintf(stderr, "%s\n", qPrintable(message));
+}
+
+static void printUsage()
+{
+    QTextStream out(stdout);
+    out << "Usage: pvtool [--verbose] <command> [options]\n"
+        << "\n"
+        << "Commands:\n"
+        << "  replay    Feed a recording through the telemetry pipeline\n"
+        << "  compress  Measure the compression of a recording\n"
+        << "  slipcheck Compare the wheel slip kernel with its scalar reference\n"
+        << "  spectrum  Benchmark the suspension spectrum of the road texture effect\n"
+        << "  sweep     Tune brake, gas and bumping indices on recordings\n"
+        << "  serialbench Measure the serial thread with many devices\n"
+        << "  protocolbench Compare encoding and decoding of serial protocol v1 and v2\n"
+        << "  protocolfuzz  Feed corrupted protocol v2 frames to the decoder\n"
+        << "  portwatch Show serial ports being plugged in and the reconnects of devices\n"
+        << "  mailboxstress Push frames through a serial mailbox from two threads\n"
+        << "\n"
+        << "Use pvtool <command> --help for the options of a command.\n";
+}
+
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    // Settings that only live as long as the tool runs, so a run neither
+    // depends on earlier runs nor changes the settings of the application.
+    // Commands take everything they need as options.
+    QTemporaryDir settingsDirectory;
+    QSettings::setDefaultFormat(QSettings::IniFormat);
+    QSettings::setPath(QSettings::IniFormat, QSettings::UserScope, settingsDirectory.path());
+    QSettings::setPath(QSettings::IniFormat, QSettings::SystemScope, settingsDirectory.path());
+    QCoreApplication::setOrganizationName("Lumlum Software");
+    QCoreApplication::setApplicationName("pvtool");
+
+    QStringList arguments = QCoreApplication::arguments();
+    arguments.removeFirst();
+    if (!arguments.isEmpty() && (arguments.first() == "--verbose"))
+    {
+        s_verbose = true;
+        arguments.removeFirst();
+    }
+
+    qInstallMessageHandler(messageHandler);
+
+    if (arguments.isEmpty())
+    {
+        printUsage();
+        return 1;
+    }
+
+    QString command = arguments.first();
+    if (command == "replay")
+    {
+        return runReplayCommand(arguments);
+    }
+    else if (command == "compress")
+    {
+        return runCompressCommand(arguments);
+    }
+    else if (command == "slipcheck")
+    {
+        return runSlipCheckCommand(arguments);
+    }
+    else if (command == "spectrum")
+    {
+        return runSpectrumCommand(arguments);
+    }
+    else if (command == "sweep")
+    {
+        return runSweepCommand(arguments);
+    }
+    else if (command == "serialbench")
+    {
+        return runSerialBenchCommand(arguments);
+    }
+    else if (command == "protocolbench")
+    {
+        return runProtocolBenchCommand(arguments);
+    }
+    else if (command == "protocolfuzz")
+    {
+        return runProtocolFuzzCommand(arguments);
+    }
+    else if (command == "portwatch")
+    {
+        return runPortWatchCommand(arguments);
+    }
+    else if (command == "mailboxstress")
+    {
+        return runMailboxStressCommand(arguments);
+    }
+
+    printUsage();
+    return 1;
+}
@@ -0,0 +1,80 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QTextStream>
+#include <QTimer>
+#include "commands.h"
+#include "acquisitionthread.h"
+#include "sender.h"
+#include "serialthread.h"
+
+int runPortWatchCommand(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Prints serial ports that are plugged in or removed. With --port the LED "
+                                     "flag of the given devices is toggled every tick, so unplugging and "
+                                     "plugging them in shows the reconnects and the downtime.");
+    parser.addHelpOption();
+    QCommandLineOption portOption("port", "Port to send to, can be given more than once", "name");
+    QCommandLineOption rateOption("rate", "Messages per second and device", "hz", "10");
+    QCommandLineOption secondsOption("seconds", "Duration", "seconds", "60");
+    parser.addOption(portOption);
+    parser.addOption(rateOption);
+    parser.addOption(secondsOption);
+    parser.process(arguments);
+
+    QTextStream out(stdout);
+    double seconds = qMax(0.1, parser.value(secondsOption).toDouble());
+    qint32 intervalMs = qMax(1, static_cast<qint32>(1000.0 / qMax(0.1, parser.value(rateOption).toDouble())));
+
+    SerialThread serialThread;
+    QTimer sendTimer;
+    QTimer reportTimer;
+
+    // The signals come from the serial thread, the timers take them to this one
+    (void)QObject::connect(&serialThread, &SerialThread::error, &reportTimer, [&out](const QString &error)
+    {
+        out << "Serial error: " << error << "\n";
+        out.flush();
+    });
+    (void)QObject::connect(&serialThread, &SerialThread::portAppeared, &reportTimer, [&out](const QString &portName)
+    {
+        out << QString::number(static_cast<double>(AcquisitionThread::now()) / 1e9, 'f', 3) << " " << portName << " appeared\n";
+        out.flush();
+    });
+    (void)QObject::connect(&serialThread, &SerialThread::portDisappeared, &reportTimer, [&out](const QString &portName)
+    {
+        out << QString::number(static_cast<double>(AcquisitionThread::now()) / 1e9, 'f', 3) << " " << portName << " disappeared\n";
+        out.flush();
+    });
+
+    QList<qint32> handles;
+    for (const QString &port : parser.values(portOption))
+    {
+        handles.append(serialThread.addPort(port));
+    }
+
+    quint8 flag = 0;
+    (void)QObject::connect(&sendTimer, &QTimer::timeout, [&serialThread, &handles, &flag]()
+    {
+        flag ^= 1;
+        for (qint32 handle : handles)
+        {
+            (void)serialThread.transaction(handle, Sender::encodeLedFlagValue(flag));
+        }
+    });
+    sendTimer.start(intervalMs);
+
+    (void)QObject::connect(&reportTimer, &QTimer::timeout, [&serialThread, &out]()
+    {
+        for (const PortHealth &health : serialThread.portHealth())
+        {
+            out << health.port << ": " << (health.connected ? "connected" : "disconnected") << ", "
+                << health.reconnects << " reconnects, " << (health.downtimeNs / 1000000) << " ms downtime\n";
+        }
+        out.flush();
+    });
+    reportTimer.start(1000);
+
+    QTimer::singleShot(static_cast<qint32>(seconds * 1000.0), QCoreApplication::instance(), &QCoreApplication::quit);
+    return QCoreApplication::exec();
+}
@@ -0,0 +1,188 @@
+#include <QCommandLineParser>
+#include <QTextStream>
+#include <QVector>
+#include <cstring>
+#include <random>
+#include "commands.h"
+#include "acquisitionthread.h"
+#include "globals.h"
+#include "protocolv2.h"
+#include "sender.h"
+
+namespace
+{
+// What the sender hands to a port at one tick: per-wheel slip, fan and LED
+const qint32 MESSAGES_PER_BATCH = 3;
+
+struct Result
+{
+    qint64 encodeNs = 0;
+    qint64 decodeNs = 0;
+    qint64 bytes = 0;
+    quint64 checksum = 0;
+    quint64 messages = 0;
+};
+
+QVector<SerialFrame> createMessages(qint32 batches)
+{
+    std::mt19937 random(1);
+    std::uniform_int_distribution<qint32> value(0, 127);
+
+    QVector<SerialFrame> messages;
+    messages.reserve(batches * MESSAGES_PER_BATCH);
+    for (qint32 i = 0; i < batches; ++i)
+    {
+        messages.append(Sender::encodePerWheelSlipValues(static_cast<quint8>(value(random) & 0x0f),
+                                                         static_cast<quint8>(value(random)), static_cast<quint8>(value(random)),
+                                                         static_cast<quint8>(value(random)), static_cast<quint8>(value(random))));
+        messages.append(Sender::encodeWindFanValue(static_cast<quint8>(value(random))));
+        messages.append(Sender::encodeLedFlagValue(static_cast<quint8>(value(random))));
+    }
+
+    return messages;
+}
+
+qint32 v1MessageSize(quint8 id)
+{
+    switch (id)
+    {
+    case ID::WheelSlip:
+        return 3;
+    case ID::WheelSlipPerWheel:
+        return 6;
+    default:
+        return 2;
+    }
+}
+
+// Legacy messages back to back, like a flush of the serial thread
+Result runV1(const QVector<SerialFrame> &messages)
+{
+    Result result;
+    QByteArray stream(messages.size() * SerialFrame::MAX_SIZE, '\0');
+    char* output = stream.data();
+
+    qint64 startNs = AcquisitionThread::now();
+    for (const SerialFrame &message : messages)
+    {
+        std::memcpy(output + result.bytes, message.data, message.size);
+        result.bytes += message.size;
+    }
+    result.encodeNs = AcquisitionThread::now() - startNs;
+
+    // A message starts at the next byte with the start bit
+    const quint8* data = reinterpret_cast<const quint8*>(stream.constData());
+    startNs = AcquisitionThread::now();
+    qint64 index = 0;
+    while (index < result.bytes)
+    {
+        if ((data[index] & START_BIT) == 0)
+        {
+            ++index;
+            continue;
+        }
+
+        qint32 size = v1MessageSize(data[index] & ~START_BIT);
+        if ((index + size) > result.bytes)
+        {
+            break;
+        }
+
+        for (qint32 i = 1; i < size; ++i)
+        {
+            result.checksum += data[index + i];
+        }
+        ++result.messages;
+        index += size;
+    }
+    result.decodeNs = AcquisitionThread::now() - startNs;
+
+    return result;
+}
+
+// One frame per batch, encoded straight into the stream
+Result runV2(const QVector<SerialFrame> &messages)
+{
+    Result result;
+    qint32 batches = messages.size() / MESSAGES_PER_BATCH;
+    QByteArray stream(batches * ProtocolV2::MAX_FRAME_SIZE, '\0');
+    quint8* output = reinterpret_cast<quint8*>(stream.data());
+
+    ProtocolV2::FrameEncoder encoder;
+    qint64 startNs = AcquisitionThread::now();
+    for (qint32 batch = 0; batch < batches; ++batch)
+    {
+        encoder.begin(static_cast<quint8>(batch));
+        for (qint32 i = 0; i < MESSAGES_PER_BATCH; ++i)
+        {
+            const SerialFrame &message = messages.at((batch * MESSAGES_PER_BATCH) + i);
+            (void)encoder.addChannel(static_cast<quint8>(message.data[0] & ~START_BIT),
+                                     reinterpret_cast<const quint8*>(message.data + 1), message.size - 1);
+        }
+        result.bytes += encoder.finish(output + result.bytes);
+    }
+    result.encodeNs = AcquisitionThread::now() - startNs;
+
+    ProtocolV2::FrameDecoder decoder;
+    startNs = AcquisitionThread::now();
+    decoder.feed(output, static_cast<qint32>(result.bytes), [&result](const ProtocolV2::FrameDecoder &frame)
+    {
+        for (qint32 i = 0; i < frame.channelCount(); ++i)
+        {
+            const ProtocolV2::ChannelView &channel = frame.channel(i);
+            for (qint32 j = 0; j < channel.size; ++j)
+            {
+                result.checksum += channel.value[j];
+            }
+            ++result.messages;
+        }
+    });
+    result.decodeNs = AcquisitionThread::now() - startNs;
+
+    return result;
+}
+
+QString describe(const Result &result, qint32 batches)
+{
+    double count = static_cast<double>(batches);
+    return QString("%1 bytes per batch, encode %2 ns (%3 MB/s), decode %4 ns (%5 MB/s) per batch")
+            .arg(static_cast<double>(result.bytes) / count, 0, 'f', 1)
+            .arg(static_cast<double>(result.encodeNs) / count, 0, 'f', 1)
+            .arg((static_cast<double>(result.bytes) * 1e3) / static_cast<double>(qMax<qint64>(1, result.encodeNs)), 0, 'f', 0)
+            .arg(static_cast<double>(result.decodeNs) / count, 0, 'f', 1)
+            .arg((static_cast<double>(result.bytes) * 1e3) / static_cast<double>(qMax<qint64>(1, result.decodeNs)), 0, 'f', 0);
+}
+}
+
+int runProtocolBenchCommand(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Measures encoding and decoding of the legacy serial messages against "
+                                     "protocol v2 frames, one batch of per-wheel slip, fan and LED per tick.");
+    parser.addHelpOption();
+    QCommandLineOption batchesOption("batches", "Number of batches", "count", "1000000");
+    parser.addOption(batchesOption);
+    parser.process(arguments);
+
+    QTextStream out(stdout);
+    qint32 batches = qMax(1, parser.value(batchesOption).toInt());
+    QVector<SerialFrame> messages = createMessages(batches);
+
+    Result v1 = runV1(messages);
+    Result v2 = runV2(messages);
+
+    out << batches << " batches of " << MESSAGES_PER_BATCH << " messages\n"
+        << "v1: " << describe(v1, batches) << "\n"
+        << "v2: " << describe(v2, batches) << "\n";
+
+    if ((v1.messages != v2.messages) || (v1.checksum != v2.checksum)
+            || (v2.messages != static_cast<quint64>(messages.size())))
+    {
+        out << "Decoded messages differ: v1 " << v1.messages << " (checksum " << v1.checksum << "), v2 "
+            << v2.messages << " (checksum " << v2.checksum << ")\n";
+        return 1;
+    }
+
+    out << "Both decode all " << v2.messages << " messages (checksum " << v2.checksum << ")\n";
+    return 0;
+}
@@ -0,0 +1,254 @@
+#include <QCommandLineParser>
+#include <QTextStream>
+#include <QVector>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "commands.h"
+#include "protocolv2.h"
+
+namespace
+{
+struct SentFrame
+{
+    quint8 sequence = 0;
+    // Type, size and value of every channel as in the frame
+    QVector<quint8> channels;
+    // Neither this frame nor the delimiter before it were touched, the
+    // decoder has to find it
+    bool intact = true;
+};
+
+std::vector<quint8> encodeFrame(const SentFrame &frame)
+{
+    ProtocolV2::FrameEncoder encoder;
+    encoder.begin(frame.sequence);
+    qint32 index = 0;
+    while (index < frame.channels.size())
+    {
+        quint8 size = frame.channels.at(index + 1);
+        (void)encoder.addChannel(frame.channels.at(index), frame.channels.constData() + index + 2, size);
+        index += ProtocolV2::channelSize(size);
+    }
+
+    std::vector<quint8> bytes(ProtocolV2::MAX_FRAME_SIZE);
+    bytes.resize(static_cast<size_t>(encoder.finish(bytes.data())));
+    return bytes;
+}
+
+bool matches(const ProtocolV2::FrameDecoder &decoder, const SentFrame &frame)
+{
+    if (decoder.sequence() != frame.sequence)
+    {
+        return false;
+    }
+
+    QVector<quint8> channels;
+    for (qint32 i = 0; i < decoder.channelCount(); ++i)
+    {
+        const ProtocolV2::ChannelView &channel = decoder.channel(i);
+        channels.append(channel.type);
+        channels.append(channel.size);
+        for (qint32 j = 0; j < channel.size; ++j)
+        {
+            channels.append(channel.value[j]);
+        }
+    }
+
+    return (channels == frame.channels);
+}
+
+// Random payloads with many zeros survive COBS unchanged
+bool checkCobs(std::mt19937 &random, qint32 rounds)
+{
+    std::uniform_int_distribution<qint32> length(0, 600);
+    std::uniform_int_distribution<qint32> byte(0, 255);
+    for (qint32 round = 0; round < rounds; ++round)
+    {
+        std::vector<quint8> input(static_cast<size_t>(length(random)));
+        for (quint8 &value : input)
+        {
+            value = ((byte(random) & 3) == 0) ? 0 : static_cast<quint8>(byte(random));
+        }
+
+        std::vector<quint8> encoded(input.size() + 2 + (input.size() / 254));
+        qint32 size = ProtocolV2::cobsEncode(input.data(), static_cast<qint32>(input.size()), encoded.data());
+        for (qint32 i = 0; i < size; ++i)
+        {
+            if (encoded[static_cast<size_t>(i)] == 0)
+            {
+                return false;
+            }
+        }
+
+        std::vector<quint8> decoded(encoded.size());
+        if ((ProtocolV2::cobsDecode(encoded.data(), size, decoded.data()) != static_cast<qint32>(input.size()))
+                || !std::equal(input.begin(), input.end(), decoded.begin()))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+}
+
+int runProtocolFuzzCommand(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Feeds protocol v2 frames with random bit flips, lost, inserted and "
+                                     "overwritten bytes to the decoder. Every frame it accepts has to be one "
+                                     "that was sent, and every frame that was not touched has to come through.");
+    parser.addHelpOption();
+    QCommandLineOption framesOption("frames", "Number of frames", "count", "1000000");
+    QCommandLineOption corruptOption("corrupt", "Share of corrupted frames", "ratio", "0.1");
+    QCommandLineOption seedOption("seed", "Seed of the random numbers", "seed", "1");
+    parser.addOption(framesOption);
+    parser.addOption(corruptOption);
+    parser.addOption(seedOption);
+    parser.process(arguments);
+
+    QTextStream out(stdout);
+    qint32 frameCount = qMax(1, parser.value(framesOption).toInt());
+    double corruptRatio = qBound(0.0, parser.value(corruptOption).toDouble(), 1.0);
+    std::mt19937 random(parser.value(seedOption).toUInt());
+
+    if (ProtocolV2::crc16(reinterpret_cast<const quint8*>("123456789"), 9) != 0x29b1)
+    {
+        out << "CRC-16 does not match the check value\n";
+        return 1;
+    }
+
+    if (!checkCobs(random, 10000))
+    {
+        out << "COBS round trip failed\n";
+        return 1;
+    }
+
+    std::uniform_int_distribution<qint32> byte(0, 255);
+    std::uniform_int_distribution<qint32> channelCount(1, 4);
+    std::uniform_int_distribution<qint32> valueSize(0, 7);
+    std::uniform_int_distribution<qint32> mutation(0, 3);
+    std::uniform_real_distribution<double> chance(0.0, 1.0);
+
+    QVector<SentFrame> sent;
+    sent.reserve(frameCount);
+    std::vector<quint8> stream;
+    quint64 corrupted = 0;
+    bool delimiterIntact = true;
+    for (qint32 n = 0; n < frameCount; ++n)
+    {
+        SentFrame frame;
+        frame.sequence = static_cast<quint8>(n);
+        qint32 channels = channelCount(random);
+        for (qint32 c = 0; c < channels; ++c)
+        {
+            qint32 size = valueSize(random);
+            frame.channels.append(static_cast<quint8>(byte(random) & 0x0f));
+            frame.channels.append(static_cast<quint8>(size));
+            for (qint32 i = 0; i < size; ++i)
+            {
+                frame.channels.append(static_cast<quint8>(byte(random)));
+            }
+        }
+
+        std::vector<quint8> bytes = encodeFrame(frame);
+        frame.intact = delimiterIntact;
+        if (chance(random) < corruptRatio)
+        {
+            frame.intact = false;
+            ++corrupted;
+            std::uniform_int_distribution<size_t> position(0, bytes.size() - 1);
+            switch (mutation(random))
+            {
+            case 0:
+                bytes[position(random)] ^= static_cast<quint8>(1 << (byte(random) & 7));
+                break;
+            case 1:
+                bytes.erase(bytes.begin() + static_cast<std::ptrdiff_t>(position(random)));
+                break;
+            case 2:
+                (void)bytes.insert(bytes.begin() + static_cast<std::ptrdiff_t>(position(random)), static_cast<quint8>(byte(random)));
+                break;
+            default:
+            {
+                size_t start = position(random);
+                size_t end = qMin(bytes.size(), start + 1 + static_cast<size_t>(byte(random) & 15));
+                for (size_t i = start; i < end; ++i)
+                {
+                    bytes[i] = static_cast<quint8>(byte(random));
+                }
+                break;
+            }
+            }
+        }
+
+        delimiterIntact = (!bytes.empty() && (bytes.back() == ProtocolV2::DELIMITER));
+        stream.insert(stream.end(), bytes.begin(), bytes.end());
+        sent.append(frame);
+    }
+
+    // Accepted frames come in the order they were sent, a frame is found
+    // by its sequence number among the next 256
+    ProtocolV2::FrameDecoder decoder;
+    qint32 cursor = 0;
+    quint64 accepted = 0;
+    quint64 falseAccepts = 0;
+    QVector<bool> received(frameCount, false);
+    decoder.feed(stream.data(), static_cast<qint32>(stream.size()), [&](const ProtocolV2::FrameDecoder &frame)
+    {
+        ++accepted;
+        for (qint32 i = cursor; (i < frameCount) && (i < (cursor + 256)); ++i)
+        {
+            if (sent.at(i).sequence == frame.sequence())
+            {
+                if (matches(frame, sent.at(i)))
+                {
+                    received[i] = true;
+                    cursor = i + 1;
+                    return;
+                }
+                break;
+            }
+        }
+        ++falseAccepts;
+    });
+
+    quint64 intact = 0;
+    quint64 missed = 0;
+    for (qint32 i = 0; i < frameCount; ++i)
+    {
+        if (sent.at(i).intact)
+        {
+            ++intact;
+            if (!received.at(i))
+            {
+                ++missed;
+            }
+        }
+    }
+
+    // Random bytes only, nothing of it may pass
+    ProtocolV2::FrameDecoder noiseDecoder;
+    std::vector<quint8> noise(stream.size());
+    for (quint8 &value : noise)
+    {
+        value = static_cast<quint8>(byte(random));
+    }
+    quint64 noiseAccepts = 0;
+    noiseDecoder.feed(noise.data(), static_cast<qint32>(noise.size()), [&noiseAccepts](const ProtocolV2::FrameDecoder &)
+    {
+        ++noiseAccepts;
+    });
+
+    const ProtocolV2::DecoderStatistics &statistics = decoder.statistics();
+    out << frameCount << " frames, " << stream.size() << " bytes, " << corrupted << " corrupted\n"
+        << "Accepted: " << accepted << " | intact frames missed: " << missed << " of " << intact
+        << " | wrong frames accepted: " << falseAccepts << "\n"
+        << "CRC errors: " << statistics.crcErrors << " | format errors: " << statistics.formatErrors
+        << " | overflows: " << statistics.overflows << " | lost by sequence: " << statistics.lostFrames << "\n"
+        << "Noise: " << noise.size() << " random bytes, " << noiseAccepts << " accepted as frames\n";
+
+    // CRC-16 lets about one corrupted frame in 65536 through, more is a bug
+    return ((missed == 0) && (falseAccepts <= ((corrupted / 65536) + 1))) ? 0 : 1;
+}
@@ -0,0 +1,38 @@
+#-------------------------------------------------
+#
+# Command line tool for benchmarks and offline analysis
+#
+#-------------------------------------------------
+
+QT       += core serialport
+QT       -= gui
+
+TARGET = pvtool
+TEMPLATE = app
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+include(../../core.pri)
+
+# openpty() for the serial benchmark
+unix:!macx: LIBS += -lutil
+
+SOURCES += \
+    main.cpp \
+    replaycommand.cpp \
+    compresscommand.cpp \
+    slipcheckcommand.cpp \
+    spectrumcommand.cpp \
+    sweepcommand.cpp \
+    serialbenchcommand.cpp \
+    protocolbenchcommand.cpp \
+    protocolfuzzcommand.cpp \
+    portwatchcommand.cpp \
+    mailboxstresscommand.cpp \
+    workstealingpool.cpp
+
+HEADERS += \
+    commands.h \
+    workstealingpool.h
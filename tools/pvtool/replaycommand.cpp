@@ -0,0 +1,210 @@
+#include <QCommandLineParser>
+#include <QSettings>
+#include <QTextStream>
+#include "commands.h"
+#include "replaybackend.h"
+#include "sender.h"
+#include "settings.h"
+#include "telemetryreader.h"
+#include "telemetryreplay.h"
+
+namespace
+{
+const QString CALIBRATION_GROUP = "SlipCalibration";
+
+// The pvtool settings are temporary, the learnt state only carries over
+// from one run to the next through a state file
+void loadCalibrationState(const QString &path)
+{
+    QSettings state(path, QSettings::IniFormat);
+    state.beginGroup(CALIBRATION_GROUP);
+    for (const QString &carModel : state.childKeys())
+    {
+        Settings::getInstance()->setSlipCalibrationData(carModel, state.value(carModel).toString());
+    }
+}
+
+bool saveCalibrationState(const QString &path)
+{
+    Settings* settings = Settings::getInstance();
+    QSettings state(path, QSettings::IniFormat);
+    state.beginGroup(CALIBRATION_GROUP);
+    for (const QString &carModel : settings->getSlipCalibrationCars())
+    {
+        state.setValue(carModel, settings->getSlipCalibrationData(carModel));
+    }
+    state.endGroup();
+    state.sync();
+    return (state.status() == QSettings::NoError);
+}
+
+int runReplay(const QCommandLineParser &parser, QTextStream &out)
+{
+    ReplayBackend* backend = new ReplayBackend();
+    TelemetryReader reader(backend);
+    reader.readSettings();
+
+    // Encode everything the reader wants to send, without opening a port
+    quint64 messages = 0;
+    quint64 bytes = 0;
+    (void)QObject::connect(&reader, &TelemetryReader::sendWheelSlipValues, [&](quint8 gasValue, quint8 brakeValue)
+    {
+        bytes += static_cast<quint64>(Sender::encodeWheelSlipValues(gasValue, brakeValue).size);
+        ++messages;
+    });
+    (void)QObject::connect(&reader, &TelemetryReader::sendPerWheelSlipValues, [&](quint8 gasMask, quint8 frontLeft, quint8 frontRight, quint8 rearLeft, quint8 rearRight)
+    {
+        bytes += static_cast<quint64>(Sender::encodePerWheelSlipValues(gasMask, frontLeft, frontRight, rearLeft, rearRight).size);
+        ++messages;
+    });
+    (void)QObject::connect(&reader, &TelemetryReader::sendWindFanValue, [&](quint8 value)
+    {
+        bytes += static_cast<quint64>(Sender::encodeWindFanValue(value).size);
+        ++messages;
+    });
+    (void)QObject::connect(&reader, &TelemetryReader::sendLedFlagValue, [&](quint8 value)
+    {
+        bytes += static_cast<quint64>(Sender::encodeLedFlagValue(value).size);
+        ++messages;
+    });
+
+    // Take the dashboard state like the main window would
+    DashboardState dashboardState;
+    (void)QObject::connect(&reader, &TelemetryReader::dashboardUpdated, [&]()
+    {
+        (void)reader.takeDashboardState(dashboardState);
+    });
+
+    TelemetryReplay replay(&reader, backend);
+    if (!replay.open(parser.positionalArguments().first()))
+    {
+        out << "Cannot open " << parser.positionalArguments().first() << "\n";
+        return 1;
+    }
+
+    replay.setSpeed(parser.value("speed").toDouble());
+
+    if (parser.isSet("lap"))
+    {
+        if (!replay.seekToLap(parser.value("lap").toInt()))
+        {
+            out << "Lap " << parser.value("lap") << " is not in the recording\n";
+            return 1;
+        }
+    }
+    else if (parser.isSet("time"))
+    {
+        qint64 offsetNs = static_cast<qint64>(parser.value("time").toDouble() * 1e9);
+        replay.seekToTime(replay.recording().firstTimestamp() + offsetNs);
+    }
+
+    qint32 repeat = qMax(1, parser.value("repeat").toInt());
+    for (qint32 i = 0; i < repeat; ++i)
+    {
+        ReplayStatistics statistics = replay.run();
+        out << "Run " << (i + 1) << ": " << statistics.frames << " frames, "
+            << QString::number(static_cast<double>(statistics.simulatedNs) / 1e9, 'f', 3) << " s recorded, "
+            << QString::number(static_cast<double>(statistics.wallNs) / 1e9, 'f', 3) << " s replayed, "
+            << QString::number(statistics.framesPerSecond(), 'f', 0) << " frames/s\n";
+        out.flush();
+    }
+
+    OutputStatistics outputs = reader.outputStatistics();
+    out << messages << " messages encoded (" << bytes << " bytes)\n"
+        << "Wheel slip writes: " << outputs.wheelSlipWrites << " of " << outputs.unfilteredWheelSlipWrites << " unfiltered\n"
+        << "Wind fan writes:   " << outputs.windFanWrites << " of " << outputs.unfilteredWindFanWrites << " unfiltered\n";
+
+    if (Settings::getInstance()->getPredictionLead() > 0)
+    {
+        out << "Prediction error: " << reader.predictionStatistics().summary() << "\n";
+    }
+
+    if (Settings::getInstance()->getSlipCalibration())
+    {
+        const SlipCalibration &calibration = reader.slipCalibration();
+        out << "Slip calibration of " << calibration.car() << ": "
+            << (calibration.isCalibrated() ? "calibrated" : "still learning") << ", "
+            << calibration.slipRange().count() << " slip samples, p95 slip "
+            << QString::number(calibration.slipRange().value(), 'f', 2) << ", p95 wheel speed deviation "
+            << QString::number(calibration.speedDeviationRange().value() * 100.0, 'f', 1) << " %\n";
+    }
+    return 0;
+}
+}
+
+
+int runReplayCommand(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Feeds a recording through TelemetryReader and the Sender encoding "
+                                     "and reports the frames per second of the whole pipeline.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("recording", "Recording (*.pvrec) to replay");
+    QCommandLineOption speedOption("speed", "Replay speed, 1 is real time, 0 is as fast as possible (default)", "factor", "0");
+    QCommandLineOption lapOption("lap", "Start at the first key frame of this lap", "lap");
+    QCommandLineOption timeOption("time", "Start at this many seconds into the recording", "seconds");
+    QCommandLineOption repeatOption("repeat", "Replay the recording this many times", "count", "1");
+    parser.addOption(speedOption);
+    parser.addOption(lapOption);
+    parser.addOption(timeOption);
+    parser.addOption(repeatOption);
+    QCommandLineOption gasFilterOption("gas-filter", "Filter chain of the gas slip value, e.g. \"ema:20,deadband:1\"", "filters");
+    QCommandLineOption brakeFilterOption("brake-filter", "Filter chain of the brake slip value", "filters");
+    QCommandLineOption windFanFilterOption("wind-fan-filter", "Filter chain of the wind fan value", "filters");
+    parser.addOption(gasFilterOption);
+    parser.addOption(brakeFilterOption);
+    parser.addOption(windFanFilterOption);
+    QCommandLineOption perWheelOption("per-wheel", "Send one slip value per wheel instead of one per pedal");
+    parser.addOption(perWheelOption);
+    QCommandLineOption calibrateOption("calibrate", "Scale the slip to the range learnt for the car, "
+                                       "learning starts from scratch");
+    QCommandLineOption calibrationStateOption("calibration-state", "Continue the slip calibration from this file "
+                                              "and store the learnt state there afterwards", "file");
+    parser.addOption(calibrateOption);
+    parser.addOption(calibrationStateOption);
+    QCommandLineOption predictOption("predict", "Predict the outputs this many milliseconds ahead", "ms", "0");
+    parser.addOption(predictOption);
+    parser.process(arguments);
+
+    QTextStream out(stdout);
+    if (parser.positionalArguments().size() != 1)
+    {
+        parser.showHelp(1);
+    }
+
+    // Run every effect, independent of what is stored in the settings
+    Settings* settings = Settings::getInstance();
+    settings->setWheelSlipEnabled(true);
+    settings->setLedFlagEnabled(true);
+    settings->setWindFanEnabled(true);
+    settings->setPerWheelSlip(parser.isSet(perWheelOption));
+    settings->setSlipCalibration(parser.isSet(calibrateOption) || parser.isSet(calibrationStateOption));
+    settings->setPredictionLead(qBound(0, parser.value(predictOption).toInt(), 100));
+    if (parser.isSet(gasFilterOption))
+    {
+        settings->setGasFilter(parser.value(gasFilterOption));
+    }
+    if (parser.isSet(brakeFilterOption))
+    {
+        settings->setBrakeFilter(parser.value(brakeFilterOption));
+    }
+    if (parser.isSet(windFanFilterOption))
+    {
+        settings->setWindFanFilter(parser.value(windFanFilterOption));
+    }
+
+    QString statePath = parser.value(calibrationStateOption);
+    if (!statePath.isEmpty())
+    {
+        loadCalibrationState(statePath);
+    }
+
+    // The reader stores the learnt state when it is destroyed at the end of the replay
+    int result = runReplay(parser, out);
+    if ((result == 0) && !statePath.isEmpty() && !saveCalibrationState(statePath))
+    {
+        out << "Cannot write " << statePath << "\n";
+        return 1;
+    }
+    return result;
+}
@@ -0,0 +1,359 @@
+#include <QCommandLineParser>
+#include <QTextStream>
+#include <QVector>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "commands.h"
+#include "acquisitionthread.h"
+#include "bandwidthplanner.h"
+#include "latencystatistics.h"
+#include "protocolv2.h"
+#include "sender.h"
+#include "serialthread.h"
+
+#if defined(Q_OS_UNIX)
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#if defined(Q_OS_MACOS)
+#include <util.h>
+#else
+#include <pty.h>
+#endif
+
+namespace
+{
+// Sequence numbers fit into the two 7 bit values of a wheel slip message
+const qint32 SEQUENCE_COUNT = 1 << 14;
+
+struct PseudoTerminal
+{
+    int master = -1;
+    QString slaveName;
+    qint32 handle = -1;
+    // Send time of each sequence number
+    QVector<qint64> sentNs = QVector<qint64>(SEQUENCE_COUNT);
+    QByteArray received;
+    // Protocol v2 only: frames are answered with the clock of the device,
+    // which runs this far ahead of the host
+    ProtocolV2::FrameDecoder decoder;
+    qint64 clockOffsetNs = 0;
+};
+
+struct Usage
+{
+    double cpuSeconds = 0.0;
+    qint64 contextSwitches = 0;
+};
+
+Usage currentUsage()
+{
+    rusage usage;
+    (void)getrusage(RUSAGE_SELF, &usage);
+    Usage result;
+    result.cpuSeconds = static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec)
+            + (static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6);
+    result.contextSwitches = usage.ru_nvcsw + usage.ru_nivcsw;
+    return result;
+}
+
+// Answers v2 frames like a device and measures when their wheel slip messages arrived
+void receiveFrames(PseudoTerminal &terminal, int descriptor, qint64 nowNs, LatencyStatistics &latency, quint64 &received)
+{
+    // Rate requests come before the first frame, a COBS block this long
+    // does not occur in the short frames
+    while ((terminal.received.size() >= 2) && (static_cast<quint8>(terminal.received.at(0)) == (START_BIT | ID::LinkConfig)))
+    {
+        (void)write(descriptor, terminal.received.constData(), 2);
+        terminal.received.remove(0, 2);
+    }
+
+    if ((terminal.received.size() == 1) && (static_cast<quint8>(terminal.received.at(0)) == (START_BIT | ID::LinkConfig)))
+    {
+        return;
+    }
+
+    terminal.decoder.feed(reinterpret_cast<const quint8*>(terminal.received.constData()), terminal.received.size(),
+                          [&](const ProtocolV2::FrameDecoder &frame)
+    {
+        quint8 value[ProtocolV2::TIMING_SIZE];
+        ProtocolV2::encodeTiming(frame.sequence(), static_cast<quint32>((nowNs + terminal.clockOffsetNs) / 1000), value);
+        ProtocolV2::FrameEncoder encoder;
+        encoder.begin(frame.sequence());
+        (void)encoder.addChannel(ID::LinkTiming, value, sizeof(value));
+        quint8 response[ProtocolV2::MAX_FRAME_SIZE];
+        (void)write(descriptor, response, static_cast<size_t>(encoder.finish(response)));
+
+        for (qint32 c = 0; c < frame.channelCount(); ++c)
+        {
+            const ProtocolV2::ChannelView &channel = frame.channel(c);
+            if ((channel.type == ID::WheelSlip) && (channel.size == 2))
+            {
+                qint32 sequence = (channel.value[0] & 0x7f) | ((channel.value[1] & 0x7f) << 7);
+                latency.addSample(nowNs - terminal.sentNs[sequence]);
+                ++received;
+            }
+        }
+    });
+    terminal.received.clear();
+}
+
+// Reads the master sides of all terminals and measures when each message arrived
+void receive(QVector<PseudoTerminal> &terminals, bool framed, const std::atomic<bool> &quit, LatencyStatistics &latency, quint64 &received)
+{
+    QVector<pollfd> descriptors(terminals.size());
+    for (qint32 i = 0; i < terminals.size(); ++i)
+    {
+        descriptors[i].fd = terminals[i].master;
+        descriptors[i].events = POLLIN;
+    }
+
+    char buffer[256];
+    while (!quit.load())
+    {
+        if (poll(descriptors.data(), static_cast<nfds_t>(descriptors.size()), 10) <= 0)
+        {
+            continue;
+        }
+
+        qint64 nowNs = AcquisitionThread::now();
+        for (qint32 i = 0; i < terminals.size(); ++i)
+        {
+            if ((descriptors[i].revents & POLLIN) == 0)
+            {
+                continue;
+            }
+
+            ssize_t size = read(descriptors[i].fd, buffer, sizeof(buffer));
+            if (size <= 0)
+            {
+                continue;
+            }
+
+            PseudoTerminal &terminal = terminals[i];
+            terminal.received.append(buffer, static_cast<int>(size));
+            if (framed)
+            {
+                receiveFrames(terminal, descriptors[i].fd, nowNs, latency, received);
+                continue;
+            }
+
+            while (terminal.received.size() >= 2)
+            {
+                // Answer rate requests like a device that supports every rate
+                if (static_cast<quint8>(terminal.received.at(0)) == (START_BIT | ID::LinkConfig))
+                {
+                    (void)write(descriptors[i].fd, terminal.received.constData(), 2);
+                    terminal.received.remove(0, 2);
+                    continue;
+                }
+
+
+                // Resynchronize on the header of a wheel slip message
+                if (static_cast<quint8>(terminal.received.at(0)) != (START_BIT | ID::WheelSlip))
+                {
+                    terminal.received.remove(0, 1);
+                    continue;
+                }
+
+                if (terminal.received.size() < 3)
+                {
+                    break;
+                }
+
+                qint32 sequence = (terminal.received.at(1) & 0x7f) | ((terminal.received.at(2) & 0x7f) << 7);
+                latency.addSample(nowNs - terminal.sentNs[sequence]);
+                ++received;
+                terminal.received.remove(0, 3);
+            }
+        }
+    }
+}
+}
+
+int runSerialBenchCommand(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Sends wheel slip messages to several pseudo terminals through the serial "
+                                     "thread and measures the delivery latency, the CPU time and the context "
+                                     "switches per message.");
+    parser.addHelpOption();
+    QCommandLineOption portsOption("ports", "Number of devices", "count", "8");
+    QCommandLineOption rateOption("rate", "Messages per second and device", "hz", "333");
+    QCommandLineOption secondsOption("seconds", "Duration", "seconds", "5");
+    parser.addOption(portsOption);
+    parser.addOption(rateOption);
+    parser.addOption(secondsOption);
+    QCommandLineOption mixedOption("mixed", "Also send wind fan and LED flag messages to every device, "
+                                   "as if they shared the port with the wheel slip");
+    parser.addOption(mixedOption);
+    QCommandLineOption baudOption("baud", "Fastest rate the devices are asked for", "baud", QString::number(SerialThread::DEFAULT_BAUD_RATE));
+    parser.addOption(baudOption);
+    QCommandLineOption protocolOption("protocol", "Serial protocol, with 2 the devices answer every frame and the "
+                                      "round trips are measured", "version", QString::number(SerialThread::PROTOCOL_V1));
+    parser.addOption(protocolOption);
+    parser.process(arguments);
+
+    QTextStream out(stdout);
+    qint32 portCount = qBound(1, parser.value(portsOption).toInt(), SerialThread::MAX_PORTS);
+    double rate = qMax(1.0, parser.value(rateOption).toDouble());
+    double seconds = qMax(0.1, parser.value(secondsOption).toDouble());
+    qint32 protocol = (parser.value(protocolOption).toInt() == SerialThread::PROTOCOL_V2) ? SerialThread::PROTOCOL_V2 : SerialThread::PROTOCOL_V1;
+    bool framed = (protocol == SerialThread::PROTOCOL_V2);
+
+    // What the sender would plan for one of these devices
+    BandwidthPlanner planner;
+    planner.setTickRate(rate);
+    planner.setBaudRate("device", parser.value(baudOption).toInt());
+    planner.addChannel("device", ID::WheelSlip, 3, 2);
+    if (parser.isSet(mixedOption))
+    {
+        planner.addChannel("device", ID::WindFan, 2, 1);
+        planner.addChannel("device", ID::LEDFlag, 2, 0);
+    }
+    (void)planner.plan();
+    for (const QString &warning : planner.warnings())
+    {
+        out << "Link overrun " << warning << "\n";
+    }
+
+    QVector<PseudoTerminal> terminals(portCount);
+    for (qint32 i = 0; i < terminals.size(); ++i)
+    {
+        PseudoTerminal &terminal = terminals[i];
+        // Every device clock runs a different amount of milliseconds ahead
+        terminal.clockOffsetNs = (i + 1) * 1500000;
+        int slave = -1;
+        char name[128];
+        if (openpty(&terminal.master, &slave, name, nullptr, nullptr) != 0)
+        {
+            out << "Cannot open a pseudo terminal\n";
+            return 1;
+        }
+
+        // The serial thread opens the slave side by name
+        (void)close(slave);
+        terminal.slaveName = QString::fromLocal8Bit(name);
+    }
+
+    std::atomic<bool> quit(false);
+    LatencyStatistics latency;
+    quint64 received = 0;
+    std::thread receiver(receive, std::ref(terminals), framed, std::cref(quit), std::ref(latency), std::ref(received));
+
+    Usage startUsage = currentUsage();
+    qint64 startNs = AcquisitionThread::now();
+    quint64 sent = 0;
+    {
+        SerialThread serialThread;
+        (void)QObject::connect(&serialThread, &SerialThread::error, [&out](const QString &error)
+        {
+            out << "Serial error: " << error << "\n";
+        });
+        (void)QObject::connect(&serialThread, &SerialThread::linkConfigured, [&out](const QString &portName, qint32 baudRate)
+        {
+            out << portName << " runs at " << baudRate << " baud\n";
+        });
+
+        for (PseudoTerminal &terminal : terminals)
+        {
+            terminal.handle = serialThread.addPort(terminal.slaveName, parser.value(baudOption).toInt(), protocol);
+        }
+
+        bool mixed = parser.isSet(mixedOption);
+        SerialFrame windFanMessage = Sender::encodeWindFanValue(5);
+        SerialFrame ledFlagMessage = Sender::encodeLedFlagValue(1);
+        qint64 periodNs = static_cast<qint64>(1e9 / rate);
+        qint64 ticks = static_cast<qint64>(seconds * rate);
+        for (qint64 tick = 0; tick < ticks; ++tick)
+        {
+            std::this_thread::sleep_until(std::chrono::steady_clock::time_point(std::chrono::nanoseconds(startNs + (tick * periodNs))));
+
+            qint32 sequence = static_cast<qint32>(tick % SEQUENCE_COUNT);
+            SerialFrame message = Sender::encodeWheelSlipValues(static_cast<quint8>(sequence & 0x7f),
+                                                                static_cast<quint8>(sequence >> 7));
+            for (PseudoTerminal &terminal : terminals)
+            {
+                terminal.sentNs[sequence] = AcquisitionThread::now();
+                (void)serialThread.transaction(terminal.handle, message);
+                ++sent;
+
+                // Ignored by the receiver, they only share the writes
+                if (mixed)
+                {
+                    (void)serialThread.transaction(terminal.handle, windFanMessage);
+                    (void)serialThread.transaction(terminal.handle, ledFlagMessage);
+                    sent += 2;
+                }
+            }
+        }
+
+        SerialStatistics statistics = serialThread.statistics();
+        out << sent << " messages queued, " << statistics.messages << " written in " << statistics.writes << " writes ("
+            << QString::number(statistics.coalescingRatio(), 'f', 2) << " per write), "
+            << statistics.replaced << " replaced, " << statistics.dropped << " dropped, "
+            << QString::number(statistics.bytesPerSecond(), 'f', 0) << " bytes/s\n";
+        for (const PortHealth &health : serialThread.portHealth())
+        {
+            if (!health.connected || (health.reconnects > 0))
+            {
+                out << health.port << ": " << (health.connected ? "connected" : "disconnected") << ", "
+                    << health.reconnects << " reconnects, " << (health.downtimeNs / 1000000) << " ms downtime\n";
+            }
+        }
+
+        if (framed)
+        {
+            // Wait for the answers to the last frames
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            for (const RoundTripStatistics &roundTrip : serialThread.roundTripStatistics())
+            {
+                for (const PseudoTerminal &terminal : terminals)
+                {
+                    if (terminal.slaveName == roundTrip.port)
+                    {
+                        out << roundTrip.port << " (clock " << QString::number(static_cast<double>(terminal.clockOffsetNs) / 1e6, 'f', 3)
+                            << "ms ahead): " << roundTrip.summary() << "\n";
+                    }
+                }
+            }
+        }
+    }
+
+    // Give the last messages time to arrive
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    quit = true;
+    receiver.join();
+
+    qint64 elapsedNs = AcquisitionThread::now() - startNs;
+    Usage endUsage = currentUsage();
+    double cpuSeconds = endUsage.cpuSeconds - startUsage.cpuSeconds;
+    qint64 contextSwitches = endUsage.contextSwitches - startUsage.contextSwitches;
+    out << received << " messages received on " << portCount << " ports\n"
+        << "Latency: " << latency.summary() << "\n"
+        << "CPU: " << QString::number(cpuSeconds * 1e3 / (static_cast<double>(elapsedNs) / 1e9), 'f', 1) << " ms/s, "
+        << QString::number(cpuSeconds * 1e6 / static_cast<double>(qMax<quint64>(1, sent)), 'f', 1) << " us per message\n"
+        << "Context switches: " << contextSwitches << " ("
+        << QString::number(static_cast<double>(contextSwitches) / static_cast<double>(qMax<quint64>(1, sent)), 'f', 2)
+        << " per message)\n";
+
+    for (PseudoTerminal &terminal : terminals)
+    {
+        (void)close(terminal.master);
+    }
+
+    return 0;
+}
+
+#else
+
+int runSerialBenchCommand(const QStringList &arguments)
+{
+    (void)arguments;
+    QTextStream(stdout) << "The serial benchmark needs pseudo terminals, which this platform does not have\n";
+    return 1;
+}
+
+#endif
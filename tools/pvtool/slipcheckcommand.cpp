@@ -0,0 +1,265 @@
+#include <QCommandLineParser>
+#include <QTextStream>
+#include <QVector>
+#include <QtMath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include "commands.h"
+#include "acquisitionthread.h"
+#include "slipkernel.h"
+
+namespace
+{
+struct SlipInput
+{
+    WheelFrame wheels;
+    WheelValueFloat tyreRadius;
+    // As TelemetryReader keeps them
+    qint32 speed = 0;
+    float brakeIndex = 0.0f;
+    float gasIndex = 0.0f;
+    qint32 bumpingIndex = 0;
+    // As WheelSlipEffect passes them to the kernel
+    float brakeSpeed = 0.0f;
+    float gasSpeed = 0.0f;
+};
+
+struct BaselineResult
+{
+    WheelValueInt slip;
+    WheelValueInt status;
+    WheelValueFloat calculatedSpeed;
+    qint32 maxBrakeValue = 0;
+    qint32 maxGasValue = 0;
+    bool bumping = false;
+};
+
+// TelemetryReader::getWheelSlip(), calculateSpeed(), getSlipStatus() and
+// calculateWheelSlip() as they were before the slip kernel, without the
+// logging and the signals. Both kernels have to give the same values.
+float baselineCalculateSpeed(float tyreRadius, float wheelAngularSpeed)
+{
+    return ((2 * tyreRadius * static_cast<float>(M_PI) * wheelAngularSpeed * 60) / 100);
+}
+
+WheelSlipStatus baselineSlipStatus(float slipValue, float calculatedSpeed, qint32 speed, float brakeIndex, float gasIndex)
+{
+    if (slipValue == 0.0f)
+    {
+        return NotSlipping;
+    }
+    else
+    {
+        if (calculatedSpeed < (speed * brakeIndex))
+        {
+            return SlippingFromBraking;
+        }
+        else if (calculatedSpeed > (speed * gasIndex))
+        {
+            return SlippingFromGas;
+        }
+    }
+
+    return NotSlipping;
+}
+
+void baselineWheelSlip(const SlipInput &input, BaselineResult &result)
+{
+    for (qint32 i = 0; i < WHEEL_COUNT; ++i)
+    {
+        // Be sure to stay between 0 and 255
+        result.slip[i] = qBound(0, static_cast<qint32>(input.wheels.slip[i]), 255);
+        result.calculatedSpeed[i] = baselineCalculateSpeed(input.tyreRadius[i], input.wheels.angularSpeed[i]);
+    }
+
+    for (qint32 i = 0; i < WHEEL_COUNT; ++i)
+    {
+        WheelSlipStatus status = baselineSlipStatus(result.slip[i], result.calculatedSpeed[i], input.speed, input.brakeIndex, input.gasIndex);
+        result.status[i] = status;
+        result.bumping |= (input.wheels.load[i] == 0.0f);
+
+        switch (status)
+        {
+        case SlippingFromBraking:
+            if (result.slip[i] > result.maxBrakeValue)
+            {
+                result.maxBrakeValue = result.slip[i];
+            }
+            break;
+        case SlippingFromGas:
+            if (result.slip[i] > result.maxGasValue)
+            {
+                result.maxGasValue = result.slip[i];
+            }
+            break;
+        case NotSlipping:
+            break;
+        }
+    }
+
+    // Let everything vibrate a bit if bumping was detected
+    if (result.bumping)
+    {
+        if (result.maxBrakeValue < input.bumpingIndex)
+        {
+            result.maxBrakeValue = input.bumpingIndex;
+        }
+
+        if (result.maxGasValue < input.bumpingIndex)
+        {
+            result.maxGasValue = input.bumpingIndex;
+        }
+    }
+}
+
+// Values the game sends rarely, but which have to give the same result anyway
+const float SPECIAL_VALUES[] =
+{
+    0.0f, -0.0f, 0.999f, 1.0f, 255.0f, 255.99f, 256.0f, -1.0f, 1e10f, -1e10f,
+    std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(),
+    std::numeric_limits<float>::quiet_NaN()
+};
+const qint32 SPECIAL_VALUE_COUNT = sizeof(SPECIAL_VALUES) / sizeof(SPECIAL_VALUES[0]);
+
+QVector<SlipInput> createInputs(qint32 count, quint32 seed)
+{
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> slip(-20.0f, 300.0f);
+    std::uniform_real_distribution<float> angularSpeed(-10.0f, 200.0f);
+    std::uniform_real_distribution<float> load(0.0f, 5000.0f);
+    std::uniform_real_distribution<float> radius(0.25f, 0.40f);
+    std::uniform_int_distribution<qint32> speed(0, 300);
+    std::uniform_int_distribution<qint32> index(0, 25);
+    std::uniform_int_distribution<qint32> bumpingIndex(0, 10);
+    std::uniform_int_distribution<qint32> percent(0, 99);
+    std::uniform_int_distribution<qint32> special(0, SPECIAL_VALUE_COUNT - 1);
+
+    QVector<SlipInput> inputs(count);
+    for (SlipInput &input : inputs)
+    {
+        for (qint32 i = 0; i < WHEEL_COUNT; ++i)
+        {
+            input.wheels.slip[i] = (percent(random) < 10) ? SPECIAL_VALUES[special(random)] : slip(random);
+            input.wheels.angularSpeed[i] = (percent(random) < 5) ? SPECIAL_VALUES[special(random)] : angularSpeed(random);
+            input.wheels.load[i] = (percent(random) < 20) ? 0.0f : load(random);
+            input.tyreRadius[i] = radius(random);
+        }
+
+        // Same conversions as TelemetryReader::readSettings() and WheelSlipEffect
+        input.speed = speed(random);
+        input.brakeIndex = static_cast<float>(100 - index(random)) / 100;
+        input.gasIndex = static_cast<float>(index(random)) / 100;
+        input.bumpingIndex = bumpingIndex(random);
+        input.brakeSpeed = static_cast<float>(input.speed) * input.brakeIndex;
+        input.gasSpeed = static_cast<float>(input.speed) * input.gasIndex;
+    }
+
+    return inputs;
+}
+
+bool sameResult(const SlipKernelResult &left, const SlipKernelResult &right)
+{
+    return (std::memcmp(left.slip.value, right.slip.value, sizeof(left.slip.value)) == 0)
+            && (std::memcmp(left.status.value, right.status.value, sizeof(left.status.value)) == 0)
+            && (std::memcmp(left.calculatedSpeed.value, right.calculatedSpeed.value, sizeof(left.calculatedSpeed.value)) == 0)
+            && (left.maxBrakeValue == right.maxBrakeValue)
+            && (left.maxGasValue == right.maxGasValue)
+            && (left.bumpingMask == right.bumpingMask);
+}
+
+// The kernel leaves the bumping index to BumpingEffect, which raises both
+// pedals to it like the baseline did
+bool sameAsBaseline(const SlipInput &input, const SlipKernelResult &result, const BaselineResult &baseline)
+{
+    bool bumping = (result.bumpingMask != 0);
+    qint32 maxBrakeValue = bumping ? qMax(result.maxBrakeValue, input.bumpingIndex) : result.maxBrakeValue;
+    qint32 maxGasValue = bumping ? qMax(result.maxGasValue, input.bumpingIndex) : result.maxGasValue;
+    return (std::memcmp(result.slip.value, baseline.slip.value, sizeof(result.slip.value)) == 0)
+            && (std::memcmp(result.status.value, baseline.status.value, sizeof(result.status.value)) == 0)
+            && (std::memcmp(result.calculatedSpeed.value, baseline.calculatedSpeed.value, sizeof(result.calculatedSpeed.value)) == 0)
+            && (maxBrakeValue == baseline.maxBrakeValue)
+            && (maxGasValue == baseline.maxGasValue)
+            && (bumping == baseline.bumping);
+}
+
+template <typename Kernel>
+double nsPerCall(const QVector<SlipInput> &inputs, qint32 rounds, Kernel kernel)
+{
+    SlipKernelResult result;
+    qint64 checksum = 0;
+    qint64 startNs = AcquisitionThread::now();
+    for (qint32 round = 0; round < rounds; ++round)
+    {
+        for (const SlipInput &input : inputs)
+        {
+            kernel(input.wheels, input.tyreRadius, input.brakeSpeed, input.gasSpeed, result);
+            checksum += result.maxBrakeValue + result.maxGasValue + result.status[0];
+        }
+    }
+    qint64 elapsedNs = AcquisitionThread::now() - startNs;
+
+    // Keeps the compiler from dropping the loop
+    volatile qint64 sink = checksum;
+    (void)sink;
+
+    return static_cast<double>(elapsedNs) / (static_cast<double>(inputs.size()) * rounds);
+}
+}
+
+int runSlipCheckCommand(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Compares the wheel slip kernel and its scalar reference with each other "
+                                     "and with the slip logic from before the kernel on random and special "
+                                     "inputs, and measures both kernels.");
+    parser.addHelpOption();
+    QCommandLineOption countOption("count", "Number of random inputs", "count", "1000000");
+    parser.addOption(countOption);
+    QCommandLineOption seedOption("seed", "Seed of the random inputs", "seed", "1");
+    parser.addOption(seedOption);
+    QCommandLineOption roundsOption("rounds", "Passes over the inputs for the timing", "rounds", "10");
+    parser.addOption(roundsOption);
+    parser.process(arguments);
+
+    QTextStream out(stdout);
+    QVector<SlipInput> inputs = createInputs(qMax(1, parser.value(countOption).toInt()), parser.value(seedOption).toUInt());
+    qint32 rounds = qMax(1, parser.value(roundsOption).toInt());
+
+    quint64 mismatches = 0;
+    quint64 kernelBaselineMismatches = 0;
+    quint64 scalarBaselineMismatches = 0;
+    for (const SlipInput &input : inputs)
+    {
+        SlipKernelResult kernelResult;
+        SlipKernelResult scalarResult;
+        BaselineResult baselineResult;
+        classifyWheelSlip(input.wheels, input.tyreRadius, input.brakeSpeed, input.gasSpeed, kernelResult);
+        classifyWheelSlipScalar(input.wheels, input.tyreRadius, input.brakeSpeed, input.gasSpeed, scalarResult);
+        baselineWheelSlip(input, baselineResult);
+        if (!sameResult(kernelResult, scalarResult))
+        {
+            ++mismatches;
+        }
+        if (!sameAsBaseline(input, kernelResult, baselineResult))
+        {
+            ++kernelBaselineMismatches;
+        }
+        if (!sameAsBaseline(input, scalarResult, baselineResult))
+        {
+            ++scalarBaselineMismatches;
+        }
+    }
+
+    double kernelNs = nsPerCall(inputs, rounds, classifyWheelSlip);
+    double scalarNs = nsPerCall(inputs, rounds, classifyWheelSlipScalar);
+
+    out << inputs.size() << " inputs, kernel " << slipKernelName() << "\n"
+        << "Kernel:  " << QString::number(kernelNs, 'f', 2) << " ns per frame\n"
+        << "Scalar:  " << QString::number(scalarNs, 'f', 2) << " ns per frame\n"
+        << "Results: " << ((mismatches == 0) ? QString("identical") : QString("%1 inputs differ").arg(mismatches)) << "\n"
+        << "Baseline: kernel " << ((kernelBaselineMismatches == 0) ? QString("identical") : QString("%1 inputs differ").arg(kernelBaselineMismatches))
+        << ", scalar " << ((scalarBaselineMismatches == 0) ? QString("identical") : QString("%1 inputs differ").arg(scalarBaselineMismatches)) << "\n";
+
+    return ((mismatches == 0) && (kernelBaselineMismatches == 0) && (scalarBaselineMismatches == 0)) ? 0 : 1;
+}
@@ -0,0 +1,111 @@
+#include <QCommandLineParser>
+#include <QTextStream>
+#include <QVector>
+#include <QtMath>
+#include <cmath>
+#include <random>
+#include "commands.h"
+#include "acquisitionthread.h"
+#include "slidingspectrum.h"
+
+namespace
+{
+// Suspension travel of a car driving over a rumble strip now and then
+QVector<WheelValueFloat> createTravel(qint32 count, float sampleRate)
+{
+    std::mt19937 random(1);
+    std::normal_distribution<float> noise(0.0f, 0.0005f);
+
+    QVector<WheelValueFloat> travel(count);
+    for (qint32 n = 0; n < count; ++n)
+    {
+        double time = static_cast<double>(n) / sampleRate;
+        bool kerb = (std::fmod(time, 4.0) < 1.0);
+        for (qint32 w = 0; w < WHEEL_COUNT; ++w)
+        {
+            double body = 0.004 * std::sin((2.0 * M_PI * 1.5 * time) + w);
+            double strip = kerb ? (0.003 * std::sin(2.0 * M_PI * 45.0 * time)) : 0.0;
+            travel[n][w] = 0.05f + static_cast<float>(body + strip) + noise(random);
+        }
+    }
+
+    return travel;
+}
+}
+
+int runSpectrumCommand(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Measures the sliding spectrum the road texture effect uses against "
+                                     "recomputing the band from the whole window every frame.");
+    parser.addHelpOption();
+    QCommandLineOption framesOption("frames", "Number of physics frames", "count", "1000000");
+    QCommandLineOption rateOption("rate", "Physics frames per second", "hz", "333");
+    QCommandLineOption minOption("min", "Lowest frequency of the band", "hz", "20");
+    QCommandLineOption maxOption("max", "Highest frequency of the band", "hz", "80");
+    parser.addOption(framesOption);
+    parser.addOption(rateOption);
+    parser.addOption(minOption);
+    parser.addOption(maxOption);
+    parser.process(arguments);
+
+    QTextStream out(stdout);
+    float sampleRate = parser.value(rateOption).toFloat();
+    SlidingSpectrum spectrum;
+    if (!spectrum.configure(sampleRate, parser.value(minOption).toFloat(), parser.value(maxOption).toFloat()))
+    {
+        out << "The band does not fit the sample rate\n";
+        return 1;
+    }
+
+    QVector<WheelValueFloat> travel = createTravel(qMax(1, parser.value(framesOption).toInt()), sampleRate);
+
+    // Sliding: one update per bin and frame
+    WheelValueFloat rms;
+    float checksum = 0.0f;
+    qint64 startNs = AcquisitionThread::now();
+    for (const WheelValueFloat &sample : travel)
+    {
+        spectrum.addSample(sample);
+        spectrum.bandRms(rms);
+        checksum += rms[0];
+    }
+    qint64 slidingNs = AcquisitionThread::now() - startNs;
+
+    // Whole window: one Goertzel filter per bin over every sample of the window
+    spectrum.reset();
+    WheelValueFloat windowRms;
+    float maxDifference = 0.0f;
+    startNs = AcquisitionThread::now();
+    for (const WheelValueFloat &sample : travel)
+    {
+        spectrum.addSample(sample);
+        spectrum.bandRmsFromWindow(windowRms);
+        checksum += windowRms[0];
+    }
+    qint64 windowNs = AcquisitionThread::now() - startNs;
+
+    // Compare both outside of the timing
+    spectrum.reset();
+    for (const WheelValueFloat &sample : travel)
+    {
+        spectrum.addSample(sample);
+        spectrum.bandRms(rms);
+        spectrum.bandRmsFromWindow(windowRms);
+        for (qint32 w = 0; w < WHEEL_COUNT; ++w)
+        {
+            maxDifference = qMax(maxDifference, std::fabs(rms[w] - windowRms[w]));
+        }
+    }
+
+    double frames = static_cast<double>(travel.size());
+    out << travel.size() << " frames, " << spectrum.binCount() << " bins from "
+        << QString::number((spectrum.firstBin() * sampleRate) / SlidingSpectrum::WINDOW_SIZE, 'f', 1) << " Hz, window "
+        << SlidingSpectrum::WINDOW_SIZE << " frames\n"
+        << "Sliding:      " << QString::number(static_cast<double>(slidingNs) / frames, 'f', 1) << " ns per frame\n"
+        << "Whole window: " << QString::number(static_cast<double>(windowNs) / frames, 'f', 1) << " ns per frame\n"
+        << "Largest difference: " << QString::number(maxDifference, 'g', 3) << " m\n"
+        << "(checksum " << checksum << ")\n";
+
+    return 0;
+}
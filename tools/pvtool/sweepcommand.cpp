@@ -0,0 +1,560 @@
+#include <QCommandLineParser>
+#include <QFile>
+#include <QTextStream>
+#include <QThread>
+#include <QVector>
+#include <algorithm>
+#include <cstring>
+#include "commands.h"
+#include "workstealingpool.h"
+#include "acquisitionthread.h"
+#include "filterchain.h"
+#include "framecodec.h"
+#include "settings.h"
+#include "slipkernel.h"
+#include "telemetryrecording.h"
+
+namespace
+{
+enum SweepFrameFlag
+{
+    BrakeSlipLabel = 0x1,
+    GasSlipLabel = 0x2,
+    SessionStart = 0x4,
+    Bumping = 0x8
+};
+
+// The part of a physics step that does not depend on the swept indices,
+// computed once by the slip kernel
+struct alignas(16) SweepFrame
+{
+    WheelValueFloat calculatedSpeed;
+    quint8 slip[WHEEL_COUNT];
+    float speed;
+    quint32 flags;
+    quint32 reserved;
+};
+
+struct SlipLabel
+{
+    qint64 startNs;
+    qint64 endNs;
+    quint32 flag;
+};
+
+struct SweepData
+{
+    QVector<SweepFrame> frames;
+    qint64 durationNs = 0;
+    bool labelled = false;
+};
+
+struct SweepConfig
+{
+    qint32 brakeIndex;
+    qint32 gasIndex;
+    qint32 bumpingIndex;
+};
+
+struct SweepResult
+{
+    SweepConfig config;
+    quint64 brakeEvents = 0;
+    quint64 gasEvents = 0;
+    quint64 falsePositives = 0;
+    quint64 misses = 0;
+    quint64 writes = 0;
+};
+
+struct SweepRange
+{
+    qint32 first;
+    qint32 last;
+    qint32 step;
+};
+
+// Labels are lines "<start> <end> brake|gas" in seconds from the start of
+// the recording, '#' starts a comment
+bool readLabels(const QString &path, QVector<SlipLabel> &labels)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        return false;
+    }
+
+    QTextStream in(&file);
+    while (!in.atEnd())
+    {
+        QString line = in.readLine().section('#', 0, 0).simplified();
+        if (line.isEmpty())
+        {
+            continue;
+        }
+
+        QStringList parts = line.split(' ');
+        bool startOk = false;
+        bool endOk = false;
+        SlipLabel label;
+        label.startNs = static_cast<qint64>(parts.value(0).toDouble(&startOk) * 1e9);
+        label.endNs = static_cast<qint64>(parts.value(1).toDouble(&endOk) * 1e9);
+        QString type = parts.value(2);
+        label.flag = (type == "brake") ? BrakeSlipLabel : ((type == "gas") ? GasSlipLabel : 0);
+        if ((parts.size() != 3) || !startOk || !endOk || (label.flag == 0))
+        {
+            qWarning() << "Ignoring label" << line;
+            continue;
+        }
+
+        labels.append(label);
+    }
+
+    return true;
+}
+
+class RecordingLoader
+{
+public:
+    RecordingLoader(SweepData &data, const QVector<SlipLabel> &labels, qint64 firstTimestamp)
+        : m_data(data)
+        , m_labels(labels)
+        , m_firstTimestamp(firstTimestamp)
+    {
+    }
+
+    void add(const RecordView &record)
+    {
+        switch (record.type)
+        {
+        case StaticRecord:
+        {
+            SPageFileStatic staticPage;
+            std::memcpy(&staticPage, record.payload, qMin<size_t>(record.size, sizeof(staticPage)));
+            for (qint32 i = 0; i < WHEEL_COUNT; ++i)
+            {
+                m_tyreRadius[i] = staticPage.tyreRadius[i];
+            }
+            break;
+        }
+
+        case GraphicsRecord:
+        {
+            SPageFileGraphic graphics;
+            std::memcpy(&graphics, record.payload, qMin<size_t>(record.size, sizeof(graphics)));
+            m_live = (graphics.status == AC_LIVE);
+            break;
+        }
+
+        case PhysicsRecord:
+            if (m_live)
+            {
+                addPhysics(record);
+            }
+            break;
+
+        case CompressedBlockRecord:
+        case InvalidRecord:
+        default:
+            break;
+        }
+
+        if (!m_live)
+        {
+            m_sessionStarted = false;
+        }
+    }
+
+private:
+    void addPhysics(const RecordView &record)
+    {
+        SPageFilePhysics physics;
+        std::memcpy(&physics, record.payload, qMin<size_t>(record.size, sizeof(physics)));
+
+        WheelFrame wheels;
+        bool rolling = false;
+        for (qint32 i = 0; i < WHEEL_COUNT; ++i)
+        {
+            wheels.slip[i] = physics.wheelSlip[i];
+            wheels.load[i] = physics.wheelLoad[i];
+            wheels.angularSpeed[i] = physics.wheelAngularSpeed[i];
+            rolling |= (qRound(physics.wheelAngularSpeed[i]) > 0);
+        }
+
+        // Same speed as TelemetryReader, the thresholds do not matter here
+        SlipKernelResult result;
+        classifyWheelSlip(wheels, m_tyreRadius, 0.0f, 0.0f, result);
+
+        SweepFrame frame;
+        frame.calculatedSpeed = result.calculatedSpeed;
+        for (qint32 i = 0; i < WHEEL_COUNT; ++i)
+        {
+            frame.slip[i] = static_cast<quint8>(result.slip[i]);
+        }
+        frame.speed = static_cast<float>(rolling ? qRound(physics.speedKmh) : 0);
+        frame.flags = (result.bumpingMask != 0) ? Bumping : 0;
+        frame.reserved = 0;
+
+        if (!m_sessionStarted)
+        {
+            frame.flags |= SessionStart;
+            m_sessionStarted = true;
+        }
+
+        qint64 timeNs = record.timestampNs - m_firstTimestamp;
+        for (const SlipLabel &label : m_labels)
+        {
+            if ((timeNs >= label.startNs) && (timeNs < label.endNs))
+            {
+                frame.flags |= label.flag;
+            }
+        }
+
+        m_data.frames.append(frame);
+    }
+
+    SweepData &m_data;
+    const QVector<SlipLabel> &m_labels;
+    qint64 m_firstTimestamp;
+    WheelValueFloat m_tyreRadius;
+    bool m_live = false;
+    bool m_sessionStarted = false;
+};
+
+bool loadRecording(const QString &path, SweepData &data, QTextStream &out)
+{
+    TelemetryRecording recording;
+    if (!recording.open(path))
+    {
+        out << "Cannot open " << path << "\n";
+        return false;
+    }
+
+    QVector<SlipLabel> labels;
+    if (readLabels(path + ".labels", labels))
+    {
+        data.labelled = true;
+    }
+
+    RecordingLoader loader(data, labels, recording.firstTimestamp());
+    FrameBlockDecoder decoder;
+    qint64 offset = recording.firstOffset();
+    RecordView record;
+    while (recording.readRecord(offset, record))
+    {
+        offset = record.nextOffset;
+        if (record.type != CompressedBlockRecord)
+        {
+            loader.add(record);
+            continue;
+        }
+
+        if (!decoder.decode(record.payload, record.size))
+        {
+            out << path << " contains a damaged block\n";
+            return false;
+        }
+
+        for (qint32 i = 0; i < decoder.count(); ++i)
+        {
+            loader.add(decoder.page(i));
+        }
+    }
+
+    data.durationNs += recording.lastTimestamp() - recording.firstTimestamp();
+    return true;
+}
+
+bool parseRange(const QString &text, qint32 min, qint32 max, SweepRange &range)
+{
+    // "<value>" or "<first>:<last>[:<step>]"
+    QStringList parts = text.split(':');
+    bool firstOk = false;
+    bool lastOk = true;
+    bool stepOk = true;
+    range.first = parts.value(0).toInt(&firstOk);
+    range.last = (parts.size() > 1) ? parts[1].toInt(&lastOk) : range.first;
+    range.step = (parts.size() > 2) ? parts[2].toInt(&stepOk) : 1;
+
+    return firstOk && lastOk && stepOk && (parts.size() <= 3) && (range.step > 0)
+            && (range.first >= min) && (range.last <= max) && (range.first <= range.last);
+}
+
+QVector<qint32> rangeValues(const SweepRange &range)
+{
+    QVector<qint32> values;
+    for (qint32 value = range.first; value <= range.last; value += range.step)
+    {
+        values.append(value);
+    }
+
+    return values;
+}
+
+// Classifies every frame once for a brake and gas index and sends the
+// values through the output stage once per bumping index
+void runSweep(const SweepData &data, qint32 brakeIndex, qint32 gasIndex, const QVector<qint32> &bumpingIndices,
+              const QString &gasFilter, const QString &brakeFilter, float sampleRate, SweepResult* results)
+{
+    // Same conversion as TelemetryReader::readSettings()
+    float brakeFactor = static_cast<float>(100 - brakeIndex) / 100;
+    float gasFactor = static_cast<float>(gasIndex) / 100;
+
+    qint32 outputs = bumpingIndices.size();
+    QVector<FilterChain> gasFilters(outputs);
+    QVector<FilterChain> brakeFilters(outputs);
+    QVector<qint32> lastGas(outputs);
+    QVector<qint32> lastBrake(outputs);
+    for (qint32 i = 0; i < outputs; ++i)
+    {
+        (void)gasFilters[i].configure(gasFilter, sampleRate);
+        (void)brakeFilters[i].configure(brakeFilter, sampleRate);
+        results[i].config = {brakeIndex, gasIndex, bumpingIndices[i]};
+    }
+
+    quint64 brakeEvents = 0;
+    quint64 gasEvents = 0;
+    quint64 falsePositives = 0;
+    quint64 misses = 0;
+    bool lastBraking = false;
+    bool lastSpinning = false;
+
+    for (const SweepFrame &frame : data.frames)
+    {
+        if ((frame.flags & SessionStart) != 0)
+        {
+            lastBraking = false;
+            lastSpinning = false;
+            for (qint32 i = 0; i < outputs; ++i)
+            {
+                gasFilters[i].reset();
+                brakeFilters[i].reset();
+                lastGas[i] = 0;
+                lastBrake[i] = 0;
+            }
+        }
+
+        // Same decision as the slip kernel, on the precomputed speeds
+        float brakeSpeed = frame.speed * brakeFactor;
+        float gasSpeed = frame.speed * gasFactor;
+        qint32 maxBrake = 0;
+        qint32 maxGas = 0;
+        for (qint32 w = 0; w < WHEEL_COUNT; ++w)
+        {
+            qint32 slip = frame.slip[w];
+            float calculatedSpeed = frame.calculatedSpeed[w];
+            if (slip != 0)
+            {
+                if (calculatedSpeed < brakeSpeed)
+                {
+                    maxBrake = qMax(maxBrake, slip);
+                }
+                else if (calculatedSpeed > gasSpeed)
+                {
+                    maxGas = qMax(maxGas, slip);
+                }
+            }
+        }
+
+        bool braking = (maxBrake > 0);
+        bool spinning = (maxGas > 0);
+        brakeEvents += (braking && !lastBraking) ? 1 : 0;
+        gasEvents += (spinning && !lastSpinning) ? 1 : 0;
+        lastBraking = braking;
+        lastSpinning = spinning;
+
+        bool brakeLabel = ((frame.flags & BrakeSlipLabel) != 0);
+        bool gasLabel = ((frame.flags & GasSlipLabel) != 0);
+        falsePositives += ((braking && !brakeLabel) ? 1 : 0) + ((spinning && !gasLabel) ? 1 : 0);
+        misses += ((!braking && brakeLabel) ? 1 : 0) + ((!spinning && gasLabel) ? 1 : 0);
+
+        bool bumping = ((frame.flags & Bumping) != 0);
+        for (qint32 i = 0; i < outputs; ++i)
+        {
+            qint32 gas = qMin(bumping ? qMax(maxGas, bumpingIndices[i]) : maxGas, 127);
+            qint32 brake = qMin(bumping ? qMax(maxBrake, bumpingIndices[i]) : maxBrake, 127);
+            gas = qBound(0, gasFilters[i].process(gas), 127);
+            brake = qBound(0, brakeFilters[i].process(brake), 127);
+            if ((gas != lastGas[i]) || (brake != lastBrake[i]))
+            {
+                ++results[i].writes;
+                lastGas[i] = gas;
+                lastBrake[i] = brake;
+            }
+        }
+    }
+
+    for (qint32 i = 0; i < outputs; ++i)
+    {
+        results[i].brakeEvents = brakeEvents;
+        results[i].gasEvents = gasEvents;
+        results[i].falsePositives = falsePositives;
+        results[i].misses = misses;
+    }
+}
+
+QString resultLine(const SweepResult &result, bool labelled)
+{
+    QString line = QString("%1 %2 %3 %4 %5 %6")
+            .arg(result.config.brakeIndex, 5)
+            .arg(result.config.gasIndex, 5)
+            .arg(result.config.bumpingIndex, 7)
+            .arg(result.brakeEvents, 10)
+            .arg(result.gasEvents, 10)
+            .arg(result.writes, 10);
+    if (labelled)
+    {
+        line += QString(" %1 %2").arg(result.falsePositives, 10).arg(result.misses, 10);
+    }
+
+    return line;
+}
+}
+
+int runSweepCommand(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Replays recordings through the wheel slip detection for a grid of brake, "
+                                     "gas and bumping indices. A recording can be labelled with a file "
+                                     "<recording>.labels holding lines \"<start s> <end s> brake|gas\" for the "
+                                     "times the wheels really slipped.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("recordings", "Recordings (*.pvrec)", "<recording>...");
+    QCommandLineOption brakeOption("brake", "Brake indices as first:last:step", "range", "0:25");
+    QCommandLineOption gasOption("gas", "Gas indices as first:last:step", "range", "0:25");
+    QCommandLineOption bumpingOption("bumping", "Bumping indices as first:last:step", "range", "0:10");
+    QCommandLineOption threadsOption("threads", "Worker threads", "count", QString::number(QThread::idealThreadCount()));
+    QCommandLineOption rateOption("rate", "Ticks per second for the output filters, default from the recordings", "hz");
+    QCommandLineOption noFiltersOption("no-filters", "Count the serial writes without the output filters");
+    QCommandLineOption gasFilterOption("gas-filter", "Filter chain of the gas slip value, default as in the application", "filters");
+    QCommandLineOption brakeFilterOption("brake-filter", "Filter chain of the brake slip value, default as in the application", "filters");
+    QCommandLineOption topOption("top", "Number of settings to print", "count", "20");
+    QCommandLineOption csvOption("csv", "Write the results of all settings to this file", "file");
+    parser.addOption(brakeOption);
+    parser.addOption(gasOption);
+    parser.addOption(bumpingOption);
+    parser.addOption(threadsOption);
+    parser.addOption(rateOption);
+    parser.addOption(noFiltersOption);
+    parser.addOption(gasFilterOption);
+    parser.addOption(brakeFilterOption);
+    parser.addOption(topOption);
+    parser.addOption(csvOption);
+    parser.process(arguments);
+
+    QTextStream out(stdout);
+    if (parser.positionalArguments().isEmpty())
+    {
+        parser.showHelp(1);
+    }
+
+    // Same limits as the settings
+    SweepRange brakeRange;
+    SweepRange gasRange;
+    SweepRange bumpingRange;
+    if (!parseRange(parser.value(brakeOption), 0, 25, brakeRange)
+            || !parseRange(parser.value(gasOption), 0, 25, gasRange)
+            || !parseRange(parser.value(bumpingOption), 0, 10, bumpingRange))
+    {
+        out << "Invalid range\n";
+        return 1;
+    }
+
+    SweepData data;
+    qint64 loadStartNs = AcquisitionThread::now();
+    for (const QString &path : parser.positionalArguments())
+    {
+        if (!loadRecording(path, data, out))
+        {
+            return 1;
+        }
+    }
+    qint64 loadNs = AcquisitionThread::now() - loadStartNs;
+
+    if (data.frames.isEmpty())
+    {
+        out << "The recordings contain no live frames\n";
+        return 1;
+    }
+
+    float sampleRate = parser.isSet(rateOption)
+            ? parser.value(rateOption).toFloat()
+            : static_cast<float>(data.frames.size()) / qMax(1e-9f, static_cast<float>(data.durationNs) / 1e9f);
+    QString gasFilter;
+    QString brakeFilter;
+    if (!parser.isSet(noFiltersOption))
+    {
+        // The pvtool settings are fresh, they hold the defaults of the application
+        gasFilter = parser.isSet(gasFilterOption) ? parser.value(gasFilterOption) : Settings::getInstance()->getGasFilter();
+        brakeFilter = parser.isSet(brakeFilterOption) ? parser.value(brakeFilterOption) : Settings::getInstance()->getBrakeFilter();
+    }
+
+    QVector<qint32> brakeIndices = rangeValues(brakeRange);
+    QVector<qint32> gasIndices = rangeValues(gasRange);
+    QVector<qint32> bumpingIndices = rangeValues(bumpingRange);
+    qint32 pairs = brakeIndices.size() * gasIndices.size();
+    QVector<SweepResult> results(pairs * bumpingIndices.size());
+
+    // One task per brake and gas index, it covers all bumping indices
+    WorkStealingPool pool(parser.value(threadsOption).toInt());
+    qint64 sweepStartNs = AcquisitionThread::now();
+    pool.run(pairs, [&](qint32 task, qint32 worker)
+    {
+        (void)worker;
+        runSweep(data, brakeIndices[task / gasIndices.size()], gasIndices[task % gasIndices.size()], bumpingIndices,
+                 gasFilter, brakeFilter, sampleRate, results.data() + (task * bumpingIndices.size()));
+    });
+    qint64 sweepNs = AcquisitionThread::now() - sweepStartNs;
+
+    if (parser.isSet(csvOption))
+    {
+        QFile file(parser.value(csvOption));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+        {
+            out << "Cannot write " << parser.value(csvOption) << "\n";
+            return 1;
+        }
+
+        QTextStream csv(&file);
+        csv << "brake,gas,bumping,brakeEvents,gasEvents,writes,falsePositives,misses\n";
+        for (const SweepResult &result : results)
+        {
+            csv << result.config.brakeIndex << "," << result.config.gasIndex << "," << result.config.bumpingIndex << ","
+                << result.brakeEvents << "," << result.gasEvents << "," << result.writes << ","
+                << result.falsePositives << "," << result.misses << "\n";
+        }
+    }
+
+    // Fewest wrong frames first, then fewest writes
+    std::stable_sort(results.begin(), results.end(), [&data](const SweepResult &left, const SweepResult &right)
+    {
+        if (data.labelled)
+        {
+            quint64 leftErrors = left.falsePositives + left.misses;
+            quint64 rightErrors = right.falsePositives + right.misses;
+            if (leftErrors != rightErrors)
+            {
+                return leftErrors < rightErrors;
+            }
+        }
+
+        return left.writes < right.writes;
+    });
+
+    double frameSettings = static_cast<double>(data.frames.size()) * results.size();
+    out << data.frames.size() << " live frames (" << QString::number(static_cast<double>(data.durationNs) / 1e9, 'f', 1)
+        << " s) loaded in " << QString::number(static_cast<double>(loadNs) / 1e9, 'f', 2) << " s, "
+        << (data.labelled ? "labelled" : "not labelled") << "\n"
+        << results.size() << " settings on " << pool.threadCount() << " threads in "
+        << QString::number(static_cast<double>(sweepNs) / 1e9, 'f', 2) << " s ("
+        << QString::number(frameSettings / (static_cast<double>(qMax<qint64>(1, sweepNs)) / 1e9) / 1e6, 'f', 1)
+        << " M frames per second, " << pool.steals() << " tasks stolen)\n\n"
+        << "brake   gas bumping brakeSlips   gasSlips     writes" << (data.labelled ? " falsePos.     missed" : "") << "\n";
+
+    qint32 top = qMin(results.size(), qMax(0, parser.value(topOption).toInt()));
+    for (qint32 i = 0; i < top; ++i)
+    {
+        out << resultLine(results[i], data.labelled) << "\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,104 @@
+#include "workstealingpool.h"
+#include <thread>
+
+
+WorkStealingPool::WorkStealingPool(qint32 threadCount)
+    : m_threadCount(qMax(1, threadCount))
+{
+    for (qint32 i = 0; i < m_threadCount; ++i)
+    {
+        m_workers.emplace_back(new Worker());
+    }
+}
+
+qint32 WorkStealingPool::threadCount() const
+{
+    return m_threadCount;
+}
+
+void WorkStealingPool::run(qint32 count, const std::function<void(qint32, qint32)> &task)
+{
+    // Neighbouring tasks stay on one worker, they tend to take similar time
+    for (qint32 i = 0; i < m_threadCount; ++i)
+    {
+        Worker &worker = *m_workers[i];
+        worker.tasks.clear();
+        worker.steals = 0;
+
+        qint32 begin = static_cast<qint32>((static_cast<qint64>(count) * i) / m_threadCount);
+        qint32 end = static_cast<qint32>((static_cast<qint64>(count) * (i + 1)) / m_threadCount);
+        for (qint32 index = end - 1; index >= begin; --index)
+        {
+            worker.tasks.push_back(index);
+        }
+    }
+
+    std::vector<std::thread> threads;
+    for (qint32 i = 1; i < m_threadCount; ++i)
+    {
+        threads.emplace_back([this, i, &task]()
+        {
+            work(i, task);
+        });
+    }
+
+    work(0, task);
+
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+}
+
+quint64 WorkStealingPool::steals() const
+{
+    quint64 steals = 0;
+    for (const std::unique_ptr<Worker> &worker : m_workers)
+    {
+        steals += worker->steals;
+    }
+
+    return steals;
+}
+
+void WorkStealingPool::work(qint32 worker, const std::function<void(qint32, qint32)> &task)
+{
+    // No task creates new tasks, so the work is done once nothing is left to steal
+    qint32 index = 0;
+    while (pop(worker, index) || steal(worker, index))
+    {
+        task(index, worker);
+    }
+}
+
+bool WorkStealingPool::pop(qint32 worker, qint32 &task)
+{
+    Worker &own = *m_workers[worker];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (own.tasks.empty())
+    {
+        return false;
+    }
+
+    task = own.tasks.back();
+    own.tasks.pop_back();
+    return true;
+}
+
+bool WorkStealingPool::steal(qint32 thief, qint32 &task)
+{
+    for (qint32 i = 1; i < m_threadCount; ++i)
+    {
+        Worker &victim = *m_workers[(thief + i) % m_threadCount];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty())
+        {
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+            ++m_workers[thief]->steals;
+            return true;
+        }
+    }
+
+    return false;
+}
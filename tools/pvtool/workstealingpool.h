@@ -0,0 +1,45 @@
+#ifndef WORKSTEALINGPOOL_B3F1E0C2A9D84C6B8E5A7D41F09C2E73
+#define WORKSTEALINGPOOL_B3F1E0C2A9D84C6B8E5A7D41F09C2E73
+
+#include <QtGlobal>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Runs a fixed number of independent tasks on all cores. Every worker
+// starts with its own block of tasks and takes them from the back of its
+// queue. A worker without tasks steals from the front of another queue,
+// so uneven tasks do not leave cores idle.
+class WorkStealingPool
+{
+public:
+    explicit WorkStealingPool(qint32 threadCount);
+
+    qint32 threadCount() const;
+
+    // Calls task(index, worker) for every index below count and returns
+    // when all are done. The calling thread is worker 0.
+    void run(qint32 count, const std::function<void(qint32, qint32)> &task);
+
+    // Tasks a worker took from another queue during the last run
+    quint64 steals() const;
+
+private:
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<qint32> tasks;
+        quint64 steals = 0;
+    };
+
+    void work(qint32 worker, const std::function<void(qint32, qint32)> &task);
+    bool pop(qint32 worker, qint32 &task);
+    bool steal(qint32 thief, qint32 &task);
+
+    qint32 m_threadCount;
+    std::vector<std::unique_ptr<Worker>> m_workers;
+};
+
+#endif // WORKSTEALINGPOOL_B3F1E0C2A9D84C6B8E5A7D41F09C2E73
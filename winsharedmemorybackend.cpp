@@ -0,0 +1,89 @@
+#include "winsharedmemorybackend.h"
+
+
+WinSharedMemoryBackend::WinSharedMemoryBackend()
+{
+    initPhysics();
+    initGraphics();
+    initStatic();
+}
+
+WinSharedMemoryBackend::~WinSharedMemoryBackend()
+{
+    dismiss(m_physics);
+    dismiss(m_graphics);
+    dismiss(m_static);
+}
+
+bool WinSharedMemoryBackend::isOpen() const
+{
+    return ((m_physics.mapFileBuffer != nullptr)
+            && (m_graphics.mapFileBuffer != nullptr)
+            && (m_static.mapFileBuffer != nullptr));
+}
+
+const SPageFilePhysics* WinSharedMemoryBackend::physics() const
+{
+    return (SPageFilePhysics*)m_physics.mapFileBuffer;
+}
+
+const SPageFileGraphic* WinSharedMemoryBackend::graphics() const
+{
+    return (SPageFileGraphic*)m_graphics.mapFileBuffer;
+}
+
+const SPageFileStatic* WinSharedMemoryBackend::staticData() const
+{
+    return (SPageFileStatic*)m_static.mapFileBuffer;
+}
+
+void WinSharedMemoryBackend::initPhysics()
+{
+    TCHAR szName[] = TEXT("Local\\acpmf_physics");
+    m_physics.hMapFile = CreateFileMapping(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, sizeof(SPageFilePhysics), szName);
+    if (!m_physics.hMapFile)
+    {
+        MessageBoxA(GetActiveWindow(), "CreateFileMapping failed", "ACS", MB_OK);
+    }
+    m_physics.mapFileBuffer = (unsigned char*)MapViewOfFile(m_physics.hMapFile, FILE_MAP_READ, 0, 0, sizeof(SPageFilePhysics));
+    if (!m_physics.mapFileBuffer)
+    {
+        MessageBoxA(GetActiveWindow(), "MapViewOfFile failed", "ACS", MB_OK);
+    }
+}
+
+void WinSharedMemoryBackend::initGraphics()
+{
+    TCHAR szName[] = TEXT("Local\\acpmf_graphics");
+    m_graphics.hMapFile = CreateFileMapping(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, sizeof(SPageFileGraphic), szName);
+    if (!m_graphics.hMapFile)
+    {
+        MessageBoxA(GetActiveWindow(), "CreateFileMapping failed", "ACS", MB_OK);
+    }
+    m_graphics.mapFileBuffer = (unsigned char*)MapViewOfFile(m_graphics.hMapFile, FILE_MAP_READ, 0, 0, sizeof(SPageFileGraphic));
+    if (!m_graphics.mapFileBuffer)
+    {
+        MessageBoxA(GetActiveWindow(), "MapViewOfFile failed", "ACS", MB_OK);
+    }
+}
+
+void WinSharedMemoryBackend::initStatic()
+{
+    TCHAR szName[] = TEXT("Local\\acpmf_static");
+    m_static.hMapFile = CreateFileMapping(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, sizeof(SPageFileStatic), szName);
+    if (!m_static.hMapFile)
+    {
+        MessageBoxA(GetActiveWindow(), "CreateFileMapping failed", "ACS", MB_OK);
+    }
+    m_static.mapFileBuffer = (unsigned char*)MapViewOfFile(m_static.hMapFile, FILE_MAP_READ, 0, 0, sizeof(SPageFileStatic));
+    if (!m_static.mapFileBuffer)
+    {
+        MessageBoxA(GetActiveWindow(), "MapViewOfFile failed", "ACS", MB_OK);
+    }
+}
+
+void WinSharedMemoryBackend::dismiss(SMElement element)
+{
+    UnmapViewOfFile(element.mapFileBuffer);
+    CloseHandle(element.hMapFile);
+}
@@ -0,0 +1,36 @@
+#ifndef WINSHAREDMEMORYBACKEND_1D92698712254045A6093BEAABEE6245
+#define WINSHAREDMEMORYBACKEND_1D92698712254045A6093BEAABEE6245
+
+#include "telemetrybackend.h"
+#include <windows.h>
+
+struct SMElement
+{
+    HANDLE hMapFile;
+    unsigned char* mapFileBuffer;
+};
+
+class WinSharedMemoryBackend : public TelemetryBackend
+{
+public:
+    WinSharedMemoryBackend();
+    ~WinSharedMemoryBackend() override;
+
+    bool isOpen() const override;
+
+    const SPageFilePhysics* physics() const override;
+    const SPageFileGraphic* graphics() const override;
+    const SPageFileStatic* staticData() const override;
+
+private:
+    void initPhysics();
+    void initGraphics();
+    void initStatic();
+    void dismiss(SMElement element);
+
+    SMElement m_graphics;
+    SMElement m_physics;
+    SMElement m_static;
+};
+
+#endif // WINSHAREDMEMORYBACKEND_1D92698712254045A6093BEAABEE6245